@@ -41,7 +41,10 @@ typedef enum {
   QEXEC_F_SENDRAWIDS = 0x2000,
 
   /* Flag for scorer function to create explanation strings */
-  QEXEC_F_SEND_SCOREEXPLAIN = 0x4000
+  QEXEC_F_SEND_SCOREEXPLAIN = 0x4000,
+
+  /* The total number of results is not needed, and may be only a lower bound */
+  QEXEC_F_NOCOUNT = 0x8000
 
 } QEFlags;
 
@@ -82,6 +85,10 @@ typedef struct {
   /** Context for iterating over the queries themselves */
   QueryIterator qiter;
 
+  /** The distance key nearest neighbours are sorted by when there is no SORTBY. The sorter keeps
+   * a pointer to it, so it lives as long as the request */
+  const RLookupKey *knnDistanceKey;
+
   /** Used for identifying unique objects across this request */
   uint32_t serial;
   /** Flags controlling query output */
@@ -7,6 +7,7 @@
 #include <util/arr.h>
 #include <rmutil/util.h>
 #include "ext/default.h"
+#include "vector_index.h"
 #include "extension.h"
 
 /**
@@ -277,6 +278,24 @@ static int parseQueryLegacyArgs(ArgsCursor *ac, RSSearchOptions *options, QueryE
       GeoFilter_Free(options->legacy.gf);
       return ARG_ERROR;
     }
+  } else if (AC_AdvanceIfMatch(ac, "GEOKNN")) {
+    if (options->geoKnn) {
+      QERR_MKBADARGS_FMT(status, "GEOKNN can only be specified once");
+      return ARG_ERROR;
+    }
+    options->geoKnn = rm_calloc(1, sizeof(*options->geoKnn));
+    if (GeoFilter_ParseKnn(options->geoKnn, ac, status) != REDISMODULE_OK) {
+      return ARG_ERROR;
+    }
+  } else if (AC_AdvanceIfMatch(ac, "VECTORKNN")) {
+    if (options->vectorKnn) {
+      QERR_MKBADARGS_FMT(status, "VECTORKNN can only be specified once");
+      return ARG_ERROR;
+    }
+    options->vectorKnn = rm_calloc(1, sizeof(*options->vectorKnn));
+    if (VectorQuery_Parse(options->vectorKnn, ac, status) != REDISMODULE_OK) {
+      return ARG_ERROR;
+    }
   } else {
     return ARG_UNKNOWN;
   }
@@ -309,6 +328,7 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       {AC_MKBITFLAG("NOCONTENT", &req->reqflags, QEXEC_F_SEND_NOFIELDS)},
       {AC_MKBITFLAG("NOSTOPWORDS", &searchOpts->flags, Search_NoStopwrods)},
       {AC_MKBITFLAG("EXPLAINSCORE", &req->reqflags, QEXEC_F_SEND_SCOREEXPLAIN)},
+      {AC_MKBITFLAG("WITHOUTCOUNT", &req->reqflags, QEXEC_F_NOCOUNT)},
       {.name = "PAYLOAD",
        .type = AC_ARGTYPE_STRING,
        .target = &req->ast.udata,
@@ -688,6 +708,12 @@ static void applyGlobalFilters(RSSearchOptions *opts, QueryAST *ast, const Redis
     QAST_GlobalFilterOptions filterOpts = {.ids = opts->inids, .nids = opts->nids};
     QAST_SetGlobalFilters(ast, &filterOpts);
   }
+
+  // Must come last, as the nearest neighbours are searched among the matches of all the filters
+  if (opts->vectorKnn) {
+    QAST_GlobalFilterOptions vectorOpts = {.vector = opts->vectorKnn};
+    QAST_SetGlobalFilters(ast, &vectorOpts);
+  }
 }
 
 int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
@@ -727,6 +753,24 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
     StopWordList_Ref(sctx->spec->stopwords);
   }
 
+  if (opts->vectorKnn) {
+    const VectorQuery *vq = opts->vectorKnn;
+    const FieldSpec *fs = IndexSpec_GetField(index, vq->property, strlen(vq->property));
+    if (!fs || !FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+      QueryError_SetErrorFmt(status, QUERY_EINVAL, "`%s` is not a vector field", vq->property);
+      return REDISMODULE_ERR;
+    }
+    if (vq->dim != fs->vectorOpts.dim) {
+      QueryError_SetErrorFmt(status, QUERY_EINVAL, "Query vector must have %u elements, got %zu",
+                             fs->vectorOpts.dim, vq->dim);
+      return REDISMODULE_ERR;
+    }
+    if (opts->geoKnn) {
+      QueryError_SetError(status, QUERY_EINVAL, "VECTORKNN cannot be combined with GEOKNN");
+      return REDISMODULE_ERR;
+    }
+  }
+
   QueryAST *ast = &req->ast;
 
   int rv = QAST_Parse(ast, sctx, &req->searchopts, req->query, strlen(req->query), status);
@@ -746,6 +790,17 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   req->rootiter = QAST_Iterate(ast, opts, sctx, &req->conc);
   RS_LOG_ASSERT(req->rootiter, "QAST_Iterate failed");
 
+  if (opts->geoKnn) {
+    const char *prop = opts->geoKnn->property;
+    const FieldSpec *fs = IndexSpec_GetField(index, prop, strlen(prop));
+    if (!fs || !FIELD_IS(fs, INDEXFLD_T_GEO)) {
+      QueryError_SetErrorFmt(status, QUERY_EINVAL, "`%s` is not a geo field", prop);
+      return REDISMODULE_ERR;
+    }
+    // The nearest neighbours are searched among the query's matches
+    req->rootiter = NewGeoKnnIterator(sctx, opts->geoKnn, req->rootiter);
+  }
+
   return REDISMODULE_OK;
 }
 
@@ -837,6 +892,24 @@ static ResultProcessor *getGroupRP(AREQ *req, PLN_GroupStep *gstp, ResultProcess
 
 #define DEFAULT_LIMIT 10
 
+/** Returns the key holding the distance of GEOKNN or VECTORKNN results, creating it if needed.
+ * Returns NULL if the request is not a nearest neighbour search */
+static const RLookupKey *getKnnDistanceKey(RLookup *lookup, const RSSearchOptions *opts) {
+  const char *fmt, *property;
+  if (opts->geoKnn) {
+    fmt = GEOKNN_DISTANCE_FIELD_FMT;
+    property = opts->geoKnn->property;
+  } else if (opts->vectorKnn) {
+    fmt = VECTOR_DISTANCE_FIELD_FMT;
+    property = opts->vectorKnn->property;
+  } else {
+    return NULL;
+  }
+  char name[strlen(property) + strlen(fmt) + 1];
+  sprintf(name, fmt, property);
+  return RLookup_GetKey(lookup, name, RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC | RLOOKUP_F_NOINCREF);
+}
+
 static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep *stp,
                                      QueryError *status, ResultProcessor *up) {
   ResultProcessor *rp = NULL;
@@ -873,8 +946,15 @@ static ResultProcessor *getArrangeRP(AREQ *req, AGGPlan *pln, const PLN_BaseStep
     up = pushRP(req, rp, up);
   }
 
-  // No sort? then it must be sort by score, which is the default.
-  if (rp == NULL && (req->reqflags & QEXEC_F_IS_SEARCH)) {
+  // No sort? then nearest neighbours are sorted by distance, and anything else by score
+  if (rp == NULL && (req->reqflags & QEXEC_F_IS_SEARCH) &&
+      (req->searchopts.geoKnn || req->searchopts.vectorKnn)) {
+    RLookup *lk = stp ? AGPLN_GetLookup(pln, stp, AGPLN_GETLOOKUP_PREV)
+                      : AGPLN_GetLookup(pln, NULL, AGPLN_GETLOOKUP_LAST);
+    req->knnDistanceKey = getKnnDistanceKey(lk, &req->searchopts);
+    rp = RPSorter_NewByFields(limit, &req->knnDistanceKey, 1, SORTASCMAP_INIT);
+    up = pushRP(req, rp, up);
+  } else if (rp == NULL && (req->reqflags & QEXEC_F_IS_SEARCH)) {
     rp = RPSorter_NewByScore(limit);
     up = pushRP(req, rp, up);
   }
@@ -920,6 +1000,46 @@ static int hasQuerySortby(const AGGPlan *pln) {
   return 0;
 }
 
+/**
+ * Returns a processor reading the results in the order of the numeric field the search is sorted
+ * by, or NULL if they should be read by their ids. Reading them in order stops early, so the total
+ * number of results is then unknown
+ */
+static ResultProcessor *getNumericOrderRP(AREQ *req, RLookup *lookup) {
+  if (!(req->reqflags & QEXEC_F_IS_SEARCH) || !(req->reqflags & QEXEC_F_NOCOUNT) ||
+      !req->rootiter || req->searchopts.geoKnn || req->searchopts.vectorKnn) {
+    return NULL;
+  }
+  const PLN_ArrangeStep *astp =
+      (PLN_ArrangeStep *)AGPLN_FindStep(&req->ap, NULL, NULL, PLN_T_ARRANGE);
+  if (!astp || !astp->sortKeys || array_len(astp->sortKeys) != 1) {
+    return NULL;
+  }
+
+  // the field must be both in the numeric index and in the sorting vectors
+  const char *name = astp->sortKeys[0];
+  const FieldSpec *fs = IndexSpec_GetField(req->sctx->spec, name, strlen(name));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsSortable(fs) ||
+      !FieldSpec_IsIndexable(fs)) {
+    return NULL;
+  }
+  const RLookupKey *sortKey = RLookup_GetKey(lookup, name, RLOOKUP_F_NOINCREF);
+  if (!sortKey || !(sortKey->flags & RLOOKUP_F_SVSRC)) {
+    return NULL;
+  }
+  NumericRangeTree *tree = OpenNumericIndexForRead(req->sctx, fs->name, INDEXFLD_T_NUMERIC);
+  if (!tree) {
+    return NULL;
+  }
+
+  size_t limit = astp->offset + astp->limit;
+  if (!limit) {
+    limit = DEFAULT_LIMIT;
+  }
+  return RPIndexIterator_NewNumericOrder(req->rootiter, tree, sortKey,
+                                         SORTASCMAP_GETASC(astp->sortAscMap, 0), limit);
+}
+
 #define PUSH_RP()                           \
   rpUpstream = pushRP(req, rp, rpUpstream); \
   rp = NULL;
@@ -940,11 +1060,23 @@ static void buildImplicitPipeline(AREQ *req, QueryError *Status) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPIndexIterator_New(req->rootiter);
+  /** A search sorted by a numeric field reads the results in its order, if it need not count them */
+  ResultProcessor *rp = getNumericOrderRP(req, first);
+  if (!rp) {
+    rp = RPIndexIterator_New(req->rootiter);
+  }
   ResultProcessor *rpUpstream = NULL;
   req->qiter.rootProc = req->qiter.endProc = rp;
   PUSH_RP();
 
+  /** Nearest neighbours carry their distance, which is also their score, and are ordered by it */
+  const RLookupKey *distanceKey = getKnnDistanceKey(first, &req->searchopts);
+  if (distanceKey) {
+    rp = RPKnnDistance_New(distanceKey);
+    PUSH_RP();
+    return;
+  }
+
   /** Create a scorer if there is no subsequent sorter within this grouping */
   if (!hasQuerySortby(&req->ap) && (req->reqflags & QEXEC_F_IS_SEARCH)) {
     rp = getScorerRP(req);
@@ -1146,6 +1278,9 @@ void AREQ_Free(AREQ *req) {
     req->rootiter = NULL;
   }
 
+  // Then everything allocated from the request, all at once
+  QITR_FreeArena(&req->qiter);
+
   // Go through each of the steps and free it..
   AGPLN_FreeSteps(&req->ap);
 
@@ -1180,6 +1315,12 @@ void AREQ_Free(AREQ *req) {
     }
     array_free(req->searchopts.legacy.filters);
   }
+  if (req->searchopts.geoKnn) {
+    GeoFilter_Free(req->searchopts.geoKnn);
+  }
+  if (req->searchopts.vectorKnn) {
+    VectorQuery_Free(req->searchopts.vectorKnn);
+  }
   rm_free(req->searchopts.inids);
   FieldList_Free(&req->outFields);
   if (thctx) {
@@ -1,6 +1,7 @@
 #include <util/minmax.h>
 #include <util/array.h>
 #include <util/block_alloc.h>
+#include "rmalloc.h"
 #include <aggregate/expr/expression.h>
 #include <ctype.h>
 
@@ -39,11 +40,10 @@ static int timeFormat(ExprEval *ctx, RSValue *result, RSValue **argv, size_t arg
   }
 
   // Finally, allocate a buffer to store the time!
-  char *buf = ExprEval_Strndup(ctx, timebuf, rv);
+  char *buf = rm_strndup(timebuf, rv);
 
-  // It will be released by the block allocator destruction, so we refer to it is a static string so
-  // the value ref counter will not release it
-  RSValue_SetConstString(result, buf, rv);
+  // It is released with the value, so that rows evaluated one after the other do not pile up
+  RSValue_SetString(result, buf, rv);
   return EXPR_EVAL_OK;
 err:
   // on runtime error (bad formatting, etc) we just set the result to null
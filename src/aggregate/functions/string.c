@@ -1,6 +1,7 @@
 #include <util/minmax.h>
 #include <rmutil/sds.h>
 #include <util/block_alloc.h>
+#include "rmalloc.h"
 #include <aggregate/expr/expression.h>
 #include <ctype.h>
 #include <util/arr.h>
@@ -56,12 +57,12 @@ static int stringfunc_tolower(ExprEval *ctx, RSValue *result, RSValue **argv, si
 
   size_t sz = 0;
   char *p = (char *)RSValue_StringPtrLen(val, &sz);
-  char *np = ExprEval_UnalignedAlloc(ctx, sz + 1);
+  char *np = rm_malloc(sz + 1);
   for (size_t i = 0; i < sz; i++) {
     np[i] = tolower(p[i]);
   }
   np[sz] = '\0';
-  RSValue_SetConstString(result, np, sz);
+  RSValue_SetString(result, np, sz);
   return EXPR_EVAL_OK;
 }
 
@@ -78,12 +79,12 @@ static int stringfunc_toupper(ExprEval *ctx, RSValue *result, RSValue **argv, si
 
   size_t sz = 0;
   char *p = (char *)RSValue_StringPtrLen(val, &sz);
-  char *np = ExprEval_UnalignedAlloc(ctx, sz + 1);
+  char *np = rm_malloc(sz + 1);
   for (size_t i = 0; i < sz; i++) {
     np[i] = toupper(p[i]);
   }
   np[sz] = '\0';
-  RSValue_SetConstString(result, np, sz);
+  RSValue_SetString(result, np, sz);
   return EXPR_EVAL_OK;
 }
 
@@ -118,8 +119,8 @@ static int stringfunc_substr(ExprEval *ctx, RSValue *result, RSValue **argv, siz
     len = sz - offset;
   }
 
-  char *dup = ExprEval_Strndup(ctx, &str[offset], len);
-  RSValue_SetConstString(result, dup, len);
+  char *dup = rm_strndup(&str[offset], len);
+  RSValue_SetString(result, dup, len);
   return EXPR_EVAL_OK;
 }
 
@@ -145,20 +146,18 @@ int func_to_str(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc, Que
   return EXPR_EVAL_OK;
 }
 
-static int stringfunc_format(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
-                             QueryError *err) {
-  if (argc < 1) {
-    QERR_MKBADARGS_FMT(err, "Need at least one argument for format");
-    return EXPR_EVAL_ERR;
-  }
-  VALIDATE_ARG_ISSTRING("format", argv, 0);
-
-  size_t argix = 1;
-  size_t fmtsz = 0;
-  const char *fmt = RSValue_StringPtrLen(argv[0], &fmtsz);
+/* Write the formatted string to out, or only compute its length if out is NULL. The arguments
+ * are already converted to strings. Returns the length, or -1 if the format is invalid */
+static ssize_t formatString(const char *fmt, size_t fmtsz, const RSValue *args, size_t nargs,
+                            char *out, QueryError *err) {
+#define FORMAT_APPEND(s, sz) \
+  if (out) {                 \
+    memcpy(out + n, s, sz);  \
+  }                          \
+  n += (sz)
+
+  size_t argix = 0, n = 0;
   const char *last = fmt, *end = fmt + fmtsz;
-  sds out = sdsMakeRoomFor(sdsnew(""), fmtsz);
-
   for (size_t ii = 0; ii < fmtsz; ++ii) {
     if (fmt[ii] != '%') {
       continue;
@@ -167,66 +166,91 @@ static int stringfunc_format(ExprEval *ctx, RSValue *result, RSValue **argv, siz
     if (ii == fmtsz - 1) {
       // ... %"
       QERR_MKBADARGS_FMT(err, "Bad format string!");
-      goto error;
+      return -1;
     }
 
     // Detected a format string. Write from 'last' up to 'fmt'
-    out = sdscatlen(out, last, (fmt + ii) - last);
+    FORMAT_APPEND(last, (fmt + ii) - last);
     last = fmt + ii + 2;
 
     char type = fmt[++ii];
     if (type == '%') {
       // Append literal '%'
-      out = sdscat(out, "%");
+      FORMAT_APPEND("%", 1);
       continue;
     }
 
-    if (argix == argc) {
+    if (argix == nargs) {
       QERR_MKBADARGS_FMT(err, "Not enough arguments for format");
-      goto error;
+      return -1;
     }
-
-    RSValue *arg = RSValue_Dereference(argv[argix++]);
-    if (type == 's') {
-      if (arg->t == RSValue_Null) {
-        // write null value
-        out = sdscat(out, "(null)");
-        continue;
-      } else if (!RSValue_IsString(arg)) {
-
-        RSValue strval = RSVALUE_STATIC;
-        RSValue_ToString(&strval, arg);
-        size_t sz;
-        const char *str = RSValue_StringPtrLen(&strval, &sz);
-        if (!str) {
-          out = sdscat(out, "(null)");
-        } else {
-          out = sdscatlen(out, str, sz);
-        }
-        RSValue_Free(&strval);
-      } else {
-        size_t sz;
-        const char *str = RSValue_StringPtrLen(arg, &sz);
-        out = sdscatlen(out, str, sz);
-      }
-    } else {
+    if (type != 's') {
       QERR_MKBADARGS_FMT(err, "Unknown format specifier passed");
-      goto error;
+      return -1;
     }
+    size_t sz;
+    const char *str = RSValue_StringPtrLen(&args[argix++], &sz);
+    FORMAT_APPEND(str, sz);
   }
 
   if (last && last < end) {
-    out = sdscatlen(out, last, end - last);
+    FORMAT_APPEND(last, end - last);
   }
+  return n;
+#undef FORMAT_APPEND
+}
 
-  RSValue_SetSDS(result, out);
-  return EXPR_EVAL_OK;
+static int stringfunc_format(ExprEval *ctx, RSValue *result, RSValue **argv, size_t argc,
+                             QueryError *err) {
+  if (argc < 1) {
+    QERR_MKBADARGS_FMT(err, "Need at least one argument for format");
+    return EXPR_EVAL_ERR;
+  }
+  VALIDATE_ARG_ISSTRING("format", argv, 0);
 
-error:
-  assert(QueryError_HasError(err));
-  sdsfree(out);
-  RSValue_MakeReference(result, RS_NullVal());
-  return EXPR_EVAL_ERR;
+  size_t fmtsz = 0;
+  const char *fmt = RSValue_StringPtrLen(argv[0], &fmtsz);
+
+  // The arguments as strings, converted once to size the output, which is then written to the
+  // heap, freed with the value
+  size_t nargs = argc - 1;
+  RSValue args[nargs + 1];
+  for (size_t ii = 0; ii < nargs; ++ii) {
+    RSValue *arg = RSValue_Dereference(argv[ii + 1]);
+    args[ii] = (RSValue)RSVALUE_STATIC;
+    if (RSValue_IsString(arg)) {
+      size_t sz;
+      const char *str = RSValue_StringPtrLen(arg, &sz);
+      RSValue_SetConstString(&args[ii], str, sz);
+      continue;
+    }
+    if (arg->t != RSValue_Null) {
+      RSValue_ToString(&args[ii], arg);
+    }
+    if (arg->t == RSValue_Null || !RSValue_StringPtrLen(&args[ii], NULL)) {
+      // write null value
+      RSValue_Free(&args[ii]);
+      RSValue_SetConstString(&args[ii], "(null)", 6);
+    }
+  }
+
+  int rc = EXPR_EVAL_OK;
+  ssize_t n = formatString(fmt, fmtsz, args, nargs, NULL, err);
+  if (n < 0) {
+    assert(QueryError_HasError(err));
+    RSValue_MakeReference(result, RS_NullVal());
+    rc = EXPR_EVAL_ERR;
+  } else {
+    char *out = rm_malloc(n + 1);
+    formatString(fmt, fmtsz, args, nargs, out, err);
+    out[n] = '\0';
+    RSValue_SetString(result, out, n);
+  }
+
+  for (size_t ii = 0; ii < nargs; ++ii) {
+    RSValue_Free(&args[ii]);
+  }
+  return rc;
 }
 
 char *strtrim(char *s, size_t sl, size_t *outlen, const char *cset) {
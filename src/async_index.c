@@ -0,0 +1,258 @@
+#include "async_index.h"
+#include "spec.h"
+#include "document.h"
+#include "indexer.h"
+#include "config.h"
+#include "module.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "dep/thpool/thpool.h"
+
+#include <sched.h>
+#include <time.h>
+
+static uint64_t nowMS() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+AsyncIndexQueue *NewAsyncIndexQueue(IndexSpec *spec) {
+  AsyncIndexQueue *q = rm_calloc(1, sizeof(*q));
+  q->spec = spec;
+  q->pending = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  q->indexing = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  return q;
+}
+
+static void AsyncIndexQueue_Destroy(AsyncIndexQueue *q) {
+  AsyncIndexEntry *e = q->head;
+  while (e) {
+    AsyncIndexEntry *next = e->next;
+    RedisModule_FreeString(NULL, e->key);
+    rm_free(e);
+    e = next;
+  }
+  dictRelease(q->pending);
+  dictRelease(q->indexing);
+  rm_free(q);
+}
+
+void AsyncIndexQueue_Free(AsyncIndexQueue *q) {
+  q->spec = NULL;
+  if (!q->scheduled) {
+    AsyncIndexQueue_Destroy(q);
+  }
+}
+
+int AsyncIndexQueue_Push(AsyncIndexQueue *q, RedisModuleString *key, uint64_t now) {
+  if (dictFind(q->pending, key)) {
+    return 0;
+  }
+  AsyncIndexEntry *e = rm_malloc(sizeof(*e));
+  e->next = NULL;
+  // the notification's string may be shared by the keyspace, keep a copy of our own
+  e->key = RedisModule_CreateStringFromString(NULL, key);
+  e->queuedAt = now;
+  dictAdd(q->pending, e->key, NULL);
+  if (q->tail) {
+    q->tail->next = e;
+  } else {
+    q->head = e;
+  }
+  q->tail = e;
+  return 1;
+}
+
+RedisModuleString *AsyncIndexQueue_Pop(AsyncIndexQueue *q) {
+  AsyncIndexEntry *e = q->head;
+  if (!e) {
+    return NULL;
+  }
+  if (!(q->head = e->next)) {
+    q->tail = NULL;
+  }
+  if (dictSize(q->indexing) == 0) {
+    q->indexingSince = e->queuedAt;
+  }
+  dictDelete(q->pending, e->key);
+  dictAdd(q->indexing, e->key, NULL);
+  RedisModuleString *key = e->key;
+  rm_free(e);
+  return key;
+}
+
+void AsyncIndexQueue_EndBatch(AsyncIndexQueue *q) {
+  dictEmpty(q->indexing, NULL);
+  q->indexingSince = 0;
+}
+
+bool AsyncIndexQueue_Contains(const AsyncIndexQueue *q, RedisModuleString *key) {
+  return dictFind(q->pending, key) || dictFind(q->indexing, key);
+}
+
+size_t AsyncIndexQueue_Size(const AsyncIndexQueue *q) {
+  return dictSize(q->pending) + dictSize(q->indexing);
+}
+
+uint64_t AsyncIndexQueue_LagMS(const AsyncIndexQueue *q, uint64_t now) {
+  uint64_t oldest = UINT64_MAX;
+  if (dictSize(q->indexing)) {
+    oldest = q->indexingSince;
+  } else if (q->head) {
+    oldest = q->head->queuedAt;
+  }
+  return oldest < now ? now - oldest : 0;
+}
+
+void AsyncIndexQueue_RenderStats(const AsyncIndexQueue *q, RedisModuleCtx *ctx) {
+#define REPLY_KVNUM(n, k, v)                   \
+  RedisModule_ReplyWithSimpleString(ctx, k);   \
+  RedisModule_ReplyWithDouble(ctx, (double)v); \
+  n += 2
+
+  int n = 0;
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  // the queue is created by the first write
+  if (q) {
+    REPLY_KVNUM(n, "pending_docs", AsyncIndexQueue_Size(q));
+    REPLY_KVNUM(n, "indexing_lag_ms", AsyncIndexQueue_LagMS(q, nowMS()));
+    REPLY_KVNUM(n, "total_batches", q->numBatches);
+    REPLY_KVNUM(n, "total_docs_indexed", q->numIndexed);
+    REPLY_KVNUM(n, "sync_fallbacks", q->numSyncFallbacks);
+  }
+  RedisModule_ReplySetArrayLength(ctx, n);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static threadpool asyncIndexPool = NULL;
+
+/* Load a queued hash into a document context ready to be preprocessed. Returns NULL if the hash
+ * was deleted since it was queued, in which case it was already removed from the index */
+static RSAddDocumentCtx *loadDocument(RedisSearchCtx *sctx, RedisModuleString *key) {
+  Document doc = {0};
+  Document_Init(&doc, key, 1.0, DEFAULT_LANGUAGE);
+  if (Document_LoadSchemaFields(&doc, sctx) != REDISMODULE_OK) {
+    Document_Free(&doc);
+    return NULL;
+  }
+  QueryError status = {0};
+  RSAddDocumentCtx *aCtx = NewAddDocumentCtx(sctx->spec, &doc, &status);
+  if (!aCtx) {
+    QueryError_ClearError(&status);
+    Document_Free(&doc);
+    return NULL;
+  }
+  aCtx->stateFlags |= ACTX_F_NOBLOCK;
+  aCtx->options = DOCUMENT_ADD_REPLACE;
+  aCtx->donecb = NULL;
+  aCtx->client.sctx = sctx;
+  return aCtx;
+}
+
+static bool hashExists(RedisModuleCtx *ctx, RedisModuleString *key) {
+  RedisModuleKey *k = RedisModule_OpenKey(ctx, key, REDISMODULE_READ);
+  bool exists = k && RedisModule_KeyType(k) == REDISMODULE_KEYTYPE_HASH;
+  if (k) {
+    RedisModule_CloseKey(k);
+  }
+  return exists;
+}
+
+static void AsyncIndex_Task(AsyncIndexQueue *q) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  arrayof(RSAddDocumentCtx *) batch = array_new(RSAddDocumentCtx *, 16);
+  RedisModule_ThreadSafeContextLock(ctx);
+
+  while (q->spec && q->head) {
+    RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, q->spec);
+    RedisModuleString *key;
+    while (array_len(batch) < RSGlobalConfig.asyncIndexBatchSize &&
+           (key = AsyncIndexQueue_Pop(q))) {
+      RSAddDocumentCtx *aCtx = loadDocument(&sctx, key);
+      RedisModule_FreeString(NULL, key);
+      if (aCtx) {
+        batch = array_append(batch, aCtx);
+      }
+    }
+
+    // tokenize without the GIL
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    for (uint32_t i = 0; i < array_len(batch); i++) {
+      if (Document_Preprocess(batch[i]) != REDISMODULE_OK) {
+        batch[i]->stateFlags |= ACTX_F_ERRORED;
+      }
+    }
+    RedisModule_ThreadSafeContextLock(ctx);
+
+    // The index may have been dropped, and the hashes deleted, meanwhile. A hash changed meanwhile
+    // was queued again, and is indexed again by a later batch
+    sctx.spec = q->spec;
+    RSAddDocumentCtx *head = NULL, **tail = &head;
+    for (uint32_t i = 0; i < array_len(batch); i++) {
+      RSAddDocumentCtx *aCtx = batch[i];
+      if (!sctx.spec || (aCtx->stateFlags & ACTX_F_ERRORED) ||
+          !hashExists(ctx, aCtx->doc.docKey)) {
+        AddDocumentCtx_Finish(aCtx);
+        continue;
+      }
+      *tail = aCtx;
+      tail = &aCtx->next;
+      q->numIndexed++;
+    }
+    if (head) {
+      Indexer_AddBatch(head->indexer, head);
+    }
+    q->numBatches++;
+    AsyncIndexQueue_EndBatch(q);
+    array_clear(batch);
+
+    // let the writers in between batches
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    sched_yield();
+    RedisModule_ThreadSafeContextLock(ctx);
+  }
+
+  q->scheduled = false;
+  if (!q->spec) {
+    AsyncIndexQueue_Destroy(q);
+  }
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  RedisModule_FreeThreadSafeContext(ctx);
+  array_free(batch);
+}
+
+void AsyncIndex_Update(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key) {
+  if (!spec->asyncQueue) {
+    spec->asyncQueue = NewAsyncIndexQueue(spec);
+  }
+  AsyncIndexQueue *q = spec->asyncQueue;
+
+  // When the queue is full the writer indexes the hash itself, unless it is already queued. A hash
+  // being indexed is queued again anyway, as the batch may have loaded it before this change
+  if (AsyncIndexQueue_Size(q) >= RSGlobalConfig.asyncIndexMaxPending &&
+      !AsyncIndexQueue_Contains(q, key)) {
+    q->numSyncFallbacks++;
+    IndexSpec_UpdateWithHash(spec, ctx, key);
+    return;
+  }
+
+  AsyncIndexQueue_Push(q, key, nowMS());
+  if (!q->scheduled) {
+    if (!asyncIndexPool) {
+      asyncIndexPool = thpool_init(RSGlobalConfig.indexPoolSize);
+    }
+    q->scheduled = true;
+    thpool_add_work(asyncIndexPool, (thpool_proc)AsyncIndex_Task, q);
+  }
+}
+
+void AsyncIndex_ThreadPoolDestroy() {
+  if (asyncIndexPool != NULL) {
+    RedisModule_ThreadSafeContextUnlock(RSDummyContext);
+    thpool_destroy(asyncIndexPool);
+    asyncIndexPool = NULL;
+    RedisModule_ThreadSafeContextLock(RSDummyContext);
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef __ASYNC_INDEX_H__
+#define __ASYNC_INDEX_H__
+
+#include "redismodule.h"
+#include "util/dict.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/* The hashes waiting to be indexed by an ASYNC index.
+ *
+ * Keyspace notifications queue the key of the changed hash, once no matter how many times it
+ * changes before being indexed, instead of indexing it inside the write command. A background
+ * worker then pops the keys in batches: it loads the hashes with the GIL held, tokenizes them
+ * with the GIL released, and writes the whole batch to the index in one merged pass with the GIL
+ * held again. When the queue is full, writers index their hash themselves, which bounds both the
+ * memory of the queue and the time a change takes to become searchable.
+ *
+ * The queue is only accessed with the GIL held */
+typedef struct AsyncIndexEntry {
+  struct AsyncIndexEntry *next;
+  RedisModuleString *key;
+  // when the key was queued, in milliseconds of the monotonic clock
+  uint64_t queuedAt;
+} AsyncIndexEntry;
+
+typedef struct AsyncIndexQueue {
+  // NULL once the index is dropped, after which the worker frees the queue
+  struct IndexSpec *spec;
+  AsyncIndexEntry *head, *tail;
+  // the keys in the queue, and the keys of the batch being indexed
+  dict *pending, *indexing;
+  // the time the oldest key of the batch being indexed was queued
+  uint64_t indexingSince;
+  size_t numBatches;
+  size_t numIndexed;
+  // the number of writes indexed by the writer, because the queue was full
+  size_t numSyncFallbacks;
+  // whether a worker is scheduled or running for this queue
+  bool scheduled;
+} AsyncIndexQueue;
+
+AsyncIndexQueue *NewAsyncIndexQueue(struct IndexSpec *spec);
+
+/* Detach the queue from its index, which is being freed. The queue is freed now, or by its
+ * worker if one is running */
+void AsyncIndexQueue_Free(AsyncIndexQueue *q);
+
+/* Queue a key. Returns 0 if it is already waiting in the queue */
+int AsyncIndexQueue_Push(AsyncIndexQueue *q, RedisModuleString *key, uint64_t now);
+
+/* Pop the oldest key, adding it to the batch being indexed. The caller owns the returned string.
+ * Returns NULL if the queue is empty */
+RedisModuleString *AsyncIndexQueue_Pop(AsyncIndexQueue *q);
+
+/* Mark the batch being indexed as done */
+void AsyncIndexQueue_EndBatch(AsyncIndexQueue *q);
+
+/* Whether the key is waiting in the queue or being indexed */
+bool AsyncIndexQueue_Contains(const AsyncIndexQueue *q, RedisModuleString *key);
+
+/* The number of keys waiting in the queue or being indexed */
+size_t AsyncIndexQueue_Size(const AsyncIndexQueue *q);
+
+/* How long the oldest key not indexed yet has been waiting, in milliseconds */
+uint64_t AsyncIndexQueue_LagMS(const AsyncIndexQueue *q, uint64_t now);
+
+void AsyncIndexQueue_RenderStats(const AsyncIndexQueue *q, RedisModuleCtx *ctx);
+
+/* Index the hash in the background, or right away if the index's queue is full */
+void AsyncIndex_Update(struct IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key);
+
+void AsyncIndex_ThreadPoolDestroy();
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -242,6 +242,19 @@ CONFIG_SETTER(setForkGcRetryInterval) {
   RETURN_STATUS(acrc);
 }
 
+CONFIG_SETTER(setForkGcThreads) {
+  size_t nthreads = 0;
+  int acrc = AC_GetSize(ac, &nthreads, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (nthreads > FORK_GC_MAX_THREADS) {
+    QueryError_SetErrorFmt(status, QUERY_ELIMIT, "Fork GC threads cannot exceed %d",
+                           FORK_GC_MAX_THREADS);
+    return REDISMODULE_ERR;
+  }
+  config->forkGcThreads = nthreads;
+  return REDISMODULE_OK;
+}
+
 CONFIG_SETTER(setMaxResultsToUnsortedMode) {
   int acrc = AC_GetLongLong(ac, &config->maxResultsToUnsortedMode, AC_F_GE1);
   RETURN_STATUS(acrc);
@@ -267,6 +280,11 @@ CONFIG_GETTER(getForkGcRetryInterval) {
   return sdscatprintf(ss, "%lu", config->forkGcRetryInterval);
 }
 
+CONFIG_GETTER(getForkGcThreads) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->forkGcThreads);
+}
+
 CONFIG_GETTER(getMaxResultsToUnsortedMode) {
   sds ss = sdsempty();
   return sdscatprintf(ss, "%lld", config->maxResultsToUnsortedMode);
@@ -313,6 +331,63 @@ CONFIG_SETTER(setFilterCommand) {
 
 CONFIG_BOOLEAN_GETTER(getFilterCommand, filterCommands, 0)
 
+// FUZZY_TRANSPOSITIONS
+CONFIG_SETTER(setFuzzyTranspositions) {
+  int acrc = AC_GetInt(ac, &config->fuzzyTranspositions, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_BOOLEAN_GETTER(getFuzzyTranspositions, fuzzyTranspositions, 0)
+
+// ASYNC_INDEX_BATCH_SIZE
+CONFIG_SETTER(setAsyncIndexBatchSize) {
+  size_t size = 0;
+  int acrc = AC_GetSize(ac, &size, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (size > ASYNC_INDEX_MAX_BATCH_SIZE) {
+    QueryError_SetErrorFmt(status, QUERY_ELIMIT, "Async index batch size cannot exceed %d",
+                           ASYNC_INDEX_MAX_BATCH_SIZE);
+    return REDISMODULE_ERR;
+  }
+  config->asyncIndexBatchSize = size;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getAsyncIndexBatchSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->asyncIndexBatchSize);
+}
+
+// ASYNC_INDEX_MAX_PENDING
+CONFIG_SETTER(setAsyncIndexMaxPending) {
+  int acrc = AC_GetSize(ac, &config->asyncIndexMaxPending, AC_F_GE1);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getAsyncIndexMaxPending) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->asyncIndexMaxPending);
+}
+
+// TERM_CACHE_SIZE
+CONFIG_SETTER(setTermCacheSize) {
+  size_t size = 0;
+  int acrc = AC_GetSize(ac, &size, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (size > TERM_CACHE_MAX_SIZE) {
+    QueryError_SetErrorFmt(status, QUERY_ELIMIT, "Term cache size cannot exceed %d",
+                           TERM_CACHE_MAX_SIZE);
+    return REDISMODULE_ERR;
+  }
+  config->termCacheSize = size;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTermCacheSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->termCacheSize);
+}
+
 RSConfig RSGlobalConfig = RS_DEFAULT_CONFIG;
 
 static RSConfigVar *findConfigVar(const RSConfigOptions *config, const char *name) {
@@ -462,6 +537,11 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "interval (in seconds) in which to retry running the forkgc after failure.",
          .setValue = setForkGcRetryInterval,
          .getValue = getForkGcRetryInterval},
+        {.name = "FORK_GC_THREADS",
+         .helpText = "number of threads the fork gc process uses to clean the inverted indexes "
+                     "(relevant only when fork gc is used)",
+         .setValue = setForkGcThreads,
+         .getValue = getForkGcThreads},
         {.name = "_MAX_RESULTS_TO_UNSORTED_MODE",
          .helpText = "max results for union interator in which the interator will switch to "
                      "unsorted mode, should be used for debug only.",
@@ -482,6 +562,23 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setFilterCommand,
          .getValue = getFilterCommand,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "FUZZY_TRANSPOSITIONS",
+         .helpText = "Count swapping two adjacent letters as a single edit in fuzzy matching",
+         .setValue = setFuzzyTranspositions,
+         .getValue = getFuzzyTranspositions},
+        {.name = "ASYNC_INDEX_BATCH_SIZE",
+         .helpText = "number of hashes an ASYNC index loads and writes at once",
+         .setValue = setAsyncIndexBatchSize,
+         .getValue = getAsyncIndexBatchSize},
+        {.name = "ASYNC_INDEX_MAX_PENDING",
+         .helpText = "number of hashes an ASYNC index lets wait for indexing, before writers index "
+                     "their hashes themselves",
+         .setValue = setAsyncIndexMaxPending,
+         .getValue = getAsyncIndexMaxPending},
+        {.name = "TERM_CACHE_SIZE",
+         .helpText = "number of stems and of phonetic codes each thread caches, 0 to disable",
+         .setValue = setTermCacheSize,
+         .getValue = getTermCacheSize},
         {.name = NULL}}};
 
 void RSConfigOptions_AddConfigs(RSConfigOptions *src, RSConfigOptions *dst) {
@@ -78,6 +78,8 @@ typedef struct {
   size_t forkGcCleanThreshold;
   size_t forkGcRetryInterval;
   size_t forkGcSleepBeforeExit;
+  // Number of threads the fork gc child uses to repair the inverted indexes
+  size_t forkGcThreads;
 
   // Chained configuration data
   void *chainedConfig;
@@ -87,6 +89,19 @@ typedef struct {
   int noMemPool;
 
   int filterCommands;
+
+  // Whether fuzzy matching counts swapping two adjacent letters as a single edit. Default: 0
+  int fuzzyTranspositions;
+
+  // The number of hashes an ASYNC index loads and writes at once. Default: 100
+  size_t asyncIndexBatchSize;
+  // The number of hashes an ASYNC index lets wait in its queue, before writers index their hashes
+  // themselves. Default: 100000
+  size_t asyncIndexMaxPending;
+
+  // The number of stems, and of phonetic codes, each thread caches. 0 disables the caches.
+  // Default: 1024
+  size_t termCacheSize;
 } RSConfig;
 
 typedef enum {
@@ -152,8 +167,15 @@ sds RSConfig_GetInfoString(const RSConfig *config);
 #define GC_SCANSIZE 100
 #define DEFAULT_MIN_PHONETIC_TERM_LEN 3
 #define DEFAULT_FORK_GC_RUN_INTERVAL 30
+#define DEFAULT_FORK_GC_THREADS 1
+#define FORK_GC_MAX_THREADS 64
 #define DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE 1000
 #define SEARCH_REQUEST_RESULTS_MAX 1000000
+#define DEFAULT_ASYNC_INDEX_BATCH_SIZE 100
+#define ASYNC_INDEX_MAX_BATCH_SIZE 1000
+#define DEFAULT_ASYNC_INDEX_MAX_PENDING 100000
+#define DEFAULT_TERM_CACHE_SIZE 1024
+#define TERM_CACHE_MAX_SIZE (1 << 20)
 
 // default configuration
 #define RS_DEFAULT_CONFIG                                                                         \
@@ -167,7 +189,11 @@ sds RSConfig_GetInfoString(const RSConfig *config);
     .gcPolicy = GCPolicy_Fork, .forkGcRunIntervalSec = DEFAULT_FORK_GC_RUN_INTERVAL,              \
     .forkGcSleepBeforeExit = 0, .maxResultsToUnsortedMode = DEFAULT_MAX_RESULTS_TO_UNSORTED_MODE, \
     .forkGcRetryInterval = 5, .forkGcCleanThreshold = 100, .noMemPool = 0, .filterCommands = 0,   \
-    .maxSearchResults = SEARCH_REQUEST_RESULTS_MAX,                                               \
+    .forkGcThreads = DEFAULT_FORK_GC_THREADS,                                                     \
+    .maxSearchResults = SEARCH_REQUEST_RESULTS_MAX, .fuzzyTranspositions = 0,                     \
+    .asyncIndexBatchSize = DEFAULT_ASYNC_INDEX_BATCH_SIZE,                                        \
+    .asyncIndexMaxPending = DEFAULT_ASYNC_INDEX_MAX_PENDING,                                      \
+    .termCacheSize = DEFAULT_TERM_CACHE_SIZE,                                                     \
   }
 
 #endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+#include "async_index.h"
+
+class AsyncIndexTest : public ::testing::Test {};
+
+static std::string popKey(AsyncIndexQueue *q) {
+  RedisModuleString *key = AsyncIndexQueue_Pop(q);
+  if (!key) {
+    return "";
+  }
+  std::string s = RedisModule_StringPtrLen(key, NULL);
+  RedisModule_FreeString(NULL, key);
+  return s;
+}
+
+TEST_F(AsyncIndexTest, testQueue) {
+  AsyncIndexQueue *q = NewAsyncIndexQueue(NULL);
+  ASSERT_EQ(0, AsyncIndexQueue_Size(q));
+  ASSERT_EQ(0, AsyncIndexQueue_LagMS(q, 100));
+
+  // a key is queued once, however many times it changes
+  ASSERT_TRUE(AsyncIndexQueue_Push(q, RMCK::RString("doc1"), 10));
+  ASSERT_TRUE(AsyncIndexQueue_Push(q, RMCK::RString("doc2"), 20));
+  ASSERT_FALSE(AsyncIndexQueue_Push(q, RMCK::RString("doc1"), 30));
+  ASSERT_TRUE(AsyncIndexQueue_Push(q, RMCK::RString("doc3"), 40));
+  ASSERT_EQ(3, AsyncIndexQueue_Size(q));
+  ASSERT_EQ(90, AsyncIndexQueue_LagMS(q, 100));
+
+  // keys being indexed are still counted, until the end of their batch
+  ASSERT_EQ("doc1", popKey(q));
+  ASSERT_EQ("doc2", popKey(q));
+  ASSERT_EQ(3, AsyncIndexQueue_Size(q));
+  ASSERT_EQ(90, AsyncIndexQueue_LagMS(q, 100));
+  ASSERT_TRUE(AsyncIndexQueue_Contains(q, RMCK::RString("doc1")));
+
+  // a key changed while being indexed is queued again
+  ASSERT_TRUE(AsyncIndexQueue_Push(q, RMCK::RString("doc1"), 50));
+  AsyncIndexQueue_EndBatch(q);
+  ASSERT_EQ(2, AsyncIndexQueue_Size(q));
+  ASSERT_EQ(60, AsyncIndexQueue_LagMS(q, 100));
+  ASSERT_TRUE(AsyncIndexQueue_Contains(q, RMCK::RString("doc1")));
+  ASSERT_FALSE(AsyncIndexQueue_Contains(q, RMCK::RString("doc2")));
+
+  ASSERT_EQ("doc3", popKey(q));
+  ASSERT_EQ("doc1", popKey(q));
+  ASSERT_EQ("", popKey(q));
+  AsyncIndexQueue_EndBatch(q);
+  ASSERT_EQ(0, AsyncIndexQueue_Size(q));
+  ASSERT_EQ(0, AsyncIndexQueue_LagMS(q, 100));
+
+  // the keys left in the queue are freed with it
+  ASSERT_TRUE(AsyncIndexQueue_Push(q, RMCK::RString("doc4"), 60));
+  AsyncIndexQueue_Free(q);
+}
@@ -22,6 +22,7 @@ struct TEvalCtx : ExprEval {
   }
 
   TEvalCtx(RSExpr *root_) {
+    memset(static_cast<ExprEval *>(this), 0, sizeof(ExprEval));
     err = &status_s;
     lookup = NULL;
     root = root_;
@@ -31,6 +32,7 @@ struct TEvalCtx : ExprEval {
     clear();
 
     memset(static_cast<ExprEval *>(this), 0, sizeof(ExprEval));
+    err = &status_s;
 
     root = ExprAST_Parse(s, strlen(s), &status_s);
     if (!root) {
@@ -77,6 +79,7 @@ struct TEvalCtx : ExprEval {
 
   ~TEvalCtx() {
     clear();
+    BlkAlloc_FreeAll(&stralloc, NULL, NULL, 0);
   }
 };
 
@@ -140,6 +143,35 @@ TEST_F(ExprTest, testFunction) {
   // RSValue_Print(&ctx.result());
 }
 
+TEST_F(ExprTest, testFormat) {
+  struct {
+    const char *expr;
+    const char *expected;
+  } cases[] = {
+      {"format(\"%s-%s\", \"foo\", 42)", "foo-42"},
+      {"format(\"100%% %s\", 1.5)", "100% 1.5"},
+      {"format(\"%s\", upper(\"abc\"))", "ABC"},
+      {"format(\"no args\")", "no args"},
+  };
+  for (auto &c : cases) {
+    TEvalCtx ctx(c.expr);
+    ASSERT_TRUE(ctx) << c.expr << ": " << ctx.error();
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.eval()) << c.expr << ": " << ctx.error();
+    size_t n;
+    const char *s = RSValue_StringPtrLen(&ctx.result(), &n);
+    ASSERT_EQ(c.expected, std::string(s, n));
+    // allocated on the heap, the string is freed with the value
+    ASSERT_EQ(RSString_Malloc, ctx.result().strval.stype);
+  }
+
+  const char *bad[] = {"format(\"%s\")", "format(\"%d\", 1)", "format(\"foo%\")"};
+  for (auto e : bad) {
+    TEvalCtx ctx(e);
+    ASSERT_TRUE(ctx) << e << ": " << ctx.error();
+    ASSERT_EQ(EXPR_EVAL_ERR, ctx.eval()) << e;
+  }
+}
+
 struct EvalResult {
   double rv;
   bool success;
@@ -7,6 +7,7 @@
 #include "rules.h"
 #include "query_error.h"
 #include "inverted_index.h"
+#include "redis_index.h"
 #include "rwlock.h"
 #include <set>
 
@@ -52,8 +53,11 @@ class FGCTest : public ::testing::Test {
   RMCK::Context ctx;
   IndexSpec *sp;
   ForkGC *fgc;
+  // tests may change the number of repair threads, which is restored for the next ones
+  size_t origGcThreads;
 
   void SetUp() override {
+    origGcThreads = RSGlobalConfig.forkGcThreads;
     sp = createIndex(ctx);
     RSGlobalConfig.forkGcCleanThreshold = 0;
     fgc = reinterpret_cast<ForkGC *>(sp->gc->gcCtx);
@@ -63,6 +67,7 @@ class FGCTest : public ::testing::Test {
   void TearDown() override {
     RediSearch_DropIndex(sp);
     pthread_join(thread, NULL);
+    RSGlobalConfig.forkGcThreads = origGcThreads;
   }
 
   IndexSpec *createIndex(RedisModuleCtx *ctx) {
@@ -304,3 +309,136 @@ TEST_F(FGCTest, testRemoveMiddleBlock) {
   ASSERT_NE(ss.end(), ss.find(numToDocid(lastLastBlockId)));
   ASSERT_EQ(0, fgc->stats.gcBlocksDenied);
 }
+
+/**
+ * Change a block in place after the fork. Only the repair of that block is dropped, the others are
+ * applied
+ */
+TEST_F(FGCTest, testRepairBlockChangedInPlace) {
+  unsigned curId = 0;
+  InvertedIndex *iv = getTagInvidx(ctx, sp, "f1", "hello");
+  while (iv->size < 3) {
+    ASSERT_TRUE(RS::addDocument(ctx, sp, numToDocid(curId++).c_str(), "f1", "hello"));
+  }
+  size_t numDocs = iv->numDocs;
+  // the marker goes past 32 bits with the update, as it does on an index updated for long enough
+  iv->gcMarker = UINT32_MAX;
+
+  FGC_WaitAtFork(fgc);
+  // doc0 and doc150 are in the first and second blocks
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "doc0"));
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "doc150"));
+  FGC_WaitAtApply(fgc);
+
+  // an in-place update of doc1 removes its record from the first block
+  ASSERT_TRUE(InvertedIndex_DeleteEntry(iv, 2));
+  FGC_WaitClear(fgc);
+
+  ASSERT_EQ(1, fgc->stats.gcBlocksDenied);
+  ASSERT_EQ(3, iv->size);
+  // doc0 is left for the next run
+  ASSERT_EQ(99, iv->blocks[0].numDocs);
+  ASSERT_EQ(1, iv->blocks[0].firstId);
+  ASSERT_EQ(99, iv->blocks[1].numDocs);
+  ASSERT_EQ(numDocs - 2, iv->numDocs);
+}
+
+/**
+ * Split a block by inserting a record in place after the fork. The blocks after it move, so the
+ * whole repair of the index is dropped
+ */
+TEST_F(FGCTest, testRepairBlockSplitInPlace) {
+  unsigned curId = 0;
+  InvertedIndex *iv = getTagInvidx(ctx, sp, "f1", "hello");
+  // the documents of the tag have every other id
+  while (iv->size < 4) {
+    std::string id = numToDocid(curId++);
+    ASSERT_TRUE(RS::addDocument(ctx, sp, id.c_str(), "f1", curId % 2 ? "hello" : "world"));
+  }
+  size_t numDocs = iv->numDocs;
+  ASSERT_EQ(100, iv->blocks[0].numDocs);
+
+  FGC_WaitAtFork(fgc);
+  // doc0 and doc400 are in the first and third blocks
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "doc0"));
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "doc400"));
+  FGC_WaitAtApply(fgc);
+
+  // an in-place update of doc1 adds its record to the first block, which is full
+  RSIndexResult rec = {.type = RSResultType_Virtual};
+  ASSERT_LT(0, InvertedIndex_InsertEntry(iv, InvertedIndex_GetEncoder(Index_DocIdsOnly), 2, &rec));
+  ASSERT_EQ(5, iv->size);
+  FGC_WaitClear(fgc);
+
+  ASSERT_EQ(2, fgc->stats.gcBlocksDenied);
+  ASSERT_EQ(5, iv->size);
+  ASSERT_EQ(100, iv->blocks[3].numDocs);
+  ASSERT_EQ(numDocs + 1, iv->numDocs);
+  ASSERT_EQ(1, iv->blocks[0].firstId);
+  ASSERT_EQ(51, iv->blocks[0].numDocs);
+}
+
+/**
+ * Repair many inverted indexes using several threads in the child, and make
+ * sure the results are applied to the right indexes.
+ */
+TEST_F(FGCTest, testRepairMultithreaded) {
+  RSGlobalConfig.forkGcThreads = 4;
+
+  // More values than fit in a single batch of the child
+  const unsigned nvalues = 1500;
+  char buf[1024];
+  for (unsigned ii = 0; ii < nvalues * 2; ++ii) {
+    sprintf(buf, "val%u", ii % nvalues);
+    ASSERT_TRUE(RS::addDocument(ctx, sp, numToDocid(ii).c_str(), "f1", buf));
+  }
+
+  FGC_WaitAtFork(fgc);
+  // Delete one of the two documents of every other value
+  for (unsigned ii = 0; ii < nvalues; ii += 2) {
+    ASSERT_TRUE(RS::deleteDocument(ctx, sp, numToDocid(ii).c_str()));
+  }
+  FGC_WaitAtApply(fgc);
+  FGC_WaitClear(fgc);
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisModuleString *fmtkey = IndexSpec_GetFormattedKeyByName(sp, "f1", INDEXFLD_T_TAG);
+  auto tix = TagIndex_Open(&sctx, fmtkey, 0, NULL);
+  for (unsigned ii = 0; ii < nvalues; ++ii) {
+    sprintf(buf, "val%u", ii);
+    auto iv = TagIndex_OpenIndex(tix, buf, strlen(buf), 0);
+    ASSERT_TRUE(iv != NULL);
+    ASSERT_EQ(ii % 2 ? 2 : 1, iv->numDocs) << buf;
+  }
+  ASSERT_EQ(nvalues * 2 - nvalues / 2, sp->stats.numRecords);
+}
+
+TEST_F(FGCTest, testFieldPostings) {
+  sp->flags = (IndexFlags)(sp->flags | Index_FieldPostings);
+  RediSearch_CreateField(sp, "t1", RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(sp, "t2", RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  const FieldSpec *t2 = IndexSpec_GetField(sp, "t2", strlen("t2"));
+
+  char buf[1024];
+  for (unsigned ii = 0; ii < 10; ++ii) {
+    sprintf(buf, "fpdoc%u", ii);
+    ASSERT_TRUE(RS::addDocument(ctx, sp, buf, ii % 2 ? "t1" : "t2", "hello"));
+  }
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  auto iv = Redis_OpenFieldInvertedIndexEx(&sctx, "hello", strlen("hello"), t2->ftId, 0, NULL);
+  ASSERT_TRUE(iv != NULL);
+  ASSERT_EQ(5, iv->numDocs);
+  size_t numRecords = sp->stats.numRecords;
+
+  FGC_WaitAtFork(fgc);
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "fpdoc0"));
+  ASSERT_TRUE(RS::deleteDocument(ctx, sp, "fpdoc1"));
+  FGC_WaitAtApply(fgc);
+  FGC_WaitClear(fgc);
+
+  ASSERT_EQ(4, iv->numDocs);
+  ASSERT_EQ(8, Redis_OpenInvertedIndex(&sctx, "hello", strlen("hello"), 0)->numDocs);
+  // Only the records of the term's main index are accounted for
+  ASSERT_EQ(numRecords - 2, sp->stats.numRecords);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+extern "C" {
+#include "cndict_loader.h"
+}
+#include <string>
+#include <vector>
+
+class FrisoTest : public ::testing::Test {
+ protected:
+  static friso_t friso;
+  static friso_config_t config;
+
+  // the built-in dictionary, configured as by the Chinese tokenizer
+  static void SetUpTestCase() {
+    friso = friso_new();
+    config = friso_new_config();
+    friso_dic_t dic = friso_dic_new();
+    ChineseDictLoad(dic);
+    ChineseDictConfigure(friso, config);
+    friso_set_dic(friso, dic);
+    config->en_sseg = 0;
+    friso_dic_compile(friso);
+  }
+
+  static void TearDownTestCase() {
+    friso_free(friso);
+    friso_free_config(config);
+  }
+};
+
+friso_t FrisoTest::friso;
+friso_config_t FrisoTest::config;
+
+static std::vector<std::string> segment(friso_t friso, friso_config_t config,
+                                        const std::string &text) {
+  std::vector<char> buf(text.begin(), text.end());
+  buf.push_back('\0');
+  friso_task_t task = friso_new_task();
+  friso_set_text(task, &buf[0]);
+  std::vector<std::string> tokens;
+  friso_token_t tok;
+  while ((tok = config->next_token(friso, config, task))) {
+    tokens.push_back(std::string(tok->word, tok->length) + "/" + std::to_string(tok->type) + "/" +
+                     std::to_string(tok->offset) + "/" + std::to_string(tok->rlen));
+  }
+  friso_free_task(task);
+  return tokens;
+}
+
+static std::string utf8(unsigned cp) {
+  char buf[8] = {0};
+  unicode_to_utf8(cp, buf);
+  return buf;
+}
+
+TEST_F(FrisoTest, testTrie) {
+  // the trie holds exactly the CJK words of the dictionary, with their entries
+  friso_hash_t words = friso->dic[__LEX_CJK_WORDS__];
+  size_t n = 0;
+  for (uint_t i = 0; i < words->length; i++) {
+    for (hash_entry_t e = words->table[i]; e; e = e->_next) {
+      int node = dat_walk(friso->cjk_dat, DAT_ROOT, e->_key);
+      ASSERT_GE(node, 0) << e->_key;
+      ASSERT_EQ(e->_val, dat_get_value(friso->cjk_dat, node)) << e->_key;
+      n++;
+    }
+  }
+  ASSERT_EQ(words->size, n);
+
+  srand(46);
+  for (size_t i = 0; i < 10000; i++) {
+    std::string s;
+    for (size_t j = 0, len = 1 + rand() % 4; j < len; j++) {
+      s += utf8(0x4E00 + rand() % (0x9FA5 - 0x4E00));
+    }
+    int node = dat_walk(friso->cjk_dat, DAT_ROOT, s.c_str());
+    void *value = node < 0 ? NULL : dat_get_value(friso->cjk_dat, node);
+    ASSERT_EQ(hash_get_value(words, (char *)s.c_str()), value) << s;
+  }
+}
+
+TEST_F(FrisoTest, testSegmentationParity) {
+  // the segmentation walking the trie splits any text as friso does with its hash tables
+  friso_entry plain = *friso;
+  plain.cjk_dat = NULL;
+
+  std::vector<std::string> words;
+  friso_hash_t dic = friso->dic[__LEX_CJK_WORDS__];
+  for (uint_t i = 0; i < dic->length; i++) {
+    for (hash_entry_t e = dic->table[i]; e; e = e->_next) {
+      words.push_back(e->_key);
+    }
+  }
+  static const char *pieces[] = {" ",  "，", "。",  "、", "！", "“",  "”",  "：",  "redis",
+                                 "OK", "3",  "38.6", "℃",  "@",  "ｏｋ", "Ａ", "\\",  "\n",
+                                 "卡拉", "高",  "於",   "說",  "張三", "x射线"};
+
+  std::vector<std::string> texts = {
+      "太初，上帝创造了天地。 那时，大地空虚混沌，还没有成形，黑暗笼罩着深渊，上帝的灵运行在水面上。",
+      "太初，上帝創造了天地。 那時，大地空虛混沌，還沒有成形，黑暗籠罩著深淵，上帝的靈運行在水面上。",
+      "Redis支持主从同步。数据可以从主服务器向任意数量的从服务器上同步，从服务器可以是关联其他从服务器的"
+      "主服务器。",
+      "2009年８月６日开始大学之旅，岳阳今天的气温为38.6℃, 也就是101.48℉",
+  };
+  srand(45);
+  for (size_t i = 0; i < 2000; i++) {
+    std::string text;
+    for (size_t j = 0, n = rand() % 60; j < n; j++) {
+      size_t r = rand() % 10;
+      if (r < 6) {
+        text += words[rand() % words.size()];
+      } else if (r < 8) {
+        text += utf8(0x4E00 + rand() % (0x9FA5 - 0x4E00));
+      } else {
+        text += pieces[rand() % (sizeof(pieces) / sizeof(*pieces))];
+      }
+    }
+    texts.push_back(text);
+  }
+
+  for (const std::string &text : texts) {
+    ASSERT_EQ(segment(&plain, config, text), segment(friso, config, text)) << text;
+  }
+}
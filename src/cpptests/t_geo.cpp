@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "geo_index.h"
+#include "index.h"
+#include "inverted_index.h"
+#include "redisearch_api.h"
+#include "aggregate/aggregate.h"
+#include "common.h"
+
+#include <algorithm>
+#include <vector>
+
+class GeoTest : public ::testing::Test {};
+
+static const GeoCoverRange *findRange(const GeoCoverRange *ranges, size_t n, double score) {
+  for (size_t i = 0; i < n; ++i) {
+    if (score >= ranges[i].range.min && score < ranges[i].range.max) {
+      return ranges + i;
+    }
+  }
+  return NULL;
+}
+
+TEST_F(GeoTest, testCovering) {
+  struct {
+    double lon, lat, radius;
+  } circles[] = {
+      {-0.1757, 51.5156, 1000},  {-73.9857, 40.7484, 25000}, {139.6917, 35.6895, 300},
+      {179.99, 0, 50000},        {12.4964, 41.9028, 2000000}, {-58.3816, -34.6037, 10},
+  };
+  srand(1337);
+
+  for (auto &c : circles) {
+    GeoCoverRange ranges[GEO_COVER_MAX_RANGES];
+    size_t n = calcCovering(c.lon, c.lat, c.radius, ranges);
+    ASSERT_GT(n, 0);
+    ASSERT_LE(n, GEO_COVER_MAX_RANGES);
+    for (size_t i = 1; i < n; ++i) {
+      ASSERT_LE(ranges[i - 1].range.max, ranges[i].range.min);
+    }
+
+    // sample points around the center, both inside and outside of the radius
+    double span = 2.5 * c.radius / 111000;
+    size_t inside = 0, interiorHits = 0;
+    for (int i = 0; i < 20000; ++i) {
+      double lon = c.lon + span * (2.0 * rand() / RAND_MAX - 1);
+      double lat = c.lat + span * (2.0 * rand() / RAND_MAX - 1);
+      if (lon < -180 || lon > 180 || lat < -85 || lat > 85) {
+        continue;
+      }
+      double score = calcGeoHash(lon, lat);
+      double xy[2];
+      decodeGeo(score, xy);
+      double dist;
+      bool within = isWithinRadiusLonLat(c.lon, c.lat, xy[0], xy[1], c.radius, &dist);
+
+      const GeoCoverRange *r = findRange(ranges, n, score);
+      if (within) {
+        ASSERT_TRUE(r != NULL) << "point " << lon << "," << lat << " is not covered";
+        inside++;
+      }
+      if (r && r->interior) {
+        interiorHits++;
+        ASSERT_TRUE(within) << "point " << lon << "," << lat << " at " << dist
+                            << "m is in an interior range";
+      }
+    }
+    ASSERT_GT(inside, 0);
+    // a good part of the points within the radius need no distance check
+    ASSERT_GT(interiorHits, inside / 3) << c.lon << "," << c.lat << " " << n << " ranges";
+  }
+}
+
+TEST_F(GeoTest, testCoveringLarge) {
+  // radii of thousands of kilometers make cells spanning tens of degrees, far from the center
+  struct {
+    double lon, lat, radius;
+  } circles[] = {
+      {30, 60, 9000000}, {-100, 10, 12000000}, {170, -45, 15000000}, {0, 0, 19000000},
+  };
+  srand(31);
+
+  for (auto &c : circles) {
+    GeoCoverRange ranges[GEO_COVER_MAX_RANGES];
+    size_t n = calcCovering(c.lon, c.lat, c.radius, ranges);
+    ASSERT_GT(n, 0);
+    for (int i = 0; i < 50000; ++i) {
+      double lon = 360.0 * rand() / RAND_MAX - 180;
+      double lat = 170.0 * rand() / RAND_MAX - 85;
+      double score = calcGeoHash(lon, lat);
+      double xy[2];
+      decodeGeo(score, xy);
+      double dist;
+      bool within = isWithinRadiusLonLat(c.lon, c.lat, xy[0], xy[1], c.radius, &dist);
+
+      const GeoCoverRange *r = findRange(ranges, n, score);
+      if (within) {
+        ASSERT_TRUE(r != NULL) << "point " << lon << "," << lat << " is not covered";
+      }
+      if (r && r->interior) {
+        ASSERT_TRUE(within) << "point " << lon << "," << lat << " at " << dist
+                            << "m is in an interior range";
+      }
+    }
+  }
+}
+
+static std::vector<t_docId> readKnn(RedisSearchCtx *sctx, const GeoFilter *gf, IndexIterator *child,
+                                    std::vector<double> *distances) {
+  IndexIterator *it = NewGeoKnnIterator(sctx, gf, child);
+  std::vector<t_docId> ids;
+  RSIndexResult *r;
+  while (it->Read(it->ctx, &r) == INDEXREAD_OK) {
+    if (!ids.empty()) {
+      EXPECT_LT(ids.back(), r->docId);
+    }
+    ids.push_back(r->docId);
+    distances->push_back(r->num.value);
+  }
+  it->Free(it);
+  return ids;
+}
+
+TEST_F(GeoTest, testKnn) {
+  RMCK::Context ctx;
+  RSIndex *index = RediSearch_CreateIndex("geoknn", NULL);
+  RediSearch_CreateGeoField(index, "loc");
+
+  const double lon = 2.3522, lat = 48.8566;
+  const size_t N = 500;
+  std::vector<std::pair<double, t_docId>> byDistance;
+  srand(7);
+  for (size_t i = 0; i < N; ++i) {
+    // spread the points over a few hundred kilometers, denser towards the center
+    double d = pow(1.0 * rand() / RAND_MAX, 2) * 3;
+    double plon = lon + d * (2.0 * rand() / RAND_MAX - 1);
+    double plat = lat + d * (2.0 * rand() / RAND_MAX - 1);
+    char key[32], val[64];
+    sprintf(key, "doc%zu", i);
+    sprintf(val, "%.6f,%.6f", plon, plat);
+    sscanf(val, "%lf,%lf", &plon, &plat);
+    RSDoc *doc = RediSearch_CreateDocumentSimple(key);
+    RediSearch_DocumentAddFieldCString(doc, "loc", val, RSFLDTYPE_GEO);
+    ASSERT_EQ(REDISMODULE_OK, RediSearch_SpecAddDocument(index, doc));
+
+    double xy[2], dist;
+    decodeGeo(calcGeoHash(plon, plat), xy);
+    isWithinRadiusLonLat(lon, lat, xy[0], xy[1], 1e8, &dist);
+    byDistance.push_back({dist, i + 1});
+  }
+  std::sort(byDistance.begin(), byDistance.end());
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, index);
+  GeoFilter *gf = NewGeoFilter(lon, lat, 0, "km");
+  gf->property = rm_strdup("loc");
+
+  for (size_t k : {(size_t)1, (size_t)10, (size_t)77, N, N + 10}) {
+    gf->knn = k;
+    std::vector<double> distances;
+    auto ids = readKnn(&sctx, gf, NewWildcardIterator(N), &distances);
+    ASSERT_EQ(std::min(k, N), ids.size());
+
+    std::vector<t_docId> expected;
+    for (size_t i = 0; i < ids.size(); ++i) {
+      expected.push_back(byDistance[i].second);
+    }
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(expected, ids) << "k=" << k;
+    for (size_t i = 0; i < ids.size(); ++i) {
+      auto pos = std::find_if(byDistance.begin(), byDistance.end(),
+                              [&](const std::pair<double, t_docId> &p) { return p.second == ids[i]; });
+      ASSERT_NEAR(pos->first / 1000, distances[i], 1e-6);
+    }
+  }
+
+  // only the documents matching the query are considered
+  t_docId odd[N / 2];
+  for (size_t i = 0; i < N / 2; ++i) {
+    odd[i] = 2 * i + 1;
+  }
+  gf->knn = 20;
+  std::vector<t_docId> expected;
+  for (size_t i = 0; i < N && expected.size() < 20; ++i) {
+    if (byDistance[i].second % 2) {
+      expected.push_back(byDistance[i].second);
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // an id list lands at or before the id skipped to, an index reader moves on to its next match
+  InvertedIndex *oddIdx = NewInvertedIndex(Index_StoreNumeric, 1);
+  for (size_t i = 0; i < N / 2; ++i) {
+    InvertedIndex_WriteNumericEntry(oddIdx, odd[i], 1);
+  }
+  for (bool reader : {false, true}) {
+    IndexIterator *child = reader ? NewReadIterator(NewNumericReader(NULL, oddIdx, NULL))
+                                  : NewIdListIterator(odd, N / 2, 1);
+    std::vector<double> distances;
+    auto ids = readKnn(&sctx, gf, child, &distances);
+    ASSERT_EQ(expected, ids) << "reader=" << reader;
+  }
+  InvertedIndex_Free(oddIdx);
+
+  GeoFilter_Free(gf);
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(GeoTest, testKnnScores) {
+  RMCK::Context ctx;
+  RSIndex *index = RediSearch_CreateIndex("geoknnscores", NULL);
+  RediSearch_CreateGeoField(index, "loc");
+  for (size_t i = 0; i < 50; ++i) {
+    char key[32], val[64];
+    sprintf(key, "doc%zu", i);
+    sprintf(val, "%.6f,%.6f", 2.35 + 0.01 * i, 48.85);
+    RSDoc *doc = RediSearch_CreateDocumentSimple(key);
+    RediSearch_DocumentAddFieldCString(doc, "loc", val, RSFLDTYPE_GEO);
+    ASSERT_EQ(REDISMODULE_OK, RediSearch_SpecAddDocument(index, doc));
+  }
+
+  // the score of each result is its distance, as there is no scorer for nearest neighbours
+  QueryError err = {QUERY_OK};
+  AREQ *req = AREQ_New();
+  req->reqflags |= QEXEC_F_IS_SEARCH;
+  RMCK::ArgvList args(ctx, "*", "GEOKNN", "loc", "2.35", "48.85", "5", "km", "NOCONTENT",
+                      "WITHSCORES");
+  ASSERT_EQ(REDISMODULE_OK, AREQ_Compile(req, args, args.size(), &err))
+      << QueryError_GetError(&err);
+  RedisSearchCtx *sctx = (RedisSearchCtx *)rm_malloc(sizeof(*sctx));
+  *sctx = (RedisSearchCtx)SEARCH_CTX_STATIC(ctx, index);
+  ASSERT_EQ(REDISMODULE_OK, AREQ_ApplyContext(req, sctx, &err)) << QueryError_GetError(&err);
+  ASSERT_EQ(REDISMODULE_OK, AREQ_BuildPipeline(req, 0, &err)) << QueryError_GetError(&err);
+
+  ResultProcessor *rp = AREQ_RP(req);
+  RLookup *lk = AGPLN_GetLookup(&req->ap, NULL, AGPLN_GETLOOKUP_LAST);
+  const RLookupKey *distanceKey = RLookup_GetKey(lk, "__loc_distance", RLOOKUP_F_NOINCREF);
+  ASSERT_TRUE(distanceKey != NULL);
+  SearchResult res = {0};
+  std::vector<t_docId> ids;
+  int rc;
+  while ((rc = rp->Next(rp, &res)) == RS_RESULT_OK) {
+    double distance;
+    ASSERT_TRUE(RSValue_ToNumber(RLookup_GetItem(distanceKey, &res.rowdata), &distance));
+    // the points are about 733m apart
+    ASSERT_NEAR(0.733 * ids.size(), res.score, 0.01) << res.docId;
+    ASSERT_EQ(distance, res.score);
+    ids.push_back(res.docId);
+    SearchResult_Clear(&res);
+  }
+  ASSERT_EQ(RS_RESULT_EOF, rc);
+  ASSERT_EQ(std::vector<t_docId>({1, 2, 3, 4, 5}), ids);
+
+  SearchResult_Destroy(&res);
+  AREQ_Free(req);
+  RediSearch_DropIndex(index);
+}
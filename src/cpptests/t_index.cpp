@@ -1,6 +1,7 @@
 #include "../buffer.h"
 #include "../index.h"
 #include "../inverted_index.h"
+#include "../redis_index.h"
 #include "../index_result.h"
 #include "../query_parser/tokenizer.h"
 #include "../rmutil/alloc.h"
@@ -14,6 +15,7 @@
 #include <time.h>
 #include <float.h>
 #include <gtest/gtest.h>
+#include <map>
 #include <vector>
 #include <cstdint>
 
@@ -489,6 +491,135 @@ TEST_F(IndexTest, testNumericVaried) {
   it->Free(it);
 }
 
+TEST_F(IndexTest, testNumericBlockBounds) {
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  for (int i = 0; i < 1000; i++) {
+    // values decrease within each block, so both bounds are updated
+    InvertedIndex_WriteNumericEntry(idx, i + 1, (double)((i / 100) * 100 + 99 - i % 100));
+  }
+  ASSERT_EQ(10, idx->size);
+  for (int i = 0; i < idx->size; i++) {
+    ASSERT_EQ(i * 100, idx->blocks[i].minValue);
+    ASSERT_EQ(i * 100 + 99, idx->blocks[i].maxValue);
+  }
+
+  // blocks 0, 1 and 5-9 are skipped, block 3 is accepted and blocks 2 and 4 are filtered
+  NumericFilter *flt = NewNumericFilter(250, 450, 1, 0);
+  IndexReader *ir = NewNumericReader(NULL, idx, flt);
+  RSIndexResult *res;
+  size_t n = 0;
+  while (INDEXREAD_EOF != IR_Read(ir, &res)) {
+    ASSERT_TRUE(res->num.value >= 250 && res->num.value < 450) << res->num.value;
+    ASSERT_EQ(res->num.value, (res->docId - 1) / 100 * 100 + 99 - (res->docId - 1) % 100);
+    n++;
+  }
+  ASSERT_EQ(200, n);
+  IR_Free(ir);
+
+  ir = NewNumericReader(NULL, idx, flt);
+  ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, 10, &res));
+  ASSERT_EQ(201, res->docId);
+  ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 350, &res));
+  ASSERT_EQ(INDEXREAD_NOTFOUND, IR_SkipTo(ir, 420, &res));
+  ASSERT_EQ(451, res->docId);
+  ASSERT_EQ(449, res->num.value);
+  ASSERT_EQ(INDEXREAD_EOF, IR_SkipTo(ir, 600, &res));
+  IR_Free(ir);
+
+  NumericFilter_Free(flt);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testNumericInsertDelete) {
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  std::map<t_docId, double> values;
+  for (t_docId i = 2; i <= 1000; i += 2) {
+    InvertedIndex_WriteNumericEntry(idx, i, (double)i);
+    values[i] = i;
+  }
+  size_t nblocks = idx->size;
+  uint64_t gcMarker = idx->gcMarker;
+
+  // records of older documents go in the middle of the blocks, and before the first one
+  for (t_docId i = 1; i <= 999; i += 6) {
+    ASSERT_GT(InvertedIndex_WriteNumericEntry(idx, i, -(double)i), 0);
+    ASSERT_EQ(0, InvertedIndex_WriteNumericEntry(idx, i, 0));
+    values[i] = -(double)i;
+  }
+  for (t_docId i = 4; i <= 1000; i += 8) {
+    ASSERT_TRUE(InvertedIndex_DeleteEntry(idx, i));
+    ASSERT_FALSE(InvertedIndex_DeleteEntry(idx, i));
+    values.erase(i);
+  }
+  ASSERT_FALSE(InvertedIndex_DeleteEntry(idx, 3));
+  ASSERT_FALSE(InvertedIndex_DeleteEntry(idx, 5000));
+  // the blocks grown past their size were split
+  ASSERT_LT(nblocks, idx->size);
+  for (uint32_t i = 0; i < idx->size; i++) {
+    ASSERT_LE(idx->blocks[i].numDocs, 100);
+  }
+  ASSERT_NE(gcMarker, idx->gcMarker);
+  ASSERT_EQ(values.size(), idx->numDocs);
+  ASSERT_EQ(1000, idx->lastId);
+
+  // the blocks' bounds follow their records
+  IndexReader *ir = NewNumericReader(NULL, idx, NULL);
+  RSIndexResult *res;
+  auto expected = values.begin();
+  while (INDEXREAD_EOF != IR_Read(ir, &res)) {
+    ASSERT_NE(values.end(), expected);
+    ASSERT_EQ(expected->first, res->docId);
+    ASSERT_EQ(expected->second, res->num.value);
+    const IndexBlock *blk = &idx->blocks[ir->currentBlock];
+    ASSERT_TRUE(blk->firstId <= res->docId && res->docId <= blk->lastId);
+    ASSERT_TRUE(blk->minValue <= res->num.value && res->num.value <= blk->maxValue);
+    ++expected;
+  }
+  ASSERT_EQ(values.end(), expected);
+  IR_Free(ir);
+
+  // removing the last records moves the index's last id back
+  ASSERT_TRUE(InvertedIndex_DeleteEntry(idx, 1000));
+  ASSERT_TRUE(InvertedIndex_DeleteEntry(idx, 998));
+  ASSERT_EQ(997, idx->lastId);
+  ASSERT_GT(InvertedIndex_WriteNumericEntry(idx, 1001, 1), 0);
+  ASSERT_EQ(1001, idx->lastId);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testNumericInsertSplit) {
+  // a single block over a sparse range of ids takes more records than a block can count
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, 1);
+  const t_docId lastId = 1000000, numInserted = 70000;
+  InvertedIndex_WriteNumericEntry(idx, 1, 1);
+  InvertedIndex_WriteNumericEntry(idx, lastId, 1);
+  ASSERT_EQ(1, idx->size);
+  for (t_docId i = numInserted + 1; i > 1; i--) {
+    ASSERT_GT(InvertedIndex_WriteNumericEntry(idx, i, (double)i), 0);
+  }
+  ASSERT_EQ(numInserted + 2, idx->numDocs);
+  ASSERT_EQ(lastId, idx->lastId);
+
+  size_t numDocs = 0;
+  for (uint32_t i = 0; i < idx->size; i++) {
+    ASSERT_LE(idx->blocks[i].numDocs, 100);
+    ASSERT_GT(idx->blocks[i].numDocs, 0);
+    numDocs += idx->blocks[i].numDocs;
+  }
+  ASSERT_EQ(idx->numDocs, numDocs);
+
+  IndexReader *ir = NewNumericReader(NULL, idx, NULL);
+  RSIndexResult *res;
+  t_docId expected = 1;
+  while (INDEXREAD_EOF != IR_Read(ir, &res)) {
+    ASSERT_EQ(expected, res->docId);
+    expected = expected == numInserted + 1 ? lastId : expected + 1;
+  }
+  ASSERT_EQ(lastId + 1, expected);
+  IR_Free(ir);
+  InvertedIndex_Free(idx);
+}
+
 typedef struct {
   double value;
   size_t size;
@@ -945,6 +1076,93 @@ TEST_F(IndexTest, testIndexFlags) {
   VVW_Free(h.vw);
 }
 
+static void checkSplitRecord(const RSIndexResult *h) {
+  RSOffsetIterator it = RSOffsetVector_Iterate(&h->term.offsets, NULL);
+  uint32_t n, count = 0;
+  while (RS_OFFSETVECTOR_EOF != (n = it.Next(it.ctx, NULL))) {
+    ASSERT_EQ(h->docId + count, n);
+    ++count;
+  }
+  it.Free(it.ctx);
+  ASSERT_EQ(h->docId % 4, count) << "docId " << h->docId;
+}
+
+TEST_F(IndexTest, testSplitPositions) {
+  const int offsetFlags[] = {
+      INDEX_DEFAULT_FLAGS,
+      INDEX_DEFAULT_FLAGS | Index_WideSchema,
+      Index_StoreTermOffsets,
+      Index_StoreTermOffsets | Index_StoreFreqs,
+      Index_StoreTermOffsets | Index_StoreFieldFlags,
+      Index_StoreTermOffsets | Index_StoreFieldFlags | Index_WideSchema,
+  };
+  const int N = 300;
+  char buf[16];
+
+  for (int flags : offsetFlags) {
+    DocTable dt = NewDocTable(10, 1000);
+    InvertedIndex *idx = NewInvertedIndex(InvertedIndex_TermFlags((IndexFlags)flags), 1);
+    ASSERT_TRUE(idx->flags & Index_SplitPositions);
+    IndexEncoder enc = InvertedIndex_GetEncoder(idx->flags);
+
+    for (int i = 0; i < N; i++) {
+      size_t nkey = sprintf(buf, "doc_%d", i);
+      ForwardIndexEntry h = {0};
+      h.docId = DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0);
+      h.fieldMask = 1;
+      h.freq = 1;
+      h.vw = NewVarintVectorWriter(8);
+      for (int n = 0; n < h.docId % 4; n++) {
+        VVW_Write(h.vw, h.docId + n);
+      }
+      InvertedIndex_WriteForwardIndexEntry(idx, enc, &h);
+      VVW_Free(h.vw);
+    }
+    ASSERT_LT(0, IndexBlock_PosLen(&idx->blocks[0]));
+
+    IndexReader *ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    RSIndexResult *h = NULL;
+    t_docId expected = 1;
+    while (IR_Read(ir, &h) != INDEXREAD_EOF) {
+      ASSERT_EQ(expected++, h->docId);
+      checkSplitRecord(h);
+    }
+    ASSERT_EQ(N + 1, expected);
+
+    IR_Free(ir);
+
+    // Skipping over records skips over their positions as well
+    ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 150, &h));
+    checkSplitRecord(h);
+    ASSERT_EQ(INDEXREAD_OK, IR_SkipTo(ir, 299, &h));
+    checkSplitRecord(h);
+    IR_Free(ir);
+
+    // Repairing a block keeps the positions of the remaining records
+    for (int i = 0; i < N; i += 2) {
+      size_t nkey = sprintf(buf, "doc_%d", i);
+      ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+    }
+    IndexRepairParams params = {0};
+    InvertedIndex_Repair(idx, &dt, 0, &params);
+    ASSERT_EQ(N / 2, params.docsCollected);
+
+    ir = NewTermIndexReader(idx, NULL, RS_FIELDMASK_ALL, NULL, 1);
+    expected = 2;
+    while (IR_Read(ir, &h) != INDEXREAD_EOF) {
+      ASSERT_EQ(expected, h->docId);
+      checkSplitRecord(h);
+      expected += 2;
+    }
+    ASSERT_EQ(N + 2, expected);
+    IR_Free(ir);
+
+    InvertedIndex_Free(idx);
+    DocTable_Free(&dt);
+  }
+}
+
 TEST_F(IndexTest, testDocTable) {
   char buf[16];
   DocTable dt = NewDocTable(10, 10);
@@ -3,6 +3,11 @@
 #include <set>
 #include <string>
 #include "common.h"
+#include "spec.h"
+#include "suffix_index.h"
+#include "query_node.h"
+#include "document.h"
+#include "indexer.h"
 
 #define DOCID1 "doc1"
 #define DOCID2 "doc2"
@@ -745,4 +750,176 @@ TEST_F(LLApiTest, duplicateFieldAdd) {
 
   RediSearch_FreeDocument(d);
   RediSearch_DropIndex(index);
-}
\ No newline at end of file
+}
+
+TEST_F(LLApiTest, testFieldPostings) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  index->flags = (IndexFlags)(index->flags | Index_FieldPostings);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, FIELD_NAME_2, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+
+  Document* d = RediSearch_CreateDocumentSimple(DOCID1);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "hello world", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_2, "foo", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+  d = RediSearch_CreateDocumentSimple(DOCID2);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "foo", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_2, "hello world", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+
+  // the per-field postings do not count as records
+  ASSERT_EQ(6, index->stats.numRecords);
+
+  auto res = search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_1, "hello"));
+  ASSERT_EQ(std::vector<std::string>({DOCID1}), res);
+  res = search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_2, "hello"));
+  ASSERT_EQ(std::vector<std::string>({DOCID2}), res);
+  res = search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_2, "foo"));
+  ASSERT_EQ(std::vector<std::string>({DOCID1}), res);
+  res = search(index, RediSearch_CreateTokenNode(index, NULL, "hello"));
+  ASSERT_EQ(std::vector<std::string>({DOCID1, DOCID2}), res);
+  ASSERT_TRUE(search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_1, "nothere")).empty());
+
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(LLApiTest, testPrefixIndex) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, FIELD_NAME_2, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  ((FieldSpec*)IndexSpec_GetField(index, FIELD_NAME_1, strlen(FIELD_NAME_1)))->prefixIndexLen = 3;
+
+  Document* d = RediSearch_CreateDocumentSimple(DOCID1);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "samuel sam", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+  d = RediSearch_CreateDocumentSimple(DOCID2);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "sandra", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_2, "samuel", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+  d = RediSearch_CreateDocumentSimple("doc3");
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "sandwich other", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+
+  // the prefix postings do not count as records
+  ASSERT_EQ(6, index->stats.numRecords);
+  ASSERT_LT(0, index->stats.prefixIndexSize);
+  ASSERT_TRUE(index->prefixes != NULL);
+
+  // with a single expansion allowed, only the prefix postings can find all the documents
+  index->maxPrefixExpansions = 1;
+  auto res = search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "sa"));
+  ASSERT_EQ(std::vector<std::string>({DOCID1, DOCID2, "doc3"}), res);
+  res = search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "san"));
+  ASSERT_EQ(std::vector<std::string>({DOCID2, "doc3"}), res);
+  ASSERT_TRUE(search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "xyz")).empty());
+
+  // prefixes longer than the indexed length, and fields without prefix postings, are expanded
+  index->maxPrefixExpansions = -1;
+  res = search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_1, "sand"));
+  ASSERT_EQ(std::vector<std::string>({DOCID2, "doc3"}), res);
+  res = search(index, RediSearch_CreatePrefixNode(index, FIELD_NAME_2, "sam"));
+  ASSERT_EQ(std::vector<std::string>({DOCID2}), res);
+  res = search(index, RediSearch_CreatePrefixNode(index, NULL, "sam"));
+  ASSERT_EQ(std::vector<std::string>({DOCID1, DOCID2}), res);
+
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(LLApiTest, testSuffixIndex) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, FIELD_NAME_2, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  FieldSpec* fs = (FieldSpec*)IndexSpec_GetField(index, FIELD_NAME_1, strlen(FIELD_NAME_1));
+  fs->options = (FieldSpecOptions)(fs->options | FieldSpec_WithSuffixTrie);
+  index->flags = (IndexFlags)(index->flags | Index_HasSuffixTrie);
+
+  Document* d = RediSearch_CreateDocumentSimple(DOCID1);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "sku-abc123 banana", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+  d = RediSearch_CreateDocumentSimple(DOCID2);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "xabc", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_2, "cabana", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+
+  // only the terms of the first field are in the suffix index
+  ASSERT_TRUE(index->suffix != NULL);
+  ASSERT_EQ(4, SuffixIndex_NumTerms(index->suffix));
+
+  auto suffixNode = [&](const char* field, const char* s, bool contains) {
+    RSQNode* qn = RediSearch_CreatePrefixNode(index, field, s);
+    qn->pfx.suffix = true;
+    qn->pfx.prefix = contains;
+    return qn;
+  };
+  auto res = search(index, suffixNode(FIELD_NAME_1, "abc", false));
+  ASSERT_EQ(std::vector<std::string>({DOCID2}), res);
+  res = search(index, suffixNode(FIELD_NAME_1, "abc", true));
+  ASSERT_EQ(std::vector<std::string>({DOCID1, DOCID2}), res);
+  res = search(index, suffixNode(FIELD_NAME_1, "ana", false));
+  ASSERT_EQ(std::vector<std::string>({DOCID1}), res);
+  ASSERT_TRUE(search(index, suffixNode(FIELD_NAME_1, "xyz", true)).empty());
+
+  // fields without a suffix index scan the terms
+  res = search(index, suffixNode(FIELD_NAME_2, "ana", false));
+  ASSERT_EQ(std::vector<std::string>({DOCID2}), res);
+  res = search(index, suffixNode(NULL, "ban", true));
+  ASSERT_EQ(std::vector<std::string>({DOCID1, DOCID2}), res);
+
+  // the scan stops at the expansion limit, taking the terms in order
+  index->maxPrefixExpansions = 1;
+  res = search(index, suffixNode(NULL, "ban", true));
+  ASSERT_EQ(std::vector<std::string>({DOCID1}), res);
+  index->maxPrefixExpansions = -1;
+
+  // the stems of terms are not matched, neither through the suffix index nor by the scan
+  d = RediSearch_CreateDocumentSimple("doc3");
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, "running", RSFLDTYPE_DEFAULT);
+  RediSearch_DocumentAddFieldCString(d, FIELD_NAME_2, "jumping", RSFLDTYPE_DEFAULT);
+  RediSearch_SpecAddDocument(index, d);
+  ASSERT_EQ(5, SuffixIndex_NumTerms(index->suffix));
+  ASSERT_TRUE(search(index, suffixNode(FIELD_NAME_1, "un", false)).empty());
+  ASSERT_TRUE(search(index, suffixNode(FIELD_NAME_2, "ump", false)).empty());
+  res = search(index, suffixNode(FIELD_NAME_2, "ump", true));
+  ASSERT_EQ(std::vector<std::string>({"doc3"}), res);
+
+  RediSearch_DropIndex(index);
+}
+
+TEST_F(LLApiTest, testAddBatch) {
+  RSIndex* index = RediSearch_CreateIndex("index", NULL);
+  RediSearch_CreateField(index, FIELD_NAME_1, RSFLDTYPE_FULLTEXT, RSFLDOPT_NONE);
+  RediSearch_CreateField(index, NUMERIC_FIELD_NAME, RSFLDTYPE_NUMERIC, RSFLDOPT_NONE);
+
+  // the documents are preprocessed first, then written together
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, index);
+  RSAddDocumentCtx* head = NULL;
+  const char* texts[] = {"red apple", "green apple", "red pepper"};
+  for (int i = 2; i >= 0; i--) {
+    std::string id = "doc" + std::to_string(i + 1);
+    Document* d = RediSearch_CreateDocumentSimple(id.c_str());
+    RediSearch_DocumentAddFieldCString(d, FIELD_NAME_1, texts[i], RSFLDTYPE_DEFAULT);
+    RediSearch_DocumentAddFieldNumber(d, NUMERIC_FIELD_NAME, i, RSFLDTYPE_DEFAULT);
+    QueryError status = {};
+    RSAddDocumentCtx* aCtx = NewAddDocumentCtx(index, d, &status);
+    ASSERT_TRUE(aCtx != NULL);
+    rm_free(d);
+    aCtx->stateFlags |= ACTX_F_NOBLOCK;
+    aCtx->options = DOCUMENT_ADD_REPLACE | DOCUMENT_ADD_NOSAVE;
+    aCtx->donecb = NULL;
+    aCtx->client.sctx = &sctx;
+    ASSERT_EQ(REDISMODULE_OK, Document_Preprocess(aCtx));
+    aCtx->next = head;
+    head = aCtx;
+  }
+  Indexer_AddBatch(index->indexer, head);
+
+  ASSERT_EQ(3, index->stats.numDocuments);
+  auto res = search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_1, "apple"));
+  ASSERT_EQ(std::vector<std::string>({"doc1", "doc2"}), res);
+  res = search(index, RediSearch_CreateTokenNode(index, FIELD_NAME_1, "red"));
+  ASSERT_EQ(std::vector<std::string>({"doc1", "doc3"}), res);
+  res = search(index, RediSearch_CreateNumericNode(index, NUMERIC_FIELD_NAME, 2, 1, 1, 1));
+  ASSERT_EQ(std::vector<std::string>({"doc2", "doc3"}), res);
+
+  RediSearch_DropIndex(index);
+}
@@ -246,11 +246,43 @@ TEST_F(QueryTest, testParser) {
   ASSERT_STREQ("baz", _n->children[0]->tn.str);
 
   ASSERT_EQ(_n->children[1]->type, QN_PREFX);
-  ASSERT_STREQ("boo", _n->children[1]->pfx.str);
+  ASSERT_STREQ("boo", _n->children[1]->pfx.tok.str);
   QAST_Destroy(&ast);
   IndexSpec_Free(ctx.spec);
 }
 
+TEST_F(QueryTest, testSuffix) {
+  static const char *args[] = {"SCHEMA", "title", "text", "WITHSUFFIXTRIE", "body", "text"};
+  QueryError err = {QueryErrorCode(0)};
+  IndexSpec *spec = IndexSpec_Parse("idx", args, sizeof(args) / sizeof(const char *), &err);
+  ASSERT_FALSE(QueryError_HasError(&err)) << QueryError_GetError(&err);
+  ASSERT_TRUE(spec->flags & Index_HasSuffixTrie);
+  ASSERT_EQ(1, IndexSpec_SuffixTrieMask(spec));
+  RedisSearchCtx ctx = SEARCH_CTX_STATIC(NULL, spec);
+
+  QASTCXX ast(ctx);
+  ASSERT_TRUE(ast.parse("*Oo")) << ast.getError();
+  ASSERT_EQ(QN_PREFX, ast.root->type);
+  ASSERT_STREQ("oo", ast.root->pfx.tok.str);
+  ASSERT_TRUE(ast.root->pfx.suffix && !ast.root->pfx.prefix);
+
+  ASSERT_TRUE(ast.parse("hello @title:*oo*")) << ast.getError();
+  QueryNode *n = ast.root->children[1];
+  ASSERT_EQ(QN_PREFX, n->type);
+  ASSERT_STREQ("oo", n->pfx.tok.str);
+  ASSERT_TRUE(n->pfx.suffix && n->pfx.prefix);
+
+  ASSERT_TRUE(ast.parse("foo*")) << ast.getError();
+  ASSERT_TRUE(ast.root->pfx.prefix && !ast.root->pfx.suffix);
+
+  assertValidQuery("*", ctx);
+  assertValidQuery("*the", ctx);
+  assertValidQuery("-*foo", ctx);
+  assertInvalidQuery("* foo", ctx);
+  assertInvalidQuery("* foo*", ctx);
+  IndexSpec_Free(spec);
+}
+
 TEST_F(QueryTest, testPureNegative) {
   const char *qs[] = {"-@title:hello", "-hello", "@title:-hello", "-(foo)", "-foo", "(-foo)", NULL};
   static const char *args[] = {"SCHEMA", "title",  "text", "weight", "0.1",    "body",
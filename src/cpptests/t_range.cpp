@@ -139,6 +139,232 @@ TEST_F(RangeTest, testRangeIterator) {
   NumericRangeTree_Free(t);
 }
 
+TEST_F(RangeTest, testCompact) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 30000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 0; i < N; i++) {
+    // time-series like values, mostly increasing with the document id
+    lookup[i + 1] = (double)(i + prng() % 100);
+    NumericRangeTree_Add(t, i + 1, lookup[i + 1]);
+  }
+  uint32_t uniqueId = t->uniqueId;
+  uint32_t revisionId = t->revisionId;
+
+  NumericRangeTree_Compact(t);
+  ASSERT_EQ(N, t->numEntries);
+  ASSERT_NE(uniqueId, t->uniqueId);
+  ASSERT_EQ(revisionId + 1, t->revisionId);
+
+  NumericRangeTreeStats stats;
+  NumericRangeTree_GetStats(t, &stats);
+  ASSERT_EQ(0, stats.emptyLeaves);
+  ASSERT_LE(stats.maxDepth - stats.minDepth, 1);
+  ASSERT_GE(stats.fill, 0.9);
+  ASSERT_EQ(stats.numLeaves, t->numRanges);
+  ASSERT_FALSE(NumericRangeTree_NeedsCompaction(t));
+
+  double rngs[][2] = {{0, 100}, {5000, 5100}, {1000, 20000}, {-1, 1e9}, {29999, 29999}};
+  for (auto &rng : rngs) {
+    NumericFilter *flt = NewNumericFilter(rng[0], rng[1], 1, 1);
+    size_t count = 0;
+    for (size_t i = 1; i <= N; i++) {
+      count += NumericFilter_Match(flt, lookup[i]);
+    }
+
+    IndexIterator *it = createNumericIterator(NULL, t, flt);
+    ASSERT_TRUE(it != NULL);
+    size_t xcount = 0;
+    t_docId lastId = 0;
+    RSIndexResult *res = NULL;
+    while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+      ASSERT_GT(res->docId, lastId);
+      lastId = res->docId;
+      ASSERT_TRUE(NumericFilter_Match(flt, lookup[res->docId]));
+      xcount++;
+    }
+    ASSERT_EQ(count, xcount);
+    it->Free(it);
+    NumericFilter_Free(flt);
+  }
+
+  // the compacted tree keeps accepting new values
+  for (size_t i = N; i < N + 10000; i++) {
+    NumericRangeTree_Add(t, i + 1, (double)i);
+  }
+  ASSERT_EQ(N + 10000, t->numEntries);
+  NumericRangeTree_Free(t);
+
+  // compacting an empty tree leaves a single empty leaf
+  t = NewNumericRangeTree();
+  NumericRangeTree_Compact(t);
+  ASSERT_EQ(1, t->numRanges);
+  ASSERT_TRUE(NumericRangeNode_IsLeaf(t->root));
+  NumericRangeTree_Add(t, 1, 42);
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testCompactStep) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 200000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 1; i <= N; i++) {
+    lookup[i] = (double)(prng() % 200000);
+    NumericRangeTree_Add(t, i, lookup[i]);
+  }
+  // empty half of the leaves and leave the others nearly empty, as garbage collection does
+  for (size_t i = 1; i <= N; i++) {
+    if (lookup[i] < 100000 || i % 40) {
+      ASSERT_TRUE(NumericRangeTree_Delete(t, i, lookup[i]));
+      lookup[i] = -1;
+    }
+  }
+  ASSERT_TRUE(NumericRangeTree_NeedsCompaction(t));
+
+  // each step compacts a bounded part of the tree, until it no longer needs compaction
+  const size_t budget = 1000;
+  size_t steps = 0;
+  uint32_t revisionId = t->revisionId;
+  while (NumericRangeTree_CompactStep(t, budget)) {
+    ASSERT_EQ(revisionId + 1, t->revisionId);
+    revisionId = t->revisionId;
+    ASSERT_LT(++steps, 100);
+
+    NumericRangeTreeStats stats;
+    NumericRangeTree_GetStats(t, &stats);
+    ASSERT_EQ(stats.numLeaves, t->numRanges);
+  }
+  ASSERT_GT(steps, 1);
+  ASSERT_FALSE(NumericRangeTree_NeedsCompaction(t));
+  ASSERT_EQ(revisionId, t->revisionId);
+  // not only because the last step found nothing
+  t->compactStalled = 0;
+  ASSERT_FALSE(NumericRangeTree_NeedsCompaction(t));
+
+  double rngs[][2] = {{0, 100}, {140000, 160000}, {150000, 150100}, {-1, 1e9}, {199999, 199999}};
+  for (auto &rng : rngs) {
+    NumericFilter *flt = NewNumericFilter(rng[0], rng[1], 1, 1);
+    size_t count = 0;
+    for (size_t i = 1; i <= N; i++) {
+      count += lookup[i] >= 0 && NumericFilter_Match(flt, lookup[i]);
+    }
+
+    IndexIterator *it = createNumericIterator(NULL, t, flt);
+    ASSERT_TRUE(it != NULL);
+    size_t xcount = 0;
+    RSIndexResult *res = NULL;
+    while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+      ASSERT_TRUE(NumericFilter_Match(flt, lookup[res->docId]));
+      xcount++;
+    }
+    ASSERT_EQ(count, xcount);
+    it->Free(it);
+    NumericFilter_Free(flt);
+  }
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testCompactStall) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 200000;
+  for (size_t i = 1; i <= N; i++) {
+    NumericRangeTree_Add(t, i, (double)(prng() % 200000));
+  }
+  // empty every other leaf. Every subtree of two leaves or more then holds a full one, so none of
+  // them can be rebuilt into half as many leaves
+  std::vector<NumericRangeNode *> leaves;
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(t);
+  NumericRangeNode *n;
+  while ((n = NumericRangeTreeIterator_Next(iter))) {
+    if (NumericRangeNode_IsLeaf(n)) {
+      leaves.push_back(n);
+    }
+  }
+  NumericRangeTreeIterator_Free(iter);
+  std::vector<std::pair<t_docId, double>> entries;
+  for (size_t i = 1; i < leaves.size(); i += 2) {
+    RSIndexResult *res = NULL;
+    IndexReader *ir = NewNumericReader(NULL, leaves[i]->range->entries, NULL);
+    while (INDEXREAD_OK == IR_Read(ir, &res)) {
+      entries.push_back({res->docId, res->num.value});
+    }
+    IR_Free(ir);
+  }
+  for (auto &e : entries) {
+    ASSERT_TRUE(NumericRangeTree_Delete(t, e.first, e.second));
+  }
+  ASSERT_TRUE(NumericRangeTree_NeedsCompaction(t));
+
+  // a step compacts nothing, so the tree stops asking for compaction instead of being retried on
+  // every run
+  uint32_t revisionId = t->revisionId;
+  ASSERT_FALSE(NumericRangeTree_CompactStep(t, NR_COMPACT_STEP_ENTRIES));
+  ASSERT_EQ(revisionId, t->revisionId);
+  ASSERT_FALSE(NumericRangeTree_NeedsCompaction(t));
+
+  // until its leaves change
+  ASSERT_TRUE(NumericRangeTree_Add(t, N + 1, 42));
+  ASSERT_FALSE(NumericRangeTree_NeedsCompaction(t));
+  ASSERT_TRUE(NumericRangeTree_Delete(t, N + 1, 42));
+  ASSERT_TRUE(NumericRangeTree_NeedsCompaction(t));
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testUpdateInPlace) {
+  NumericRangeTree *t = NewNumericRangeTree();
+  const size_t N = 20000;
+  std::vector<double> lookup(N + 1);
+  for (size_t i = 1; i <= N; i++) {
+    lookup[i] = (double)(prng() % 5000);
+    NumericRangeTree_Add(t, i, lookup[i]);
+  }
+
+  // documents updated in place keep their ids, their values move to other ranges
+  for (size_t i = 1; i <= N; i += 3) {
+    ASSERT_TRUE(NumericRangeTree_Delete(t, i, lookup[i]));
+    ASSERT_FALSE(NumericRangeTree_Delete(t, i, lookup[i]));
+    lookup[i] = (double)(prng() % 5000);
+    NumericRangeTree_Insert(t, i, lookup[i]);
+  }
+  // a value the document was not indexed with is not found, as its leaf does not hold the document
+  ASSERT_FALSE(NumericRangeTree_Delete(t, 2, lookup[2] < 2500 ? 4999 : 0));
+  // only Insert accepts documents older than the last one
+  ASSERT_EQ(0, NumericRangeTree_Add(t, N, 1));
+  // and nothing is added for a document the tree already holds
+  ASSERT_EQ(0, NumericRangeTree_Insert(t, 2, lookup[2]));
+  ASSERT_EQ(N, t->numEntries);
+
+  double rngs[][2] = {{0, 100}, {2500, 2600}, {1000, 4000}, {-1, 1e9}, {4999, 4999}};
+  for (auto &rng : rngs) {
+    NumericFilter *flt = NewNumericFilter(rng[0], rng[1], 1, 1);
+    size_t count = 0;
+    for (size_t i = 1; i <= N; i++) {
+      count += NumericFilter_Match(flt, lookup[i]);
+    }
+
+    IndexIterator *it = createNumericIterator(NULL, t, flt);
+    if (!it) {
+      // no range overlaps the filter
+      ASSERT_EQ(0, count);
+      NumericFilter_Free(flt);
+      continue;
+    }
+    size_t xcount = 0;
+    t_docId lastId = 0;
+    RSIndexResult *res = NULL;
+    while (it->Read(it->ctx, &res) != INDEXREAD_EOF) {
+      ASSERT_GT(res->docId, lastId);
+      lastId = res->docId;
+      ASSERT_TRUE(NumericFilter_Match(flt, lookup[res->docId])) << res->docId;
+      xcount++;
+    }
+    ASSERT_EQ(count, xcount);
+    it->Free(it);
+    NumericFilter_Free(flt);
+  }
+  NumericRangeTree_Free(t);
+}
+
 // int benchmarkNumericRangeTree() {
 //   NumericRangeTree *t = NewNumericRangeTree();
 //   int count = 1;
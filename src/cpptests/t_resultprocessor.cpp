@@ -1,6 +1,11 @@
 #include <result_processor.h>
 #include <query.h>
+#include <spec.h>
+#include <doc_table.h>
+#include <index.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 
 struct processor1Ctx : public ResultProcessor {
   processor1Ctx() {
@@ -77,4 +82,300 @@ TEST_F(ResultProcessorTest, testProcessorChain) {
   QITR_FreeChain(&qitr);
   ASSERT_EQ(2, numFreed);
   RLookup_Cleanup(&lk);
-}
\ No newline at end of file
+}
+TEST_F(ResultProcessorTest, testArena) {
+  QueryIterator qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey(&lk, "foo", RLOOKUP_F_OCREAT);
+  QITR_PushRP(&qitr, p);
+  // the results held by the sorter are allocated from the arena
+  QITR_PushRP(&qitr, RPSorter_NewByScore(3));
+
+  // allocations of any size are aligned, and kept until the arena is freed
+  std::vector<char *> strs;
+  for (size_t ii = 0; ii < 100; ii++) {
+    std::string s(ii * ii, 'a' + ii % 26);
+    char *str = (char *)QITR_Alloc(&qitr, s.size() + 1);
+    memcpy(str, s.c_str(), s.size() + 1);
+    ASSERT_EQ(0, (uintptr_t)str % 16);
+    strs.push_back(str);
+  }
+  for (size_t ii = 0; ii < strs.size(); ii++) {
+    ASSERT_EQ(std::string(ii * ii, 'a' + ii % 26), strs[ii]);
+  }
+
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  t_docId expected = NUM_RESULTS;
+  for (; rpTail->Next(rpTail, &r) == RS_RESULT_OK; expected--) {
+    ASSERT_EQ(expected, r.docId);
+    ASSERT_EQ(expected, RLookup_GetItem(p->kout, &r.rowdata)->numval);
+    SearchResult_Clear(&r);
+  }
+  ASSERT_LT(expected, NUM_RESULTS);
+  SearchResult_Destroy(&r);
+
+  ASSERT_TRUE(qitr.arena.root != NULL);
+  QITR_FreeChain(&qitr);
+  ASSERT_TRUE(qitr.arena.root == NULL);
+  RLookup_Cleanup(&lk);
+}
+
+struct docsGenerator : public ResultProcessor {
+  docsGenerator(DocTable *docs_, const RLookupKey *extra_) : docs(docs_), extra(extra_) {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+  }
+  DocTable *docs;
+  // written to every result when set, so that it is held whole by the sorter
+  const RLookupKey *extra;
+  t_docId next = 0;
+};
+
+static int docs_Next(ResultProcessor *rp, SearchResult *res) {
+  docsGenerator *g = static_cast<docsGenerator *>(rp);
+  // skipping the deleted documents
+  do {
+    if (g->next == g->docs->maxDocId) return RS_RESULT_EOF;
+    res->docId = ++g->next;
+  } while (!(res->dmd = DocTable_Get(g->docs, res->docId)));
+  res->score = res->docId % 17;
+  DMD_Incref(res->dmd);
+  res->rowdata.sv = res->dmd->sortVector;
+  if (g->extra) {
+    RLookup_WriteOwnKey(g->extra, &res->rowdata, RS_NumVal(res->docId));
+  }
+  rp->parent->totalResults++;
+  return RS_RESULT_OK;
+}
+
+static void docs_Free(ResultProcessor *rp) {
+  delete static_cast<docsGenerator *>(rp);
+}
+
+TEST_F(ResultProcessorTest, testSorterLazyResults) {
+  IndexSpec spec = {0};
+  spec.docs = DocTable_New(100);
+  RedisSearchCtx sctx = {0};
+  sctx.spec = &spec;
+  for (int i = 0; i < 1000; i++) {
+    std::string key = "doc" + std::to_string(i);
+    t_docId id = DocTable_Put(&spec.docs, key.c_str(), key.size(), 1, 0, NULL, 0);
+    RSSortingVector *sv = NewSortingVector(1);
+    double v = (i * 37) % 101;
+    RSSortingVector_Put(sv, 0, &v, RS_SORTABLE_NUM);
+    DocTable_SetSortingVector(&spec.docs, id, sv);
+  }
+
+  RLookupKey svkey = {0};
+  svkey.flags = RLOOKUP_F_SVSRC;
+  RLookupKey extra = {0};
+  extra.dstidx = 1;
+
+  // the results held by their documents alone are yielded as those held whole
+  auto run = [&](bool byField, bool whole, t_docId deleted) {
+    QueryIterator qitr = {0};
+    qitr.sctx = &sctx;
+    QITR_PushRP(&qitr, new docsGenerator(&spec.docs, whole ? &extra : NULL));
+    qitr.endProc->Next = docs_Next;
+    qitr.endProc->Free = docs_Free;
+    const RLookupKey *keys[] = {&svkey};
+    QITR_PushRP(&qitr, byField ? RPSorter_NewByFields(10, keys, 1, SORTASCMAP_INIT)
+                               : RPSorter_NewByScore(10));
+
+    std::vector<std::pair<t_docId, double>> out;
+    SearchResult r = {0};
+    ResultProcessor *rp = qitr.endProc;
+    while (rp->Next(rp, &r) == RS_RESULT_OK) {
+      EXPECT_EQ(r.docId, r.dmd->id);
+      EXPECT_EQ(r.dmd->sortVector, r.rowdata.sv);
+      out.push_back({r.docId, r.score});
+      // a document deleted before it is yielded is skipped, unless its result is held whole
+      if (deleted && out.size() == 1) {
+        const char *key = DMD_KeyPtrLen(DocTable_Get(&spec.docs, deleted), NULL);
+        std::string k(key);
+        RSDocumentMetadata *md = DocTable_Pop(&spec.docs, k.c_str(), k.size());
+        DMD_Decref(md);
+      }
+      SearchResult_Clear(&r);
+    }
+    SearchResult_Destroy(&r);
+    QITR_FreeChain(&qitr);
+    return out;
+  };
+
+  for (bool byField : {false, true}) {
+    auto lazy = run(byField, false, 0);
+    auto whole = run(byField, true, 0);
+    ASSERT_EQ(10, lazy.size());
+    ASSERT_EQ(whole, lazy);
+    for (size_t i = 1; i < lazy.size(); i++) {
+      if (!byField) {
+        ASSERT_GE(lazy[i - 1].second, lazy[i].second);
+      }
+    }
+
+    auto skipped = run(byField, false, lazy[5].first);
+    lazy.erase(lazy.begin() + 5);
+    ASSERT_EQ(lazy, skipped);
+  }
+
+  DocTable_Free(&spec.docs);
+}
+
+TEST_F(ResultProcessorTest, testNumericOrder) {
+  IndexSpec spec = {0};
+  spec.docs = DocTable_New(100);
+  RedisSearchCtx sctx = {0};
+  sctx.spec = &spec;
+  NumericRangeTree *tree = NewNumericRangeTree();
+  std::vector<t_docId> matches;
+  for (int i = 0; i < 3000; i++) {
+    std::string key = "doc" + std::to_string(i);
+    t_docId id = DocTable_Put(&spec.docs, key.c_str(), key.size(), 1, 0, NULL, 0);
+    RSSortingVector *sv = NewSortingVector(1);
+    // some documents have no value, and many share theirs
+    if (i % 13) {
+      double v = (i * 37) % 701 - 300;
+      RSSortingVector_Put(sv, 0, &v, RS_SORTABLE_NUM);
+      NumericRangeTree_Add(tree, id, v);
+    }
+    DocTable_SetSortingVector(&spec.docs, id, sv);
+    if (i % 3) {
+      matches.push_back(id);
+    }
+  }
+  // deleted documents are left in the tree
+  for (int i = 0; i < 3000; i += 7) {
+    std::string key = "doc" + std::to_string(i);
+    DMD_Decref(DocTable_Pop(&spec.docs, key.c_str(), key.size()));
+  }
+  NumericRange **leaves = NumericRangeTree_GetLeaves(tree);
+  ASSERT_GT(array_len(leaves), 4);
+  for (size_t i = 1; i < array_len(leaves); i++) {
+    ASSERT_LE(leaves[i - 1]->maxVal, leaves[i]->minVal);
+  }
+  array_free(leaves);
+
+  RLookupKey svkey = {0};
+  svkey.flags = RLOOKUP_F_SVSRC;
+
+  // the results read in the order of the field are sorted as those read by their ids
+  auto run = [&](bool wildcard, bool ordered, bool asc, size_t limit, size_t *total) {
+    std::vector<t_docId> ids(matches);
+    IndexIterator *root = wildcard ? NewWildcardIterator(spec.docs.maxDocId)
+                                   : NewIdListIterator(&ids[0], ids.size(), 1);
+    QueryIterator qitr = {0};
+    qitr.sctx = &sctx;
+    QITR_PushRP(&qitr, ordered ? RPIndexIterator_NewNumericOrder(root, tree, &svkey, asc, limit)
+                               : RPIndexIterator_New(root));
+    const RLookupKey *keys[] = {&svkey};
+    QITR_PushRP(&qitr, RPSorter_NewByFields(limit, keys, 1, asc ? SORTASCMAP_INIT : 0));
+
+    std::vector<t_docId> out;
+    SearchResult r = {0};
+    ResultProcessor *rp = qitr.endProc;
+    while (rp->Next(rp, &r) == RS_RESULT_OK) {
+      out.push_back(r.docId);
+      SearchResult_Clear(&r);
+    }
+    SearchResult_Destroy(&r);
+    *total = qitr.totalResults;
+    QITR_FreeChain(&qitr);
+    root->Free(root);
+    return out;
+  };
+
+  for (bool wildcard : {false, true}) {
+    for (bool asc : {false, true}) {
+      for (size_t limit : {1, 10, 100, 2000}) {
+        size_t total, orderedTotal;
+        auto expected = run(wildcard, false, asc, limit, &total);
+        auto ordered = run(wildcard, true, asc, limit, &orderedTotal);
+        ASSERT_EQ(std::min(limit, total), expected.size());
+        ASSERT_EQ(expected, ordered) << wildcard << asc << limit;
+        // the results past the leaves which make the top are not read
+        ASSERT_LE(orderedTotal, total);
+        if (limit <= 100) {
+          ASSERT_LT(orderedTotal, total / 2) << wildcard << asc << limit;
+        }
+      }
+    }
+  }
+
+  NumericRangeTree_Free(tree);
+  DocTable_Free(&spec.docs);
+}
+
+static size_t numRootReads;
+static int (*rootRead)(void *, RSIndexResult **);
+
+static int countingRead(void *ctx, RSIndexResult **hit) {
+  numRootReads++;
+  return rootRead(ctx, hit);
+}
+
+TEST_F(ResultProcessorTest, testNumericOrderNoMissing) {
+  IndexSpec spec = {0};
+  spec.docs = DocTable_New(100);
+  RedisSearchCtx sctx = {0};
+  sctx.spec = &spec;
+  NumericRangeTree *tree = NewNumericRangeTree();
+  for (int i = 0; i < 1000; i++) {
+    std::string key = "doc" + std::to_string(i);
+    t_docId id = DocTable_Put(&spec.docs, key.c_str(), key.size(), 1, 0, NULL, 0);
+    RSSortingVector *sv = NewSortingVector(1);
+    double v = (i * 37) % 701;
+    RSSortingVector_Put(sv, 0, &v, RS_SORTABLE_NUM);
+    NumericRangeTree_Add(tree, id, v);
+    DocTable_SetSortingVector(&spec.docs, id, sv);
+  }
+  ASSERT_EQ(0, DocTable_NumMissingSortable(&spec.docs, 0));
+
+  RLookupKey svkey = {0};
+  svkey.flags = RLOOKUP_F_SVSRC;
+  auto run = [&](bool asc) {
+    IndexIterator *root = NewWildcardIterator(spec.docs.maxDocId);
+    rootRead = root->Read;
+    root->Read = countingRead;
+    numRootReads = 0;
+    QueryIterator qitr = {0};
+    qitr.sctx = &sctx;
+    QITR_PushRP(&qitr, RPIndexIterator_NewNumericOrder(root, tree, &svkey, asc, 10));
+    const RLookupKey *keys[] = {&svkey};
+    QITR_PushRP(&qitr, RPSorter_NewByFields(10, keys, 1, asc ? SORTASCMAP_INIT : 0));
+    SearchResult r = {0};
+    size_t n = 0;
+    while (qitr.endProc->Next(qitr.endProc, &r) == RS_RESULT_OK) {
+      n++;
+      SearchResult_Clear(&r);
+    }
+    SearchResult_Destroy(&r);
+    QITR_FreeChain(&qitr);
+    root->Free(root);
+    return n;
+  };
+
+  // with every document holding a value, the root iterator is only skipped to the leaves' documents
+  for (bool asc : {false, true}) {
+    ASSERT_EQ(10, run(asc));
+    ASSERT_EQ(0, numRootReads) << asc;
+  }
+
+  // a document losing its value is looked for again
+  RSDocumentMetadata *md = DocTable_Get(&spec.docs, 5);
+  DocTable_PutSortable(&spec.docs, md, 0, NULL, RS_SORTABLE_NIL);
+  ASSERT_EQ(1, DocTable_NumMissingSortable(&spec.docs, 0));
+  ASSERT_EQ(10, run(true));
+  ASSERT_LT(0, numRootReads);
+  // and not once it's deleted
+  const char *key = DMD_KeyPtrLen(md, NULL);
+  std::string k(key);
+  DMD_Decref(DocTable_Pop(&spec.docs, k.c_str(), k.size()));
+  ASSERT_EQ(0, DocTable_NumMissingSortable(&spec.docs, 0));
+
+  NumericRangeTree_Free(tree);
+  DocTable_Free(&spec.docs);
+}
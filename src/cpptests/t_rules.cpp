@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+#include "rules.h"
+#include "spec.h"
+#include <set>
+#include <string>
+#include <vector>
+
+class RulesTest : public ::testing::Test {};
+
+typedef std::set<const IndexSpec *> SpecSet;
+
+static SchemaRule *addRule(IndexSpec *spec, std::vector<const char *> prefixes,
+                           const char *filter = NULL) {
+  SchemaRuleArgs args = {0};
+  args.prefixes = &prefixes[0];
+  args.nprefixes = prefixes.size();
+  args.filter_exp_str = (char *)filter;
+  QueryError status = {QueryErrorCode(0)};
+  SchemaRule *rule = SchemaRule_Create(&args, spec, &status);
+  EXPECT_TRUE(rule) << QueryError_GetError(&status);
+  return rule;
+}
+
+static SpecSet match(RedisModuleCtx *ctx, const char *key) {
+  size_t nwords = SchemaRules_MatchWords();
+  std::vector<SchemaRuleBits> matches(nwords);
+  SchemaRules_Match(ctx, RMCK::RString(key), &matches[0]);
+  SpecSet specs;
+  int i;
+  while ((i = SchemaRules_NextMatch(&matches[0], nwords)) >= 0) {
+    specs.insert(SchemaRules_g[i]->spec);
+  }
+  return specs;
+}
+
+static void setAge(RedisModuleCtx *ctx, const char *key, const char *age) {
+  RedisModuleKey *k = RedisModule_OpenKey(ctx, RMCK::RString(key), REDISMODULE_WRITE);
+  RedisModule_HashSet(k, REDISMODULE_HASH_CFIELDS, "age", RMCK::RString(age).rstring(), NULL);
+  RedisModule_CloseKey(k);
+}
+
+TEST_F(RulesTest, testMatch) {
+  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(NULL);
+  std::vector<IndexSpec> specs(74);
+  IndexSpec *users = &specs[0], *admins = &specs[1], *named = &specs[2], *orders = &specs[3];
+  SchemaRule *rules[] = {
+      addRule(users, {"user:"}),
+      addRule(admins, {"user:admin:", "adm"}, "@age > 30"),
+      addRule(named, {""}, "@__key == 'user:1'"),
+      addRule(orders, {"order:"}),
+  };
+
+  setAge(ctx, "user:1", "40");
+  setAge(ctx, "user:admin:7", "20");
+  setAge(ctx, "user:admin:9", "50");
+  setAge(ctx, "adm", "50");
+  ASSERT_EQ(SpecSet({users, named}), match(ctx, "user:1"));
+  ASSERT_EQ(SpecSet({users}), match(ctx, "user:admin:7"));
+  ASSERT_EQ(SpecSet({users, admins}), match(ctx, "user:admin:9"));
+  ASSERT_EQ(SpecSet({admins}), match(ctx, "adm"));
+  ASSERT_EQ(SpecSet({orders}), match(ctx, "order:1"));
+  ASSERT_EQ(SpecSet(), match(ctx, "use"));
+  // a filter reading a field the hash lacks keeps the index, as it cannot be evaluated
+  ASSERT_EQ(SpecSet({users, admins}), match(ctx, "user:admin:8"));
+
+  // the matcher follows the rules being added and removed, past one word of the bitmap
+  SchemaRule_Free(rules[3]);
+  ASSERT_EQ(SpecSet(), match(ctx, "order:1"));
+  std::vector<std::string> prefixes;
+  for (size_t i = 4; i < specs.size(); i++) {
+    prefixes.push_back("k" + std::to_string(i) + ":");
+  }
+  std::vector<SchemaRule *> more;
+  for (size_t i = 4; i < specs.size(); i++) {
+    more.push_back(addRule(&specs[i], {prefixes[i - 4].c_str()}));
+  }
+  ASSERT_LT(SCHEMA_RULE_BITS, array_len(SchemaRules_g));
+  ASSERT_EQ(SpecSet({&specs[70]}), match(ctx, "k70:x"));
+  ASSERT_EQ(SpecSet({&specs[7]}), match(ctx, "k7:x"));
+  ASSERT_EQ(SpecSet({users, admins}), match(ctx, "user:admin:9"));
+
+  for (SchemaRule *rule : more) {
+    SchemaRule_Free(rule);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    SchemaRule_Free(rules[i]);
+  }
+  ASSERT_EQ(SpecSet(), match(ctx, "user:1"));
+  SchemaRules_FreeMatcher();
+  RedisModule_FreeThreadSafeContext(ctx);
+}
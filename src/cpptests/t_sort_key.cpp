@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "sort_key.h"
+#include "result_processor.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+class SortKeyTest : public ::testing::Test {};
+
+static RSValue *randomValue() {
+  static const double numbers[] = {-INFINITY, -1e300, -2.5, -1, -0.0, 0, 1e-300, 1e-300 * -1,
+                                   1,         1.5,    2,    3, 1e300, INFINITY, NAN};
+  static const char *alphabet = "ab\x7f\x80z";
+  switch (rand() % 5) {
+    case 0:
+      return NULL;
+    case 1:
+      return RS_NullVal();
+    case 2:
+      if (rand() % 2) {
+        return RS_NumVal(numbers[rand() % (sizeof(numbers) / sizeof(*numbers))]);
+      }
+      return RS_NumVal((rand() % 2000 - 1000) / 8.0);
+    default: {
+      // short strings over a small alphabet share long prefixes, and hold a NUL now and then
+      std::string s;
+      for (size_t i = 0, n = rand() % 13; i < n; i++) {
+        s += rand() % 50 ? alphabet[rand() % 5] : '\0';
+      }
+      return RS_NewCopiedString(s.data(), s.size());
+    }
+  }
+}
+
+static int sign(int rc) {
+  return rc > 0 ? 1 : (rc < 0 ? -1 : 0);
+}
+
+// the order of the fields as compared by the sorter, 0 if it is up to the ids
+static int cmpFields(const RLookupKey **keys, size_t nkeys, uint64_t ascMap,
+                     const RLookupRow *r1, const RLookupRow *r2) {
+  for (size_t i = 0; i < nkeys; i++) {
+    RSValue *v1 = RLookup_GetItem(keys[i], r1), *v2 = RLookup_GetItem(keys[i], r2);
+    int rc;
+    if (!v1 || !v2) {
+      rc = v1 ? 1 : (v2 ? -1 : 0);
+    } else {
+      rc = RSValue_Cmp(v1, v2, NULL);
+    }
+    if (rc || !v1 || !v2) {
+      return SORTASCMAP_GETASC(ascMap, i) ? -rc : rc;
+    }
+  }
+  return 0;
+}
+
+TEST_F(SortKeyTest, testParity) {
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  const RLookupKey *keys[3];
+  keys[0] = RLookup_GetKey(&lk, "a", RLOOKUP_F_OCREAT);
+  keys[1] = RLookup_GetKey(&lk, "b", RLOOKUP_F_OCREAT);
+  keys[2] = RLookup_GetKey(&lk, "c", RLOOKUP_F_OCREAT);
+
+  srand(49);
+  size_t decided = 0;
+  for (size_t i = 0; i < 20000; i++) {
+    size_t nkeys = 1 + rand() % 3;
+    uint64_t ascMap = rand();
+    RLookupRow rows[2] = {{0}};
+    for (size_t j = 0; j < 2; j++) {
+      for (size_t k = 0; k < nkeys; k++) {
+        RSValue *v = randomValue();
+        if (v) {
+          RLookup_WriteOwnKey(keys[k], &rows[j], v);
+        }
+      }
+    }
+    // equal rows now and then
+    if (rand() % 4 == 0) {
+      for (size_t k = 0; k < nkeys; k++) {
+        RSValue *v = RLookup_GetItem(keys[k], &rows[0]);
+        if (v) {
+          RLookup_WriteKey(keys[k], &rows[1], v);
+        }
+      }
+    }
+
+    std::vector<char> k1(SortKey_Size(nkeys)), k2(SortKey_Size(nkeys));
+    SortKey_Encode(&k1[0], keys, nkeys, ascMap, &rows[0]);
+    SortKey_Encode(&k2[0], keys, nkeys, ascMap, &rows[1]);
+    int rc = SortKey_Cmp(&k1[0], &k2[0], nkeys);
+    if (rc) {
+      ASSERT_EQ(sign(cmpFields(keys, nkeys, ascMap, &rows[0], &rows[1])), sign(rc)) << i;
+      ASSERT_EQ(-sign(rc), sign(SortKey_Cmp(&k2[0], &k1[0], nkeys)));
+      decided++;
+    }
+    RLookupRow_Cleanup(&rows[0]);
+    RLookupRow_Cleanup(&rows[1]);
+  }
+  // the rows of the same types are mostly ordered by their keys
+  ASSERT_GT(decided, 20000 / 10);
+  RLookup_Cleanup(&lk);
+}
+
+TEST_F(SortKeyTest, testNumbers) {
+  // numbers are always ordered by their keys, unless equal
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  const RLookupKey *keys[1] = {RLookup_GetKey(&lk, "n", RLOOKUP_F_OCREAT)};
+  std::vector<double> numbers = {-INFINITY, -1e300, -3, -2.5, -1e-300, 0, 1e-300, 1, 1.5, 1e300,
+                                 INFINITY};
+  for (int asc = 0; asc < 2; asc++) {
+    for (size_t i = 0; i < numbers.size(); i++) {
+      for (size_t j = 0; j < numbers.size(); j++) {
+        RLookupRow r1 = {0}, r2 = {0};
+        RLookup_WriteOwnKey(keys[0], &r1, RS_NumVal(numbers[i]));
+        RLookup_WriteOwnKey(keys[0], &r2, RS_NumVal(numbers[j]));
+        char k1[SORTKEY_FIELD_SIZE], k2[SORTKEY_FIELD_SIZE];
+        SortKey_Encode(k1, keys, 1, asc, &r1);
+        SortKey_Encode(k2, keys, 1, asc, &r2);
+        int expected = i < j ? -1 : (i > j ? 1 : 0);
+        ASSERT_EQ(asc ? -expected : expected, sign(SortKey_Cmp(k1, k2, 1))) << i << " " << j;
+        RLookupRow_Cleanup(&r1);
+        RLookupRow_Cleanup(&r2);
+      }
+    }
+  }
+
+  // -0 is 0
+  RLookupRow r1 = {0}, r2 = {0};
+  RLookup_WriteOwnKey(keys[0], &r1, RS_NumVal(-0.0));
+  RLookup_WriteOwnKey(keys[0], &r2, RS_NumVal(0));
+  char k1[SORTKEY_FIELD_SIZE], k2[SORTKEY_FIELD_SIZE];
+  SortKey_Encode(k1, keys, 1, 0, &r1);
+  SortKey_Encode(k2, keys, 1, 0, &r2);
+  ASSERT_EQ(0, memcmp(k1, k2, SORTKEY_FIELD_SIZE));
+  RLookupRow_Cleanup(&r1);
+  RLookupRow_Cleanup(&r2);
+  RLookup_Cleanup(&lk);
+}
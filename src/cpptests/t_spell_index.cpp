@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "spell_index.h"
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef std::set<std::string> TermSet;
+
+class SpellIndexTest : public ::testing::Test {};
+
+static int editDistance(const std::string &a, const std::string &b, bool transpositions) {
+  std::vector<std::vector<int>> d(a.size() + 1, std::vector<int>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); ++i) {
+    for (size_t j = 0; j <= b.size(); ++j) {
+      if (!i || !j) {
+        d[i][j] = i + j;
+        continue;
+      }
+      d[i][j] = std::min({d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (a[i - 1] != b[j - 1])});
+      if (transpositions && i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+        d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+      }
+    }
+  }
+  return d[a.size()][b.size()];
+}
+
+static int spellIndexFind(SpellIndex *si, const std::string &q, int maxDist, bool transpositions,
+                          TermSet &found) {
+  return SpellIndex_Find(si, q.c_str(), q.size(), maxDist, transpositions,
+                         [](const char *term, size_t len, void *ctx) {
+                           TermSet *found = (TermSet *)ctx;
+                           std::string s(term, len);
+                           ASSERT_EQ(found->end(), found->find(s));
+                           found->insert(s);
+                         },
+                         &found);
+}
+
+TEST_F(SpellIndexTest, testFind) {
+  SpellIndex *si = NewSpellIndex();
+  srand(3);
+  TermSet terms;
+  for (size_t ii = 0; ii < 3000; ++ii) {
+    std::string s;
+    for (size_t jj = 0, n = 1 + rand() % 8; jj < n; ++jj) {
+      s += 'a' + rand() % 5;
+    }
+    if (terms.insert(s).second) {
+      SpellIndex_Add(si, s.c_str(), s.size());
+    }
+  }
+  ASSERT_EQ(terms.size(), SpellIndex_NumTerms(si));
+
+  for (const char *query : {"", "a", "abc", "bac", "eddea", "aabbcc", "ecdbaab", "abcdeabcde"}) {
+    std::string q(query);
+    for (int maxDist = 0; maxDist <= SPELL_INDEX_MAX_DISTANCE; ++maxDist) {
+      for (bool transpositions : {false, true}) {
+        TermSet expected, found;
+        for (auto &term : terms) {
+          if (editDistance(q, term, transpositions) <= maxDist) {
+            expected.insert(term);
+          }
+        }
+        ASSERT_TRUE(spellIndexFind(si, q, maxDist, transpositions, found));
+        ASSERT_EQ(expected, found) << q << " " << maxDist << " " << transpositions;
+      }
+    }
+  }
+  SpellIndex_Free(si);
+}
+
+TEST_F(SpellIndexTest, testCannotAnswer) {
+  SpellIndex *si = NewSpellIndex();
+  std::string longTerm(SPELL_INDEX_MAX_TERM_LEN + 1, 'a');
+  SpellIndex_Add(si, longTerm.c_str(), longTerm.size());
+  SpellIndex_Add(si, "hello", 5);
+  ASSERT_EQ(1, SpellIndex_NumTerms(si));
+
+  TermSet found;
+  // above the maximal distance
+  ASSERT_FALSE(spellIndexFind(si, "hello", SPELL_INDEX_MAX_DISTANCE + 1, false, found));
+  // could match terms too long to be indexed
+  ASSERT_FALSE(spellIndexFind(si, std::string(SPELL_INDEX_MAX_TERM_LEN, 'a'), 1, false, found));
+  ASSERT_TRUE(found.empty());
+
+  // matching is case insensitive, and returns the terms as they were added
+  ASSERT_TRUE(spellIndexFind(si, "HELO", 1, false, found));
+  ASSERT_EQ(TermSet({"hello"}), found);
+  SpellIndex_Free(si);
+}
+
+TEST_F(SpellIndexTest, testDelete) {
+  SpellIndex *si = NewSpellIndex();
+  srand(5);
+  std::vector<std::string> all;
+  for (size_t ii = 0; ii < 1000; ++ii) {
+    std::string s;
+    for (size_t jj = 0, n = 1 + rand() % 6; jj < n; ++jj) {
+      s += 'a' + rand() % 5;
+    }
+    all.push_back(s);
+  }
+
+  TermSet terms;
+  size_t memUsage = 0;
+  for (int round = 0; round < 4; ++round) {
+    // the terms come and go, and an existing term is not added again
+    for (auto &s : all) {
+      bool in = terms.count(s);
+      if (rand() % 2) {
+        ASSERT_EQ(!in, SpellIndex_Add(si, s.c_str(), s.size())) << s;
+        terms.insert(s);
+      } else {
+        ASSERT_EQ(in, SpellIndex_Delete(si, s.c_str(), s.size())) << s;
+        terms.erase(s);
+      }
+    }
+    ASSERT_EQ(terms.size(), SpellIndex_NumTerms(si));
+
+    for (const char *query : {"a", "abc", "eddea", "aabbc"}) {
+      TermSet expected, found;
+      for (auto &term : terms) {
+        if (editDistance(query, term, false) <= SPELL_INDEX_MAX_DISTANCE) {
+          expected.insert(term);
+        }
+      }
+      ASSERT_TRUE(spellIndexFind(si, query, SPELL_INDEX_MAX_DISTANCE, false, found));
+      ASSERT_EQ(expected, found) << query;
+    }
+
+    // refilled with all the terms, the index takes the same memory on every round once the list of
+    // free ids was sized
+    for (auto &s : all) {
+      SpellIndex_Add(si, s.c_str(), s.size());
+      terms.insert(s);
+    }
+    if (round == 1) {
+      memUsage = SpellIndex_MemUsage(si);
+    } else if (round > 1) {
+      ASSERT_EQ(memUsage, SpellIndex_MemUsage(si));
+    }
+  }
+
+  for (auto &term : terms) {
+    ASSERT_TRUE(SpellIndex_Delete(si, term.c_str(), term.size()));
+  }
+  ASSERT_EQ(0, SpellIndex_NumTerms(si));
+  TermSet found;
+  ASSERT_TRUE(spellIndexFind(si, "abc", SPELL_INDEX_MAX_DISTANCE, false, found));
+  ASSERT_TRUE(found.empty());
+  SpellIndex_Free(si);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "suffix_index.h"
+#include <set>
+#include <string>
+
+typedef std::set<std::string> TermSet;
+
+class SuffixIndexTest : public ::testing::Test {};
+
+static TermSet suffixIndexFind(SuffixIndex *si, const std::string &q, bool contains) {
+  TermSet found;
+  SuffixIndex_Find(si, q.c_str(), q.size(), contains,
+                   [](const char *term, size_t len, void *ctx) {
+                     TermSet *found = (TermSet *)ctx;
+                     std::string s(term, len);
+                     EXPECT_EQ(found->end(), found->find(s));
+                     found->insert(s);
+                     return 1;
+                   },
+                   &found);
+  return found;
+}
+
+static void assertFind(SuffixIndex *si, const TermSet &terms, const std::string &q) {
+  for (bool contains : {false, true}) {
+    TermSet expected;
+    for (auto &term : terms) {
+      size_t pos = contains ? term.find(q) : term.rfind(q);
+      if (pos != std::string::npos && (contains || pos + q.size() == term.size())) {
+        expected.insert(term);
+      }
+    }
+    ASSERT_EQ(expected, suffixIndexFind(si, q, contains)) << q << " " << contains;
+  }
+}
+
+TEST_F(SuffixIndexTest, testFind) {
+  SuffixIndex *si = NewSuffixIndex();
+  srand(3);
+  TermSet terms;
+  for (size_t ii = 0; ii < 3000; ++ii) {
+    std::string s;
+    for (size_t jj = 0, n = 1 + rand() % 8; jj < n; ++jj) {
+      s += 'a' + rand() % 4;
+    }
+    ASSERT_EQ(terms.insert(s).second, SuffixIndex_Add(si, s.c_str(), s.size()));
+  }
+  ASSERT_EQ(terms.size(), SuffixIndex_NumTerms(si));
+
+  const char *queries[] = {"a", "ab", "abc", "dda", "cbad", "abcdabcd", "e"};
+  for (const char *q : queries) {
+    assertFind(si, terms, q);
+  }
+
+  // delete half of the terms
+  size_t usage = SuffixIndex_MemUsage(si);
+  for (auto it = terms.begin(); it != terms.end();) {
+    if (rand() % 2) {
+      ASSERT_TRUE(SuffixIndex_Delete(si, it->c_str(), it->size()));
+      ASSERT_FALSE(SuffixIndex_Delete(si, it->c_str(), it->size()));
+      it = terms.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(terms.size(), SuffixIndex_NumTerms(si));
+  ASSERT_LT(SuffixIndex_MemUsage(si), usage);
+  for (const char *q : queries) {
+    assertFind(si, terms, q);
+  }
+  SuffixIndex_Free(si);
+}
+
+TEST_F(SuffixIndexTest, testUtf8) {
+  SuffixIndex *si = NewSuffixIndex();
+  // suffixes start at letters, never inside the bytes of one
+  std::string term = "caf\xc3\xa9";
+  SuffixIndex_Add(si, term.c_str(), term.size());
+  ASSERT_EQ(TermSet({term}), suffixIndexFind(si, "\xc3\xa9", false));
+  ASSERT_EQ(TermSet({term}), suffixIndexFind(si, "f\xc3\xa9", false));
+  ASSERT_EQ(TermSet(), suffixIndexFind(si, "\xa9", false));
+  ASSERT_EQ(TermSet(), suffixIndexFind(si, "\xa9", true));
+
+  // the search stops when the callback asks to
+  SuffixIndex_Add(si, "cafe", 4);
+  size_t calls = 0;
+  SuffixIndex_Find(si, "caf", 3, 1,
+                   [](const char *, size_t, void *ctx) {
+                     ++*(size_t *)ctx;
+                     return 0;
+                   },
+                   &calls);
+  ASSERT_EQ(1, calls);
+  SuffixIndex_Free(si);
+}
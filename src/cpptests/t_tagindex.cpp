@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 
 class TagIndexTest : public ::testing::Test {};
 
@@ -48,6 +49,61 @@ TEST_F(TagIndexTest, testCreate) {
   TagIndex_Free(idx);
 }
 
+static std::vector<t_docId> tagDocs(TagIndex *idx, const char *tag) {
+  std::vector<t_docId> docs;
+  IndexIterator *it = TagIndex_OpenReader(idx, NULL, tag, strlen(tag), 1);
+  if (!it) {
+    return docs;
+  }
+  RSIndexResult *r;
+  while (INDEXREAD_EOF != it->Read(it->ctx, &r)) {
+    docs.push_back(r->docId);
+  }
+  it->Free(it);
+  return docs;
+}
+
+TEST_F(TagIndexTest, testUnindex) {
+  TagIndex *idx = NewTagIndex();
+  std::vector<const char *> foo{"foo"}, bar{"bar"};
+  std::vector<t_docId> fooDocs, barDocs;
+  for (t_docId d = 1; d <= 1000; d++) {
+    TagIndex_Index(idx, &foo[0], 1, d);
+    fooDocs.push_back(d);
+  }
+
+  // a document updated in place moves from one tag to the other, keeping its id
+  for (t_docId d = 10; d <= 1000; d += 10) {
+    ASSERT_EQ(1, TagIndex_Unindex(idx, &foo[0], 1, d));
+    ASSERT_EQ(0, TagIndex_Unindex(idx, &foo[0], 1, d));
+    ASSERT_EQ(0, TagIndex_Unindex(idx, &bar[0], 1, d));
+    fooDocs.erase(std::find(fooDocs.begin(), fooDocs.end(), d));
+  }
+  for (t_docId d = 1000; d >= 10; d -= 10) {
+    ASSERT_GT(TagIndex_Index(idx, &bar[0], 1, d), 0);
+    barDocs.insert(barDocs.begin(), d);
+  }
+  // and back, into the middle of its old tag's blocks
+  ASSERT_EQ(1, TagIndex_Unindex(idx, &bar[0], 1, 500));
+  ASSERT_GT(TagIndex_Index(idx, &foo[0], 1, 500), 0);
+  ASSERT_EQ(0, TagIndex_Index(idx, &foo[0], 1, 500));
+  barDocs.erase(std::find(barDocs.begin(), barDocs.end(), 500));
+  fooDocs.insert(std::lower_bound(fooDocs.begin(), fooDocs.end(), 500), 500);
+
+  ASSERT_EQ(fooDocs, tagDocs(idx, "foo"));
+  ASSERT_EQ(barDocs, tagDocs(idx, "bar"));
+
+  // removing the last documents of a tag lets it be written to again
+  ASSERT_EQ(1, TagIndex_Unindex(idx, &foo[0], 1, 999));
+  ASSERT_EQ(1, TagIndex_Unindex(idx, &foo[0], 1, 998));
+  InvertedIndex *iv = TagIndex_OpenIndex(idx, "foo", 3, 0);
+  ASSERT_EQ(997, iv->lastId);
+  ASSERT_EQ(fooDocs.size() - 2, iv->numDocs);
+  ASSERT_GT(TagIndex_Index(idx, &foo[0], 1, 1001), 0);
+  ASSERT_EQ(1001, tagDocs(idx, "foo").back());
+  TagIndex_Free(idx);
+}
+
 #define TEST_MY_SEP(sep, str)                     \
   orig = s = strdup(str);                         \
   token = TagIndex_SepString(sep, &s, &tokenLen); \
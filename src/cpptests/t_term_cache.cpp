@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "term_cache.h"
+#include "stemmer.h"
+#include "phonetic_manager.h"
+#include "config.h"
+#include "rmalloc.h"
+#include <string>
+#include <thread>
+
+class TermCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // the stemmers of the indexes of previous tests fill this thread's cache
+    TermCache_FreeThread();
+  }
+  void TearDown() override {
+    RSGlobalConfig.termCacheSize = DEFAULT_TERM_CACHE_SIZE;
+    TermCache_FreeThread();
+  }
+};
+
+static std::string stem(Stemmer *st, const char *word) {
+  size_t len;
+  const char *s = st->Stem(st->ctx, word, strlen(word), &len);
+  return s ? std::string(s, len) : "";
+}
+
+TEST_F(TermCacheTest, testGetPut) {
+  const char *res;
+  size_t len;
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, &res, &len));
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, "run", 3);
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, "run", 3, NULL, 0);
+  ASSERT_TRUE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, &res, &len));
+  ASSERT_EQ("run", std::string(res, len));
+  // a term without a result is cached too
+  ASSERT_TRUE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "run", 3, &res, &len));
+  ASSERT_EQ(NULL, res);
+
+  // the language and the kind are part of the key
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_FRENCH, "running", 7, &res, &len));
+  ASSERT_FALSE(TermCache_Get(TermCache_Phonetics, RS_LANG_ENGLISH, "running", 7, &res, &len));
+  // as is the whole term
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "runnin", 6, &res, &len));
+
+  // terms which do not fit an entry are not cached
+  std::string longTerm(TERM_CACHE_DATA_SIZE - 2, 'x');
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, longTerm.c_str(), longTerm.size(), "xxx", 3);
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, longTerm.c_str(), longTerm.size(),
+                             &res, &len));
+
+  // a term hashed to the same entry evicts the older one
+  RSGlobalConfig.termCacheSize = 1;
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, "run", 3);
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, "jumping", 7, "jump", 4);
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, &res, &len));
+  ASSERT_TRUE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "jumping", 7, &res, &len));
+
+  // and a size of 0 disables the cache
+  RSGlobalConfig.termCacheSize = 0;
+  TermCache_Put(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, "run", 3);
+  ASSERT_FALSE(TermCache_Get(TermCache_Stems, RS_LANG_ENGLISH, "running", 7, &res, &len));
+}
+
+TEST_F(TermCacheTest, testStemsAndPhonetics) {
+  const char *words[] = {"running", "run", "arbitrary", "Kitties", "gardens", "hello", NULL};
+  Stemmer *st = NewStemmer(SnowballStemmer, RS_LANG_ENGLISH);
+  TermCacheStats before = TermCache_GetStats(TermCache_Stems);
+
+  // the cached results are those of the stemmer and the phonetic encoder
+  for (int i = 0; words[i]; i++) {
+    RSGlobalConfig.termCacheSize = 0;
+    std::string expected = stem(st, words[i]);
+    char *p0 = NULL, *s0 = NULL;
+    PhoneticManager_ExpandPhonetics(NULL, words[i], strlen(words[i]), &p0, &s0);
+
+    RSGlobalConfig.termCacheSize = DEFAULT_TERM_CACHE_SIZE;
+    for (int j = 0; j < 2; j++) {
+      ASSERT_EQ(expected, stem(st, words[i])) << words[i];
+      char *p = NULL, *s = NULL;
+      PhoneticManager_ExpandPhonetics(NULL, words[i], strlen(words[i]), &p, &s);
+      ASSERT_STREQ(p0, p);
+      ASSERT_STREQ(s0, s);
+      rm_free(p);
+      rm_free(s);
+    }
+    rm_free(p0);
+    rm_free(s0);
+  }
+  ASSERT_EQ("+run", stem(st, "running"));
+
+  // each word missed once, the first time it was stemmed with the cache enabled
+  TermCacheStats after = TermCache_GetStats(TermCache_Stems);
+  ASSERT_EQ(6, after.misses - before.misses);
+  ASSERT_EQ(6 + 1, after.hits - before.hits);
+  st->Free(st);
+
+  // the stats of a thread are kept once it exits
+  before = TermCache_GetStats(TermCache_Phonetics);
+  std::thread([] {
+    char *p = NULL;
+    for (int i = 0; i < 3; i++) {
+      PhoneticManager_ExpandPhonetics(NULL, "hello", 5, &p, NULL);
+      rm_free(p);
+    }
+  }).join();
+  after = TermCache_GetStats(TermCache_Phonetics);
+  ASSERT_EQ(1, after.misses - before.misses);
+  ASSERT_EQ(2, after.hits - before.hits);
+}
@@ -2,6 +2,8 @@
 #include "stemmer.h"
 #include "tokenize.h"
 #include <set>
+#include <string>
+#include <vector>
 
 class TokenizerTest : public ::testing::Test {};
 
@@ -120,4 +122,67 @@ TEST_F(TokenizerTest, testTrailingEscapes) {
   ASSERT_NE(tokens.end(), tokens.find("world "));  // note the space
   tk->Free(tk);
   free(txt);
-}
\ No newline at end of file
+}
+
+struct TokenizeResult {
+  // the tokens, their offsets in the text, and the text once tokenized
+  std::vector<std::string> tokens, stems;
+  std::vector<size_t> offsets;
+  std::string text;
+};
+
+static TokenizeResult tokenize(Stemmer *st, const std::string &text, uint32_t options) {
+  RSTokenizer *tk = NewSimpleTokenizer(st, DefaultStopWordList(), 0);
+  std::vector<char> buf(text.begin(), text.end());
+  buf.push_back('\0');
+  tk->Start(tk, &buf[0], text.size(), options);
+  TokenizeResult res;
+  Token t = {0};
+  while (tk->Next(tk, &t)) {
+    EXPECT_EQ(res.tokens.size() + 1, t.pos);
+    res.tokens.push_back(std::string(t.tok, t.tokLen));
+    res.stems.push_back(t.stem ? std::string(t.stem, t.stemLen) : "");
+    res.offsets.push_back(t.raw - &buf[0]);
+    t.stem = NULL;
+  }
+  res.text.assign(&buf[0], text.size());
+  tk->Free(tk);
+  return res;
+}
+
+TEST_F(TokenizerTest, testASCIIFastPath) {
+  // the vectorized scan of ASCII tokens gives the same tokens as the scalar one, down to the text
+  // normalized in place
+  static const char *pieces[] = {"a",  "Z",  "q",   "7",    "_",   " ",  "  ", ",",   ".",
+                                 "\\", "\t", "\n",  "\x01", "\x7f", "-",  "é",  "\xff", "@",
+                                 "[",  "`",  "the", "Hello", "WORLDS", "running"};
+  Stemmer *st = NewStemmer(SnowballStemmer, RS_LANG_ENGLISH);
+  srand(44);
+  for (size_t ii = 0; ii < 3000; ++ii) {
+    std::string text;
+    for (size_t jj = 0, n = rand() % 200; jj < n; ++jj) {
+      // mostly words, some long enough to span several chunks, or the normalization buffer
+      size_t r = rand() % 100;
+      if (r < 60) {
+        text += pieces[rand() % (sizeof(pieces) / sizeof(*pieces))];
+      } else if (r < 65) {
+        text.append(1 + rand() % 150, "aBc9_"[rand() % 5]);
+      } else {
+        text += pieces[rand() % 21];
+      }
+    }
+    for (uint32_t options : {TOKENIZE_DEFAULT_OPTIONS, TOKENIZE_NOMODIFY, TOKENIZE_NOSTEM}) {
+      TokenizeResult fast = tokenize(st, text, options);
+      TokenizeResult scalar = tokenize(st, text, options | TOKENIZE_SCALAR);
+      ASSERT_EQ(scalar.tokens, fast.tokens) << text;
+      ASSERT_EQ(scalar.stems, fast.stems) << text;
+      ASSERT_EQ(scalar.offsets, fast.offsets) << text;
+      ASSERT_EQ(scalar.text, fast.text) << text;
+    }
+  }
+
+  // a NUL byte ends the text, as with the scalar scan
+  TokenizeResult res = tokenize(st, std::string("Hello Worlds\0Again", 18), 0);
+  ASSERT_EQ(std::vector<std::string>({"hello", "worlds"}), res.tokens);
+  st->Free(st);
+}
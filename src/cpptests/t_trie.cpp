@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 #include <trie/trie.h>
 #include <trie/trie_type.h>
+#include "rmalloc.h"
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 typedef std::set<std::string> ElemSet;
 
@@ -41,17 +47,18 @@ static ElemSet trieIterRange(Trie *t, const char *begin, size_t nbegin, const ch
   }
 
   ElemSet foundElements;
-  TrieNode_IterateRange(t->root, r1Ptr, nr1, true, r2Ptr, nr2, false,
-                        [](const rune *u16, size_t nrune, void *ctx) {
-                          size_t n;
-                          char *s = runesToStr(u16, nrune, &n);
-                          std::string xs(s, n);
-                          free(s);
-                          ElemSet *e = (ElemSet *)ctx;
-                          ASSERT_EQ(e->end(), e->find(xs));
-                          e->insert(xs);
-                        },
-                        &foundElements);
+  Trie_IterateRange(t, r1Ptr, nr1, true, r2Ptr, nr2, false,
+                    [](const rune *u16, size_t nrune, void *ctx) {
+                      size_t n;
+                      char *s = runesToStr(u16, nrune, &n);
+                      std::string xs(s, n);
+                      free(s);
+                      ElemSet *e = (ElemSet *)ctx;
+                      EXPECT_EQ(e->end(), e->find(xs));
+                      e->insert(xs);
+                      return 1;
+                    },
+                    &foundElements);
   return foundElements;
 }
 
@@ -119,3 +126,350 @@ TEST_F(TrieTest, testDeepEntry) {
   ASSERT_EQ(maxbuf, ret.size());
   TrieType_Free(t);
 }
+
+// checks that each node's max score is the max score of its subtree
+static float checkMaxScore(TrieNode *n) {
+  float maxScore = n->score;
+  for (t_len i = 0; i < n->numChildren; ++i) {
+    maxScore = std::max(maxScore, checkMaxScore(__trieNode_children(n)[i]));
+  }
+  EXPECT_EQ(maxScore, n->maxChildScore);
+  return maxScore;
+}
+
+// the top scores of Trie_Search, found by iterating all the matching completions instead
+static std::vector<float> searchAll(Trie *t, const std::string &prefix, size_t num, int maxDist) {
+  size_t rlen;
+  rune *runes = strToFoldedRunes(prefix.c_str(), &rlen);
+  TrieIterator *it = Trie_Iterate(t, prefix.c_str(), prefix.size(), maxDist, 1);
+  rune *rstr;
+  t_len slen;
+  float score;
+  int dist = maxDist + 1;
+  std::vector<float> scores;
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    if (slen == rlen && !memcmp(runes, rstr, slen * sizeof(rune))) {
+      score = INT_MAX;
+    }
+    if (maxDist > 0) {
+      score *= exp((double)-(2 * dist));
+    }
+    score /= sqrt(1 + (slen >= prefix.size() ? slen - prefix.size() : prefix.size() - slen));
+    scores.push_back(score);
+  }
+  DFAFilter_Free((DFAFilter *)it->ctx);
+  rm_free(it->ctx);
+  TrieIterator_Free(it);
+  rm_free(runes);
+  std::sort(scores.begin(), scores.end(), std::greater<float>());
+  scores.resize(std::min(num, scores.size()));
+  return scores;
+}
+
+TEST_F(TrieTest, testTopK) {
+  Trie *t = NewTrie();
+  srand(1);
+  std::vector<std::string> terms;
+  for (size_t ii = 0; ii < 5000; ++ii) {
+    std::string s;
+    for (size_t jj = 0, n = 2 + rand() % 6; jj < n; ++jj) {
+      s += 'a' + rand() % 4;
+    }
+    Trie_InsertStringBuffer(t, s.c_str(), s.size(), 1 + rand() % 1000, rand() % 2, NULL);
+    terms.push_back(s);
+  }
+  // lower the scores of some and delete others, which must lower the bounds of their subtrees
+  for (size_t ii = 0; ii < terms.size(); ii += 3) {
+    Trie_InsertStringBuffer(t, terms[ii].c_str(), terms[ii].size(), 0.5, 0, NULL);
+  }
+  for (size_t ii = 1; ii < terms.size(); ii += 7) {
+    Trie_Delete(t, terms[ii].c_str(), terms[ii].size());
+  }
+  checkMaxScore(t->root);
+
+  for (const char *prefix : {"a", "ab", "abc", "dcb", "bbbb", "abcdabcd", "x"}) {
+    for (int maxDist : {0, 1}) {
+      auto expected = searchAll(t, prefix, 10, maxDist);
+      Vector *res = Trie_Search(t, prefix, strlen(prefix), 10, maxDist, 1, 0, 0);
+      ASSERT_EQ(expected.size(), Vector_Size(res)) << prefix << " " << maxDist;
+      for (size_t ii = 0; ii < Vector_Size(res); ++ii) {
+        TrieSearchResult *e;
+        Vector_Get(res, ii, &e);
+        ASSERT_FLOAT_EQ(expected[ii], e->score) << prefix << " " << maxDist << " " << ii;
+        TrieSearchResult_Free(e);
+      }
+      Vector_Free(res);
+    }
+  }
+  TrieType_Free(t);
+}
+
+// the edit distance of two strings, counting a swap of adjacent letters as one edit if set
+static int editDistance(const std::string &a, const std::string &b, bool transpositions) {
+  std::vector<std::vector<int>> d(a.size() + 1, std::vector<int>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); ++i) {
+    for (size_t j = 0; j <= b.size(); ++j) {
+      if (!i || !j) {
+        d[i][j] = i + j;
+        continue;
+      }
+      d[i][j] = std::min({d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (a[i - 1] != b[j - 1])});
+      if (transpositions && i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+        d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+      }
+    }
+  }
+  return d[a.size()][b.size()];
+}
+
+TEST_F(TrieTest, testFuzzy) {
+  Trie *t = NewTrie();
+  srand(2);
+  ElemSet terms;
+  for (size_t ii = 0; ii < 3000; ++ii) {
+    std::string s;
+    for (size_t jj = 0, n = 1 + rand() % 7; jj < n; ++jj) {
+      s += 'a' + rand() % 5;
+    }
+    trieInsert(t, s);
+    terms.insert(s);
+  }
+
+  for (const char *query : {"abc", "bac", "eddea", "a", "aabbcc", "ecdba"}) {
+    for (int maxDist : {1, 2}) {
+      for (int transpositions : {0, 1}) {
+        size_t rlen;
+        rune *runes = strToFoldedRunes(query, &rlen);
+        DFAFilter fc = NewDFAFilter(runes, rlen, maxDist, 0, transpositions);
+        TrieIterator *it = TrieNode_Iterate(t->root, FilterFunc, StackPop, &fc);
+        rune *rstr;
+        t_len slen;
+        float score;
+        int dist;
+        ElemSet found;
+        while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+          size_t n;
+          char *s = runesToStr(rstr, slen, &n);
+          found.insert(std::string(s, n));
+          rm_free(s);
+        }
+        TrieIterator_Free(it);
+        DFAFilter_Free(&fc);
+        rm_free(runes);
+
+        // the filter also accepts a term if it matches without its last letter, as long as the
+        // term is still within reach of some prefix of the query
+        std::string q(query);
+        auto prefixDistance = [&](const std::string &term) {
+          int d = maxDist + 1;
+          for (size_t jj = 0; jj <= q.size(); ++jj) {
+            d = std::min(d, editDistance(q.substr(0, jj), term, transpositions));
+          }
+          return d;
+        };
+        ElemSet expected;
+        for (auto &term : terms) {
+          if (editDistance(q, term, transpositions) <= maxDist ||
+              (editDistance(q, term.substr(0, term.size() - 1), transpositions) <= maxDist &&
+               prefixDistance(term) <= maxDist)) {
+            expected.insert(term);
+          }
+        }
+        ASSERT_EQ(expected, found) << query << " " << maxDist << " " << transpositions;
+      }
+    }
+  }
+  TrieType_Free(t);
+}
+
+typedef std::map<std::string, std::pair<float, std::string>> TermMap;
+
+// all the terms of a trie, with their scores and payloads
+static TermMap trieTerms(Trie *t) {
+  TermMap terms;
+  TrieIterator *it = Trie_Iterate(t, "", 0, 0, 1);
+  rune *rstr;
+  t_len slen;
+  float score;
+  RSPayload payload;
+  while (TrieIterator_Next(it, &rstr, &slen, &payload, &score, NULL)) {
+    size_t n;
+    char *s = runesToStr(rstr, slen, &n);
+    std::string term(s, n);
+    EXPECT_EQ(terms.end(), terms.find(term));
+    terms[term] = {score, std::string(payload.data ? payload.data : "", payload.len)};
+    rm_free(s);
+  }
+  DFAFilter_Free((DFAFilter *)it->ctx);
+  rm_free(it->ctx);
+  TrieIterator_Free(it);
+  return terms;
+}
+
+static ElemSet trieFuzzy(Trie *t, const char *query, int maxDist) {
+  ElemSet found;
+  TrieIterator *it = Trie_Iterate(t, query, strlen(query), maxDist, 0);
+  rune *rstr;
+  t_len slen;
+  float score;
+  int dist;
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    size_t n;
+    char *s = runesToStr(rstr, slen, &n);
+    found.insert(std::string(s, n));
+    rm_free(s);
+  }
+  DFAFilter_Free((DFAFilter *)it->ctx);
+  rm_free(it->ctx);
+  TrieIterator_Free(it);
+  return found;
+}
+
+static std::vector<std::pair<float, std::string>> trieTopK(Trie *t, const char *prefix,
+                                                            int maxDist) {
+  // the scores and the strings with their payloads
+  std::vector<std::pair<float, std::string>> ret;
+  Vector *res = Trie_Search(t, prefix, strlen(prefix), 10, maxDist, 1, 0, 0);
+  for (size_t ii = 0; ii < Vector_Size(res); ++ii) {
+    TrieSearchResult *e;
+    Vector_Get(res, ii, &e);
+    ret.push_back({e->score, std::string(e->str, e->len) + "/" +
+                                 std::string(e->payload ? e->payload : "", e->plen)});
+    TrieSearchResult_Free(e);
+  }
+  Vector_Free(res);
+  return ret;
+}
+
+TEST_F(TrieTest, testFreeze) {
+  // the same operations on a trie that is frozen along the way and on one that is never frozen
+  Trie *frozen = NewTrie(), *t = NewTrie();
+  srand(4);
+  std::vector<std::string> terms;
+  for (int round = 0; round < 3; ++round) {
+    for (size_t ii = 0; ii < 3000; ++ii) {
+      std::string s;
+      for (size_t jj = 0, n = 1 + rand() % 7; jj < n; ++jj) {
+        s += 'a' + rand() % 5;
+      }
+      // re-add old terms as well, some of which are in the frozen part
+      if (round && rand() % 4 == 0) {
+        s = terms[rand() % terms.size()];
+      }
+      double score = 1 + rand() % 1000;
+      int incr = rand() % 2;
+      std::string pl = std::to_string(rand() % 10);
+      RSPayload payload = {.data = (char *)pl.c_str(), .len = pl.size()};
+      RSPayload *p = rand() % 3 ? NULL : &payload;
+      ASSERT_EQ(Trie_InsertStringBuffer(t, s.c_str(), s.size(), score, incr, p),
+                Trie_InsertStringBuffer(frozen, s.c_str(), s.size(), score, incr, p));
+      terms.push_back(s);
+    }
+    for (size_t ii = 0; ii < terms.size(); ii += 11) {
+      ASSERT_EQ(Trie_Delete(t, terms[ii].c_str(), terms[ii].size()),
+                Trie_Delete(frozen, terms[ii].c_str(), terms[ii].size()));
+    }
+    if (round < 2) {
+      Trie_Freeze(frozen);
+      ASSERT_EQ(frozen->size, frozen->frozen->size);
+    }
+    ASSERT_TRUE(frozen->frozen != NULL);
+    ASSERT_EQ(t->size, frozen->size);
+
+    TermMap all = trieTerms(t);
+    ASSERT_EQ(t->size, all.size());
+    ASSERT_EQ(all, trieTerms(frozen));
+    for (const char *query : {"a", "abc", "eddea", "aabbcc"}) {
+      ASSERT_EQ(trieFuzzy(t, query, 1), trieFuzzy(frozen, query, 1)) << query;
+    }
+    for (const char *prefix : {"a", "ab", "abc", "dcb", "bbbb", "x"}) {
+      for (int maxDist : {0, 1}) {
+        ASSERT_EQ(trieTopK(t, prefix, maxDist), trieTopK(frozen, prefix, maxDist))
+            << prefix << " " << maxDist;
+      }
+    }
+    // ranges are checked while all the terms are frozen
+    if (round < 2) {
+      for (auto &range : std::vector<std::pair<const char *, const char *>>{
+               {"a", "b"}, {"abc", "ac"}, {NULL, "bb"}, {"dd", NULL}, {"c", "c"}}) {
+        ElemSet expected;
+        for (auto &e : all) {
+          if ((!range.first || e.first >= range.first) &&
+              (!range.second || e.first < range.second)) {
+            expected.insert(e.first);
+          }
+        }
+        ASSERT_EQ(expected, trieIterRange(frozen, range.first, range.second))
+            << (range.first ? range.first : "") << " " << (range.second ? range.second : "");
+      }
+    }
+  }
+
+  // the trie freezes on its own once enough terms are added, over the following inserts
+  for (size_t ii = 0; !t->frozen; ++ii) {
+    ASSERT_LT(ii, 2 * TRIE_FREEZE_MIN_TERMS);
+    std::string s = "term" + std::to_string(ii);
+    Trie_InsertStringBuffer(t, s.c_str(), s.size(), 1, 0, NULL);
+  }
+  ASSERT_TRUE(t->freezing == NULL);
+  ASSERT_EQ(t->size, trieTerms(t).size());
+  double score;
+  char *str;
+  t_len len;
+  ASSERT_TRUE(Trie_RandomKey(t, &str, &len, &score));
+  rm_free(str);
+
+  TrieType_Free(frozen);
+  TrieType_Free(t);
+}
+
+TEST_F(TrieTest, testIncrementalFreeze) {
+  // updates made while the trie is being frozen, before or after their terms are moved into the new
+  // frozen trie, are all kept
+  Trie *t = NewTrie();
+  TermMap expected;
+  for (size_t ii = 0; ii < TRIE_FREEZE_MIN_TERMS; ++ii) {
+    std::string s = "term" + std::to_string(ii);
+    Trie_InsertStringBuffer(t, s.c_str(), s.size(), 1, 0, NULL);
+    expected[s] = {1, ""};
+  }
+  // the last insert started the freeze, which is not done yet
+  ASSERT_TRUE(t->freezing != NULL);
+  ASSERT_TRUE(t->frozen == NULL);
+
+  srand(5);
+  for (size_t ii = 0; t->freezing; ++ii) {
+    ASSERT_LT(ii, TRIE_FREEZE_MIN_TERMS);
+    // existing terms, and new ones sorting anywhere among them
+    std::string s = "term" + std::to_string(rand() % (TRIE_FREEZE_MIN_TERMS + 2000));
+    auto it = expected.find(s);
+    if (it != expected.end() && rand() % 4 == 0) {
+      ASSERT_EQ(1, Trie_Delete(t, s.c_str(), s.size()));
+      expected.erase(it);
+    } else {
+      float score = 1 + rand() % 100;
+      int incr = it != expected.end() && rand() % 2;
+      std::string pl = std::to_string(rand() % 10);
+      RSPayload payload = {.data = (char *)pl.c_str(), .len = pl.size()};
+      Trie_InsertStringBuffer(t, s.c_str(), s.size(), score, incr, &payload);
+      std::pair<float, std::string> e = {incr ? it->second.first + score : score, pl};
+      expected[s] = e;
+    }
+    ASSERT_EQ(expected.size(), t->size);
+    if (ii % 250 == 0) {
+      ASSERT_EQ(expected, trieTerms(t));
+    }
+  }
+  // the terms added after their place was passed are left in the mutable nodes
+  ASSERT_TRUE(t->frozen != NULL);
+  ASSERT_LT(t->frozen->size, t->size);
+  ASSERT_EQ(expected, trieTerms(t));
+  for (const char *prefix : {"term1", "term42", "term7"}) {
+    ASSERT_EQ(10, trieTopK(t, prefix, 0).size());
+  }
+
+  Trie_Freeze(t);
+  ASSERT_EQ(t->size, t->frozen->size);
+  ASSERT_EQ(expected, trieTerms(t));
+  TrieType_Free(t);
+}
@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "vector_index.h"
+#include "spec.h"
+#include "index.h"
+#include "inverted_index.h"
+#include "knn_iterator.h"
+#include "util/arr.h"
+#include "common.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+class VectorIndexTest : public ::testing::Test {};
+
+static IndexSpec *parseSpec(std::vector<const char *> args, QueryError *err) {
+  return IndexSpec_Parse("vecidx", &args[0], args.size(), err);
+}
+
+TEST_F(VectorIndexTest, testParse) {
+  QueryError err = {QUERY_OK};
+  IndexSpec *sp = parseSpec({"SCHEMA", "v", "VECTOR", "HNSW", "DIM", "128", "TYPE", "FLOAT32",
+                             "DISTANCE_METRIC", "COSINE", "M", "8", "EF_RUNTIME", "50"},
+                            &err);
+  ASSERT_TRUE(sp) << QueryError_GetError(&err);
+  const FieldSpec *fs = sp->fields;
+  ASSERT_TRUE(FIELD_IS(fs, INDEXFLD_T_VECTOR));
+  ASSERT_EQ(128, fs->vectorOpts.dim);
+  ASSERT_EQ(VectorAlgo_HNSW, fs->vectorOpts.algo);
+  ASSERT_EQ(VectorMetric_Cosine, fs->vectorOpts.metric);
+  ASSERT_EQ(8, fs->vectorOpts.hnswM);
+  ASSERT_EQ(VECTOR_DEFAULT_HNSW_EF_CONSTRUCTION, fs->vectorOpts.hnswEfConstruction);
+  ASSERT_EQ(50, fs->vectorOpts.hnswEfRuntime);
+  IndexSpec_Free(sp);
+
+  std::vector<std::vector<const char *>> bad = {
+      {"SCHEMA", "v", "VECTOR", "FLAT"},
+      {"SCHEMA", "v", "VECTOR", "IVF", "DIM", "4"},
+      {"SCHEMA", "v", "VECTOR", "FLAT", "DIM", "0"},
+      {"SCHEMA", "v", "VECTOR", "FLAT", "DIM", "4", "TYPE", "FLOAT64"},
+      {"SCHEMA", "v", "VECTOR", "FLAT", "DIM", "4", "DISTANCE_METRIC", "L1"},
+      {"SCHEMA", "v", "VECTOR", "FLAT", "DIM", "4", "SORTABLE"},
+      // HNSW options are only known to HNSW fields
+      {"SCHEMA", "v", "VECTOR", "FLAT", "DIM", "4", "M", "8"},
+  };
+  for (auto &args : bad) {
+    QueryError_ClearError(&err);
+    ASSERT_FALSE(parseSpec(args, &err)) << args.size();
+    ASSERT_TRUE(QueryError_HasError(&err));
+  }
+  QueryError_ClearError(&err);
+}
+
+static std::vector<t_docId> readKnn(RedisSearchCtx *sctx, const FieldSpec *fs, const VectorQuery *vq,
+                                    IndexIterator *child) {
+  IndexIterator *it = NewVectorKnnIterator(sctx, fs, vq, child);
+  std::vector<t_docId> ids;
+  RSIndexResult *r;
+  while (it->Read(it->ctx, &r) == INDEXREAD_OK) {
+    if (!ids.empty()) {
+      EXPECT_LT(ids.back(), r->docId);
+    }
+    ids.push_back(r->docId);
+  }
+  it->Free(it);
+  return ids;
+}
+
+class VectorKnnTest : public ::testing::TestWithParam<const char *> {};
+
+TEST_P(VectorKnnTest, testKnn) {
+  const size_t N = 2000, DIM = 16, K = 10;
+  QueryError err = {QUERY_OK};
+  IndexSpec *sp = parseSpec({"SCHEMA", "v", "VECTOR", GetParam(), "DIM", "16"}, &err);
+  ASSERT_TRUE(sp) << QueryError_GetError(&err);
+  const FieldSpec *fs = sp->fields;
+  RMCK::Context ctx;
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  VectorIndex *vi = VectorIndex_Open(&sctx, fs, 1);
+  ASSERT_TRUE(vi);
+
+  // clustered points, which are harder on the graph than uniform ones
+  srand(42);
+  std::vector<float> vecs(N * DIM);
+  for (size_t i = 0; i < N; ++i) {
+    float center = (float)(i % 5);
+    for (size_t j = 0; j < DIM; ++j) {
+      vecs[i * DIM + j] = center + (float)rand() / RAND_MAX;
+    }
+    char key[32];
+    sprintf(key, "doc%zu", i);
+    t_docId docId = DocTable_Put(&sp->docs, key, strlen(key), 1.0, Document_DefaultFlags, NULL, 0);
+    ASSERT_EQ(i + 1, docId);
+    VectorIndex_Add(vi, docId, &vecs[i * DIM]);
+  }
+  ASSERT_EQ(N, VectorIndex_Size(vi));
+
+  // delete every tenth document
+  for (size_t i = 0; i < N; i += 10) {
+    char key[32];
+    sprintf(key, "doc%zu", i);
+    ASSERT_TRUE(DocTable_Delete(&sp->docs, key, strlen(key)));
+  }
+
+  t_docId odd[N / 2];
+  InvertedIndex *oddIdx = NewInvertedIndex(Index_StoreNumeric, 1);
+  for (size_t i = 0; i < N / 2; ++i) {
+    InvertedIndex_WriteNumericEntry(oddIdx, 2 * i + 1, 1);
+  }
+
+  const bool exact = !strcmp(GetParam(), "FLAT");
+  size_t found = 0, total = 0;
+  for (size_t q = 0; q < 50; ++q) {
+    float qv[DIM];
+    for (size_t j = 0; j < DIM; ++j) {
+      qv[j] = (float)(q % 5) + (float)rand() / RAND_MAX;
+    }
+    VectorQuery vq = {.property = "v", .k = K, .vector = qv, .dim = DIM};
+
+    for (bool filtered : {false, true}) {
+      std::vector<std::pair<float, t_docId>> byDistance;
+      for (size_t i = 0; i < N; ++i) {
+        if (i % 10 && (!filtered || (i + 1) % 2)) {
+          byDistance.push_back({VectorIndex_Distance(vi, qv, &vecs[i * DIM]), i + 1});
+        }
+      }
+      std::sort(byDistance.begin(), byDistance.end());
+      std::set<t_docId> expected;
+      for (size_t i = 0; i < K; ++i) {
+        expected.insert(byDistance[i].second);
+      }
+
+      // an id list lands at or before the id skipped to, an index reader moves on to its next
+      // match
+      IndexIterator *child = NULL;
+      if (filtered && q % 2) {
+        child = NewReadIterator(NewNumericReader(NULL, oddIdx, NULL));
+      } else if (filtered) {
+        for (size_t i = 0; i < N / 2; ++i) {
+          odd[i] = 2 * i + 1;
+        }
+        child = NewIdListIterator(odd, N / 2, 1);
+      }
+      auto ids = readKnn(&sctx, fs, &vq, child);
+      ASSERT_EQ(K, ids.size());
+      for (auto id : ids) {
+        ASSERT_NE(0, (id - 1) % 10) << "deleted document " << id;
+        if (filtered) {
+          ASSERT_EQ(1, id % 2);
+        }
+        found += expected.count(id);
+      }
+      total += K;
+      if (exact) {
+        ASSERT_EQ(std::vector<t_docId>(expected.begin(), expected.end()), ids);
+      }
+    }
+  }
+  ASSERT_GE((double)found / total, 0.9) << GetParam();
+
+  InvertedIndex_Free(oddIdx);
+  IndexSpec_Free(sp);
+}
+
+TEST_F(VectorIndexTest, testMatch) {
+  InvertedIndex *idx[2] = {NewInvertedIndex(Index_StoreNumeric, 1),
+                           NewInvertedIndex(Index_StoreNumeric, 1)};
+  for (t_docId docId : {2, 3, 5}) {
+    InvertedIndex_WriteNumericEntry(idx[0], docId, 1);
+  }
+  for (t_docId docId : {2, 3, 4}) {
+    InvertedIndex_WriteNumericEntry(idx[1], docId, 1);
+  }
+
+  // skipping to 1 misses, and moves the child on to 2
+  for (bool intersect : {false, true}) {
+    IndexIterator *child = NewReadIterator(NewNumericReader(NULL, idx[0], NULL));
+    if (intersect) {
+      IndexIterator **its = (IndexIterator **)calloc(2, sizeof(IndexIterator *));
+      its[0] = child;
+      its[1] = NewReadIterator(NewNumericReader(NULL, idx[1], NULL));
+      child = NewIntersecIterator(its, 2, NULL, RS_FIELDMASK_ALL, -1, 0, 1);
+    }
+    KnnHit *hits = array_new(KnnHit, 4);
+    for (t_docId docId : {1, 2, 2, 3, 4}) {
+      hits = array_append(hits, ((KnnHit){.docId = docId, .distance = 0}));
+    }
+    hits = KnnHits_Match(hits, child);
+    ASSERT_EQ(2, array_len(hits)) << "intersect=" << intersect;
+    ASSERT_EQ(2, hits[0].docId);
+    ASSERT_EQ(3, hits[1].docId);
+    array_free(hits);
+    child->Free(child);
+  }
+  InvertedIndex_Free(idx[0]);
+  InvertedIndex_Free(idx[1]);
+}
+
+TEST_P(VectorKnnTest, testSweep) {
+  const size_t LIVE = 200, DIM = 4, K = 10;
+  QueryError err = {QUERY_OK};
+  IndexSpec *sp = parseSpec({"SCHEMA", "v", "VECTOR", GetParam(), "DIM", "4"}, &err);
+  ASSERT_TRUE(sp) << QueryError_GetError(&err);
+  RMCK::Context ctx;
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  VectorIndex *vi = VectorIndex_Open(&sctx, sp->fields, 1);
+
+  // keep re-adding the same documents, as updates do, while sweeping a few slots at a time as the
+  // GC would
+  srand(7);
+  std::vector<float> vecs(LIVE * DIM);
+  std::vector<t_docId> docIds(LIVE);
+  size_t dropped = 0, bytesFreed = 0, maxSize = 0;
+  for (size_t i = 0; i < 3000; ++i) {
+    size_t n = i % LIVE;
+    char key[32];
+    sprintf(key, "doc%zu", n);
+    DocTable_Delete(&sp->docs, key, strlen(key));
+    docIds[n] = DocTable_Put(&sp->docs, key, strlen(key), 1.0, Document_DefaultFlags, NULL, 0);
+    for (size_t j = 0; j < DIM; ++j) {
+      vecs[n * DIM + j] = (float)rand() / RAND_MAX;
+    }
+    VectorIndex_Add(vi, docIds[n], &vecs[n * DIM]);
+    if (i % 10 == 9) {
+      dropped += VectorIndex_Sweep(vi, &sp->docs, 100, &bytesFreed);
+    }
+    maxSize = std::max(maxSize, VectorIndex_Size(vi));
+  }
+  // dead vectors are dropped and their slots reused
+  ASSERT_LT(maxSize, 2 * LIVE + LIVE / 2);
+  for (int i = 0; i < 3; ++i) {
+    dropped += VectorIndex_Sweep(vi, &sp->docs, SIZE_MAX, &bytesFreed);
+  }
+  ASSERT_EQ(LIVE, VectorIndex_Size(vi));
+  ASSERT_EQ(3000 - LIVE, dropped);
+  if (!strcmp(GetParam(), "HNSW")) {
+    ASSERT_GT(bytesFreed, 0);
+  }
+
+  // the graph stays searchable once the dead nodes are unlinked
+  std::set<t_docId> live(docIds.begin(), docIds.end());
+  size_t found = 0;
+  for (size_t q = 0; q < 20; ++q) {
+    float qv[DIM];
+    for (size_t j = 0; j < DIM; ++j) {
+      qv[j] = (float)rand() / RAND_MAX;
+    }
+    std::vector<std::pair<float, t_docId>> byDistance;
+    for (size_t n = 0; n < LIVE; ++n) {
+      byDistance.push_back({VectorIndex_Distance(vi, qv, &vecs[n * DIM]), docIds[n]});
+    }
+    std::sort(byDistance.begin(), byDistance.end());
+    std::set<t_docId> expected;
+    for (size_t i = 0; i < K; ++i) {
+      expected.insert(byDistance[i].second);
+    }
+
+    VectorQuery vq = {.property = "v", .k = K, .vector = qv, .dim = DIM};
+    auto ids = readKnn(&sctx, sp->fields, &vq, NULL);
+    ASSERT_EQ(K, ids.size());
+    for (auto id : ids) {
+      ASSERT_TRUE(live.count(id)) << "deleted document " << id;
+      found += expected.count(id);
+    }
+  }
+  ASSERT_GE((double)found / (20 * K), 0.9) << GetParam();
+
+  IndexSpec_Free(sp);
+}
+
+INSTANTIATE_TEST_CASE_P(VectorKnn, VectorKnnTest, ::testing::Values("FLAT", "HNSW"));
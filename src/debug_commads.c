@@ -175,6 +175,16 @@ DEBUG_COMMAND(NumericIndexSummary) {
   REPLY_WITH_LONG_LONG("lastDocId", rt->lastDocId, invIdxBulkLen);
   REPLY_WITH_LONG_LONG("revisionId", rt->revisionId, invIdxBulkLen);
 
+  NumericRangeTreeStats stats;
+  NumericRangeTree_GetStats(rt, &stats);
+  REPLY_WITH_LONG_LONG("numLeaves", stats.numLeaves, invIdxBulkLen);
+  REPLY_WITH_LONG_LONG("emptyLeaves", stats.emptyLeaves, invIdxBulkLen);
+  REPLY_WITH_LONG_LONG("depth", stats.maxDepth, invIdxBulkLen);
+  REPLY_WITH_LONG_LONG("skew", stats.maxDepth - stats.minDepth, invIdxBulkLen);
+  RedisModule_ReplyWithStringBuffer(ctx, "fill", strlen("fill"));
+  RedisModule_ReplyWithDouble(ctx, stats.fill);
+  invIdxBulkLen += 2;
+
   RedisModule_ReplySetArrayLength(ctx, invIdxBulkLen);
 
 end:
@@ -185,6 +195,33 @@ end:
   return REDISMODULE_OK;
 }
 
+DEBUG_COMMAND(RebuildNumericIndex) {
+  if (argc != 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  GET_SEARCH_CTX(argv[0])
+  RedisModuleKey *keyp = NULL;
+  RedisModuleString *keyName = getFieldKeyName(sctx->spec, argv[1], INDEXFLD_T_NUMERIC);
+  if (!keyName) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "Could not find given field in index spec");
+    goto end;
+  }
+  NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &keyp);
+  if (!rt) {
+    RedisModule_ReplyWithError(sctx->redisCtx, "can not open numeric field");
+    goto end;
+  }
+  NumericRangeTree_Compact(rt);
+  RedisModule_ReplyWithLongLong(ctx, rt->numRanges);
+
+end:
+  if (keyp) {
+    RedisModule_CloseKey(keyp);
+  }
+  SearchCtx_Free(sctx);
+  return REDISMODULE_OK;
+}
+
 DEBUG_COMMAND(DumpNumericIndex) {
   if (argc != 2) {
     return RedisModule_WrongArity(ctx);
@@ -630,6 +667,7 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex},
                                {"DUMP_TERMS", DumpTerms},
                                {"INVIDX_SUMMARY", InvertedIndexSummary},
                                {"NUMIDX_SUMMARY", NumericIndexSummary},
+                               {"NUMIDX_REBUILD", RebuildNumericIndex},
                                {"GC_FORCEINVOKE", GCForceInvoke},
                                {"GC_FORCEBGINVOKE", GCForceBGInvoke},
                                {"GIT_SHA", GitSha},
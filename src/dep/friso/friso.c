@@ -25,6 +25,7 @@ FRISO_API friso_t friso_new(void) {
 
   e->dic = NULL;
   e->charset = FRISO_UTF8;  // set default charset UTF8.
+  e->cjk_dat = NULL;
 
   return e;
 }
@@ -198,10 +199,35 @@ FRISO_API void friso_free(friso_t friso) {
   if (friso->dic != NULL) {
     friso_dic_free(friso->dic);
   }
+  if (friso->cjk_dat != NULL) {
+    free_dat(friso->cjk_dat);
+  }
   FRISO_FREE(friso);
 }
 /* }}} */
 
+/* {{{ compile the CJK words of the dictionary into a trie.
+ */
+FRISO_API void friso_dic_compile(friso_t friso) {
+  if (friso->cjk_dat != NULL) {
+    free_dat(friso->cjk_dat);
+  }
+  friso->cjk_dat = new_dat_from_hash(friso->dic[__LEX_CJK_WORDS__]);
+}
+/* }}} */
+
+/* {{{ check the existence of a CJK word, through the compiled trie if any.
+ */
+__STATIC_API__ int cjk_dic_match(friso_t friso, fstring word) {
+  int node;
+  if (friso->cjk_dat == NULL) {
+    return friso_dic_match(friso->dic, __LEX_CJK_WORDS__, word);
+  }
+  node = dat_walk(friso->cjk_dat, DAT_ROOT, word);
+  return node >= 0 && dat_get_value(friso->cjk_dat, node) != NULL;
+}
+/* }}} */
+
 /* {{{ set the current split mode
  *    view the friso.h#friso_mode_t
  */
@@ -685,10 +711,19 @@ __STATIC_API__ lex_entry_t next_basic_latin(friso_t friso, friso_config_t config
  *
  * @return friso_array_t that contains all the matchs.
  */
+__STATIC_API__ friso_array_t get_next_dat_match(friso_t friso, friso_config_t config,
+                                                friso_task_t task, uint_t idx);
+
 __STATIC_API__ friso_array_t get_next_match(friso_t friso, friso_config_t config, friso_task_t task,
                                             uint_t idx) {
   register uint_t t;
-  string_buffer_t sb = new_string_buffer_with_string(task->buffer);
+  string_buffer_t sb;
+
+  if (friso->cjk_dat != NULL) {
+    return get_next_dat_match(friso, config, task, idx);
+  }
+
+  sb = new_string_buffer_with_string(task->buffer);
 
   // create a match dynamic array.
   friso_array_t match = new_array_list_with_opacity(config->max_len);
@@ -729,6 +764,40 @@ __STATIC_API__ friso_array_t get_next_match(friso_t friso, friso_config_t config
 }
 /* }}} */
 
+/* {{{ get the next match from the current position,
+ *        walking the compiled trie of the CJK words.
+ *
+ * the same matchs as get_next_match, found with a single walk from the
+ *     current character, which stops as soon as no word can match,
+ *     instead of a dictionary lookup of every candidate word.
+ */
+__STATIC_API__ friso_array_t get_next_dat_match(friso_t friso, friso_config_t config,
+                                                friso_task_t task, uint_t idx) {
+  register uint_t t;
+  lex_entry_t e;
+  friso_dat_t dat = friso->cjk_dat;
+  int node = dat_walk(dat, DAT_ROOT, task->buffer);
+
+  // create a match dynamic array.
+  friso_array_t match = new_array_list_with_opacity(config->max_len);
+  array_list_add(match, node < 0 ? NULL : dat_get_value(dat, node));
+
+  for (t = 1; node >= 0 && t < config->max_len &&
+              (task->bytes = readNextWord(friso, task, &idx, task->buffer)) != 0;
+       t++) {
+    if (friso_whitespace(friso->charset, task)) break;
+    if (!friso_cn_string(friso->charset, task)) break;
+
+    node = dat_walk(dat, node, task->buffer);
+    if (node >= 0 && (e = (lex_entry_t)dat_get_value(dat, node)) != NULL) {
+      array_list_add(match, e);
+    }
+  }
+
+  return match;
+}
+/* }}} */
+
 /* {{{ chunk for mmseg defines and functions to handle them.*/
 typedef struct {
   friso_array_t words;
@@ -1025,7 +1094,7 @@ FRISO_API lex_entry_t next_complex_cjk(friso_t friso, friso_config_t config, fri
     readNextWord(friso, task, &__idx__, task->buffer);
 
     if (task->bytes != 0 && friso_cn_string(friso->charset, task) &&
-        friso_dic_match(friso->dic, __LEX_CJK_WORDS__, task->buffer)) {
+        cjk_dic_match(friso, task->buffer)) {
       // get the next matchs
       smatch = get_next_match(friso, config, task, __idx__);
       for (y = 0; y < smatch->length; y++) {
@@ -1035,7 +1104,7 @@ FRISO_API lex_entry_t next_complex_cjk(friso_t friso, friso_config_t config, fri
         readNextWord(friso, task, &__idx__, task->buffer);
 
         if (task->bytes != 0 && friso_cn_string(friso->charset, task) &&
-            friso_dic_match(friso->dic, __LEX_CJK_WORDS__, task->buffer)) {
+            cjk_dic_match(friso, task->buffer)) {
           // get the matchs.
           tmatch = get_next_match(friso, config, task, __idx__);
           for (z = 0; z < tmatch->length; z++) {
@@ -1341,7 +1410,7 @@ FRISO_API friso_token_t next_mmseg_token(friso_t friso, friso_config_t config, f
       /* check the dictionary.
        * and return the unrecognized CJK char as a single word.
        * */
-      if (!friso_dic_match(friso->dic, __LEX_CJK_WORDS__, task->buffer)) {
+      if (!cjk_dic_match(friso, task->buffer)) {
         memcpy(task->token->word, task->buffer, task->bytes);
         task->token->type = __LEX_PUNC_WORDS__;
         task->token->length = task->bytes;
@@ -70,6 +70,7 @@ typedef enum {
 typedef struct {
     friso_dic_t dic;        //friso dictionary
     friso_charset_t charset;    //project charset.
+    friso_dat_t cjk_dat;    //the compiled CJK words of the dictionary, or NULL.
 } friso_entry;
 typedef friso_entry * friso_t;
 
@@ -210,6 +211,16 @@ do {\
     friso->dic = dic;\
 } while (0)
 
+/*
+ * Function: friso_dic_compile
+ * Usage: friso_dic_compile( friso );
+ * ----------------------------------
+ * This function compiles the CJK words of the dictionary into a double-array trie,
+ *         which the segmentation walks instead of looking up each candidate word.
+ * the dictionary must not change afterwards.
+ */
+FRISO_API void friso_dic_compile( friso_t );
+
 /*
  * Function: friso_set_mode
  * Usage: friso_set_mode( vars, mode );
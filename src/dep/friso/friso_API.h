@@ -369,6 +369,70 @@ FRISO_API hash_entry_t hash_remove_mapping(friso_hash_t, fstring);
 #define hash_get_size(hash) hash->size
 /* }}} hashtable interface define :: end*/
 
+/* {{{ double-array trie interface define :: start*/
+/*
+ * An immutable byte-wise double-array trie, compiled from a hash table.
+ * A key is looked up by walking its bytes from the root, each byte in
+ * constant time, so the keys which are prefixes of a string are all
+ * found with a single walk, instead of a hash lookup for each of them.
+ */
+typedef struct {
+  int base;   // the children of the node are at base + byte
+  int check;  // the parent of the node, -1 for a free node
+  int value;  // index of the value of the key ending here, or -1
+} friso_dat_node;
+
+typedef struct {
+  friso_dat_node *nodes;
+  uint_t length;
+  void **values;
+} friso_dat_cdt;
+
+typedef friso_dat_cdt *friso_dat_t;
+
+#define DAT_ROOT 0
+
+/*
+ * Function: new_dat_from_hash
+ * Usage: dat = new_dat_from_hash( table );
+ * ----------------------------------------
+ * compile the keys and values of the table into a trie,
+ *         which does not follow the later changes of the table.
+ */
+FRISO_API friso_dat_t new_dat_from_hash(friso_hash_t);
+
+FRISO_API void free_dat(friso_dat_t);
+
+/*
+ * Function: dat_walk
+ * Usage: node = dat_walk( dat, node, str );
+ * -----------------------------------------
+ * follow the bytes of the string from the node.
+ *         -1 will be return if no key starts with them.
+ */
+__STATIC_API__ int dat_walk(friso_dat_t dat, int node, const char *str) {
+  for (; *str != '\0'; str++) {
+    uint_t t = (uint_t)(dat->nodes[node].base + (uchar_t)*str);
+    if (t >= dat->length || dat->nodes[t].check != node) {
+      return -1;
+    }
+    node = (int)t;
+  }
+  return node;
+}
+
+/*
+ * Function: dat_get_value
+ * Usage: value = dat_get_value( dat, node );
+ * ------------------------------------------
+ * the value of the key ending at the node, NULL if none does.
+ */
+__STATIC_API__ void *dat_get_value(friso_dat_t dat, int node) {
+  int v = dat->nodes[node].value;
+  return v < 0 ? NULL : dat->values[v];
+}
+/* }}} double-array trie interface define :: end*/
+
 /* {{{ utf8 string interface define :: start*/
 
 /*
@@ -0,0 +1,172 @@
+/*
+ * friso double-array trie implements functions
+ *     defined in header file "friso_API.h".
+ */
+#include "friso_API.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  fstring key;
+  void *value;
+} dat_key_entry;
+
+/* the state of the compilation. the free nodes are linked in a ring,
+ *     headed by the root, which is never free. */
+typedef struct {
+  friso_dat_t dat;
+  dat_key_entry *keys;
+  int *next_free;
+  int *prev_free;
+  uint_t capacity;
+} dat_builder;
+
+__STATIC_API__ int dat_key_cmp(const void *a, const void *b) {
+  return strcmp(((const dat_key_entry *)a)->key, ((const dat_key_entry *)b)->key);
+}
+
+__STATIC_API__ void dat_unlink_free(dat_builder *b, int node) {
+  b->next_free[b->prev_free[node]] = b->next_free[node];
+  b->prev_free[b->next_free[node]] = b->prev_free[node];
+}
+
+// grow the nodes, linking the new ones at the end of the free ring.
+__STATIC_API__ void dat_grow(dat_builder *b, uint_t capacity) {
+  uint_t t;
+  b->dat->nodes = rm_realloc(b->dat->nodes, capacity * sizeof(friso_dat_node));
+  b->next_free = rm_realloc(b->next_free, capacity * sizeof(int));
+  b->prev_free = rm_realloc(b->prev_free, capacity * sizeof(int));
+  for (t = b->capacity; t < capacity; t++) {
+    b->dat->nodes[t].base = 0;
+    b->dat->nodes[t].check = -1;
+    b->dat->nodes[t].value = -1;
+    b->prev_free[t] = b->prev_free[DAT_ROOT];
+    b->next_free[t] = DAT_ROOT;
+    b->next_free[b->prev_free[DAT_ROOT]] = t;
+    b->prev_free[DAT_ROOT] = t;
+  }
+  b->capacity = capacity;
+}
+
+// find a base for which the nodes of all the given bytes are free.
+__STATIC_API__ int dat_find_base(dat_builder *b, const uchar_t *bytes, uint_t n) {
+  int free, base;
+  uint_t t;
+  for (free = b->next_free[DAT_ROOT];; free = b->next_free[free]) {
+    if (free == DAT_ROOT) {
+      // no room left, the nodes are grown past the last one.
+      free = b->capacity;
+      dat_grow(b, b->capacity * 2);
+    }
+    base = free - bytes[0];
+    if (base < 0) {
+      continue;
+    }
+    if ((uint_t)base + bytes[n - 1] >= b->capacity) {
+      dat_grow(b, (b->capacity * 2 > (uint_t)base + 256) ? b->capacity * 2 : (uint_t)base + 256);
+    }
+    for (t = 1; t < n; t++) {
+      if (b->dat->nodes[base + bytes[t]].check != -1) {
+        break;
+      }
+    }
+    if (t == n) {
+      return base;
+    }
+  }
+}
+
+/* place the children of the node, which are the keys in [lo, hi)
+ *     sharing their first depth bytes, and then their own children. */
+__STATIC_API__ void dat_build(dat_builder *b, int node, uint_t lo, uint_t hi, uint_t depth) {
+  uchar_t bytes[256];
+  uint_t bounds[257];
+  uint_t n = 0, t;
+  int base;
+
+  // sorted first, the key ending at the node.
+  if (lo < hi && b->keys[lo].key[depth] == '\0') {
+    b->dat->nodes[node].value = lo;
+    lo++;
+  }
+  if (lo == hi) {
+    return;
+  }
+
+  for (t = lo; t < hi; t++) {
+    uchar_t c = (uchar_t)b->keys[t].key[depth];
+    if (n == 0 || bytes[n - 1] != c) {
+      bytes[n] = c;
+      bounds[n++] = t;
+    }
+  }
+  bounds[n] = hi;
+
+  base = dat_find_base(b, bytes, n);
+  b->dat->nodes[node].base = base;
+  for (t = 0; t < n; t++) {
+    dat_unlink_free(b, base + bytes[t]);
+    b->dat->nodes[base + bytes[t]].check = node;
+  }
+  for (t = 0; t < n; t++) {
+    dat_build(b, base + bytes[t], bounds[t], bounds[t + 1], depth + 1);
+  }
+}
+
+FRISO_API friso_dat_t new_dat_from_hash(friso_hash_t hash) {
+  uint_t t, n = 0, length = 0;
+  hash_entry_t e;
+  dat_builder b;
+
+  friso_dat_t dat = (friso_dat_t)FRISO_CALLOC(sizeof(friso_dat_cdt), 1);
+  if (dat == NULL) {
+    ___ALLOCATION_ERROR___
+  }
+
+  // the keys, sorted to place the children of each node at once.
+  b.keys = (dat_key_entry *)FRISO_MALLOC((hash->size + 1) * sizeof(dat_key_entry));
+  for (t = 0; t < hash->length; t++) {
+    for (e = hash->table[t]; e != NULL; e = e->_next) {
+      b.keys[n].key = e->_key;
+      b.keys[n++].value = e->_val;
+    }
+  }
+  qsort(b.keys, n, sizeof(dat_key_entry), dat_key_cmp);
+
+  // the root heads the ring of the free nodes.
+  b.dat = dat;
+  b.capacity = 1;
+  dat->nodes = (friso_dat_node *)FRISO_MALLOC(sizeof(friso_dat_node));
+  dat->nodes[DAT_ROOT].base = 0;
+  dat->nodes[DAT_ROOT].check = -2;
+  dat->nodes[DAT_ROOT].value = -1;
+  b.next_free = (int *)FRISO_MALLOC(sizeof(int));
+  b.prev_free = (int *)FRISO_MALLOC(sizeof(int));
+  b.next_free[DAT_ROOT] = b.prev_free[DAT_ROOT] = DAT_ROOT;
+  dat_grow(&b, 1024);
+  dat_build(&b, DAT_ROOT, 0, n, 0);
+
+  // trim the free nodes at the end.
+  for (t = 0; t < b.capacity; t++) {
+    if (dat->nodes[t].check != -1) {
+      length = t + 1;
+    }
+  }
+  dat->length = length;
+  dat->nodes = rm_realloc(dat->nodes, length * sizeof(friso_dat_node));
+  dat->values = (void **)FRISO_MALLOC((n + 1) * sizeof(void *));
+  for (t = 0; t < n; t++) {
+    dat->values[t] = b.keys[t].value;
+  }
+
+  FRISO_FREE(b.keys);
+  FRISO_FREE(b.next_free);
+  FRISO_FREE(b.prev_free);
+  return dat;
+}
+
+FRISO_API void free_dat(friso_dat_t dat) {
+  FRISO_FREE(dat->nodes);
+  FRISO_FREE(dat->values);
+  FRISO_FREE(dat);
+}
@@ -1,4 +1,7 @@
 #include "rs_geo.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 int encodeGeo(double lon, double lat, double *bits) {
   GeoHashBits hash;
@@ -90,6 +93,171 @@ void calcRanges(double longitude, double latitude, double radius_meters, GeoHash
   calcAllNeighbors(&georadius, longitude, latitude, radius_meters, ranges);
 }
 
+typedef enum { GEO_CELL_OUTSIDE, GEO_CELL_BORDER, GEO_CELL_INSIDE } GeoCellPosition;
+
+typedef struct {
+  GeoHashBits hash;
+  GeoCellPosition pos;
+} GeoCoverCell;
+
+static int inSpan(double v, double min, double max) {
+  return v >= min && v <= max;
+}
+
+/* The distance from a point to the farthest point of a geohash cell. Along an edge of constant
+ * latitude the distance grows with the difference in longitude, up to half a turn. Along an edge of
+ * constant longitude, more than a quarter turn away, it peaks between the corners, at the latitude
+ * of the great circle through the antipode. So the farthest point is one of the corners, of these
+ * points on the edges, or the antipode itself */
+static double cellMaxDistance(const GeoHashArea *area, double lon, double lat) {
+  const double alon = lon > 0 ? lon - 180 : lon + 180;
+  double points[10][2] = {{area->longitude.min, area->latitude.min},
+                          {area->longitude.min, area->latitude.max},
+                          {area->longitude.max, area->latitude.min},
+                          {area->longitude.max, area->latitude.max}};
+  size_t n = 4;
+  if (inSpan(alon, area->longitude.min, area->longitude.max)) {
+    points[n][0] = points[n + 1][0] = points[n + 2][0] = alon;
+    points[n][1] = area->latitude.min;
+    points[n + 1][1] = area->latitude.max;
+    points[n + 2][1] = -lat;
+    n += inSpan(-lat, area->latitude.min, area->latitude.max) ? 3 : 2;
+  }
+  const double latr = lat * M_PI / 180;
+  const double elons[2] = {area->longitude.min, area->longitude.max};
+  for (int i = 0; i < 2; ++i) {
+    double dlon = (elons[i] - lon) * M_PI / 180;
+    // the latitude closest to the point along the meridian, and the farthest half a turn from it
+    double near = atan2(sin(latr), cos(latr) * cos(dlon)) * 180 / M_PI;
+    double far = near > 0 ? near - 180 : near + 180;
+    if (inSpan(far, area->latitude.min, area->latitude.max)) {
+      points[n][0] = elons[i];
+      points[n++][1] = far;
+    }
+  }
+
+  double max = 0;
+  for (size_t i = 0; i < n; ++i) {
+    max = fmax(max, geohashGetDistance(lon, lat, points[i][0], points[i][1]));
+  }
+  return max;
+}
+
+/* Classify a geohash cell against a circle. A cell is inside the circle if its farthest point from
+ * the center is, and it is outside of it if the circle's center is farther from the cell's center
+ * than the radius and the cell's own circumradius together */
+static GeoCellPosition classifyCell(GeoHashBits hash, double lon, double lat, double radius) {
+  GeoHashArea area;
+  geohashDecodeWGS84(hash, &area);
+  if (cellMaxDistance(&area, lon, lat) <= radius) {
+    return GEO_CELL_INSIDE;
+  }
+  const double clon = (area.longitude.min + area.longitude.max) / 2;
+  const double clat = (area.latitude.min + area.latitude.max) / 2;
+  if (geohashGetDistance(lon, lat, clon, clat) - cellMaxDistance(&area, clon, clat) > radius) {
+    return GEO_CELL_OUTSIDE;
+  }
+  return GEO_CELL_BORDER;
+}
+
+static int cmpCoverRange(const void *p1, const void *p2) {
+  const GeoCoverRange *r1 = p1, *r2 = p2;
+  return r1->range.min < r2->range.min ? -1 : (r1->range.min > r2->range.min ? 1 : 0);
+}
+
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoCoverRange *ranges) {
+  GeoHashRadius georadius = geohashGetAreasByRadiusWGS84(longitude, latitude, radius_meters);
+  const GeoHashBits boxes[GEO_RANGE_COUNT] = {
+      georadius.hash,
+      georadius.neighbors.north,
+      georadius.neighbors.south,
+      georadius.neighbors.east,
+      georadius.neighbors.west,
+      georadius.neighbors.north_east,
+      georadius.neighbors.north_west,
+      georadius.neighbors.south_east,
+      georadius.neighbors.south_west,
+  };
+
+  GeoCoverCell cells[GEO_COVER_MAX_RANGES];
+  size_t ncells = 0;
+  for (size_t i = 0; i < GEO_RANGE_COUNT; ++i) {
+    if (HASHISZERO(boxes[i])) {
+      continue;
+    }
+    // with huge radii neighbors may repeat
+    int dup = 0;
+    for (size_t j = 0; j < ncells && !dup; ++j) {
+      dup = cells[j].hash.bits == boxes[i].bits && cells[j].hash.step == boxes[i].step;
+    }
+    if (dup) {
+      continue;
+    }
+    GeoCellPosition pos = classifyCell(boxes[i], longitude, latitude, radius_meters);
+    if (pos != GEO_CELL_OUTSIDE) {
+      cells[ncells++] = (GeoCoverCell){.hash = boxes[i], .pos = pos};
+    }
+  }
+
+  // Refine the border cells one step at a time, as long as the covering fits
+  for (int level = 0; level < GEO_COVER_MAX_STEPS; ++level) {
+    GeoCoverCell next[GEO_COVER_MAX_RANGES];
+    size_t nnext = 0;
+    int refined = 0;
+    for (size_t i = 0; i < ncells; ++i) {
+      if (cells[i].pos == GEO_CELL_BORDER && cells[i].hash.step < GEO_STEP_MAX) {
+        GeoCoverCell children[4];
+        size_t nchildren = 0;
+        for (uint64_t k = 0; k < 4; ++k) {
+          GeoHashBits child = {.bits = (cells[i].hash.bits << 2) | k,
+                               .step = cells[i].hash.step + 1};
+          GeoCellPosition pos = classifyCell(child, longitude, latitude, radius_meters);
+          if (pos != GEO_CELL_OUTSIDE) {
+            children[nchildren++] = (GeoCoverCell){.hash = child, .pos = pos};
+          }
+        }
+        // the cells after this one must still fit as well
+        if (nnext + nchildren + (ncells - i - 1) <= GEO_COVER_MAX_RANGES) {
+          for (size_t k = 0; k < nchildren; ++k) {
+            next[nnext++] = children[k];
+          }
+          refined = 1;
+          continue;
+        }
+      }
+      next[nnext++] = cells[i];
+    }
+    memcpy(cells, next, nnext * sizeof(*cells));
+    ncells = nnext;
+    if (!refined) {
+      break;
+    }
+  }
+
+  size_t nranges = 0;
+  for (size_t i = 0; i < ncells; ++i) {
+    GeoHashBits next = cells[i].hash;
+    next.bits++;
+    ranges[nranges++] = (GeoCoverRange){
+        .range = {.min = geohashAlign52Bits(cells[i].hash), .max = geohashAlign52Bits(next)},
+        .interior = cells[i].pos == GEO_CELL_INSIDE};
+  }
+  qsort(ranges, nranges, sizeof(*ranges), cmpCoverRange);
+
+  // merge adjacent ranges of the same kind
+  size_t n = 0;
+  for (size_t i = 0; i < nranges; ++i) {
+    if (n && ranges[n - 1].range.max == ranges[i].range.min &&
+        ranges[n - 1].interior == ranges[i].interior) {
+      ranges[n - 1].range.max = ranges[i].range.max;
+    } else {
+      ranges[n++] = ranges[i];
+    }
+  }
+  return n;
+}
+
 bool isWithinRadiusLonLat(double lon1, double lat1, double lon2, double lat2, double radius,
                           double *distance) {
   double dist = geohashGetDistance(lon1, lat1, lon2, lat2);
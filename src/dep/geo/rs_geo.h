@@ -4,8 +4,14 @@
 #include "geohash_helper.h"
 #include "geo_index.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define GEO_RANGE_COUNT 9
 
+extern const double EARTH_RADIUS_IN_METERS;
+
 /*
  * Encode longetude and latitude doubles into a single double.
  * This value can be sorted and used for distance. 
@@ -26,6 +32,29 @@ int  decodeGeo(double bits, double *xy);
 void calcRanges(double longitude, double latitude, double radius_meters,
                 GeoHashRange *ranges);
 
+/* The maximal number of ranges in a radius covering, and the maximal number of geohash steps the
+ * covering refines the initial boxes by */
+#define GEO_COVER_MAX_RANGES 32
+#define GEO_COVER_MAX_STEPS 6
+
+/* A range of geohash scores, [min, max), in a radius covering */
+typedef struct {
+  GeoHashRange range;
+  /* All the points in the range are within the radius, and need no distance check */
+  int interior;
+} GeoCoverRange;
+
+/*
+ * Calculate a covering of the given radius by geohash cells. Starting from the boxes of
+ * `calcRanges`, boxes that cross the circle's border are split into their four sub-cells, sub-cells
+ * outside of the circle are dropped, and the ones entirely inside of it are marked as interior.
+ * Adjacent cells of the same kind are merged into a single range.
+ *
+ * Writes up to GEO_COVER_MAX_RANGES ranges, sorted by score, and returns their number.
+ */
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoCoverRange *ranges);
+
 /*
  * Return true is distance is smaller than radius. radius must be in meters.
  * If `distance' is not NULL, the distance value is returned.
@@ -34,4 +63,7 @@ bool isWithinRadiusLonLat(double lon1, double lat1,
                          double lon2, double lat2,
                          double radius, double *distance);
 
+#ifdef __cplusplus
+}
+#endif
 #endif
@@ -141,6 +141,27 @@ int DocTable_SetPayload(DocTable *t, t_docId docId, const char *data, size_t len
   return 1;
 }
 
+static int sortableHasValue(const RSSortingVector *v, int idx) {
+  const RSValue *val = RSSortingVector_Get((RSSortingVector *)v, idx);
+  return val && val->t != RSValue_Null;
+}
+
+static void DocTable_CountSortable(DocTable *t, int idx, int delta) {
+  if (!t->sortableValues) {
+    t->sortableValues = rm_calloc(RS_SORTABLES_MAX, sizeof(*t->sortableValues));
+  }
+  t->sortableValues[idx] += delta;
+}
+
+/* Count the values of a sorting vector of a document added to or removed from the table */
+static void DocTable_CountSortables(DocTable *t, const RSSortingVector *v, int delta) {
+  for (int i = 0; v && i < v->len; i++) {
+    if (sortableHasValue(v, i)) {
+      DocTable_CountSortable(t, i, delta);
+    }
+  }
+}
+
 /* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done
  */
@@ -167,10 +188,26 @@ int DocTable_SetSortingVector(DocTable *t, t_docId docId, RSSortingVector *v) {
   dmd->sortVector = v;
   dmd->flags |= Document_HasSortVector;
   t->sortablesSize += RSSortingVector_GetMemorySize(v);
+  DocTable_CountSortables(t, v, 1);
 
   return 1;
 }
 
+void DocTable_PutSortable(DocTable *t, RSDocumentMetadata *dmd, int idx, const void *p, int type) {
+  int had = sortableHasValue(dmd->sortVector, idx);
+  RSSortingVector_Put(dmd->sortVector, idx, p, type);
+  int has = sortableHasValue(dmd->sortVector, idx);
+  if (has != had) {
+    DocTable_CountSortable(t, idx, has - had);
+  }
+}
+
+size_t DocTable_NumMissingSortable(const DocTable *t, int idx) {
+  // the size of the table is one above its number of documents
+  size_t numDocs = t->size - 1;
+  return t->sortableValues ? numDocs - t->sortableValues[idx] : numDocs;
+}
+
 int DocTable_SetByteOffsets(DocTable *t, t_docId docId, RSByteOffsets *v) {
   RSDocumentMetadata *dmd = DocTable_Get(t, docId);
   if (!dmd) {
@@ -292,6 +329,7 @@ void DocTable_Free(DocTable *t) {
     }
   }
   rm_free(t->buckets);
+  rm_free(t->sortableValues);
   DocIdMap_Free(&t->dim);
 }
 
@@ -325,6 +363,7 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
     DocTable_DmdUnchain(t, md);
     DocIdMap_Delete(&t->dim, s, n);
     --t->size;
+    DocTable_CountSortables(t, md->sortVector, -1);
 
     return md;
   }
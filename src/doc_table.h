@@ -64,6 +64,9 @@ typedef struct {
   size_t cap;
   size_t memsize;
   size_t sortablesSize;
+  // the number of documents with a value at each position of their sorting vectors, allocated for
+  // RS_SORTABLES_MAX positions once a document has one
+  size_t *sortableValues;
 
   DMDChain *buckets;
   DocIdMap dim;
@@ -123,6 +126,14 @@ int DocTable_Exists(const DocTable *t, t_docId docId);
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done */
 int DocTable_SetSortingVector(DocTable *t, t_docId docId, RSSortingVector *v);
 
+/* Put a value in the sorting vector of a document in the table, which must have one. Use this
+ * rather than RSSortingVector_Put, so that the documents with a value at each position are
+ * counted */
+void DocTable_PutSortable(DocTable *t, RSDocumentMetadata *dmd, int idx, const void *p, int type);
+
+/* The number of documents in the table without a value at a position of their sorting vectors */
+size_t DocTable_NumMissingSortable(const DocTable *t, int idx);
+
 /* Set the offset vector for a document. This contains the byte offsets of each token found in
  * the document. This is used for highlighting
  */
@@ -14,6 +14,7 @@
 #include "rmalloc.h"
 #include "indexer.h"
 #include "tag_index.h"
+#include "vector_index.h"
 #include "aggregate/expr/expression.h"
 #include "rmutil/rm_assert.h"
 
@@ -182,6 +183,7 @@ RSAddDocumentCtx *NewAddDocumentCtx(IndexSpec *sp, Document *b, QueryError *stat
   if (AddDocumentCtx_SetDocument(aCtx, sp, b, aCtx->doc.numFields) != 0) {
     *status = aCtx->status;
     aCtx->status.detail = NULL;
+    Indexer_Decref(aCtx->indexer);
     mempool_release(actxPool_g, aCtx);
     return NULL;
   }
@@ -262,6 +264,7 @@ static int AddDocumentCtx_ReplaceMerge(RSAddDocumentCtx *aCtx, RedisSearchCtx *s
   if (rv != REDISMODULE_OK) {
     QueryError_SetError(&aCtx->status, QUERY_ENODOC, "Could not load existing document");
     aCtx->donecb(aCtx, sctx->redisCtx, aCtx->donecbData);
+    Indexer_Decref(aCtx->indexer);
     AddDocumentCtx_Free(aCtx);
     return 1;
   }
@@ -395,7 +398,8 @@ FIELD_PREPROCESSOR(fulltextPreprocessor) {
       curOffsetWriter = &aCtx->offsetsWriter;
     }
 
-    ForwardIndexTokenizerCtx_Init(&tokCtx, aCtx->fwIdx, c, curOffsetWriter, fs->ftId, fs->ftWeight);
+    ForwardIndexTokenizerCtx_Init(&tokCtx, aCtx->fwIdx, c, curOffsetWriter, fs->ftId, fs->ftWeight,
+                                  fs->prefixIndexLen);
 
     uint32_t options = TOKENIZE_DEFAULT_OPTIONS;
     if (FieldSpec_IsNoStem(fs)) {
@@ -510,12 +514,37 @@ FIELD_BULK_INDEXER(tagIndexer) {
   return 0;
 }
 
+FIELD_PREPROCESSOR(vectorPreprocessor) {
+  size_t len;
+  const char *blob = RedisModule_StringPtrLen(field->text, &len);
+  if (len != fs->vectorOpts.dim * sizeof(float)) {
+    QueryError_SetErrorFmt(status, QUERY_EINVAL,
+                           "Vector of field `%s` must be a FLOAT32 blob of %u elements", fs->name,
+                           fs->vectorOpts.dim);
+    return -1;
+  }
+  fdata->vector = (const float *)blob;
+  return 0;
+}
+
+FIELD_BULK_INDEXER(vectorIndexer) {
+  VectorIndex *vi = VectorIndex_Open(ctx, fs, 1);
+  if (!vi) {
+    QueryError_SetError(status, QUERY_EGENERIC, "Could not open vector index for indexing");
+    return -1;
+  }
+  ctx->spec->stats.invertedSize += VectorIndex_Add(vi, aCtx->doc.docId, fdata->vector);
+  ctx->spec->stats.numRecords++;
+  return 0;
+}
+
 static PreprocessorFunc preprocessorMap[] = {
     // nl break
     [IXFLDPOS_FULLTEXT] = fulltextPreprocessor,
     [IXFLDPOS_NUMERIC] = numericPreprocessor,
     [IXFLDPOS_GEO] = geoPreprocessor,
-    [IXFLDPOS_TAG] = tagPreprocessor};
+    [IXFLDPOS_TAG] = tagPreprocessor,
+    [IXFLDPOS_VECTOR] = vectorPreprocessor};
 
 int IndexerBulkAdd(IndexBulkData *bulk, RSAddDocumentCtx *cur, RedisSearchCtx *sctx,
                    const DocumentField *field, const FieldSpec *fs, FieldIndexerData *fdata,
@@ -532,6 +561,9 @@ int IndexerBulkAdd(IndexBulkData *bulk, RSAddDocumentCtx *cur, RedisSearchCtx *s
         case IXFLDPOS_GEO:
           rc = numericIndexer(bulk, cur, sctx, field, fs, fdata, status);
           break;
+        case IXFLDPOS_VECTOR:
+          rc = vectorIndexer(bulk, cur, sctx, field, fs, fdata, status);
+          break;
         case IXFLDPOS_FULLTEXT:
           break;
         default:
@@ -552,9 +584,8 @@ void IndexerBulkCleanup(IndexBulkData *cur, RedisSearchCtx *sctx) {
   }
 }
 
-int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
+int Document_Preprocess(RSAddDocumentCtx *aCtx) {
   Document *doc = &aCtx->doc;
-  int ourRv = REDISMODULE_OK;
 
   for (size_t i = 0; i < doc->numFields; i++) {
     const FieldSpec *fs = aCtx->fspecs + i;
@@ -573,11 +604,18 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
 
       PreprocessorFunc pp = preprocessorMap[ii];
       if (pp(aCtx, &doc->fields[i], fs, fdata, &aCtx->status) != 0) {
-        ourRv = REDISMODULE_ERR;
-        goto cleanup;
+        return REDISMODULE_ERR;
       }
     }
   }
+  return REDISMODULE_OK;
+}
+
+int Document_AddToIndexes(RSAddDocumentCtx *aCtx) {
+  int ourRv = Document_Preprocess(aCtx);
+  if (ourRv != REDISMODULE_OK) {
+    goto cleanup;
+  }
 
   if (Indexer_Add(aCtx->indexer, aCtx) != 0) {
     ourRv = REDISMODULE_ERR;
@@ -700,7 +738,8 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
       if (idx < 0) continue;
 
       if (!md->sortVector) {
-        md->sortVector = NewSortingVector(sctx->spec->sortables->len);
+        DocTable_SetSortingVector(&sctx->spec->docs, docId,
+                                  NewSortingVector(sctx->spec->sortables->len));
       }
 
       RS_LOG_ASSERT((fs->options & FieldSpec_Dynamic) == 0, "Dynamic field cannot use PARTIAL");
@@ -708,15 +747,15 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
       switch (fs->types) {
         case INDEXFLD_T_FULLTEXT:
         case INDEXFLD_T_TAG:
-          RSSortingVector_Put(md->sortVector, idx, (void *)RedisModule_StringPtrLen(f->text, NULL),
-                              RS_SORTABLE_STR);
+          DocTable_PutSortable(&sctx->spec->docs, md, idx,
+                               (void *)RedisModule_StringPtrLen(f->text, NULL), RS_SORTABLE_STR);
           break;
         case INDEXFLD_T_NUMERIC: {
           double numval;
           if (RedisModule_StringToDouble(f->text, &numval) == REDISMODULE_ERR) {
             BAIL("Could not parse numeric index value");
           }
-          RSSortingVector_Put(md->sortVector, idx, &numval, RS_SORTABLE_NUM);
+          DocTable_PutSortable(&sctx->spec->docs, md, idx, &numval, RS_SORTABLE_NUM);
           break;
         }
         default:
@@ -730,9 +769,222 @@ done:
   if (aCtx->donecb) {
     aCtx->donecb(aCtx, sctx->redisCtx, aCtx->donecbData);
   }
+  Indexer_Decref(aCtx->indexer);
   AddDocumentCtx_Free(aCtx);
 }
 
+/* Whether a field can be updated without reindexing the whole document */
+static bool fieldUpdatableInPlace(const FieldSpec *fs) {
+  if (fs->options & FieldSpec_Dynamic) {
+    return false;
+  }
+  switch (fs->types) {
+    case INDEXFLD_T_NUMERIC:
+    case INDEXFLD_T_TAG:
+      return true;
+    case INDEXFLD_T_FULLTEXT:
+      // only kept in the sorting vector
+      return !FieldSpec_IsIndexable(fs);
+    default:
+      return false;
+  }
+}
+
+static int updateNumericInPlace(RedisSearchCtx *sctx, const FieldSpec *fs, t_docId docId,
+                                RedisModuleString *oldValue, RedisModuleString *newValue) {
+  double oldNum, newNum;
+  if ((oldValue && RedisModule_StringToDouble(oldValue, &oldNum) != REDISMODULE_OK) ||
+      (newValue && RedisModule_StringToDouble(newValue, &newNum) != REDISMODULE_OK)) {
+    return REDISMODULE_ERR;
+  }
+  if (!FieldSpec_IsIndexable(fs) || (oldValue && newValue && oldNum == newNum)) {
+    return REDISMODULE_OK;
+  }
+
+  RedisModuleKey *idxKey = NULL;
+  RedisModuleString *keyName = IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_NUMERIC);
+  NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &idxKey);
+  int rc = REDISMODULE_ERR;
+  if (!rt) {
+    goto done;
+  }
+  if (oldValue) {
+    if (!NumericRangeTree_Delete(rt, docId, oldNum)) {
+      goto done;
+    }
+    sctx->spec->stats.numRecords--;
+  }
+  if (newValue) {
+    // nothing is added if the tree already holds the document
+    size_t sz = NumericRangeTree_Insert(rt, docId, newNum);
+    if (sz) {
+      sctx->spec->stats.invertedSize += sz;
+      sctx->spec->stats.numRecords++;
+    }
+  }
+  rc = REDISMODULE_OK;
+
+done:
+  if (idxKey) {
+    RedisModule_CloseKey(idxKey);
+  }
+  return rc;
+}
+
+static int updateTagInPlace(RedisSearchCtx *sctx, const FieldSpec *fs, t_docId docId,
+                            RedisModuleString *oldValue, RedisModuleString *newValue) {
+  DocumentField oldField = {.name = fs->name, .text = oldValue};
+  DocumentField newField = {.name = fs->name, .text = newValue};
+  char **oldTags = oldValue ? TagIndex_Preprocess(fs->tagSep, fs->tagFlags, &oldField) : NULL;
+  char **newTags = newValue ? TagIndex_Preprocess(fs->tagSep, fs->tagFlags, &newField) : NULL;
+  RedisModuleKey *idxKey = NULL;
+  int rc = REDISMODULE_ERR;
+
+  RedisModuleString *kname = IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_TAG);
+  TagIndex *tidx = TagIndex_Open(sctx, kname, 1, &idxKey);
+  if (!tidx) {
+    goto done;
+  }
+  if (oldTags && array_len(oldTags) &&
+      !TagIndex_Unindex(tidx, (const char **)oldTags, array_len(oldTags), docId)) {
+    // the document was not indexed with this value
+    goto done;
+  }
+  if (newTags) {
+    sctx->spec->stats.invertedSize +=
+        TagIndex_Index(tidx, (const char **)newTags, array_len(newTags), docId);
+  }
+  rc = REDISMODULE_OK;
+
+done:
+  if (idxKey) {
+    RedisModule_CloseKey(idxKey);
+  }
+  if (oldTags) {
+    TagIndex_FreePreprocessedData(oldTags);
+  }
+  if (newTags) {
+    TagIndex_FreePreprocessedData(newTags);
+  }
+  return rc;
+}
+
+int Document_UpdateFieldsInPlace(RedisSearchCtx *sctx, RedisModuleString *key,
+                                 RedisModuleString **fields, RedisModuleString **oldValues) {
+  IndexSpec *spec = sctx->spec;
+  const SchemaRule *rule = spec->rule;
+  t_docId docId = DocTable_GetIdR(&spec->docs, key);
+  RSDocumentMetadata *md = docId ? DocTable_Get(&spec->docs, docId) : NULL;
+  if (!md || !rule) {
+    return REDISMODULE_ERR;
+  }
+  RedisModuleKey *k = RedisModule_OpenKey(sctx->redisCtx, key, REDISMODULE_READ);
+  if (!k || RedisModule_KeyType(k) != REDISMODULE_KEYTYPE_HASH) {
+    if (k) {
+      RedisModule_CloseKey(k);
+    }
+    return REDISMODULE_ERR;
+  }
+
+  size_t n = 0;
+  while (fields[n]) {
+    n++;
+  }
+  const FieldSpec *fss[n];
+  RedisModuleString *newValues[n];
+  memset(fss, 0, sizeof(fss));
+  memset(newValues, 0, sizeof(newValues));
+  FieldSpecDedupeArray dedupes = {0};
+  const char *payloadField = rule->payload_field ? rule->payload_field : "__payload";
+  bool scoreChanged = false, payloadChanged = false;
+  int rc = REDISMODULE_ERR;
+
+  // Check that every changed field can be updated in place before changing anything. Text fields
+  // are reindexed with the whole document, as their terms' positions and frequencies span all the
+  // text fields of the document
+  for (size_t i = 0; i < n; i++) {
+    size_t len;
+    const char *name = RedisModule_StringPtrLen(fields[i], &len);
+    if (rule->lang_field && !strcmp(name, rule->lang_field)) {
+      goto done;
+    }
+    scoreChanged |= rule->score_field && !strcmp(name, rule->score_field);
+    payloadChanged |= !strcmp(name, payloadField);
+
+    const FieldSpec *fs = IndexSpec_GetField(spec, name, len);
+    if (!fs || dedupes[fs->index]) {
+      continue;
+    }
+    if (!fieldUpdatableInPlace(fs)) {
+      goto done;
+    }
+    dedupes[fs->index] = 1;
+    fss[i] = fs;
+    RedisModule_HashGet(k, REDISMODULE_HASH_NONE, fields[i], &newValues[i], NULL);
+  }
+
+  RedisModuleString *payload = NULL;
+  if (payloadChanged &&
+      !(payload = SchemaRule_HashPayload(sctx->redisCtx, rule, k,
+                                         RedisModule_StringPtrLen(key, NULL)))) {
+    // the doc table cannot drop a payload
+    goto done;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    const FieldSpec *fs = fss[i];
+    if (!fs) {
+      continue;
+    }
+    RedisModuleString *oldValue = oldValues[i], *newValue = newValues[i];
+    if (fs->types == INDEXFLD_T_NUMERIC) {
+      if (updateNumericInPlace(sctx, fs, docId, oldValue, newValue) != REDISMODULE_OK) {
+        goto done;
+      }
+    } else if (fs->types == INDEXFLD_T_TAG && FieldSpec_IsIndexable(fs)) {
+      if (updateTagInPlace(sctx, fs, docId, oldValue, newValue) != REDISMODULE_OK) {
+        goto done;
+      }
+    }
+
+    if (FieldSpec_IsSortable(fs)) {
+      if (!md->sortVector) {
+        DocTable_SetSortingVector(&spec->docs, docId, NewSortingVector(spec->sortables->len));
+      }
+      if (!newValue) {
+        DocTable_PutSortable(&spec->docs, md, fs->sortIdx, NULL, RS_SORTABLE_NIL);
+      } else if (fs->types == INDEXFLD_T_NUMERIC) {
+        double numval;
+        RedisModule_StringToDouble(newValue, &numval);
+        DocTable_PutSortable(&spec->docs, md, fs->sortIdx, &numval, RS_SORTABLE_NUM);
+      } else {
+        DocTable_PutSortable(&spec->docs, md, fs->sortIdx, RedisModule_StringPtrLen(newValue, NULL),
+                             RS_SORTABLE_STR);
+      }
+    }
+  }
+
+  if (scoreChanged) {
+    md->score = SchemaRule_HashScore(sctx->redisCtx, rule, k, RedisModule_StringPtrLen(key, NULL));
+  }
+  if (payload) {
+    size_t len;
+    const char *data = RedisModule_StringPtrLen(payload, &len);
+    DocTable_SetPayload(&spec->docs, docId, data, len);
+    RedisModule_FreeString(sctx->redisCtx, payload);
+  }
+  rc = REDISMODULE_OK;
+
+done:
+  for (size_t i = 0; i < n; i++) {
+    if (newValues[i]) {
+      RedisModule_FreeString(sctx->redisCtx, newValues[i]);
+    }
+  }
+  RedisModule_CloseKey(k);
+  return rc;
+}
+
 DocumentField *Document_GetField(Document *d, const char *fieldName) {
   if (!d || !fieldName) return NULL;
 
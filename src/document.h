@@ -293,6 +293,13 @@ void AddDocumentCtx_Finish(RSAddDocumentCtx *aCtx);
  */
 int Document_AddToIndexes(RSAddDocumentCtx *ctx);
 
+/**
+ * Run the preprocessors of the document's fields, i.e. tokenize them, without writing anything
+ * to the index. This does not need the GIL. Returns REDISMODULE_ERR, with the context's status
+ * set, if a field is invalid.
+ */
+int Document_Preprocess(RSAddDocumentCtx *aCtx);
+
 /**
  * Free the AddDocumentCtx. Should be done once AddToIndexes() completes; or
  * when the client is unblocked.
@@ -309,6 +316,18 @@ void AddDocumentCtx_Free(RSAddDocumentCtx *aCtx);
 int Document_EvalExpression(RedisSearchCtx *sctx, RedisModuleString *key, const char *expr,
                             int *result, QueryError *err);
 
+/* Apply a change of some of the fields of an indexed hash to its document in place, keeping its
+ * docId. `fields` is the NULL terminated list of the changed fields and `oldValues` holds the
+ * values the document was indexed with, NULL for the fields the hash lacked. Numeric and tag fields
+ * have their postings swapped, and sortables, the score and the payload are updated in the doc
+ * table.
+ *
+ * Returns REDISMODULE_ERR if the change requires reindexing the whole document, as for a change of
+ * an indexed text field or of the language, or if the document was not indexed with the given old
+ * values. The document may then be partly updated, and must be reindexed */
+int Document_UpdateFieldsInPlace(RedisSearchCtx *sctx, RedisModuleString *key,
+                                 RedisModuleString **fields, RedisModuleString **oldValues);
+
 // Don't create document if it does not exist. Replace only
 #define REDIS_SAVEDOC_NOCREATE 0x01
 /**
@@ -6,7 +6,6 @@
 #include "../spec.h"
 #include "../query.h"
 #include "../synonym_map.h"
-#include "../dep/snowball/include/libstemmer.h"
 #include "default.h"
 #include "../tokenize.h"
 #include "../rmutil/vector.h"
@@ -317,7 +316,7 @@ typedef struct {
       RSTokenizer *tokenizer;
       Vector *tokList;
     } cn;
-    struct sb_stemmer *latin;
+    Stemmer *latin;
   } data;
 } defaultExpanderCtx;
 
@@ -357,7 +356,7 @@ int StemmerExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
 
   // we store the stemmer as private data on the first call to expand
   defaultExpanderCtx *dd = ctx->privdata;
-  struct sb_stemmer *sb;
+  Stemmer *stemmer;
 
   if (!ctx->privdata) {
     if (ctx->language == RS_LANG_CHINESE) {
@@ -366,7 +365,7 @@ int StemmerExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
     } else {
       dd = ctx->privdata = rm_calloc(1, sizeof(*dd));
       dd->isCn = 0;
-      sb = dd->data.latin = sb_stemmer_new(RSLanguage_ToString(ctx->language), NULL);
+      dd->data.latin = NewStemmer(SnowballStemmer, ctx->language);
     }
   }
 
@@ -375,29 +374,29 @@ int StemmerExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
     return REDISMODULE_OK;
   }
 
-  sb = dd->data.latin;
+  stemmer = dd->data.latin;
 
   // No stemmer available for this language - just return the node so we won't
   // be called again
-  if (!sb) {
+  if (!stemmer) {
     return REDISMODULE_OK;
   }
 
-  const sb_symbol *b = (const sb_symbol *)token->str;
-  const sb_symbol *stemmed = sb_stemmer_stem(sb, b, token->len);
-
-  if (stemmed) {
-    int sl = sb_stemmer_length(sb);
-
-    // Make a copy of the stemmed buffer with the + prefix given to stems
-    char *dup = rm_malloc(sl + 2);
+  // The stemmer returns the stem with the + prefix given to stems, or NULL if the term is its own
+  // stem, which may still be the stem of other indexed terms
+  size_t sl;
+  const char *stemmed = stemmer->Stem(stemmer->ctx, token->str, token->len, &sl);
+  if (!stemmed) {
+    char *dup = rm_malloc(token->len + 2);
     dup[0] = STEM_PREFIX;
-    memcpy(dup + 1, stemmed, sl + 1);
-    ctx->ExpandToken(ctx, dup, sl + 1, 0x0);  // TODO: Set proper flags here
-    if (sl != token->len || strncmp((const char *)stemmed, token->str, token->len)) {
-      ctx->ExpandToken(ctx, rm_strndup((const char *)stemmed, sl), sl, 0x0);
-    }
+    memcpy(dup + 1, token->str, token->len);
+    dup[token->len + 1] = '\0';
+    ctx->ExpandToken(ctx, dup, token->len + 1, 0x0);  // TODO: Set proper flags here
+    return REDISMODULE_OK;
   }
+
+  ctx->ExpandToken(ctx, rm_strndup(stemmed, sl), sl, 0x0);  // TODO: Set proper flags here
+  ctx->ExpandToken(ctx, rm_strndup(stemmed + 1, sl - 1), sl - 1, 0x0);
   return REDISMODULE_OK;
 }
 
@@ -410,7 +409,7 @@ void StemmerExpanderFree(void *p) {
     dd->data.cn.tokenizer->Free(dd->data.cn.tokenizer);
     Vector_Free(dd->data.cn.tokList);
   } else if (dd->data.latin) {
-    sb_stemmer_delete(dd->data.latin);
+    dd->data.latin->Free(dd->data.latin);
   }
   rm_free(dd);
 }
@@ -18,10 +18,11 @@ typedef enum {
   INDEXFLD_T_FULLTEXT = 0x01,
   INDEXFLD_T_NUMERIC = 0x02,
   INDEXFLD_T_GEO = 0x04,
-  INDEXFLD_T_TAG = 0x08
+  INDEXFLD_T_TAG = 0x08,
+  INDEXFLD_T_VECTOR = 0x10
 } FieldType;
 
-#define INDEXFLD_NUM_TYPES 4
+#define INDEXFLD_NUM_TYPES 5
 
 // clang-format off
 // otherwise, it looks h o r r i b l e
@@ -29,7 +30,8 @@ typedef enum {
   (T == INDEXFLD_T_FULLTEXT   ? 0 : \
   (T == INDEXFLD_T_NUMERIC    ? 1 : \
   (T == INDEXFLD_T_GEO        ? 2 : \
-  (T == INDEXFLD_T_TAG        ? 3 : -1))))
+  (T == INDEXFLD_T_TAG        ? 3 : \
+  (T == INDEXFLD_T_VECTOR     ? 4 : -1)))))
 
 #define INDEXTYPE_FROM_POS(P) (1<<(P))
 // clang-format on
@@ -38,6 +40,7 @@ typedef enum {
 #define IXFLDPOS_NUMERIC INDEXTYPE_TO_POS(INDEXFLD_T_NUMERIC)
 #define IXFLDPOS_GEO INDEXTYPE_TO_POS(INDEXFLD_T_GEO)
 #define IXFLDPOS_TAG INDEXTYPE_TO_POS(INDEXFLD_T_TAG)
+#define IXFLDPOS_VECTOR INDEXTYPE_TO_POS(INDEXFLD_T_VECTOR)
 
 RS_ENUM_BITWISE_HELPER(FieldType)
 
@@ -46,7 +49,8 @@ typedef enum {
   FieldSpec_NoStemming = 0x02,
   FieldSpec_NotIndexable = 0x04,
   FieldSpec_Phonetics = 0x08,
-  FieldSpec_Dynamic = 0x10
+  FieldSpec_Dynamic = 0x10,
+  FieldSpec_WithSuffixTrie = 0x20
 } FieldSpecOptions;
 
 RS_ENUM_BITWISE_HELPER(FieldSpecOptions)
@@ -60,6 +64,37 @@ typedef enum {
 
 RS_ENUM_BITWISE_HELPER(TagFieldFlags)
 
+typedef enum {
+  VectorMetric_L2 = 0,  // squared euclidean distance
+  VectorMetric_IP,      // 1 - inner product
+  VectorMetric_Cosine,  // 1 - cosine similarity
+} VectorMetric;
+
+typedef enum {
+  VectorAlgo_Flat = 0,  // brute force scan
+  VectorAlgo_HNSW,      // hierarchical navigable small world graph
+} VectorAlgo;
+
+// Options for vector fields. Vectors are stored as FLOAT32 blobs of `dim` elements
+typedef struct {
+  uint32_t dim;
+  VectorMetric metric : 8;
+  VectorAlgo algo : 8;
+  // HNSW only: the number of neighbours per node, and the size of the candidate lists used when
+  // inserting and when querying
+  uint16_t hnswM;
+  uint16_t hnswEfConstruction;
+  uint16_t hnswEfRuntime;
+} VectorFieldOptions;
+
+#define VECTOR_DEFAULT_HNSW_M 16
+#define VECTOR_DEFAULT_HNSW_EF_CONSTRUCTION 200
+#define VECTOR_DEFAULT_HNSW_EF_RUNTIME 10
+#define VECTOR_MAX_DIM 32768
+
+// The longest prefix a text field can keep postings for
+#define PREFIX_INDEX_MAX_LEN 8
+
 /* The fieldSpec represents a single field in the document's field spec.
 Each field has a unique id that's a power of two, so we can filter fields
 by a bit mask.
@@ -79,6 +114,12 @@ typedef struct FieldSpec {
   TagFieldFlags tagFlags : 16;
   char tagSep;
 
+  // Options for vector fields
+  VectorFieldOptions vectorOpts;
+
+  // The longest prefix, in letters, whose postings are kept for a text field, or 0
+  uint8_t prefixIndexLen;
+
   // weight in frequency calculations
   double ftWeight;
   // ID used to identify the field within the field mask
@@ -96,6 +137,7 @@ typedef struct FieldSpec {
 #define FieldSpec_IsSortable(fs) ((fs)->options & FieldSpec_Sortable)
 #define FieldSpec_IsNoStem(fs) ((fs)->options & FieldSpec_NoStemming)
 #define FieldSpec_IsPhonetics(fs) ((fs)->options & FieldSpec_Phonetics)
+#define FieldSpec_HasSuffixTrie(fs) ((fs)->options & FieldSpec_WithSuffixTrie)
 #define FieldSpec_IsIndexable(fs) (0 == ((fs)->options & FieldSpec_NotIndexable))
 
 void FieldSpec_SetSortable(FieldSpec* fs);
@@ -5,12 +5,16 @@
 #include "redis_index.h"
 #include "numeric_index.h"
 #include "tag_index.h"
+#include "suffix_index.h"
+#include "spell_index.h"
+#include "vector_index.h"
 #include "tests/time_sample.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
+#include <pthread.h>
 #include "rwlock.h"
 #include "util/khash.h"
 #include <float.h>
@@ -166,10 +170,9 @@ typedef struct {
   uint64_t nbytesCollected;
   // Number of document records removed
   uint64_t ndocsCollected;
-
-  /** Specific information about the _last_ index block */
-  size_t lastblkDocsRemoved;
-  size_t lastblkBytesCollected;
+  // The index's GC marker when the child scanned it
+  uint64_t gcMarker;
+  // Number of documents of the last index block before repair, if it was repaired
   size_t lastblkNumDocs;
 } MSG_IndexInfo;
 
@@ -177,29 +180,48 @@ typedef struct {
 typedef struct {
   IndexBlock blk;
   int64_t oldix;  // Old position of the block
-  int64_t newix;  // New position of the block
+  // Number of documents and bytes collected from the block
+  uint64_t ndocsCollected;
+  uint64_t nbytesCollected;
   // the actual content of the block follows...
 } MSG_RepairedBlock;
 
 typedef struct {
-  void *ptr;       // Address of the buffer to free
-  uint32_t oldix;  // Old index of deleted block
-  uint32_t _pad;   // Uninitialized reads, otherwise
+  uint32_t oldix;           // Old index of deleted block
+  uint32_t ndocsCollected;  // Number of documents the block held
+  uint64_t nbytesCollected;
 } MSG_DeletedBlock;
 
+typedef struct {
+  MSG_RepairedBlock *fixed;
+  MSG_DeletedBlock *deleted;
+  MSG_IndexInfo ixmsg;
+} InvIdxRepair;
+
+static void InvIdxRepair_Free(InvIdxRepair *r) {
+  array_free(r->fixed);
+  array_free(r->deleted);
+  memset(r, 0, sizeof(*r));
+}
+
 /**
- * headerCallback and hdrarg are invoked before the inverted index is sent, only
- * iff the inverted index was repaired.
+ * Scan the inverted index and repair its blocks, without sending anything to the parent.
+ * Returns true if the index was repaired, in which case `out` holds the repair
+ * results and must be released using InvIdxRepair_Free (after sending them
+ * with FGC_childSendRepair). On false, `out` is left empty.
+ *
+ * This function only reads the index and the document table, which are not
+ * modified in the child process, so it may be called from several threads
+ * concurrently (for different indexes).
+ *
  * RepairCallback and its argument are passed directly to IndexBlock_Repair; see
  * that function for more details.
  */
-static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedIndex *idx,
-                                  void (*headerCallback)(ForkGC *, void *), void *hdrarg,
-                                  IndexRepairParams *params) {
+static bool FGC_childRepairInvidxScan(RedisSearchCtx *sctx, InvertedIndex *idx,
+                                      IndexRepairParams *params, InvIdxRepair *out) {
   MSG_RepairedBlock *fixed = array_new(MSG_RepairedBlock, 10);
   MSG_DeletedBlock *deleted = array_new(MSG_DeletedBlock, 10);
-  IndexBlock *blocklist = array_new(IndexBlock, idx->size);
-  MSG_IndexInfo ixmsg = {.nblocksOrig = idx->size};
+  MSG_IndexInfo ixmsg = {.nblocksOrig = idx->size, .gcMarker = idx->gcMarker};
   IndexRepairParams params_s = {0};
   bool rv = false;
   if (!params) {
@@ -212,41 +234,35 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
       // Skip over blocks which have a wide variation. In the future we might
       // want to split a block into two (or more) on high-delta boundaries.
       // todo: is it ok??
-      blocklist = array_append(blocklist, *blk);
       continue;
     }
 
-    // Capture the pointer address before the block is cleared; otherwise
-    // the pointer might be freed!
-    void *bufptr = blk->buf.data;
     int nrepaired = IndexBlock_Repair(blk, &sctx->spec->docs, idx->flags, params);
     // We couldn't repair the block - return 0
     if (nrepaired == -1) {
       goto done;
     } else if (nrepaired == 0) {
       // unmodified block
-      blocklist = array_append(blocklist, *blk);
       continue;
     }
 
     if (blk->numDocs == 0) {
       // this block should be removed
       MSG_DeletedBlock *delmsg = array_ensure_tail(&deleted, MSG_DeletedBlock);
-      *delmsg = (MSG_DeletedBlock){.ptr = bufptr, .oldix = i};
+      *delmsg = (MSG_DeletedBlock){
+          .oldix = i, .ndocsCollected = nrepaired, .nbytesCollected = params->bytesCollected};
     } else {
-      blocklist = array_append(blocklist, *blk);
       MSG_RepairedBlock *fixmsg = array_ensure_tail(&fixed, MSG_RepairedBlock);
-      fixmsg->newix = array_len(blocklist) - 1;
-      fixmsg->oldix = i;
-      fixmsg->blk = *blk;
+      *fixmsg = (MSG_RepairedBlock){.blk = *blk,
+                                    .oldix = i,
+                                    .ndocsCollected = nrepaired,
+                                    .nbytesCollected = params->bytesCollected};
       ixmsg.nblocksRepaired++;
     }
 
     ixmsg.nbytesCollected += params->bytesCollected;
     ixmsg.ndocsCollected += nrepaired;
     if (i == idx->size - 1) {
-      ixmsg.lastblkBytesCollected = params->bytesCollected;
-      ixmsg.lastblkDocsRemoved = nrepaired;
       ixmsg.lastblkNumDocs = blk->numDocs + nrepaired;
     }
   }
@@ -255,65 +271,30 @@ static bool FGC_childRepairInvidx(ForkGC *gc, RedisSearchCtx *sctx, InvertedInde
     // No blocks were removed or repaired
     goto done;
   }
-
-  headerCallback(gc, hdrarg);
-  FGC_sendFixed(gc, &ixmsg, sizeof ixmsg);
-  if (array_len(blocklist) == idx->size) {
-    // no empty block, there is no need to send the blocks array. Don't send
-    // any new blocks
-    FGC_sendBuffer(gc, NULL, 0);
-  } else {
-    FGC_sendBuffer(gc, blocklist, array_len(blocklist) * sizeof(*blocklist));
-  }
-  FGC_sendBuffer(gc, deleted, array_len(deleted) * sizeof(*deleted));
-
-  for (size_t i = 0; i < array_len(fixed); ++i) {
-    // write fix block
-    const MSG_RepairedBlock *msg = fixed + i;
-    const IndexBlock *blk = blocklist + msg->newix;
-    FGC_sendFixed(gc, msg, sizeof(*msg));
-    FGC_sendBuffer(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
-  }
   rv = true;
 
 done:
-  array_free(fixed);
-  array_free(blocklist);
-  array_free(deleted);
+  if (rv) {
+    *out = (InvIdxRepair){.fixed = fixed, .deleted = deleted, .ixmsg = ixmsg};
+  } else {
+    array_free(fixed);
+    array_free(deleted);
+  }
   return rv;
 }
 
-static void sendHeaderString(ForkGC *gc, void *arg) {
-  struct iovec *iov = arg;
-  FGC_sendBuffer(gc, iov->iov_base, iov->iov_len);
-}
+static void FGC_childSendRepair(ForkGC *gc, const InvIdxRepair *r) {
+  FGC_sendFixed(gc, &r->ixmsg, sizeof r->ixmsg);
+  FGC_sendBuffer(gc, r->deleted, array_len(r->deleted) * sizeof(*r->deleted));
 
-static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
-  TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
-  rune *rstr = NULL;
-  t_len slen = 0;
-  float score = 0;
-  int dist = 0;
-  while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
-    size_t termLen;
-    char *term = runesToStr(rstr, slen, &termLen);
-    RedisModuleKey *idxKey = NULL;
-    InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, strlen(term), 1, &idxKey);
-    if (idx) {
-      struct iovec iov = {.iov_base = (void *)term, termLen};
-      FGC_childRepairInvidx(gc, sctx, idx, sendHeaderString, &iov, NULL);
-    }
-    if (idxKey) {
-      RedisModule_CloseKey(idxKey);
-    }
-    rm_free(term);
+  for (size_t i = 0; i < array_len(r->fixed); ++i) {
+    // write fix block
+    const MSG_RepairedBlock *msg = r->fixed + i;
+    const IndexBlock *blk = &msg->blk;
+    FGC_sendFixed(gc, msg, sizeof(*msg));
+    FGC_sendBuffer(gc, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
+    FGC_sendBuffer(gc, IndexBlock_PosBuf(blk), IndexBlock_PosLen(blk));
   }
-  DFAFilter_Free(iter->ctx);
-  rm_free(iter->ctx);
-  TrieIterator_Free(iter);
-
-  // we are done with terms
-  FGC_sendTerminator(gc);
 }
 
 KHASH_MAP_INIT_INT64(cardvals, size_t)
@@ -410,7 +391,258 @@ static void sendKht(ForkGC *gc, const khash_t(cardvals) * kh) {
   RS_LOG_ASSERT(nsent == n, "Not all hashes has been sent");
 }
 
-static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
+/** A single inverted index to be repaired by the child */
+typedef struct {
+  InvertedIndex *idx;
+  // Term of a term index. Owned by the job
+  char *term;
+  size_t termLen;
+  // Address of the numeric range node or tag value, identifying the index in the parent
+  const void *curPtr;
+  // Set for numeric indexes, whose deleted values are also collected
+  int isNumeric;
+  numCbCtx nctx;
+
+  bool repaired;
+  InvIdxRepair repair;
+  // Set by the worker once the repair results are ready to be sent
+  int done;
+} FGCRepairJob;
+
+/**
+ * Threads repairing the inverted indexes in the child. Jobs are handed out in
+ * batches; the workers repair them in any order, but the calling thread sends
+ * the results in the order the jobs were submitted, so the parent receives
+ * the same message stream as with a single thread.
+ */
+typedef struct {
+  RedisSearchCtx *sctx;
+  pthread_t *threads;
+  size_t nthreads;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+
+  FGCRepairJob *batch;
+  size_t njobs;
+  size_t next;
+  int shutdown;
+} FGCChildPool;
+
+#define FGC_CHILD_BATCH_SIZE 1024
+
+typedef void (*FGCSendRepairCallback)(ForkGC *gc, FGCRepairJob *job, void *arg);
+
+static void FGC_childRepairJob(RedisSearchCtx *sctx, FGCRepairJob *job) {
+  IndexRepairParams params = {0};
+  if (job->isNumeric) {
+    job->nctx.lastblk = job->idx->blocks + job->idx->size - 1;
+    params.RepairCallback = countDeleted;
+    params.arg = &job->nctx;
+  }
+  job->repaired = FGC_childRepairInvidxScan(sctx, job->idx, &params, &job->repair);
+}
+
+static void *FGC_childWorkerMain(void *arg) {
+  FGCChildPool *pool = arg;
+  pthread_mutex_lock(&pool->lock);
+  while (1) {
+    while (!pool->shutdown && pool->next >= pool->njobs) {
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    if (pool->shutdown) {
+      break;
+    }
+    FGCRepairJob *job = pool->batch + pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+
+    FGC_childRepairJob(pool->sctx, job);
+
+    pthread_mutex_lock(&pool->lock);
+    job->done = 1;
+    pthread_cond_broadcast(&pool->cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+static void FGC_childPoolInit(FGCChildPool *pool, RedisSearchCtx *sctx) {
+  *pool = (FGCChildPool){.sctx = sctx};
+  pool->batch = rm_calloc(FGC_CHILD_BATCH_SIZE, sizeof(*pool->batch));
+  if (RSGlobalConfig.forkGcThreads <= 1) {
+    // Everything is done inline by the child's main thread
+    return;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pool->threads = rm_calloc(RSGlobalConfig.forkGcThreads, sizeof(*pool->threads));
+  for (size_t ii = 0; ii < RSGlobalConfig.forkGcThreads; ++ii) {
+    if (pthread_create(pool->threads + ii, NULL, FGC_childWorkerMain, pool) != 0) {
+      // Continue with whatever threads we managed to create
+      break;
+    }
+    pool->nthreads++;
+  }
+}
+
+static void FGC_childPoolFree(FGCChildPool *pool) {
+  if (pool->threads) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t ii = 0; ii < pool->nthreads; ++ii) {
+      pthread_join(pool->threads[ii], NULL);
+    }
+    rm_free(pool->threads);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+  }
+  rm_free(pool->batch);
+}
+
+/**
+ * Repair the first `njobs` jobs of the pool's batch, and call `sendCb` for each
+ * of them in order. The callback is responsible for releasing the job's resources.
+ */
+static void FGC_childRunBatch(ForkGC *gc, FGCChildPool *pool, size_t njobs,
+                              FGCSendRepairCallback sendCb, void *arg) {
+  FGCRepairJob *jobs = pool->batch;
+  if (!pool->nthreads) {
+    for (size_t ii = 0; ii < njobs; ++ii) {
+      FGC_childRepairJob(pool->sctx, jobs + ii);
+      sendCb(gc, jobs + ii, arg);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->njobs = njobs;
+  pool->next = 0;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  // Stream results while the workers are still busy with later jobs
+  for (size_t ii = 0; ii < njobs; ++ii) {
+    pthread_mutex_lock(&pool->lock);
+    while (!jobs[ii].done) {
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    sendCb(gc, jobs + ii, arg);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->njobs = pool->next = 0;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void sendTermRepair(ForkGC *gc, FGCRepairJob *job, void *unused) {
+  if (job->repaired) {
+    FGC_sendBuffer(gc, job->term, job->termLen);
+    FGC_childSendRepair(gc, &job->repair);
+  }
+  InvIdxRepair_Free(&job->repair);
+  rm_free(job->term);
+}
+
+static void sendNumericTagRepair(ForkGC *gc, FGCRepairJob *job, void *arg) {
+  tagNumHeader *header = arg;
+  if (job->repaired) {
+    header->curPtr = job->curPtr;
+    sendNumericTagHeader(gc, header);
+    FGC_childSendRepair(gc, &job->repair);
+    if (job->isNumeric) {
+      sendKht(gc, job->nctx.delRest);
+      sendKht(gc, job->nctx.delLast);
+    }
+  }
+  if (job->nctx.delRest) {
+    kh_destroy(cardvals, job->nctx.delRest);
+  }
+  if (job->nctx.delLast) {
+    kh_destroy(cardvals, job->nctx.delLast);
+  }
+  InvIdxRepair_Free(&job->repair);
+}
+
+static void FGC_childEnqueueTerm(ForkGC *gc, FGCChildPool *pool, size_t *njobs,
+                                 InvertedIndex *idx, char *term, size_t termLen) {
+  pool->batch[(*njobs)++] = (FGCRepairJob){.idx = idx, .term = term, .termLen = termLen};
+  if (*njobs == FGC_CHILD_BATCH_SIZE) {
+    FGC_childRunBatch(gc, pool, *njobs, sendTermRepair, NULL);
+    *njobs = 0;
+  }
+}
+
+static void FGC_childCollectTerms(ForkGC *gc, FGCChildPool *pool) {
+  RedisSearchCtx *sctx = pool->sctx;
+  TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
+  rune *rstr = NULL;
+  t_len slen = 0;
+  float score = 0;
+  int dist = 0;
+  size_t njobs = 0;
+  FieldSpec **textFields = NULL;
+  if (sctx->spec->flags & Index_FieldPostings) {
+    textFields = getFieldsByType(sctx->spec, INDEXFLD_T_FULLTEXT);
+  }
+  while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
+    size_t termLen;
+    char *term = runesToStr(rstr, slen, &termLen);
+    RedisModuleKey *idxKey = NULL;
+    InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, strlen(term), 1, &idxKey);
+    // Nothing modifies the index in the child, so it stays valid after closing the key
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+    if (!idx) {
+      rm_free(term);
+      continue;
+    }
+    // The per-field postings go first, since sending the term's own job releases the term
+    for (size_t i = 0; i < array_len(textFields); ++i) {
+      t_fieldId ftId = textFields[i]->ftId;
+      InvertedIndex *fidx = Redis_OpenFieldInvertedIndexEx(sctx, term, termLen, ftId, 0, NULL);
+      if (!fidx) {
+        continue;
+      }
+      char *fterm = rm_malloc(termLen + FIELD_TERM_SUFFIX_LEN);
+      size_t ftermLen = Redis_FormatFieldTerm(fterm, term, termLen, ftId);
+      FGC_childEnqueueTerm(gc, pool, &njobs, fidx, fterm, ftermLen);
+    }
+    FGC_childEnqueueTerm(gc, pool, &njobs, idx, term, termLen);
+  }
+  array_free(textFields);
+  DFAFilter_Free(iter->ctx);
+  rm_free(iter->ctx);
+  TrieIterator_Free(iter);
+
+  // the postings of prefixes are collected like those of terms, under their own names
+  if (sctx->spec->prefixes) {
+    TrieMapIterator *pit = TrieMap_Iterate(sctx->spec->prefixes, "", 0);
+    char *prefix;
+    tm_len_t prefixLen;
+    void *unused;
+    while (TrieMapIterator_Next(pit, &prefix, &prefixLen, &unused)) {
+      InvertedIndex *idx = Redis_OpenPrefixInvertedIndexEx(sctx, prefix, prefixLen, 0, NULL);
+      if (!idx) {
+        continue;
+      }
+      char *name = rm_malloc(prefixLen + PREFIX_TERM_SUFFIX_LEN);
+      size_t nameLen = Redis_FormatPrefixTerm(name, prefix, prefixLen);
+      FGC_childEnqueueTerm(gc, pool, &njobs, idx, name, nameLen);
+    }
+    TrieMapIterator_Free(pit);
+  }
+  FGC_childRunBatch(gc, pool, njobs, sendTermRepair, NULL);
+
+  // we are done with terms
+  FGC_sendTerminator(gc);
+}
+
+static void FGC_childCollectNumeric(ForkGC *gc, FGCChildPool *pool) {
+  RedisSearchCtx *sctx = pool->sctx;
   RedisModuleKey *idxKey = NULL;
   FieldSpec **numericFields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC | INDEXFLD_T_GEO);
 
@@ -423,30 +655,27 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
 
     NumericRangeNode *currNode = NULL;
     tagNumHeader header = {.field = numericFields[i]->name, .uniqueId = rt->uniqueId};
+    size_t njobs = 0;
 
     while ((currNode = NumericRangeTreeIterator_Next(gcIterator))) {
       if (!currNode->range) {
         continue;
       }
-      numCbCtx nctx = {0};
-      InvertedIndex *idx = currNode->range->entries;
-      nctx.lastblk = idx->blocks + idx->size - 1;
-      IndexRepairParams params = {.RepairCallback = countDeleted, .arg = &nctx};
-      header.curPtr = currNode;
-      bool repaired = FGC_childRepairInvidx(gc, sctx, idx, sendNumericTagHeader, &header, &params);
-
-      if (repaired) {
-        sendKht(gc, nctx.delRest);
-        sendKht(gc, nctx.delLast);
-      }
-      if (nctx.delRest) {
-        kh_destroy(cardvals, nctx.delRest);
-      }
-      if (nctx.delLast) {
-        kh_destroy(cardvals, nctx.delLast);
+      pool->batch[njobs++] = (FGCRepairJob){
+          .idx = currNode->range->entries, .curPtr = currNode, .isNumeric = 1};
+      if (njobs == FGC_CHILD_BATCH_SIZE) {
+        FGC_childRunBatch(gc, pool, njobs, sendNumericTagRepair, &header);
+        njobs = 0;
       }
     }
+    FGC_childRunBatch(gc, pool, njobs, sendNumericTagRepair, &header);
 
+    if (!header.sentFieldName && NumericRangeTree_NeedsCompaction(rt)) {
+      // nothing was collected, but the parent is still to compact the tree further
+      header.sentFieldName = 1;
+      FGC_sendBuffer(gc, header.field, strlen(header.field));
+      FGC_sendFixed(gc, &header.uniqueId, sizeof header.uniqueId);
+    }
     if (header.sentFieldName) {
       // If we've repaired at least one entry, send the terminator;
       // note that "terminator" just means a zero address and not the
@@ -466,7 +695,8 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
   FGC_sendTerminator(gc);
 }
 
-static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
+static void FGC_childCollectTags(ForkGC *gc, FGCChildPool *pool) {
+  RedisSearchCtx *sctx = pool->sctx;
   RedisModuleKey *idxKey = NULL;
   FieldSpec **tagFields = getFieldsByType(sctx->spec, INDEXFLD_T_TAG);
   if (array_len(tagFields) != 0) {
@@ -479,16 +709,22 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
       }
 
       tagNumHeader header = {.field = tagFields[i]->name, .uniqueId = tagIdx->uniqueId};
+      size_t njobs = 0;
 
       TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values, "", 0);
       char *ptr;
       tm_len_t len;
       InvertedIndex *value;
       while (TrieMapIterator_Next(iter, &ptr, &len, (void **)&value)) {
-        header.curPtr = value;
-        // send repaired data
-        FGC_childRepairInvidx(gc, sctx, value, sendNumericTagHeader, &header, NULL);
+        pool->batch[njobs++] = (FGCRepairJob){.idx = value, .curPtr = value};
+        if (njobs == FGC_CHILD_BATCH_SIZE) {
+          FGC_childRunBatch(gc, pool, njobs, sendNumericTagRepair, &header);
+          njobs = 0;
+        }
       }
+      // send repaired data
+      FGC_childRunBatch(gc, pool, njobs, sendNumericTagRepair, &header);
+      TrieMapIterator_Free(iter);
 
       // we are done with the current field
       if (header.sentFieldName) {
@@ -512,10 +748,14 @@ static void FGC_childScanIndexes(ForkGC *gc) {
     return;
   }
 
-  FGC_childCollectTerms(gc, sctx);
-  FGC_childCollectNumeric(gc, sctx);
-  FGC_childCollectTags(gc, sctx);
+  FGCChildPool pool;
+  FGC_childPoolInit(&pool, sctx);
 
+  FGC_childCollectTerms(gc, &pool);
+  FGC_childCollectNumeric(gc, &pool);
+  FGC_childCollectTags(gc, &pool);
+
+  FGC_childPoolFree(&pool);
   SearchCtx_Free(sctx);
 }
 
@@ -525,9 +765,9 @@ typedef struct {
 
   MSG_RepairedBlock *changedBlocks;
 
-  IndexBlock *newBlocklist;
-  size_t newBlocklistSize;
+  // The repair of the last block, or of others, was dropped as the parent changed them
   int lastBlockIgnored;
+  int restBlocksIgnored;
 } InvIdxBuffers;
 
 static int __attribute__((warn_unused_result))
@@ -540,6 +780,12 @@ FGC_recvRepairedBlock(ForkGC *gc, MSG_RepairedBlock *binfo) {
     return REDISMODULE_ERR;
   }
   b->cap = b->offset;
+  Buffer *pb = &binfo->blk.posBuf;
+  if (FGC_recvBuffer(gc, (void **)&pb->data, &pb->offset) != REDISMODULE_OK) {
+    rm_free(b->data);
+    return REDISMODULE_ERR;
+  }
+  pb->cap = pb->offset;
   return REDISMODULE_OK;
 }
 
@@ -549,13 +795,6 @@ FGC_recvInvIdx(ForkGC *gc, InvIdxBuffers *bufs, MSG_IndexInfo *info) {
   if (FGC_recvFixed(gc, info, sizeof(*info)) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
-  if (FGC_recvBuffer(gc, (void **)&bufs->newBlocklist, &bufs->newBlocklistSize) != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-
-  if (bufs->newBlocklistSize) {
-    bufs->newBlocklistSize /= sizeof(*bufs->newBlocklist);
-  }
   if (FGC_recvBuffer(gc, (void **)&bufs->delBlocks, &bufs->numDelBlocks) != REDISMODULE_OK) {
     goto error;
   }
@@ -570,9 +809,9 @@ FGC_recvInvIdx(ForkGC *gc, InvIdxBuffers *bufs, MSG_IndexInfo *info) {
   return REDISMODULE_OK;
 
 error:
-  rm_free(bufs->newBlocklist);
+  rm_free(bufs->delBlocks);
   for (size_t ii = 0; ii < nblocksRecvd; ++ii) {
-    rm_free(bufs->changedBlocks[ii].blk.buf.data);
+    indexBlock_Free(&bufs->changedBlocks[ii].blk);
   }
   rm_free(bufs->changedBlocks);
   memset(bufs, 0, sizeof(*bufs));
@@ -580,130 +819,81 @@ error:
 }
 
 static void freeInvIdx(InvIdxBuffers *bufs, MSG_IndexInfo *info) {
-  rm_free(bufs->newBlocklist);
   rm_free(bufs->delBlocks);
 
   if (bufs->changedBlocks) {
     // could be null because of pipe error
     for (size_t ii = 0; ii < info->nblocksRepaired; ++ii) {
-      rm_free(bufs->changedBlocks[ii].blk.buf.data);
+      indexBlock_Free(&bufs->changedBlocks[ii].blk);
     }
   }
   rm_free(bufs->changedBlocks);
 }
 
-static void checkLastBlock(ForkGC *gc, InvIdxBuffers *idxData, MSG_IndexInfo *info,
-                           InvertedIndex *idx) {
-  IndexBlock *lastOld = idx->blocks + info->nblocksOrig - 1;
-  if (info->lastblkDocsRemoved == 0) {
-    // didn't touch last block in child
-    return;
-  }
-  if (info->lastblkNumDocs == lastOld->numDocs) {
-    // didn't touch last block in parent
-    return;
-  }
-
-  if (info->lastblkDocsRemoved == info->lastblkNumDocs) {
-    // Last block was deleted entirely while updates on the main process.
-    // We need to remove it from delBlocks list
-    idxData->numDelBlocks--;
-
-    // Then We need add it to the newBlocklist.
-    idxData->newBlocklistSize++;
-    idxData->newBlocklist = rm_realloc(idxData->newBlocklist,
-                                       sizeof(*idxData->newBlocklist) * idxData->newBlocklistSize);
-    idxData->newBlocklist[idxData->newBlocklistSize - 1] = *lastOld;
-  } else {
-    // Last block was modified on the child and on the parent.
-
-    // we need to remove it from changedBlocks
-    MSG_RepairedBlock *rb = idxData->changedBlocks + info->nblocksRepaired - 1;
-    indexBlock_Free(&rb->blk);
-    info->nblocksRepaired--;
-
-    // Then add it to newBlocklist if newBlocklist is not NULL.
-    // If newBlocklist!=NULL then the last block must be there (it was changed and not deleted)
-    // If newBlocklist==NULL then by decreasing the nblocksOrig by one we make sure to keep the last
-    // block
-    if (idxData->newBlocklist) {
-      idxData->newBlocklist[idxData->newBlocklistSize - 1] = *lastOld;
-    } else {
-      --info->nblocksOrig;
-    }
-  }
-
-  info->ndocsCollected -= info->lastblkDocsRemoved;
-  info->nbytesCollected -= info->lastblkBytesCollected;
-  idxData->lastBlockIgnored = 1;
-  gc->stats.gcBlocksDenied++;
+/* Whether the parent changed a block of the index since the fork, which makes the child's copy of
+ * it stale. Documents updated in place have their records inserted in, or removed from, any block,
+ * and new documents are appended to the last one. Once a block was split, the blocks no longer are
+ * at the positions the child knows them by, and all of them are taken as changed */
+static bool FGC_blockChanged(const InvertedIndex *idx, const MSG_IndexInfo *info, uint32_t ix) {
+  const IndexBlock *blk = idx->blocks + ix;
+  return idx->splitMarker > info->gcMarker || blk->gcMarker > info->gcMarker ||
+         (ix == info->nblocksOrig - 1 && blk->numDocs != info->lastblkNumDocs);
 }
 
+/* Apply the child's repair to the index. The repair of the blocks the parent changed since the
+ * fork is dropped, and their documents are left for the next run */
 static void FGC_applyInvertedIndex(ForkGC *gc, InvIdxBuffers *idxData, MSG_IndexInfo *info,
                                    InvertedIndex *idx) {
-  checkLastBlock(gc, idxData, info, idx);
-  for (size_t i = 0; i < info->nblocksRepaired; ++i) {
-    MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
-    indexBlock_Free(&idx->blocks[blockModified->oldix]);
-  }
-  for (size_t i = 0; i < idxData->numDelBlocks; ++i) {
-    // Blocks that were deleted entirely:
-    MSG_DeletedBlock *delinfo = idxData->delBlocks + i;
-    rm_free(delinfo->ptr);
-  }
-  rm_free(idxData->delBlocks);
-
   // Ensure the old index is at least as big as the new index' size
   RS_LOG_ASSERT(idx->size >= info->nblocksOrig, "Old index should be larger or equal to new index");
 
-  if (idxData->newBlocklist) {
-    /**
-     * At this point, we check if the last block has had new data added to it,
-     * but was _not_ repaired. We check for a repaired last block in
-     * checkLastBlock().
-     */
-
-    if (!info->lastblkDocsRemoved) {
-      /**
-       * Last block was unmodified-- let's prefer the last block's pointer
-       * over our own (which may be stale).
-       * If the last block was repaired, this is handled above
-       */
-      idxData->newBlocklist[idxData->newBlocklistSize - 1] = idx->blocks[info->nblocksOrig - 1];
+  IndexBlock *blocks = rm_malloc(sizeof(*blocks) * idx->size);
+  size_t nblocks = 0, nfixed = 0, ndeleted = 0;
+  for (uint32_t i = 0; i < info->nblocksOrig; ++i) {
+    IndexBlock *blk = idx->blocks + i;
+    MSG_RepairedBlock *fixed = NULL;
+    MSG_DeletedBlock *deleted = NULL;
+    // both lists are ordered by the blocks' old positions
+    if (nfixed < info->nblocksRepaired && idxData->changedBlocks[nfixed].oldix == i) {
+      fixed = idxData->changedBlocks + nfixed++;
+    } else if (ndeleted < idxData->numDelBlocks && idxData->delBlocks[ndeleted].oldix == i) {
+      deleted = idxData->delBlocks + ndeleted++;
+    } else {
+      blocks[nblocks++] = *blk;
+      continue;
     }
 
-    // Number of blocks added in the parent process since the last scan
-    size_t newAddedLen = idx->size - info->nblocksOrig;
-
-    // The final size is the reordered block size, plus the number of blocks
-    // which we haven't scanned yet, because they were added in the parent
-    size_t totalLen = idxData->newBlocklistSize + newAddedLen;
-
-    idxData->newBlocklist =
-        rm_realloc(idxData->newBlocklist, totalLen * sizeof(*idxData->newBlocklist));
-    memcpy(idxData->newBlocklist + idxData->newBlocklistSize, (idx->blocks + info->nblocksOrig),
-           newAddedLen * sizeof(*idxData->newBlocklist));
-
-    rm_free(idx->blocks);
-    idxData->newBlocklistSize += newAddedLen;
-    idx->blocks = idxData->newBlocklist;
-    idx->size = idxData->newBlocklistSize;
-  } else if (idxData->numDelBlocks) {
-    // In this case, all blocks the child has seen need to be deleted. We don't
-    // get a new block list, because they are all gone..
-    size_t newAddedLen = idx->size - info->nblocksOrig;
-    if (newAddedLen) {
-      memmove(idx->blocks, idx->blocks + info->nblocksOrig, sizeof(*idx->blocks) * newAddedLen);
+    if (FGC_blockChanged(idx, info, i)) {
+      info->ndocsCollected -= fixed ? fixed->ndocsCollected : deleted->ndocsCollected;
+      info->nbytesCollected -= fixed ? fixed->nbytesCollected : deleted->nbytesCollected;
+      if (fixed) {
+        indexBlock_Free(&fixed->blk);
+      }
+      if (i == info->nblocksOrig - 1) {
+        idxData->lastBlockIgnored = 1;
+      } else {
+        idxData->restBlocksIgnored = 1;
+      }
+      gc->stats.gcBlocksDenied++;
+      blocks[nblocks++] = *blk;
+      continue;
     }
-    idx->size = newAddedLen;
-    if (idx->size == 0) {
-      InvertedIndex_AddBlock(idx, 0);
+
+    indexBlock_Free(blk);
+    if (fixed) {
+      blocks[nblocks++] = fixed->blk;
     }
   }
+  rm_free(idxData->delBlocks);
 
-  for (size_t i = 0; i < info->nblocksRepaired; ++i) {
-    MSG_RepairedBlock *blockModified = idxData->changedBlocks + i;
-    idx->blocks[blockModified->newix] = blockModified->blk;
+  // The blocks added in the parent process since the fork, which the child hasn't scanned
+  size_t newAddedLen = idx->size - info->nblocksOrig;
+  memcpy(blocks + nblocks, idx->blocks + info->nblocksOrig, newAddedLen * sizeof(*blocks));
+  rm_free(idx->blocks);
+  idx->blocks = blocks;
+  idx->size = nblocks + newAddedLen;
+  if (idx->size == 0) {
+    InvertedIndex_AddBlock(idx, 0);
   }
 
   idx->numDocs -= info->ndocsCollected;
@@ -744,7 +934,14 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
     goto cleanup;
   }
 
-  InvertedIndex *idx = Redis_OpenInvertedIndexEx(sctx, term, len, 1, &idxKey);
+  size_t termLen = len;
+  t_fieldId ftId = 0;
+  int isPrefix = Redis_ParsePrefixTerm(term, len, &termLen);
+  int isFieldTerm = !isPrefix && (sctx->spec->flags & Index_FieldPostings) &&
+                    Redis_ParseFieldTerm(term, len, &termLen, &ftId);
+  InvertedIndex *idx = isFieldTerm
+                           ? Redis_OpenFieldInvertedIndexEx(sctx, term, termLen, ftId, 0, &idxKey)
+                           : Redis_OpenInvertedIndexEx(sctx, term, len, 1, &idxKey);
 
   if (idx == NULL) {
     status = FGC_PARENT_ERROR;
@@ -752,7 +949,12 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
   }
 
   FGC_applyInvertedIndex(gc, &idxbufs, &info, idx);
-  FGC_updateStats(sctx, gc, info.ndocsCollected, info.nbytesCollected);
+  // per-field and prefix postings are not counted as index records
+  FGC_updateStats(sctx, gc, isFieldTerm || isPrefix ? 0 : info.ndocsCollected,
+                  info.nbytesCollected);
+  if (isPrefix) {
+    sctx->spec->stats.prefixIndexSize -= info.nbytesCollected;
+  }
 
   if (idx->numDocs == 0) {
     // inverted index was cleaned entirely lets free it
@@ -762,7 +964,17 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc, RedisModuleCtx *rctx) {
     if (sctx->spec->keysDict) {
       dictDelete(sctx->spec->keysDict, termKey);
     }
-    Trie_Delete(sctx->spec->terms, term, len);
+    if (isPrefix) {
+      TrieMap_Delete(sctx->spec->prefixes, term, termLen, NULL);
+    } else if (!isFieldTerm) {
+      Trie_Delete(sctx->spec->terms, term, len);
+      if (sctx->spec->suffix) {
+        SuffixIndex_Delete(sctx->spec->suffix, term, len);
+      }
+      if (sctx->spec->spellIndex) {
+        SpellIndex_Delete(sctx->spec->spellIndex, term, len);
+      }
+    }
     RedisModule_FreeString(sctx->redisCtx, termKey);
   }
 
@@ -903,7 +1115,41 @@ static void applyNumIdx(ForkGC *gc, RedisSearchCtx *sctx, NumGcInfo *ninfo) {
   MSG_IndexInfo *info = &ninfo->info;
   FGC_applyInvertedIndex(gc, idxbufs, info, currNode->range->entries);
   FGC_updateStats(sctx, gc, info->ndocsCollected, info->nbytesCollected);
-  resetCardinality(ninfo, currNode);
+  // the values deleted from the blocks other than the last one are only counted together
+  if (!idxbufs->restBlocksIgnored) {
+    resetCardinality(ninfo, currNode);
+  }
+}
+
+/* Compact the numeric tree of the field a step further once the collected documents left too many
+ * of its leaves empty or underfilled. Each run only rebuilds a bounded part of the tree, so that
+ * the lock is never held for the time of a whole rebuild */
+static void FGC_parentCompactNumeric(ForkGC *gc, RedisModuleCtx *rctx, const char *fieldName,
+                                     uint64_t rtUniqueId) {
+  RedisModuleKey *idxKey = NULL;
+  if (!FGC_lock(gc, rctx)) {
+    return;
+  }
+  RedisSearchCtx *sctx = FGC_getSctx(gc, rctx);
+  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    goto end;
+  }
+  RedisModuleString *keyName =
+      IndexSpec_GetFormattedKeyByName(sctx->spec, fieldName, INDEXFLD_T_NUMERIC);
+  NumericRangeTree *rt = OpenNumericIndex(sctx, keyName, &idxKey);
+  if (rt && rt->uniqueId == rtUniqueId && NumericRangeTree_NeedsCompaction(rt) &&
+      NumericRangeTree_CompactStep(rt, NR_COMPACT_STEP_ENTRIES)) {
+    gc->stats.gcNumericTreesCompacted++;
+  }
+
+end:
+  if (idxKey) {
+    RedisModule_CloseKey(idxKey);
+  }
+  if (sctx) {
+    SearchCtx_Free(sctx);
+  }
+  FGC_unlock(gc, rctx);
 }
 
 static FGCError FGC_parentHandleNumeric(ForkGC *gc, RedisModuleCtx *rctx) {
@@ -954,6 +1200,8 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc, RedisModuleCtx *rctx) {
     }
 
     applyNumIdx(gc, sctx, &ninfo);
+    // emptier leaves may let a compaction step which found nothing before make progress
+    rt->compactStalled = 0;
 
   loop_cleanup:
     if (sctx) {
@@ -976,6 +1224,10 @@ static FGCError FGC_parentHandleNumeric(ForkGC *gc, RedisModuleCtx *rctx) {
     rm_free(ninfo.lastBlockDeleted);
   }
 
+  if (status == FGC_COLLECTED) {
+    FGC_parentCompactNumeric(gc, rctx, fieldName, rtUniqueId);
+  }
+
   rm_free(fieldName);
   return status;
 }
@@ -1055,6 +1307,35 @@ static FGCError FGC_parentHandleTags(ForkGC *gc, RedisModuleCtx *rctx) {
   return status;
 }
 
+/* Vector indexes live in the parent's memory only, so their deleted vectors are swept here rather
+ * than collected by the child. Each run visits a bounded part of each index */
+static void FGC_parentSweepVectors(ForkGC *gc, RedisModuleCtx *rctx) {
+  if (!FGC_lock(gc, rctx)) {
+    return;
+  }
+  RedisSearchCtx *sctx = FGC_getSctx(gc, rctx);
+  if (!sctx || sctx->spec->uniqueId != gc->specUniqueId) {
+    goto end;
+  }
+  FieldSpec **vectorFields = getFieldsByType(sctx->spec, INDEXFLD_T_VECTOR);
+  for (size_t i = 0; i < array_len(vectorFields); ++i) {
+    VectorIndex *vi = VectorIndex_Open(sctx, vectorFields[i], 0);
+    if (!vi) {
+      continue;
+    }
+    size_t bytesFreed = 0;
+    size_t dropped = VectorIndex_Sweep(vi, &sctx->spec->docs, VECTOR_SWEEP_STEP_SLOTS, &bytesFreed);
+    FGC_updateStats(sctx, gc, dropped, bytesFreed);
+  }
+  array_free(vectorFields);
+
+end:
+  if (sctx) {
+    SearchCtx_Free(sctx);
+  }
+  FGC_unlock(gc, rctx);
+}
+
 int FGC_parentHandleFromChild(ForkGC *gc) {
   FGCError status = FGC_COLLECTED;
 
@@ -1068,6 +1349,7 @@ int FGC_parentHandleFromChild(ForkGC *gc) {
   COLLECT_FROM_CHILD(FGC_parentHandleTerms(gc, gc->ctx));
   COLLECT_FROM_CHILD(FGC_parentHandleNumeric(gc, gc->ctx));
   COLLECT_FROM_CHILD(FGC_parentHandleTags(gc, gc->ctx));
+  FGC_parentSweepVectors(gc, gc->ctx);
   return REDISMODULE_OK;
 }
 
@@ -1315,6 +1597,7 @@ static void statsCb(RedisModuleCtx *ctx, void *gcCtx) {
     REPLY_KVNUM(n, "last_run_time_ms", (double)gc->stats.lastRunTimeMs);
     REPLY_KVNUM(n, "gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
     REPLY_KVNUM(n, "gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+    REPLY_KVNUM(n, "gc_numeric_trees_compacted", (double)gc->stats.gcNumericTreesCompacted);
   }
   RedisModule_ReplySetArrayLength(ctx, n);
 }
@@ -22,6 +22,7 @@ typedef struct {
 
   uint64_t gcNumericNodesMissed;
   uint64_t gcBlocksDenied;
+  uint64_t gcNumericTreesCompacted;
 } ForkGCStats;
 
 typedef enum FGCType { FGC_TYPE_INKEYSPACE, FGC_TYPE_NOKEYSPACE } FGCType;
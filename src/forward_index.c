@@ -2,6 +2,7 @@
 #include "tokenize.h"
 #include "util/fnv.h"
 #include "util/logging.h"
+#include "redis_index.h"
 #include <stdio.h>
 #include <sys/param.h>
 #include "rmalloc.h"
@@ -162,6 +163,8 @@ static khIdxEntry *makeEntry(ForwardIndex *idx, const char *s, size_t n, uint32_
 
 #define TOKOPT_F_STEM 0x01
 #define TOKOPT_F_COPYSTR 0x02
+// prefix postings don't count towards the document's length
+#define TOKOPT_F_PREFIX 0x04
 
 static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t tokLen,
                                      uint32_t pos, float fieldScore, t_fieldId fieldId,
@@ -207,8 +210,10 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
     score *= STEM_TOKEN_FACTOR;
   }
   h->freq += MAX(1, (uint32_t)score);
-  idx->maxFreq = MAX(h->freq, idx->maxFreq);
-  idx->totalFreq += h->freq;
+  if (!(options & TOKOPT_F_PREFIX)) {
+    idx->maxFreq = MAX(h->freq, idx->maxFreq);
+    idx->totalFreq += h->freq;
+  }
   if (h->vw) {
     VVW_Write(h->vw, pos);
   }
@@ -219,6 +224,26 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
 // void ForwardIndex_NormalizeFreq(ForwardIndex *idx, ForwardIndexEntry *e) {
 //   e->freq = e->freq / idx->maxFreq;
 // }
+/* Add an entry for the prefix postings of each prefix of a token, up to `maxLen` letters long */
+static void ForwardIndex_HandlePrefixes(ForwardIndex *idx, const char *tok, size_t tokLen,
+                                        uint32_t pos, float fieldScore, t_fieldId fieldId,
+                                        uint8_t maxLen) {
+  char buf[PREFIX_INDEX_MAX_LEN * 4 + PREFIX_TERM_SUFFIX_LEN];
+  size_t end = 0;
+  for (uint8_t n = 0; n < maxLen && end < tokLen; n++) {
+    // skip to the end of the next utf-8 letter
+    do {
+      end++;
+    } while (end < tokLen && (tok[end] & 0xC0) == 0x80);
+    if (end > PREFIX_INDEX_MAX_LEN * 4) {
+      break;
+    }
+    size_t len = Redis_FormatPrefixTerm(buf, tok, end);
+    ForwardIndex_HandleToken(idx, buf, len, pos, fieldScore, fieldId,
+                             TOKOPT_F_COPYSTR | TOKOPT_F_PREFIX);
+  }
+}
+
 int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
 #define SYNONYM_BUFF_LEN 100
   const ForwardIndexTokenizerCtx *tokCtx = ctx;
@@ -229,6 +254,11 @@ int forwardIndexTokenFunc(void *ctx, const Token *tokInfo) {
   ForwardIndex_HandleToken(tokCtx->idx, tokInfo->tok, tokInfo->tokLen, tokInfo->pos,
                            tokCtx->fieldScore, tokCtx->fieldId, options);
 
+  if (tokCtx->prefixIndexLen) {
+    ForwardIndex_HandlePrefixes(tokCtx->idx, tokInfo->tok, tokInfo->tokLen, tokInfo->pos,
+                                tokCtx->fieldScore, tokCtx->fieldId, tokCtx->prefixIndexLen);
+  }
+
   if (tokCtx->allOffsets) {
     VVW_Write(tokCtx->allOffsets, tokInfo->raw - tokCtx->doc);
   }
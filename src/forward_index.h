@@ -44,14 +44,18 @@ typedef struct {
   ForwardIndex *idx;
   t_fieldId fieldId;
   float fieldScore;
+  // the longest prefix of the tokens to add prefix postings for, or 0
+  uint8_t prefixIndexLen;
 } ForwardIndexTokenizerCtx;
 
 static inline void ForwardIndexTokenizerCtx_Init(ForwardIndexTokenizerCtx *ctx, ForwardIndex *idx,
                                                  const char *doc, VarintVectorWriter *vvw,
-                                                 t_fieldId fieldId, float score) {
+                                                 t_fieldId fieldId, float score,
+                                                 uint8_t prefixIndexLen) {
   ctx->idx = idx;
   ctx->fieldId = fieldId;
   ctx->fieldScore = score;
+  ctx->prefixIndexLen = prefixIndexLen;
   ctx->doc = doc;
   ctx->allOffsets = vvw;
 }
@@ -3,6 +3,9 @@
 #include "rmutil/util.h"
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
+#include "util/arr.h"
+#include "knn_iterator.h"
+#include <math.h>
 
 static double extractUnitFactor(GeoDistance unit);
 
@@ -52,14 +55,62 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
   return REDISMODULE_OK;
 }
 
+/* Parse a nearest neighbour filter. GEOKNN is not passed to us.
+ * The syntax is (GEOKNN) <property> LONG LAT K m|km|ft|mi
+ * Returns REDISMODUEL_OK or ERR  */
+int GeoFilter_ParseKnn(GeoFilter *gf, ArgsCursor *ac, QueryError *status) {
+  gf->lat = 0;
+  gf->lon = 0;
+  gf->radius = 0;
+  gf->unitType = GEO_DISTANCE_KM;
+
+  if (AC_NumRemaining(ac) < 5) {
+    QERR_MKBADARGS_FMT(status, "GEOKNN requires 5 arguments");
+    return REDISMODULE_ERR;
+  }
+
+  int rv;
+  if ((rv = AC_GetString(ac, &gf->property, NULL, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<geo property>", rv);
+    return REDISMODULE_ERR;
+  } else {
+    gf->property = rm_strdup(gf->property);
+  }
+  if ((rv = AC_GetDouble(ac, &gf->lon, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lon>", rv);
+    return REDISMODULE_ERR;
+  }
+  if ((rv = AC_GetDouble(ac, &gf->lat, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<lat>", rv);
+    return REDISMODULE_ERR;
+  }
+  uint64_t k;
+  if ((rv = AC_GetU64(ac, &k, AC_F_GE1)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<k>", rv);
+    return REDISMODULE_ERR;
+  }
+  gf->knn = k;
+
+  const char *unitstr = AC_GetStringNC(ac, NULL);
+  if ((gf->unitType = GeoDistance_Parse(unitstr)) == GEO_DISTANCE_INVALID) {
+    QERR_MKBADARGS_FMT(status, "Unknown distance unit %s", unitstr);
+    return REDISMODULE_ERR;
+  }
+  if (gf->lat > 90 || gf->lat < -90 || gf->lon > 180 || gf->lon < -180) {
+    QERR_MKBADARGS_FMT(status, "Invalid GEOKNN lat/lon");
+    return REDISMODULE_ERR;
+  }
+
+  return REDISMODULE_OK;
+}
+
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->property) rm_free((char *)gf->property);
   if (gf->numericFilters) {
-    for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
-      if (gf->numericFilters[i])
-        NumericFilter_Free(gf->numericFilters[i]);
+    for (int i = 0; i < array_len(gf->numericFilters); ++i) {
+      NumericFilter_Free(gf->numericFilters[i]);
     }
-    rm_free(gf->numericFilters);
+    array_free(gf->numericFilters);
   }
   rm_free(gf);
 }
@@ -103,24 +154,40 @@ done:
   return docIds;
 }
 
+/* Precompute the center and radius terms of the haversine formula, so that checking a candidate
+ * takes no trigonometry on the center and no inverse functions */
+static void prepareGeoFilter(GeoFilter *gf) {
+  gf->radiusMeters = gf->radius * extractUnitFactor(gf->unitType);
+  gf->cosLat = cos(gf->lat * M_PI / 180);
+  double angle = gf->radiusMeters / EARTH_RADIUS_IN_METERS;
+  // radii over half of the earth's circumference include every point
+  gf->maxHav = angle >= M_PI ? 1 : pow(sin(angle / 2), 2);
+}
+
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
-  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
-  double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
-  calcRanges(gf->lon, gf->lat, radius_meter, ranges);
+  GeoFilter *mgf = (GeoFilter *)gf;
+  prepareGeoFilter(mgf);
 
-  IndexIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
+  GeoCoverRange ranges[GEO_COVER_MAX_RANGES];
+  size_t nranges = calcCovering(gf->lon, gf->lat, gf->radiusMeters, ranges);
+
+  IndexIterator **iters = rm_calloc(nranges ? nranges : 1, sizeof(*iters));
+  mgf->numericFilters = array_new(NumericFilter *, nranges ? nranges : 1);
   size_t itersCount = 0;
-  for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
-    if (ranges[ii].min != ranges[ii].max) {
-      NumericFilter *filt = gf->numericFilters[ii] =
-              NewNumericFilter(ranges[ii].min, ranges[ii].max, 1, 1);
-      filt->fieldName = rm_strdup(gf->property);
+  for (size_t ii = 0; ii < nranges; ++ii) {
+    NumericFilter *filt;
+    if (ranges[ii].interior) {
+      // every point in the range is within the radius, so the score range is the exact filter
+      filt = NewNumericFilter(ranges[ii].range.min, ranges[ii].range.max, 1, 0);
+    } else {
+      filt = NewNumericFilter(ranges[ii].range.min, ranges[ii].range.max, 1, 1);
       filt->geoFilter = gf;
-      struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
-      if (numIter != NULL) {
-        iters[itersCount++] = numIter;
-      }
+    }
+    filt->fieldName = rm_strdup(gf->property);
+    mgf->numericFilters = array_append(mgf->numericFilters, filt);
+    struct indexIterator *numIter = NewNumericFilterIterator(ctx, filt, NULL, INDEXFLD_T_GEO);
+    if (numIter != NULL) {
+      iters[itersCount++] = numIter;
     }
   }
 
@@ -139,6 +206,125 @@ IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf) {
   return it;
 }
 
+/*****************************************************************************
+ * Nearest neighbour iterator
+ *
+ * Finding the K closest documents needs no guessed radius: we cover a small circle around the
+ * center with geohash cells, read the points within it and test them against the query. If fewer
+ * than K match, the circle grows - by the ratio the observed density suggests, and at least twice -
+ * and the cells are read again. Once K matches are within the radius they are proven to be the
+ * closest, since every point outside of the circle is further away. The geometric growth keeps
+ * the re-reads to a constant factor of the final scan.
+ *****************************************************************************/
+
+// The radius of the first circle, in meters
+#define GEOKNN_INITIAL_RADIUS 500
+// Half of the earth's circumference. A circle this large contains every point
+#define GEOKNN_MAX_RADIUS (M_PI * EARTH_RADIUS_IN_METERS)
+
+typedef struct {
+  RedisSearchCtx *sctx;
+  const GeoFilter *gf;
+  IndexIterator *child;
+} GeoKnnCtx;
+
+static const RSIndexResult *geoResultValue(const RSIndexResult *r) {
+  if (r->type == RSResultType_Numeric) {
+    return r;
+  }
+  if (r->type == RSResultType_Union || r->type == RSResultType_Intersection) {
+    for (size_t ii = 0; ii < r->agg.numChildren; ++ii) {
+      const RSIndexResult *v = geoResultValue(r->agg.children[ii]);
+      if (v) {
+        return v;
+      }
+    }
+  }
+  return NULL;
+}
+
+/* Append the live documents within `radius` meters of the center to `hits` */
+static KnnHit *geoKnnCollect(GeoKnnCtx *kc, double radius, KnnHit *hits) {
+  const GeoFilter *gf = kc->gf;
+  GeoCoverRange ranges[GEO_COVER_MAX_RANGES];
+  size_t nranges = calcCovering(gf->lon, gf->lat, radius, ranges);
+
+  for (size_t ii = 0; ii < nranges; ++ii) {
+    NumericFilter *nf = NewNumericFilter(ranges[ii].range.min, ranges[ii].range.max, 1, 0);
+    nf->fieldName = rm_strdup(gf->property);
+    IndexIterator *nit = NewNumericFilterIterator(kc->sctx, nf, NULL, INDEXFLD_T_GEO);
+    if (nit) {
+      RSIndexResult *r;
+      int rc;
+      while ((rc = nit->Read(nit->ctx, &r)) != INDEXREAD_EOF) {
+        const RSIndexResult *v = rc == INDEXREAD_OK ? geoResultValue(r) : NULL;
+        if (!v) {
+          continue;
+        }
+        const RSDocumentMetadata *dmd = DocTable_Get(&kc->sctx->spec->docs, v->docId);
+        if (!dmd || (dmd->flags & Document_Deleted)) {
+          continue;
+        }
+        double xy[2], distance;
+        decodeGeo(v->num.value, xy);
+        if (isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], radius, &distance)) {
+          hits = array_append(hits, ((KnnHit){.docId = v->docId, .distance = distance}));
+        }
+      }
+      nit->Free(nit);
+    }
+    NumericFilter_Free(nf);
+  }
+  return hits;
+}
+
+static KnnHit *geoKnnLoad(void *ctx) {
+  GeoKnnCtx *kc = ctx;
+  const GeoFilter *gf = kc->gf;
+  KnnHit *hits = array_new(KnnHit, gf->knn);
+  double radius = GEOKNN_INITIAL_RADIUS;
+
+  while (1) {
+    array_clear(hits);
+    hits = geoKnnCollect(kc, radius, hits);
+    KnnHits_SortByDocId(hits);
+    hits = KnnHits_Match(hits, kc->child);
+
+    size_t found = array_len(hits);
+    if (found >= gf->knn || radius >= GEOKNN_MAX_RADIUS) {
+      break;
+    }
+    // assume a uniform density around the center: the area, and so the radius' square, has to
+    // grow by knn/found to contain enough matches
+    double growth = found ? 1.2 * sqrt((double)gf->knn / found) : 4;
+    radius *= growth > 2 ? growth : 2;
+    if (radius > GEOKNN_MAX_RADIUS) {
+      radius = GEOKNN_MAX_RADIUS;
+    }
+  }
+
+  hits = KnnHits_Nearest(hits, gf->knn);
+  double factor = extractUnitFactor(gf->unitType);
+  for (size_t ii = 0; ii < array_len(hits); ++ii) {
+    hits[ii].distance /= factor;
+  }
+  return hits;
+}
+
+static void geoKnnFree(void *ctx) {
+  GeoKnnCtx *kc = ctx;
+  if (kc->child) {
+    kc->child->Free(kc->child);
+  }
+  rm_free(kc);
+}
+
+IndexIterator *NewGeoKnnIterator(RedisSearchCtx *ctx, const GeoFilter *gf, IndexIterator *child) {
+  GeoKnnCtx *kc = rm_malloc(sizeof(*kc));
+  *kc = (GeoKnnCtx){.sctx = ctx, .gf = gf, .child = child};
+  return NewKnnIterator(kc, geoKnnLoad, geoKnnFree, gf->knn);
+}
+
 GeoDistance GeoDistance_Parse(const char *s) {
 #define X(c, val)            \
   if (!strcasecmp(val, s)) { \
@@ -257,6 +443,13 @@ static int populateRange(const GeoFilter *gf, GeoHashRange *ranges) {
 int isWithinRadius(const GeoFilter *gf, double d, double *distance) {
   double xy[2];
   decodeGeo(d, xy);
+  if (!distance && gf->radiusMeters > 0) {
+    // compare the haversine of the central angle instead of the distance itself
+    double lat2r = xy[1] * M_PI / 180;
+    double u = sin((lat2r - gf->lat * M_PI / 180) / 2);
+    double v = sin((xy[0] - gf->lon) * M_PI / 360);
+    return u * u + gf->cosLat * cos(lat2r) * v * v <= gf->maxHav;
+  }
   double radius_meters = gf->radius * extractUnitFactor(gf->unitType);
   int rv = isWithinRadiusLonLat(gf->lon, gf->lat, xy[0], xy[1], radius_meters, distance);
   return rv;
@@ -10,6 +10,10 @@
 #include "dep/geo/rs_geo.h"
 #include "numeric_index.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct geoIndex {
   RedisSearchCtx *ctx;
   const FieldSpec *sp;
@@ -37,8 +41,20 @@ typedef struct GeoFilter {
   double radius;
   GeoDistance unitType;
   NumericFilter **numericFilters;
+
+  // Precomputed by NewGeoRangeIterator for testing candidates against the radius: the radius in
+  // meters, the cosine of the center's latitude, and the haversine of the radius' central angle
+  double radiusMeters;
+  double cosLat;
+  double maxHav;
+
+  // Number of nearest neighbours to return for GEOKNN. 0 for radius filters
+  size_t knn;
 } GeoFilter;
 
+// Name of the result field holding the distance of each GEOKNN result, given the geo property
+#define GEOKNN_DISTANCE_FIELD_FMT "__%s_distance"
+
 /* Create a geo filter from parsed strings and numbers */
 GeoFilter *NewGeoFilter(double lon, double lat, double radius, const char *unit);
 
@@ -54,10 +70,23 @@ int GeoFilter_Parse(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
 void GeoFilter_Free(GeoFilter *gf);
 IndexIterator *NewGeoRangeIterator(RedisSearchCtx *ctx, const GeoFilter *gf);
 
+/* Parse a nearest neighbour filter from redis arguments, starting after GEOKNN.
+ * The syntax is <property> LONG LAT K m|km|ft|mi, where the unit is the unit of the returned
+ * distances */
+int GeoFilter_ParseKnn(GeoFilter *gf, ArgsCursor *ac, QueryError *status);
+
+/* Create an iterator over the `gf->knn` documents matching `child` which are closest to the
+ * filter's center, in docId order. Each result is numeric, holding the distance from the center in
+ * the filter's unit. The child is owned by the returned iterator */
+IndexIterator *NewGeoKnnIterator(RedisSearchCtx *ctx, const GeoFilter *gf, IndexIterator *child);
+
 /*****************************************************************************/
 
 #define INVALID_GEOHASH -1.0
 double calcGeoHash(double lon, double lat);
 int isWithinRadius(const GeoFilter *gf, double d, double *distance);
 
+#ifdef __cplusplus
+}
+#endif
 #endif
@@ -28,6 +28,54 @@ static void writeIndexEntry(IndexSpec *spec, InvertedIndex *idx, IndexEncoder en
   }
 }
 
+/* Copy an entry to the per-field postings of every text field the term appears in. These records
+ * only add to the inverted size, not to the number of records used to compute document lengths */
+static void writeFieldEntries(RedisSearchCtx *ctx, IndexEncoder encoder,
+                              ForwardIndexEntry *entry) {
+  t_fieldMask mask = entry->fieldMask;
+  for (t_fieldId ftId = 0; mask; ++ftId, mask >>= 1) {
+    if (!(mask & 1)) {
+      continue;
+    }
+    RedisModuleKey *idxKey = NULL;
+    InvertedIndex *invidx =
+        Redis_OpenFieldInvertedIndexEx(ctx, entry->term, entry->len, ftId, 1, &idxKey);
+    if (invidx) {
+      ctx->spec->stats.invertedSize +=
+          InvertedIndex_WriteForwardIndexEntry(invidx, encoder, entry);
+    }
+    if (idxKey) {
+      RedisModule_CloseKey(idxKey);
+    }
+  }
+}
+
+/* Prefix postings, with PREFIXINDEX text fields, only add to the inverted size and to the prefix
+ * index size */
+static void writePrefixEntry(IndexSpec *spec, InvertedIndex *idx, IndexEncoder encoder,
+                             ForwardIndexEntry *entry) {
+  size_t sz = InvertedIndex_WriteForwardIndexEntry(idx, encoder, entry);
+  spec->stats.invertedSize += sz;
+  spec->stats.prefixIndexSize += sz;
+}
+
+/* Register the term of a forward index entry with the spec, and with its suffix index if the term
+ * appears in text fields that have one and is not a stem or synonym term. Returns 1 if the entry is for the postings of a prefix
+ * rather than for a term */
+static int addEntryTerm(IndexSpec *spec, const char *term, size_t len, t_fieldMask fieldMask) {
+  size_t prefixLen;
+  if (Redis_ParsePrefixTerm(term, len, &prefixLen)) {
+    IndexSpec_AddPrefix(spec, term, prefixLen);
+    return 1;
+  }
+  IndexSpec_AddTerm(spec, term, len);
+  if ((spec->flags & Index_HasSuffixTrie) && (fieldMask & IndexSpec_SuffixTrieMask(spec)) &&
+      !(len && IndexSpec_IsInternalTermStart(term[0]))) {
+    IndexSpec_AddSuffixTerm(spec, term, len);
+  }
+  return 0;
+}
+
 // Number of terms for each block-allocator block
 #define TERMS_PER_BLOCK 128
 
@@ -140,6 +188,10 @@ static int writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
                               KHTable *ht, RSAddDocumentCtx **parentMap) {
 
   IndexEncoder encoder = InvertedIndex_GetEncoder(ctx->spec->flags);
+  IndexEncoder fieldEncoder = NULL;
+  if (ctx->spec->flags & Index_FieldPostings) {
+    fieldEncoder = InvertedIndex_GetEncoder(IndexSpec_FieldPostingsFlags(ctx->spec));
+  }
   const int isBlocked = AddDocumentCtx_IsBlockable(aCtx);
 
   // This is used as a cache layer, so that we don't need to derefernce the
@@ -155,7 +207,11 @@ static int writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
       ForwardIndexEntry *fwent = merged->head;
 
       // Add the term to the prefix trie. This only needs to be done once per term
-      IndexSpec_AddTerm(ctx->spec, fwent->term, fwent->len);
+      t_fieldMask fieldMask = 0;
+      for (ForwardIndexEntry *e = fwent; e; e = e->next) {
+        fieldMask |= e->fieldMask;
+      }
+      int isPrefix = addEntryTerm(ctx->spec, fwent->term, fwent->len, fieldMask);
 
       RedisModuleKey *idxKey = NULL;
       InvertedIndex *invidx = Redis_OpenInvertedIndexEx(ctx, fwent->term, fwent->len, 1, &idxKey);
@@ -184,7 +240,14 @@ static int writeMergedEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx,
 
         // Finally assign the document ID to the entry
         fwent->docId = docId;
+        if (isPrefix) {
+          writePrefixEntry(ctx->spec, invidx, encoder, fwent);
+          continue;
+        }
         writeIndexEntry(ctx->spec, invidx, encoder, fwent);
+        if (fieldEncoder) {
+          writeFieldEntries(ctx, fieldEncoder, fwent);
+        }
       }
 
       if (idxKey) {
@@ -212,21 +275,32 @@ static void writeCurEntries(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx, Re
   ForwardIndexIterator it = ForwardIndex_Iterate(aCtx->fwIdx);
   ForwardIndexEntry *entry = ForwardIndexIterator_Next(&it);
   IndexEncoder encoder = InvertedIndex_GetEncoder(aCtx->specFlags);
+  IndexEncoder fieldEncoder = NULL;
+  if (aCtx->specFlags & Index_FieldPostings) {
+    fieldEncoder = InvertedIndex_GetEncoder(IndexSpec_FieldPostingsFlags(ctx->spec));
+  }
   const int isBlocked = AddDocumentCtx_IsBlockable(aCtx);
 
   while (entry != NULL) {
     RedisModuleKey *idxKey = NULL;
-    IndexSpec_AddTerm(ctx->spec, entry->term, entry->len);
+    int isPrefix = addEntryTerm(ctx->spec, entry->term, entry->len, entry->fieldMask);
 
     InvertedIndex *invidx = Redis_OpenInvertedIndexEx(ctx, entry->term, entry->len, 1, &idxKey);
     if (invidx) {
       entry->docId = aCtx->doc.docId;
       RS_LOG_ASSERT(entry->docId, "docId should not be 0");
-      writeIndexEntry(ctx->spec, invidx, encoder, entry);
+      if (isPrefix) {
+        writePrefixEntry(ctx->spec, invidx, encoder, entry);
+      } else {
+        writeIndexEntry(ctx->spec, invidx, encoder, entry);
+      }
     }
     if (idxKey) {
       RedisModule_CloseKey(idxKey);
     }
+    if (invidx && fieldEncoder && !isPrefix) {
+      writeFieldEntries(ctx, fieldEncoder, entry);
+    }
 
     entry = ForwardIndexIterator_Next(&it);
     if (isBlocked && CONCURRENT_CTX_TICK(&indexer->concCtx) && ctx->spec == NULL) {
@@ -366,7 +440,10 @@ static void Indexer_Process(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
     }
   }
 
-  int useTermHt = indexer->size > 1 && (aCtx->stateFlags & ACTX_F_TEXTINDEXED) == 0;
+  // Blocking contexts are merged with the ones queued after them, non blocking ones with the rest
+  // of their batch (see Indexer_AddBatch)
+  int useTermHt = (AddDocumentCtx_IsBlockable(aCtx) ? indexer->size > 1 : aCtx->next != NULL) &&
+                  (aCtx->stateFlags & ACTX_F_TEXTINDEXED) == 0;
   if (useTermHt) {
     firstZeroId = doMerge(aCtx, &indexer->mergeHt, parentMap);
     if (firstZeroId && firstZeroId->stateFlags & ACTX_F_ERRORED) {
@@ -500,6 +577,21 @@ int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx) {
   return 0;
 }
 
+int Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx *head) {
+  // The first context merges as many of the batch as it can, and the others are already indexed
+  // unless the batch was too large for a single merge
+  for (RSAddDocumentCtx *cur = head; cur; cur = cur->next) {
+    RS_LOG_ASSERT(!AddDocumentCtx_IsBlockable(cur), "batched documents must not block");
+    Indexer_Process(indexer, cur);
+  }
+  while (head) {
+    RSAddDocumentCtx *next = head->next;
+    AddDocumentCtx_Finish(head);
+    head = next;
+  }
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 /// Multiple Indexers                                                        ///
@@ -566,7 +658,9 @@ static void Indexer_FreeInternal(DocumentIndexer *indexer) {
 
 size_t Indexer_Decref(DocumentIndexer *indexer) {
   size_t ret = __sync_sub_and_fetch(&indexer->refcount, 1);
-  if (!ret) {
+  if (!ret && (indexer->options & INDEXER_THREADLESS)) {
+    Indexer_FreeInternal(indexer);
+  } else if (!ret) {
     pthread_mutex_lock(&indexer->lock);
     indexer->options |= INDEXER_STOPPED;
     pthread_cond_signal(&indexer->cond);
@@ -580,9 +674,6 @@ size_t Indexer_Incref(DocumentIndexer *indexer) {
 }
 
 void Indexer_Free(DocumentIndexer *indexer) {
-  if (indexer->options & INDEXER_THREADLESS) {
-    Indexer_FreeInternal(indexer);
-  } else {
-    Indexer_Decref(indexer);
-  }
+  // documents still being indexed in the background hold a reference to the indexer
+  Indexer_Decref(indexer);
 }
@@ -6,12 +6,18 @@
 #include "util/block_alloc.h"
 #include "concurrent_ctx.h"
 #include "util/arr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Preprocessors can store field data to this location
 typedef struct FieldIndexerData {
   double numeric;  // i.e. the numeric value of the field
   const char *geoSlon;
   const char *geoSlat;
   char **tags;
+  const float *vector;  // points into the field's value
 } FieldIndexerData;
 
 typedef struct DocumentIndexer {
@@ -51,6 +57,13 @@ DocumentIndexer *NewIndexer(IndexSpec *spec);
  */
 int Indexer_Add(DocumentIndexer *indexer, RSAddDocumentCtx *aCtx);
 
+/**
+ * Index a chain of preprocessed, non blocking document contexts (linked by their `next` field),
+ * merging their terms so that each inverted index is written once for the whole chain, and
+ * finish them. Must be called with the GIL locked.
+ */
+int Indexer_AddBatch(DocumentIndexer *indexer, RSAddDocumentCtx *head);
+
 /**
  * Function to preprocess field data. This should do as much stateless processing
  * as possible on the field - this means things like input validation and normalization.
@@ -84,4 +97,7 @@ int IndexerBulkAdd(IndexBulkData *bulk, RSAddDocumentCtx *cur, RedisSearchCtx *s
                    QueryError *status);
 void IndexerBulkCleanup(IndexBulkData *cur, RedisSearchCtx *sctx);
 
+#ifdef __cplusplus
+}
+#endif
 #endif
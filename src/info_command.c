@@ -2,6 +2,11 @@
 #include "spec.h"
 #include "inverted_index.h"
 #include "cursor.h"
+#include "vector_index.h"
+#include "suffix_index.h"
+#include "spell_index.h"
+#include "async_index.h"
+#include "term_cache.h"
 
 #define REPLY_KVNUM(n, k, v)                       \
   do {                                             \
@@ -37,6 +42,14 @@ static int renderIndexOptions(RedisModuleCtx *ctx, IndexSpec *sp) {
     RedisModule_ReplyWithSimpleString(ctx, SPEC_SCHEMA_EXPANDABLE_STR);
     n++;
   }
+  if (sp->flags & Index_FieldPostings) {
+    RedisModule_ReplyWithSimpleString(ctx, SPEC_FIELDPOSTINGS_STR);
+    n++;
+  }
+  if (sp->flags & Index_SpellIndex) {
+    RedisModule_ReplyWithSimpleString(ctx, SPEC_SPELLINDEX_STR);
+    n++;
+  }
   RedisModule_ReplySetArrayLength(ctx, n);
   return 2;
 }
@@ -137,6 +150,9 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
     if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT)) {
       REPLY_KVNUM(nn, SPEC_WEIGHT_STR, fs->ftWeight);
+      if (fs->prefixIndexLen) {
+        REPLY_KVNUM(nn, SPEC_PREFIXINDEX_STR, fs->prefixIndexLen);
+      }
     }
 
     if (FIELD_IS(fs, INDEXFLD_T_TAG)) {
@@ -144,6 +160,17 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       sprintf(buf, "%c", fs->tagSep);
       REPLY_KVSTR(nn, SPEC_SEPARATOR_STR, buf);
     }
+    if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+      const VectorFieldOptions *opts = &fs->vectorOpts;
+      REPLY_KVSTR(nn, "ALGORITHM", VectorAlgo_ToString(opts->algo));
+      REPLY_KVNUM(nn, "DIM", opts->dim);
+      REPLY_KVSTR(nn, "DISTANCE_METRIC", VectorMetric_ToString(opts->metric));
+      if (opts->algo == VectorAlgo_HNSW) {
+        REPLY_KVNUM(nn, "M", opts->hnswM);
+        REPLY_KVNUM(nn, "EF_CONSTRUCTION", opts->hnswEfConstruction);
+        REPLY_KVNUM(nn, "EF_RUNTIME", opts->hnswEfRuntime);
+      }
+    }
     if (FieldSpec_IsSortable(fs)) {
       RedisModule_ReplyWithSimpleString(ctx, SPEC_SORTABLE_STR);
       ++nn;
@@ -152,6 +179,10 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       RedisModule_ReplyWithSimpleString(ctx, SPEC_NOSTEM_STR);
       ++nn;
     }
+    if (FieldSpec_HasSuffixTrie(fs)) {
+      RedisModule_ReplyWithSimpleString(ctx, SPEC_WITHSUFFIXTRIE_STR);
+      ++nn;
+    }
     if (!FieldSpec_IsIndexable(fs)) {
       RedisModule_ReplyWithSimpleString(ctx, SPEC_NOINDEX_STR);
       ++nn;
@@ -164,8 +195,14 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   REPLY_KVNUM(n, "max_doc_id", sp->docs.maxDocId);
   REPLY_KVNUM(n, "num_terms", sp->stats.numTerms);
   REPLY_KVNUM(n, "num_records", sp->stats.numRecords);
+  REPLY_KVNUM(n, "num_in_place_updates", sp->stats.numInPlaceUpdates);
   REPLY_KVNUM(n, "inverted_sz_mb", sp->stats.invertedSize / (float)0x100000);
   REPLY_KVNUM(n, "total_inverted_index_blocks", TotalIIBlocks);
+  REPLY_KVNUM(n, "prefix_index_sz_mb", sp->stats.prefixIndexSize / (float)0x100000);
+  REPLY_KVNUM(n, "suffix_index_sz_mb",
+              (sp->suffix ? SuffixIndex_MemUsage(sp->suffix) : 0) / (float)0x100000);
+  REPLY_KVNUM(n, "spell_index_sz_mb",
+              (sp->spellIndex ? SpellIndex_MemUsage(sp->spellIndex) : 0) / (float)0x100000);
   // REPLY_KVNUM(n, "inverted_cap_mb", sp->stats.invertedCap / (float)0x100000);
 
   // REPLY_KVNUM(n, "inverted_cap_ovh", 0);
@@ -210,6 +247,17 @@ int IndexInfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     n += 2;
   }
 
+  if (sp->flags & Index_Async) {
+    RedisModule_ReplyWithSimpleString(ctx, "async_indexing_stats");
+    AsyncIndexQueue_RenderStats(sp->asyncQueue, ctx);
+    n += 2;
+  }
+
+  // the caches are shared by all the indexes
+  RedisModule_ReplyWithSimpleString(ctx, "term_cache_stats");
+  TermCache_RenderStats(ctx);
+  n += 2;
+
   RedisModule_ReplyWithSimpleString(ctx, "cursor_stats");
   Cursors_RenderStats(&RSCursors, sp->name, ctx);
   n += 2;
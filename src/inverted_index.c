@@ -27,6 +27,39 @@ uint64_t TotalIIBlocks = 0;
 // pointer to the current block while reading the index
 #define IR_CURRENT_BLOCK(ir) (ir->idx->blocks[ir->currentBlock])
 
+/* Compare the value bounds of the current block with the reader's numeric filter. Blocks entirely
+ * outside of the filter are skipped without decoding them, and the records of blocks entirely
+ * inside of it are accepted without testing each of them */
+static void IndexReader_FilterNumericBlock(IndexReader *ir) {
+  const IndexBlock *blk = &IR_CURRENT_BLOCK(ir);
+  const NumericFilter *f = ir->numericFilter;
+  ir->decoderCtx.ptr = (void *)f;
+  if (!blk->numDocs) {
+    return;
+  }
+  if (!NumericFilter_Overlaps(f, blk->minValue, blk->maxValue)) {
+    ir->br.pos = ir->br.buf->offset;
+  } else if (NumericFilter_Contains(f, blk->minValue, blk->maxValue)) {
+    ir->decoderCtx.ptr = NULL;
+  }
+}
+
+/* Point the reader at the beginning of the current block's record and positional streams */
+static inline void IndexReader_ResetBlockReaders(IndexReader *ir) {
+  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  ir->posBr = NewBufferReader(&IR_CURRENT_BLOCK(ir).posBuf);
+  if (ir->numericFilter) {
+    IndexReader_FilterNumericBlock(ir);
+  }
+}
+
+/* Attach the offsets of a record decoded from a split-positions index, and advance the positional
+ * stream past them. The offsets themselves are only decoded if someone iterates them */
+static inline void IndexReader_ReadPositions(BufferReader *posBr, RSIndexResult *res) {
+  res->term.offsets = (RSOffsetVector){.data = BufferReader_Current(posBr), .len = res->offsetsSz};
+  Buffer_Skip(posBr, res->offsetsSz);
+}
+
 static IndexReader *NewIndexReaderGeneric(const IndexSpec *sp, InvertedIndex *idx,
                                           IndexDecoderProcs decoder, IndexDecoderCtx decoderCtx,
                                           RSIndexResult *record, double weight);
@@ -58,6 +91,7 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
   idx->size = 0;
   idx->lastId = 0;
   idx->gcMarker = 0;
+  idx->splitMarker = 0;
   idx->flags = flags;
   idx->numDocs = 0;
   if (initBlock) {
@@ -68,6 +102,7 @@ InvertedIndex *NewInvertedIndex(IndexFlags flags, int initBlock) {
 
 void indexBlock_Free(IndexBlock *blk) {
   Buffer_Free(&blk->buf);
+  Buffer_Free(&blk->posBuf);
 }
 
 void InvertedIndex_Free(void *ctx) {
@@ -97,8 +132,10 @@ void IndexReader_OnReopen(void *privdata) {
   if (ir->gcMarker == ir->idx->gcMarker) {
     // no GC - we just go to the same offset we were at
     size_t offset = ir->br.pos;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+    size_t posOffset = ir->posBr.pos;
+    IndexReader_ResetBlockReaders(ir);
     ir->br.pos = offset;
+    ir->posBr.pos = posOffset;
   } else {
     // if there has been a GC cycle on this key while we were asleep, the offset might not be valid
     // anymore. This means that we need to seek to last docId we were at
@@ -106,7 +143,7 @@ void IndexReader_OnReopen(void *privdata) {
     // reset the state of the reader
     t_docId lastId = ir->lastId;
     ir->currentBlock = 0;
-    ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+    IndexReader_ResetBlockReaders(ir);
     ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
 
     // seek to the previous last id
@@ -168,13 +205,13 @@ ENCODER(encodeFieldsOnlyWide) {
 
 // 5. (field, offset)
 ENCODER(encodeFieldsOffsets) {
-  size_t sz = qint_encode3(bw, delta, (uint32_t)res->fieldMask, res->term.offsets.len);
+  size_t sz = qint_encode3(bw, delta, (uint32_t)res->fieldMask, res->offsetsSz);
   sz += Buffer_Write(bw, res->term.offsets.data, res->term.offsets.len);
   return sz;
 }
 
 ENCODER(encodeFieldsOffsetsWide) {
-  size_t sz = qint_encode2(bw, delta, res->term.offsets.len);
+  size_t sz = qint_encode2(bw, delta, res->offsetsSz);
   sz += WriteVarintFieldMask(res->fieldMask, bw);
   sz += Buffer_Write(bw, res->term.offsets.data, res->term.offsets.len);
   return sz;
@@ -183,14 +220,14 @@ ENCODER(encodeFieldsOffsetsWide) {
 // 6. Offsets only
 ENCODER(encodeOffsetsOnly) {
 
-  size_t sz = qint_encode2(bw, delta, res->term.offsets.len);
+  size_t sz = qint_encode2(bw, delta, res->offsetsSz);
   sz += Buffer_Write(bw, res->term.offsets.data, res->term.offsets.len);
   return sz;
 }
 
 // 7. Offsets and freqs
 ENCODER(encodeFreqsOffsets) {
-  size_t sz = qint_encode3(bw, delta, (uint32_t)res->freq, (uint32_t)res->term.offsets.len);
+  size_t sz = qint_encode3(bw, delta, (uint32_t)res->freq, res->offsetsSz);
   sz += Buffer_Write(bw, res->term.offsets.data, res->term.offsets.len);
   return sz;
 }
@@ -345,9 +382,24 @@ ENCODER(encodeNumeric) {
   return sz;
 }
 
-/* Get the appropriate encoder based on index flags */
+/* Encode a record of a split-positions index: the record itself is written to bw without its
+ * offset vector, which is appended to the positional stream instead */
+static size_t encodeSplitPositions(IndexEncoder encoder, BufferWriter *bw, BufferWriter *pw,
+                                   uint32_t delta, RSIndexResult *res) {
+  RSOffsetVector offsets = res->term.offsets;
+  res->term.offsets.len = 0;
+  size_t sz = encoder(bw, delta, res);
+  res->term.offsets = offsets;
+  if (offsets.len) {
+    sz += Buffer_Write(pw, offsets.data, offsets.len);
+  }
+  return sz;
+}
+
+/* Get the appropriate encoder based on index flags. Split-positions indexes use the same
+ * encoders, with the offsets moved out by the writer */
 IndexEncoder InvertedIndex_GetEncoder(IndexFlags flags) {
-  switch (flags & INDEX_STORAGE_MASK) {
+  switch (flags & INDEX_STORAGE_MASK & ~Index_SplitPositions) {
     // 1. Full encoding - docId, freq, flags, offset
     case Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags:
       return encodeFull;
@@ -430,7 +482,13 @@ size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder,
   BufferWriter bw = NewBufferWriter(&blk->buf);
 
   // printf("Writing docId %llu, delta %llu, flags %x\n", docId, delta, (int)idx->flags);
-  size_t ret = encoder(&bw, delta, entry);
+  size_t ret;
+  if (idx->flags & Index_SplitPositions) {
+    BufferWriter pw = NewBufferWriter(&blk->posBuf);
+    ret = encodeSplitPositions(encoder, &bw, &pw, delta, entry);
+  } else {
+    ret = encoder(&bw, delta, entry);
+  }
 
   idx->lastId = docId;
   blk->lastId = docId;
@@ -465,12 +523,27 @@ size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double
       .type = RSResultType_Numeric,
       .num = (RSNumericRecord){.value = value},
   };
-  return InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec);
+  if (idx->lastId && docId <= idx->lastId) {
+    // a document updated in place keeps its id, its record goes back in its block
+    return InvertedIndex_InsertEntry(idx, encodeNumeric, docId, &rec);
+  }
+  size_t sz = InvertedIndex_WriteEntryGeneric(idx, encodeNumeric, docId, &rec);
+  if (sz) {
+    IndexBlock *blk = &INDEX_LAST_BLOCK(idx);
+    if (blk->numDocs == 1) {
+      blk->minValue = blk->maxValue = value;
+    } else if (value < blk->minValue) {
+      blk->minValue = value;
+    } else if (value > blk->maxValue) {
+      blk->maxValue = value;
+    }
+  }
+  return sz;
 }
 
 static void IndexReader_AdvanceBlock(IndexReader *ir) {
   ir->currentBlock++;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IndexReader_ResetBlockReaders(ir);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
 }
 
@@ -688,6 +761,94 @@ DECODER(readFreqsOffsets) {
   return 1;
 }
 
+/* Decoders for split-positions indexes. These only read the size of the offset vector; the
+ * reader attaches the offsets from the block's positional stream */
+DECODER(readFreqOffsetsFlagsSplit) {
+  qint_decode4(br, (uint32_t *)&res->docId, &res->freq, (uint32_t *)&res->fieldMask,
+               &res->offsetsSz);
+  CHECK_FLAGS(ctx, res);
+}
+
+SKIPPER(seekFreqOffsetsFlagsSplit) {
+  uint32_t did = 0, freq = 0, offsz = 0;
+  t_fieldMask fm = 0;
+  t_docId lastId = ir->lastId;
+  int rc = 0;
+
+  t_fieldMask num = ctx->num;
+  // the offsets of skipped records are never looked at, only their total size
+  size_t posSkip = 0;
+
+  if (!BufferReader_AtEnd(br)) {
+    size_t oldpos = br->pos;
+    qint_decode4(br, &did, &freq, (uint32_t *)&fm, &offsz);
+    posSkip += offsz;
+
+    if (oldpos == 0 && did != 0) {
+      lastId = did;
+    } else {
+      lastId = (did += lastId);
+    }
+
+    if ((num & fm) && did >= expid) {
+      rc = 1;
+      goto done;
+    }
+  }
+
+  while (!BufferReader_AtEnd(br)) {
+    qint_decode4(br, &did, &freq, (uint32_t *)&fm, &offsz);
+    posSkip += offsz;
+    lastId = (did += lastId);
+    if (!(num & fm)) {
+      continue;
+    }
+    if (did >= expid) {
+      rc = 1;
+      break;
+    }
+  }
+
+done:
+  Buffer_Skip(&ir->posBr, posSkip);
+  res->docId = did;
+  res->freq = freq;
+  res->fieldMask = fm;
+  res->offsetsSz = offsz;
+  res->term.offsets.data = BufferReader_Current(&ir->posBr) - offsz;
+  res->term.offsets.len = offsz;
+
+  ir->lastId = lastId;
+  return rc;
+}
+
+DECODER(readFreqOffsetsFlagsWideSplit) {
+  qint_decode3(br, (uint32_t *)&res->docId, &res->freq, &res->offsetsSz);
+  res->fieldMask = ReadVarintFieldMask(br);
+  CHECK_FLAGS(ctx, res);
+}
+
+DECODER(readFlagsOffsetsSplit) {
+  qint_decode3(br, (uint32_t *)&res->docId, (uint32_t *)&res->fieldMask, &res->offsetsSz);
+  CHECK_FLAGS(ctx, res);
+}
+
+DECODER(readFlagsOffsetsWideSplit) {
+  qint_decode2(br, (uint32_t *)&res->docId, &res->offsetsSz);
+  res->fieldMask = ReadVarintFieldMask(br);
+  CHECK_FLAGS(ctx, res);
+}
+
+DECODER(readOffsetsSplit) {
+  qint_decode2(br, (uint32_t *)&res->docId, &res->offsetsSz);
+  return 1;
+}
+
+DECODER(readFreqsOffsetsSplit) {
+  qint_decode3(br, (uint32_t *)&res->docId, &res->freq, &res->offsetsSz);
+  return 1;
+}
+
 DECODER(readDocIdsOnly) {
   res->docId = ReadVarint(br);
   res->freq = 1;
@@ -700,7 +861,32 @@ IndexDecoderProcs InvertedIndex_GetDecoder(uint32_t flags) {
   procs.seeker = seeker_;                \
   return procs;
   IndexDecoderProcs procs = {0};
-  switch (flags & INDEX_STORAGE_MASK) {
+  if (flags & Index_SplitPositions) {
+    switch (flags & INDEX_STORAGE_MASK & ~Index_SplitPositions) {
+      case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets:
+        RETURN_DECODERS(readFreqOffsetsFlagsSplit, seekFreqOffsetsFlagsSplit);
+
+      case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema:
+        RETURN_DECODERS(readFreqOffsetsFlagsWideSplit, NULL);
+
+      case Index_StoreTermOffsets:
+        RETURN_DECODERS(readOffsetsSplit, NULL);
+
+      case Index_StoreFreqs | Index_StoreTermOffsets:
+        RETURN_DECODERS(readFreqsOffsetsSplit, NULL);
+
+      case Index_StoreFieldFlags | Index_StoreTermOffsets:
+        RETURN_DECODERS(readFlagsOffsetsSplit, NULL);
+
+      case Index_StoreFieldFlags | Index_StoreTermOffsets | Index_WideSchema:
+        RETURN_DECODERS(readFlagsOffsetsWideSplit, NULL);
+
+      default:
+        // records without offsets are laid out the same way in both formats
+        break;
+    }
+  }
+  switch (flags & INDEX_STORAGE_MASK & ~Index_SplitPositions) {
 
     // (freqs, fields, offset)
     case Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets:
@@ -846,14 +1032,14 @@ IndexCriteriaTester *IR_GetCriteriaTester(void *ctx) {
     // for now, if the iterator did not took the numric filter
     // we will avoid using the CT.
     // TODO: save the numeric filter in the numeric iterator to support CT anyway.
-    if (!ir->decoderCtx.ptr) {
+    if (!ir->decoderCtx.ptr && !ir->numericFilter) {
       return NULL;
     }
   }
   IR_CriteriaTester *irct = rm_malloc(sizeof(*irct));
   irct->spec = ir->sp;
   if (ir->decoders.decoder == readNumeric) {
-    irct->nf = *(NumericFilter *)ir->decoderCtx.ptr;
+    irct->nf = ir->numericFilter ? *ir->numericFilter : *(NumericFilter *)ir->decoderCtx.ptr;
     irct->nf.fieldName = rm_strdup(irct->nf.fieldName);
     irct->base.Test = IR_TestNumeric;
     irct->base.Free = IR_TesterFreeNumeric;
@@ -892,6 +1078,9 @@ int IR_Read(void *ctx, RSIndexResult **e) {
     size_t pos = ir->br.pos;
     int rv = ir->decoders.decoder(&ir->br, &ir->decoderCtx, ir->record);
     RSIndexResult *record = ir->record;
+    if (ir->idx->flags & Index_SplitPositions) {
+      IndexReader_ReadPositions(&ir->posBr, record);
+    }
 
     // We write the docid as a 32 bit number when decoding it with qint.
     uint32_t delta = *(uint32_t *)&record->docId;
@@ -947,7 +1136,7 @@ static int IndexReader_SkipToBlock(IndexReader *ir, t_docId docId) {
 
 new_block:
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IndexReader_ResetBlockReaders(ir);
   return rc;
 }
 
@@ -1053,9 +1242,17 @@ static void IndexReader_Init(const IndexSpec *sp, IndexReader *ret, InvertedInde
   ret->len = 0;
   ret->weight = weight;
   ret->lastId = IR_CURRENT_BLOCK(ret).firstId;
-  ret->br = NewBufferReader(&IR_CURRENT_BLOCK(ret).buf);
   ret->decoders = decoder;
   ret->decoderCtx = decoderCtx;
+  ret->numericFilter = NULL;
+  if (decoder.decoder == readNumeric && decoderCtx.ptr) {
+    const NumericFilter *f = decoderCtx.ptr;
+    // geo filters test the distance from their center rather than the value range
+    if (!f->geoFilter) {
+      ret->numericFilter = f;
+    }
+  }
+  IndexReader_ResetBlockReaders(ret);
   ret->isValidP = NULL;
   ret->sp = sp;
   IR_SetAtEnd(ret, 0);
@@ -1121,7 +1318,7 @@ void IR_Rewind(void *ctx) {
   IR_SetAtEnd(ir, 0);
   ir->currentBlock = 0;
   ir->gcMarker = ir->idx->gcMarker;
-  ir->br = NewBufferReader(&IR_CURRENT_BLOCK(ir).buf);
+  IndexReader_ResetBlockReaders(ir);
   ir->lastId = IR_CURRENT_BLOCK(ir).firstId;
 }
 
@@ -1165,9 +1362,17 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
   BufferReader br = NewBufferReader(&blk->buf);
   BufferWriter bw = NewBufferWriter(&repair);
 
+  // The positional stream keeps the offsets of the valid records as they are, in the same order
+  const int splitPositions = flags & Index_SplitPositions;
+  Buffer posRepair = {0};
+  BufferReader pr = NewBufferReader(&blk->posBuf);
+  BufferWriter pw = NewBufferWriter(&posRepair);
+
   RSIndexResult *res = flags == Index_StoreNumeric ? NewNumericResult() : NewTokenRecord(NULL, 1);
   size_t frags = 0;
   int isLastValid = 0;
+  // value bounds of the records that remain in a numeric block
+  double minValue = INFINITY, maxValue = -INFINITY;
 
   uint32_t readFlags = flags & INDEX_STORAGE_MASK;
   IndexDecoderProcs decoders = InvertedIndex_GetDecoder(readFlags);
@@ -1183,6 +1388,11 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     const char *bufBegin = BufferReader_Current(&br);
     decoders.decoder(&br, &empty, res);
     size_t sz = BufferReader_Current(&br) - bufBegin;
+    const char *posBegin = NULL;
+    if (splitPositions) {
+      posBegin = BufferReader_Current(&pr);
+      IndexReader_ReadPositions(&pr, res);
+    }
     if (!(isFirstRes && res->docId != 0)) {
       // if we are entering this here
       // then its not the first entry or its
@@ -1206,8 +1416,14 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
         // First invalid doc; copy everything prior to this to the repair
         // buffer
         Buffer_Write(&bw, blk->buf.data, bufBegin - blk->buf.data);
+        if (splitPositions) {
+          Buffer_Write(&pw, blk->posBuf.data, posBegin - blk->posBuf.data);
+        }
       }
       params->bytesCollected += sz;
+      if (splitPositions) {
+        params->bytesCollected += res->offsetsSz;
+      }
       isLastValid = 0;
     } else {
       // Valid document, but we're rewriting the block:
@@ -1220,6 +1436,11 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
         }
         if (isLastValid) {
           Buffer_Write(&bw, bufBegin, sz);
+          if (splitPositions) {
+            Buffer_Write(&pw, posBegin, res->offsetsSz);
+          }
+        } else if (splitPositions) {
+          encodeSplitPositions(encoder, &bw, &pw, res->docId - blk->lastId, res);
         } else {
           encoder(&bw, res->docId - blk->lastId, res);
         }
@@ -1232,8 +1453,16 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
       }
       blk->lastId = res->docId;
       isLastValid = 1;
+      if (flags == Index_StoreNumeric) {
+        if (res->num.value < minValue) minValue = res->num.value;
+        if (res->num.value > maxValue) maxValue = res->num.value;
+      }
     }
   }
+  if (frags && flags == Index_StoreNumeric) {
+    blk->minValue = minValue;
+    blk->maxValue = maxValue;
+  }
   if (frags) {
     // If we deleted stuff from this block, we need to change the number of docs and the data
     // pointer
@@ -1241,6 +1470,11 @@ int IndexBlock_Repair(IndexBlock *blk, DocTable *dt, IndexFlags flags, IndexRepa
     Buffer_Free(&blk->buf);
     blk->buf = repair;
     Buffer_ShrinkToSize(&blk->buf);
+    if (splitPositions) {
+      Buffer_Free(&blk->posBuf);
+      blk->posBuf = posRepair;
+      Buffer_ShrinkToSize(&blk->posBuf);
+    }
   }
   if (blk->numDocs == 0) {
     // if we left with no elements we do need to keep the
@@ -1266,7 +1500,7 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
       // want to split a block into two (or more) on high-delta boundaries.
       continue;
     }
-    int repaired = IndexBlock_Repair(&idx->blocks[startBlock], dt, idx->flags, params);
+    int repaired = IndexBlock_Repair(blk, dt, idx->flags, params);
     // We couldn't repair the block - return 0
     if (repaired == -1) {
       return 0;
@@ -1282,3 +1516,175 @@ int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
 
   return startBlock < idx->size ? startBlock : 0;
 }
+
+/* Whether records can be inserted in or removed from the middle of the index's blocks */
+#define INDEX_SPLICEABLE(idx)                                  \
+  (((idx)->flags & INDEX_STORAGE_MASK) == Index_DocIdsOnly || \
+   ((idx)->flags & INDEX_STORAGE_MASK) == Index_StoreNumeric)
+
+/* The position of the block in which a document's record is, or belongs */
+static uint32_t invertedIndex_FindBlock(InvertedIndex *idx, t_docId docId) {
+  uint32_t lo = 0, hi = idx->size;
+  // the last block starting at or before the document
+  while (hi - lo > 1) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (idx->blocks[mid].firstId <= docId) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Rewrite the block at position `ix` without the record of `docId`, or with `entry` inserted at its
+ * place if given. A block grown past INDEX_BLOCK_SIZE records is split into blocks of even sizes,
+ * so that records inserted into a sparse range of ids never make a block too large to count or to
+ * rewrite. Returns the size of the new blocks' buffers, or -1 if the block was left as is: the
+ * document was not found for a removal, or already had a record for an insertion */
+static ssize_t indexBlock_Splice(InvertedIndex *idx, uint32_t ix, IndexEncoder encoder,
+                                 t_docId docId, RSIndexResult *entry) {
+  const int numeric = (idx->flags & INDEX_STORAGE_MASK) == Index_StoreNumeric;
+  IndexDecoderProcs decoders = InvertedIndex_GetDecoder(idx->flags & INDEX_STORAGE_MASK);
+  if (!encoder) {
+    encoder = InvertedIndex_GetEncoder(idx->flags & INDEX_STORAGE_MASK);
+  }
+  RSIndexResult *res = numeric ? NewNumericResult() : NewVirtualResult(1);
+  IndexBlock *blk = idx->blocks + ix;
+
+  // the records of the new blocks, evenly spread
+  size_t numDocs = blk->numDocs + (entry ? 1 : 0);
+  size_t nblocks = MAX(1, (numDocs + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE);
+  size_t perBlock = MAX(1, (numDocs + nblocks - 1) / nblocks);
+
+  IndexBlock *nbs = array_new(IndexBlock, nblocks);
+  IndexBlock *nb = NULL;
+  BufferWriter bw;
+  BufferReader br = NewBufferReader(&blk->buf);
+  t_docId lastReadId = blk->firstId;
+  bool isFirstRes = true, found = false, failed = false;
+
+#define SPLICE_WRITE(rec)                                                  \
+  do {                                                                     \
+    if (!nb || nb->numDocs == perBlock) {                                  \
+      nb = array_ensure_tail(&nbs, IndexBlock);                            \
+      *nb = (IndexBlock){.firstId = (rec)->docId, .lastId = (rec)->docId}; \
+      nb->minValue = INFINITY;                                             \
+      nb->maxValue = -INFINITY;                                            \
+      bw = NewBufferWriter(&nb->buf);                                      \
+    }                                                                      \
+    if ((rec)->docId - nb->lastId > UINT32_MAX) {                          \
+      failed = true;                                                       \
+    }                                                                      \
+    encoder(&bw, (rec)->docId - nb->lastId, (rec));                        \
+    nb->lastId = (rec)->docId;                                             \
+    nb->numDocs++;                                                         \
+    if (numeric) {                                                         \
+      nb->minValue = fmin(nb->minValue, (rec)->num.value);                 \
+      nb->maxValue = fmax(nb->maxValue, (rec)->num.value);                 \
+    }                                                                      \
+  } while (0)
+
+  while (!failed && !BufferReader_AtEnd(&br)) {
+    static const IndexDecoderCtx empty = {0};
+    decoders.decoder(&br, &empty, res);
+    // like in IndexBlock_Repair, the first record of blocks of old RDB versions holds its id
+    if (!(isFirstRes && res->docId != 0)) {
+      res->docId = (*(uint32_t *)&res->docId) + lastReadId;
+    }
+    isFirstRes = false;
+    lastReadId = res->docId;
+
+    if (res->docId == docId) {
+      found = true;
+      if (entry) {
+        failed = true;
+      }
+      continue;
+    }
+    if (entry && !found && docId < res->docId) {
+      found = true;
+      SPLICE_WRITE(entry);
+    }
+    SPLICE_WRITE(res);
+  }
+  if (entry && !found) {
+    found = true;
+    SPLICE_WRITE(entry);
+  }
+#undef SPLICE_WRITE
+  IndexResult_Free(res);
+  if (failed || !found) {
+    array_free_ex(nbs, Buffer_Free(&((IndexBlock *)ptr)->buf));
+    return -1;
+  }
+
+  if (!array_len(nbs)) {
+    // like a repaired block left empty, keep the first id for the binary search on the blocks
+    IndexBlock empty = {.firstId = blk->firstId, .lastId = 0};
+    nbs = array_append(nbs, empty);
+  }
+  // let suspended readers seek back to their document, as after a GC pass
+  uint64_t gcMarker = ++idx->gcMarker;
+  size_t n = array_len(nbs), size = 0;
+  for (size_t i = 0; i < n; i++) {
+    Buffer_ShrinkToSize(&nbs[i].buf);
+    nbs[i].gcMarker = gcMarker;
+    size += nbs[i].buf.offset;
+  }
+
+  indexBlock_Free(blk);
+  if (n > 1) {
+    // the blocks after the split one move, which the fork GC can't tell from its block positions
+    idx->splitMarker = gcMarker;
+    idx->blocks = rm_realloc(idx->blocks, (idx->size + n - 1) * sizeof(*idx->blocks));
+    memmove(idx->blocks + ix + n, idx->blocks + ix + 1,
+            (idx->size - ix - 1) * sizeof(*idx->blocks));
+    idx->size += n - 1;
+    TotalIIBlocks += n - 1;
+  }
+  memcpy(idx->blocks + ix, nbs, n * sizeof(*nbs));
+  array_free(nbs);
+  return size;
+}
+
+/* The index's last document, once its last block has changed */
+static void invertedIndex_ResetLastId(InvertedIndex *idx) {
+  idx->lastId = 0;
+  for (uint32_t i = idx->size; i > 0 && !idx->lastId; i--) {
+    idx->lastId = idx->blocks[i - 1].lastId;
+  }
+}
+
+size_t InvertedIndex_InsertEntry(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
+                                 RSIndexResult *entry) {
+  if (docId > idx->lastId) {
+    return InvertedIndex_WriteEntryGeneric(idx, encoder, docId, entry);
+  }
+  RS_LOG_ASSERT(INDEX_SPLICEABLE(idx), "records can only be inserted in numeric and tag indexes");
+  uint32_t ix = invertedIndex_FindBlock(idx, docId);
+  size_t before = idx->blocks[ix].buf.offset;
+  entry->docId = docId;
+  ssize_t after = indexBlock_Splice(idx, ix, encoder, docId, entry);
+  if (after < 0) {
+    return 0;
+  }
+  idx->numDocs++;
+  return after > before ? after - before : 0;
+}
+
+int InvertedIndex_DeleteEntry(InvertedIndex *idx, t_docId docId) {
+  RS_LOG_ASSERT(INDEX_SPLICEABLE(idx), "records can only be removed from numeric and tag indexes");
+  if (!idx->size || docId > idx->lastId) {
+    return 0;
+  }
+  uint32_t ix = invertedIndex_FindBlock(idx, docId);
+  const IndexBlock *blk = idx->blocks + ix;
+  if (docId < blk->firstId || docId > blk->lastId ||
+      indexBlock_Splice(idx, ix, NULL, docId, NULL) < 0) {
+    return 0;
+  }
+  idx->numDocs--;
+  invertedIndex_ResetLastId(idx);
+  return 1;
+}
@@ -23,7 +23,19 @@ typedef struct {
   t_docId firstId;
   t_docId lastId;
   Buffer buf;
+  // The offset vectors of the block's records, in record order. Only used by indexes with
+  // Index_SplitPositions; the records in buf then only hold the size of their offset vector
+  Buffer posBuf;
+  // The smallest and largest values of the block's records. Only used by numeric indexes, where
+  // they let readers skip blocks outside of their filter, and accept blocks inside of it without
+  // testing each record
+  double minValue;
+  double maxValue;
   uint16_t numDocs;
+  // The index's gcMarker when a record was last inserted in or removed from the middle of the
+  // block, which tells the fork GC whether its copy of the block is stale. It is 64 bits wide so
+  // that it never wraps around, which would make a changed block look older than the GC's copy
+  uint64_t gcMarker;
 } IndexBlock;
 
 typedef struct InvertedIndex {
@@ -32,7 +44,9 @@ typedef struct InvertedIndex {
   IndexFlags flags;
   t_docId lastId;
   uint32_t numDocs;
-  uint32_t gcMarker;
+  uint64_t gcMarker;
+  // The gcMarker when a block was last split in two or more, moving the blocks after it
+  uint64_t splitMarker;
 } InvertedIndex;
 
 struct indexReadCtx;
@@ -73,6 +87,13 @@ void InvertedIndex_Free(void *idx);
 
 #define IndexBlock_DataBuf(b) (b)->buf.data
 #define IndexBlock_DataLen(b) (b)->buf.offset
+#define IndexBlock_PosBuf(b) (b)->posBuf.data
+#define IndexBlock_PosLen(b) (b)->posBuf.offset
+
+/* The flags for a new term inverted index. Offsets are written to a separate positional stream,
+ * so that queries which don't need them don't have to skip over them */
+#define InvertedIndex_TermFlags(flags) \
+  ((flags) & Index_StoreTermOffsets ? (IndexFlags)((flags) | Index_SplitPositions) : (flags))
 
 int InvertedIndex_Repair(InvertedIndex *idx, DocTable *dt, uint32_t startBlock,
                          IndexRepairParams *params);
@@ -116,6 +137,9 @@ typedef struct IndexReader {
   // the underlying data buffer
   BufferReader br;
 
+  // reader of the current block's positional stream, for indexes with Index_SplitPositions
+  BufferReader posBr;
+
   InvertedIndex *idx;
   // last docId, used for delta encoding/decoding
   t_docId lastId;
@@ -124,6 +148,9 @@ typedef struct IndexReader {
   /* The decoder's filtering context. It may be a number or a pointer. The number is used for
    * filtering field masks, the pointer for numeric filtering */
   IndexDecoderCtx decoderCtx;
+  /* The filter of numeric readers. The decoder context only points at it while reading blocks
+   * whose value bounds are not entirely inside of the filter */
+  const NumericFilter *numericFilter;
   /* The decoding function for reading the index */
   IndexDecoderProcs decoders;
 
@@ -142,7 +169,7 @@ typedef struct IndexReader {
   /* This marker lets us know whether the garbage collector has visited this index while the reading
    * thread was asleep, and reset the state in a deeper way
    */
-  uint32_t gcMarker;
+  uint64_t gcMarker;
 
   /* boosting weight */
   double weight;
@@ -165,6 +192,18 @@ size_t InvertedIndex_WriteNumericEntry(InvertedIndex *idx, t_docId docId, double
 
 size_t InvertedIndex_WriteEntryGeneric(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
                                        RSIndexResult *entry);
+
+/* Write an entry for a document which may be older than the last document of the index, as when a
+ * document is updated in place and keeps its id. The block holding the document's position is
+ * rewritten with the entry in it. Only numeric and docId-only indexes support this. Returns 0 if
+ * the index already holds the document */
+size_t InvertedIndex_InsertEntry(InvertedIndex *idx, IndexEncoder encoder, t_docId docId,
+                                 RSIndexResult *entry);
+
+/* Remove a document's entry from a numeric or docId-only index, rewriting its block. Returns 0 if
+ * the index does not hold the document */
+int InvertedIndex_DeleteEntry(InvertedIndex *idx, t_docId docId);
+
 /* Create a new index reader for numeric records, optionally using a given filter. If the filter
  * is
  * NULL we will return all the records in the index */
@@ -0,0 +1,176 @@
+#include "knn_iterator.h"
+#include "index_result.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <stdlib.h>
+
+typedef struct {
+  IndexIterator base;
+  void *ctx;
+  KnnLoadFunc load;
+  void (*freeCtx)(void *);
+  size_t estimate;
+  // The nearest neighbours, sorted by docId. NULL until the first read
+  KnnHit *hits;
+  size_t offset;
+  t_docId lastDocId;
+} KnnIterator;
+
+static int cmpHitsByDocId(const void *p1, const void *p2) {
+  const KnnHit *h1 = p1, *h2 = p2;
+  return h1->docId < h2->docId ? -1 : (h1->docId > h2->docId ? 1 : 0);
+}
+
+static int cmpHitsByDistance(const void *p1, const void *p2) {
+  const KnnHit *h1 = p1, *h2 = p2;
+  if (h1->distance != h2->distance) {
+    return h1->distance < h2->distance ? -1 : 1;
+  }
+  return cmpHitsByDocId(p1, p2);
+}
+
+void KnnHits_SortByDocId(KnnHit *hits) {
+  qsort(hits, array_len(hits), sizeof(*hits), cmpHitsByDocId);
+}
+
+KnnHit *KnnHits_Nearest(KnnHit *hits, size_t k) {
+  if (array_len(hits) > k) {
+    qsort(hits, array_len(hits), sizeof(*hits), cmpHitsByDistance);
+    hits = array_trimm_len(hits, k);
+    KnnHits_SortByDocId(hits);
+  }
+  return hits;
+}
+
+KnnHit *KnnHits_Match(KnnHit *hits, IndexIterator *child) {
+  if (!child) {
+    return hits;
+  }
+  child->Rewind(child->ctx);
+
+  size_t n = 0;
+  // where the child stands, and whether it is a match there not yet taken
+  t_docId at = 0;
+  int atMatch = 0;
+  for (size_t ii = 0; ii < array_len(hits); ++ii) {
+    t_docId docId = hits[ii].docId;
+    if (docId < at || (docId == at && !atMatch)) {
+      // duplicates, and documents the child already skipped over
+      continue;
+    }
+    if (docId == at) {
+      // a miss on an earlier hit moved the child to the next match, which is this one
+      hits[n++] = hits[ii];
+      atMatch = 0;
+      continue;
+    }
+    RSIndexResult *r = NULL;
+    int rc = child->SkipTo(child->ctx, docId, &r);
+    if (rc == INDEXREAD_EOF) {
+      break;
+    }
+    if (rc == INDEXREAD_OK) {
+      hits[n++] = hits[ii];
+      at = docId;
+      atMatch = 0;
+    } else if (r && r->docId > docId) {
+      // not found, the child moved on to its next match
+      at = r->docId;
+      atMatch = 1;
+    } else {
+      at = docId;
+      atMatch = 0;
+    }
+  }
+  return array_trimm_len(hits, n);
+}
+
+static int KI_Read(void *ctx, RSIndexResult **r) {
+  KnnIterator *it = ctx;
+  if (!it->hits) {
+    it->hits = it->load(it->ctx);
+  }
+  if (!it->base.isValid || it->offset >= array_len(it->hits)) {
+    it->base.isValid = 0;
+    return INDEXREAD_EOF;
+  }
+
+  const KnnHit *hit = it->hits + it->offset++;
+  it->lastDocId = hit->docId;
+  it->base.current->docId = hit->docId;
+  it->base.current->num.value = hit->distance;
+  *r = it->base.current;
+  return INDEXREAD_OK;
+}
+
+static int KI_SkipTo(void *ctx, t_docId docId, RSIndexResult **r) {
+  KnnIterator *it = ctx;
+  if (!it->hits) {
+    it->hits = it->load(it->ctx);
+  }
+  while (it->offset < array_len(it->hits) && it->hits[it->offset].docId < docId) {
+    it->offset++;
+  }
+  int rc = KI_Read(ctx, r);
+  if (rc == INDEXREAD_OK && (*r)->docId != docId) {
+    return INDEXREAD_NOTFOUND;
+  }
+  return rc;
+}
+
+static t_docId KI_LastDocId(void *ctx) {
+  return ((KnnIterator *)ctx)->lastDocId;
+}
+
+static size_t KI_Len(void *ctx) {
+  KnnIterator *it = ctx;
+  return it->hits ? array_len(it->hits) : it->estimate;
+}
+
+static void KI_Abort(void *ctx) {
+  ((KnnIterator *)ctx)->base.isValid = 0;
+}
+
+static void KI_Rewind(void *ctx) {
+  KnnIterator *it = ctx;
+  it->base.isValid = 1;
+  it->offset = 0;
+  it->lastDocId = 0;
+}
+
+static void KI_Free(IndexIterator *self) {
+  KnnIterator *it = self->ctx;
+  if (it->freeCtx) {
+    it->freeCtx(it->ctx);
+  }
+  if (it->hits) {
+    array_free(it->hits);
+  }
+  IndexResult_Free(it->base.current);
+  rm_free(it);
+}
+
+IndexIterator *NewKnnIterator(void *ctx, KnnLoadFunc load, void (*freeCtx)(void *),
+                              size_t estimate) {
+  KnnIterator *it = rm_calloc(1, sizeof(*it));
+  it->ctx = ctx;
+  it->load = load;
+  it->freeCtx = freeCtx;
+  it->estimate = estimate;
+
+  IndexIterator *ret = &it->base;
+  ret->ctx = it;
+  ret->isValid = 1;
+  ret->current = NewNumericResult();
+  ret->mode = MODE_SORTED;
+  ret->NumEstimated = KI_Len;
+  ret->Read = KI_Read;
+  ret->SkipTo = KI_SkipTo;
+  ret->LastDocId = KI_LastDocId;
+  ret->Free = KI_Free;
+  ret->Len = KI_Len;
+  ret->Abort = KI_Abort;
+  ret->Rewind = KI_Rewind;
+  return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef __KNN_ITERATOR_H__
+#define __KNN_ITERATOR_H__
+
+#include "redisearch.h"
+#include "index_iterator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A nearest neighbour and its distance from the query */
+typedef struct {
+  t_docId docId;
+  double distance;
+} KnnHit;
+
+/* Find the nearest neighbours. Returns an array (util/arr.h) of hits sorted by docId, which the
+ * iterator takes ownership of */
+typedef KnnHit *(*KnnLoadFunc)(void *ctx);
+
+/* Create an iterator over nearest neighbours, which are only searched for on the first read.
+ * Each result is numeric, holding the distance of the document. `freeCtx` is called on `ctx` when
+ * the iterator is freed, and `estimate` is the number of results expected */
+IndexIterator *NewKnnIterator(void *ctx, KnnLoadFunc load, void (*freeCtx)(void *),
+                              size_t estimate);
+
+/* Keep only the hits matching `child`, which is rewound first. A NULL child matches every hit.
+ * `hits` must be sorted by docId */
+KnnHit *KnnHits_Match(KnnHit *hits, IndexIterator *child);
+
+/* Keep the `k` hits nearest to the query, and sort them back by docId */
+KnnHit *KnnHits_Nearest(KnnHit *hits, size_t k);
+
+void KnnHits_SortByDocId(KnnHit *hits);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
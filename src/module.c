@@ -29,6 +29,8 @@
 #include "alias.h"
 #include "module.h"
 #include "info_command.h"
+#include "async_index.h"
+#include "term_cache.h"
 
 pthread_rwlock_t RWLock = PTHREAD_RWLOCK_INITIALIZER;
 
@@ -1013,10 +1015,12 @@ void __attribute__((destructor)) RediSearch_CleanupModule(void) {
     mempool_free_global();
     ConcurrentSearch_ThreadPoolDestroy();
     ReindexPool_ThreadPoolDestroy();
+    AsyncIndex_ThreadPoolDestroy();
     GC_ThreadPoolDestroy();
     IndexAlias_DestroyGlobal();
     freeGlobalAddStrings();
-    SchemaPrefixes_Free();
+    SchemaRules_FreeMatcher();
+    TermCache_FreeThread();
     RedisModule_FreeThreadSafeContext(RSDummyContext);
     Dictionary_Free();
   }
@@ -5,6 +5,9 @@
 RedisModuleString *global_RenameFromKey = NULL;
 extern RedisModuleCtx *RSDummyContext;
 RedisModuleString **hashFields = NULL;
+// The values of the fields before the command, NULL for the ones the hash lacked, and its key
+RedisModuleString **hashFieldValues = NULL;
+RedisModuleString *hashFieldsKey = NULL;
 
 typedef enum {
   hset_cmd,
@@ -28,10 +31,27 @@ static void freeHashFields() {
   if (hashFields != NULL) {
     for (size_t i = 0; hashFields[i] != NULL; ++i) {
       RedisModule_FreeString(RSDummyContext, hashFields[i]);
+      if (hashFieldValues[i]) {
+        RedisModule_FreeString(RSDummyContext, hashFieldValues[i]);
+      }
     }
     rm_free(hashFields);
+    rm_free(hashFieldValues);
     hashFields = NULL;
+    hashFieldValues = NULL;
+  }
+  if (hashFieldsKey != NULL) {
+    RedisModule_FreeString(RSDummyContext, hashFieldsKey);
+    hashFieldsKey = NULL;
+  }
+}
+
+/* The values the changed fields had before the command, if it changed this key */
+static RedisModuleString **oldHashFieldValues(RedisModuleString *key) {
+  if (!hashFields || !hashFieldsKey || RedisModule_StringCompare(hashFieldsKey, key) != 0) {
+    return NULL;
   }
+  return hashFieldValues;
 }
 
 int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
@@ -108,8 +128,11 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
     case hincrby_cmd:
     case hincrbyfloat_cmd:
     case hdel_cmd:
+      Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields, oldHashFieldValues(key));
+      break;
+
     case restore_cmd:
-      Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields);
+      Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields, NULL);
       break;
 
     case del_cmd:
@@ -126,7 +149,7 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
         // in crdt empty key means that key was deleted
         Indexes_DeleteMatchingWithSchemaRules(ctx, key, hashFields);
       } else {
-        Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields);
+        Indexes_UpdateMatchingWithSchemaRules(ctx, key, hashFields, NULL);
       }
       RedisModule_CloseKey(kp);
       break;
@@ -187,15 +210,22 @@ void CommandFilterCallback(RedisModuleCommandFilterCtx *filter) {
 
   int fieldsNum = (numArgs - 2) / cmdFactor;
   hashFields = (RedisModuleString **)rm_calloc(fieldsNum + 1, sizeof(*hashFields));
+  // the indexes can update the document in place when they know what the fields were indexed with
+  hashFieldValues = (RedisModuleString **)rm_calloc(fieldsNum + 1, sizeof(*hashFieldValues));
 
   for (size_t i = 0; i < fieldsNum; ++i) {
     RedisModuleString *field = (RedisModuleString *)RedisModule_CommandFilterArgGet(filter, 2 + i * cmdFactor);
     RedisModule_RetainString(RSDummyContext, field);
     hashFields[i] = field;
+    RedisModule_HashGet(k, REDISMODULE_HASH_NONE, field, &hashFieldValues[i], NULL);
   }
+  hashFieldsKey = copyKeyStr;
+  copyKeyStr = NULL;
 
 done:
-  RedisModule_FreeString(RSDummyContext, copyKeyStr);
+  if (copyKeyStr) {
+    RedisModule_FreeString(RSDummyContext, copyKeyStr);
+  }
   RedisModule_CloseKey(k);
 }
 
@@ -211,4 +241,4 @@ void Initialize_CommandFilter(RedisModuleCtx *ctx) {
   if (RSGlobalConfig.filterCommands) {
     RedisModule_RegisterCommandFilter(ctx, CommandFilterCallback, 0);
   }
-}
\ No newline at end of file
+}
\ No newline at end of file
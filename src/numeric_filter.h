@@ -42,6 +42,17 @@ static inline int NumericFilter_Match(const NumericFilter *f, double score) {
   return rc;
 }
 
+/* Returns 1 if all the values between min and max match the filter */
+static inline int NumericFilter_Contains(const NumericFilter *f, double min, double max) {
+  return NumericFilter_Match(f, min) && NumericFilter_Match(f, max);
+}
+
+/* Returns 1 if any of the values between min and max may match the filter */
+static inline int NumericFilter_Overlaps(const NumericFilter *f, double min, double max) {
+  return (f->inclusiveMin ? max >= f->min : max > f->min) &&
+         (f->inclusiveMax ? min <= f->max : min < f->max);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,17 @@
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
 #define NR_MAX_DEPTH 2
+// number of entries in the leaves of a compacted tree
+#define NR_COMPACT_LEAF_SIZE NR_MAXRANGE_CARD
+// trees with fewer leaves are never compacted by the GC
+#define NR_COMPACT_MIN_LEAVES 16
+
+/* A single entry in a numeric index's single range. Since entries are binned together, each needs
+ * to have the exact value */
+typedef struct {
+  t_docId docId;
+  double value;
+} NumericRangeEntry;
 
 typedef struct {
   IndexIterator *it;
@@ -78,6 +89,26 @@ size_t NumericRange_Add(NumericRange *n, t_docId docId, double value, int checkC
   return InvertedIndex_WriteNumericEntry(n->entries, docId, value);
 }
 
+int NumericRange_Delete(NumericRange *n, t_docId docId, double value, int checkCard) {
+  if (!InvertedIndex_DeleteEntry(n->entries, docId)) {
+    return 0;
+  }
+  if (checkCard) {
+    for (int i = 0; i < array_len(n->values); i++) {
+      if (n->values[i].value == value) {
+        if (!--n->values[i].appearances) {
+          array_del_fast(n->values, i);
+          n->unique_sum -= value;
+          --n->card;
+        }
+        break;
+      }
+    }
+  }
+  // the value bounds are left as they are, wider bounds only make the range less selective
+  return 1;
+}
+
 double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNode **rp) {
 
   double split = (n->unique_sum) / (double)n->card;
@@ -196,6 +227,23 @@ NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value)
 }
 
 /* Recursively add a node's children to the range. */
+int NumericRangeNode_Delete(NumericRangeNode *n, t_docId docId, double value) {
+  // the value is in its leaf, and in the ranges retained along its path
+  NumericRangeNode *leaf = n;
+  while (!NumericRangeNode_IsLeaf(leaf)) {
+    leaf = value < leaf->value ? leaf->left : leaf->right;
+  }
+  if (!NumericRange_Delete(leaf->range, docId, value, 1)) {
+    return 0;
+  }
+  for (; n != leaf; n = value < n->value ? n->left : n->right) {
+    if (n->range) {
+      NumericRange_Delete(n->range, docId, value, 0);
+    }
+  }
+  return 1;
+}
+
 void __recursiveAddRange(Vector *v, NumericRangeNode *n, double min, double max) {
   if (!n) return;
 
@@ -242,6 +290,27 @@ Vector *NumericRangeNode_FindRange(NumericRangeNode *n, double min, double max)
   return leaves;
 }
 
+static void collectLeaves(NumericRangeNode *n, NumericRange ***leaves) {
+  if (!n) {
+    return;
+  }
+  if (NumericRangeNode_IsLeaf(n)) {
+    if (n->range) {
+      *array_ensure_tail(leaves, NumericRange *) = n->range;
+    }
+    return;
+  }
+  // the values below the node's value are on its left
+  collectLeaves(n->left, leaves);
+  collectLeaves(n->right, leaves);
+}
+
+NumericRange **NumericRangeTree_GetLeaves(NumericRangeTree *t) {
+  NumericRange **leaves = array_new(NumericRange *, t->numRanges ? t->numRanges : 1);
+  collectLeaves(t->root, &leaves);
+  return leaves;
+}
+
 void NumericRangeNode_Free(NumericRangeNode *n) {
   if (!n) return;
   if (n->range) {
@@ -270,9 +339,27 @@ NumericRangeTree *NewNumericRangeTree() {
   ret->revisionId = 0;
   ret->lastDocId = 0;
   ret->uniqueId = numericTreesUniqueId++;
+  ret->compactStalled = 0;
   return ret;
 }
 
+static size_t numericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
+  NRN_AddRv rv = NumericRangeNode_Add(t->root, docId, value);
+  // rc != 0 means the tree nodes have changed, and concurrent iteration is not allowed now
+  // we increment the revision id of the tree, so currently running query iterators on it
+  // will abort the next time they get execution context
+  if (rv.changed) {
+    t->revisionId++;
+    t->compactStalled = 0;
+  }
+  t->numRanges += rv.changed;
+  if (rv.sz) {
+    t->numEntries++;
+  }
+
+  return rv.sz;
+}
+
 size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
 
   // Do not allow duplicate entries. This might happen due to indexer bugs and we need to protect
@@ -281,18 +368,23 @@ size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value) {
     return 0;
   }
   t->lastDocId = docId;
+  return numericRangeTree_Add(t, docId, value);
+}
 
-  NRN_AddRv rv = NumericRangeNode_Add(t->root, docId, value);
-  // rc != 0 means the tree nodes have changed, and concurrent iteration is not allowed now
-  // we increment the revision id of the tree, so currently running query iterators on it
-  // will abort the next time they get execution context
-  if (rv.changed) {
-    t->revisionId++;
+size_t NumericRangeTree_Insert(NumericRangeTree *t, t_docId docId, double value) {
+  if (docId > t->lastDocId) {
+    t->lastDocId = docId;
   }
-  t->numRanges += rv.changed;
-  t->numEntries++;
+  return numericRangeTree_Add(t, docId, value);
+}
 
-  return rv.sz;
+int NumericRangeTree_Delete(NumericRangeTree *t, t_docId docId, double value) {
+  int found = NumericRangeNode_Delete(t->root, docId, value);
+  if (found) {
+    t->numEntries--;
+    t->compactStalled = 0;
+  }
+  return found;
 }
 
 Vector *NumericRangeTree_Find(NumericRangeTree *t, double min, double max) {
@@ -312,6 +404,229 @@ void NumericRangeNode_Traverse(NumericRangeNode *n,
   }
 }
 
+static void numericTreeStats(NumericRangeNode *n, size_t depth, NumericRangeTreeStats *stats,
+                             size_t *numEntries) {
+  if (!NumericRangeNode_IsLeaf(n)) {
+    numericTreeStats(n->left, depth + 1, stats, numEntries);
+    numericTreeStats(n->right, depth + 1, stats, numEntries);
+    return;
+  }
+  if (!stats->numLeaves || depth < stats->minDepth) stats->minDepth = depth;
+  if (depth > stats->maxDepth) stats->maxDepth = depth;
+  stats->numLeaves++;
+  if (!n->range || !n->range->entries->numDocs) {
+    stats->emptyLeaves++;
+  } else {
+    *numEntries += n->range->entries->numDocs;
+  }
+}
+
+/* The stats of the subtree under a node. Returns the number of entries of its leaves */
+static size_t numericNodeStats(NumericRangeNode *n, NumericRangeTreeStats *stats) {
+  *stats = (NumericRangeTreeStats){0};
+  size_t numEntries = 0;
+  numericTreeStats(n, 0, stats, &numEntries);
+  stats->fill = (double)numEntries / stats->numLeaves / NR_COMPACT_LEAF_SIZE;
+  return numEntries;
+}
+
+void NumericRangeTree_GetStats(NumericRangeTree *t, NumericRangeTreeStats *stats) {
+  numericNodeStats(t->root, stats);
+}
+
+int NumericRangeTree_NeedsCompaction(NumericRangeTree *t) {
+  if (t->compactStalled) {
+    return 0;
+  }
+  NumericRangeTreeStats stats;
+  NumericRangeTree_GetStats(t, &stats);
+  if (stats.numLeaves < NR_COMPACT_MIN_LEAVES) {
+    return 0;
+  }
+  // a quarter of the leaves are empty, or the leaves are mostly tiny
+  return stats.emptyLeaves * 4 >= stats.numLeaves || stats.fill < 0.125;
+}
+
+static void collectEntries(NumericRangeNode *n, void *ctx) {
+  NumericRangeEntry **entries = ctx;
+  if (!NumericRangeNode_IsLeaf(n) || !n->range) {
+    return;
+  }
+  RSIndexResult *res = NULL;
+  IndexReader *ir = NewNumericReader(NULL, n->range->entries, NULL);
+  while (INDEXREAD_OK == IR_Read(ir, &res)) {
+    NumericRangeEntry e = {.docId = res->docId, .value = res->num.value};
+    *entries = array_append(*entries, e);
+  }
+  IR_Free(ir);
+}
+
+static int cmpEntryValue(const void *p1, const void *p2) {
+  const NumericRangeEntry *e1 = p1, *e2 = p2;
+  if (e1->value != e2->value) {
+    return e1->value < e2->value ? -1 : 1;
+  }
+  return e1->docId < e2->docId ? -1 : (e1->docId > e2->docId ? 1 : 0);
+}
+
+static int cmpEntryDocId(const void *p1, const void *p2) {
+  const NumericRangeEntry *e1 = p1, *e2 = p2;
+  return e1->docId < e2->docId ? -1 : (e1->docId > e2->docId ? 1 : 0);
+}
+
+/* Create a range holding the given entries, which are sorted by value */
+static NumericRange *newCompactedRange(const NumericRangeEntry *entries, size_t n,
+                                       size_t splitCard) {
+  NumericRange *r = rm_malloc(sizeof(*r));
+  *r = (NumericRange){.minVal = entries[0].value,
+                      .maxVal = entries[n - 1].value,
+                      .splitCard = splitCard,
+                      .values = array_new(CardinalityValue, 1),
+                      .entries = NewInvertedIndex(Index_StoreNumeric, 1)};
+  size_t card = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (i && entries[i].value == entries[i - 1].value) {
+      if (card <= splitCard) {
+        r->values[array_len(r->values) - 1].appearances++;
+      }
+      continue;
+    }
+    if (++card <= splitCard) {
+      CardinalityValue val = {.value = entries[i].value, .appearances = 1};
+      r->values = array_append(r->values, val);
+      r->unique_sum += entries[i].value;
+    }
+  }
+  r->card = MIN(card, UINT16_MAX);
+
+  // the inverted index is written in document order
+  NumericRangeEntry *byId = rm_malloc(n * sizeof(*byId));
+  memcpy(byId, entries, n * sizeof(*byId));
+  qsort(byId, n, sizeof(*byId), cmpEntryDocId);
+  for (size_t i = 0; i < n; i++) {
+    InvertedIndex_WriteNumericEntry(r->entries, byId[i].docId, byId[i].value);
+  }
+  rm_free(byId);
+  return r;
+}
+
+/* Build a balanced subtree over the leaves in [lo, hi). bounds[i] is the offset of the first entry
+ * of leaf i in the value sorted entries array */
+static NumericRangeNode *buildCompactedNode(const NumericRangeEntry *entries, const size_t *bounds,
+                                            size_t lo, size_t hi) {
+  NumericRangeNode *n = rm_calloc(1, sizeof(*n));
+  if (hi - lo == 1) {
+    n->range = newCompactedRange(entries + bounds[lo], bounds[hi] - bounds[lo], NR_MAXRANGE_CARD);
+    return n;
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  n->value = entries[bounds[mid]].value;
+  n->left = buildCompactedNode(entries, bounds, lo, mid);
+  n->right = buildCompactedNode(entries, bounds, mid, hi);
+  n->maxDepth = 1 + MAX(n->left->maxDepth, n->right->maxDepth);
+  // like nodes split on insertion, shallow inner nodes retain a range over their subtree
+  if (n->maxDepth <= NR_MAX_DEPTH) {
+    n->range = newCompactedRange(entries + bounds[lo], bounds[hi] - bounds[lo], NR_MAXRANGE_CARD);
+  }
+  return n;
+}
+
+/* Replace the subtree under a node, of numEntries entries, by a balanced one over the same entries.
+ * Returns its root, and sets numRanges to its number of leaves */
+static NumericRangeNode *compactNode(NumericRangeNode *node, size_t numEntries,
+                                     size_t *numRanges) {
+  NumericRangeEntry *entries = array_new(NumericRangeEntry, numEntries ? numEntries : 1);
+  NumericRangeNode_Traverse(node, collectEntries, &entries);
+  size_t n = array_len(entries);
+  qsort(entries, n, sizeof(*entries), cmpEntryValue);
+
+  // cut the entries into leaves of about NR_COMPACT_LEAF_SIZE entries, never splitting a value
+  // between two leaves
+  size_t *bounds = array_new(size_t, n / NR_COMPACT_LEAF_SIZE + 2);
+  for (size_t i = 0; i < n; i++) {
+    if (!i || (i - bounds[array_len(bounds) - 1] >= NR_COMPACT_LEAF_SIZE &&
+               entries[i].value != entries[i - 1].value)) {
+      bounds = array_append(bounds, i);
+    }
+  }
+  size_t numLeaves = array_len(bounds);
+  bounds = array_append(bounds, n);
+
+  NumericRangeNode_Free(node);
+  if (numLeaves) {
+    node = buildCompactedNode(entries, bounds, 0, numLeaves);
+  } else {
+    node = NewLeafNode(2, NF_NEGATIVE_INFINITY, NF_INFINITY, 2);
+  }
+  // like on insertion, where each split adds a leaf, the ranges of a tree are counted by its leaves
+  *numRanges = MAX(numLeaves, 1);
+  array_free(bounds);
+  array_free(entries);
+  return node;
+}
+
+/* The tree's nodes were replaced */
+static void numericTreeChanged(NumericRangeTree *t) {
+  // running iterators hold ranges of the old nodes, and the fork GC refers to the tree's nodes by
+  // their address
+  t->revisionId++;
+  t->uniqueId = numericTreesUniqueId++;
+  t->compactStalled = 0;
+}
+
+void NumericRangeTree_Compact(NumericRangeTree *t) {
+  t->root = compactNode(t->root, t->numEntries, &t->numRanges);
+  numericTreeChanged(t);
+}
+
+/* Compact the subtrees under *np whose entries fit in the budget and would fit in half of their
+ * leaves, taking the largest of them, and take their entries off the budget. Returns 1 if any was
+ * compacted */
+static int compactStep(NumericRangeTree *t, NumericRangeNode **np, size_t *budget) {
+  NumericRangeNode *n = *np;
+  NumericRangeTreeStats stats;
+  size_t numEntries = numericNodeStats(n, &stats);
+  if (numEntries <= *budget) {
+    size_t minLeaves = MAX(1, (numEntries + NR_COMPACT_LEAF_SIZE - 1) / NR_COMPACT_LEAF_SIZE);
+    if (2 * minLeaves > stats.numLeaves) {
+      return 0;
+    }
+    size_t numRanges;
+    *np = compactNode(n, numEntries, &numRanges);
+    t->numRanges = t->numRanges - stats.numLeaves + numRanges;
+    *budget -= numEntries;
+    return 1;
+  }
+  if (NumericRangeNode_IsLeaf(n)) {
+    return 0;
+  }
+
+  int compacted = compactStep(t, &n->left, budget);
+  compacted |= compactStep(t, &n->right, budget);
+  if (compacted) {
+    // the depth of the subtree may have changed, and like on insertion, a node too deep does not
+    // retain its range
+    n->maxDepth = 1 + MAX(n->left->maxDepth, n->right->maxDepth);
+    if (n->maxDepth > NR_MAX_DEPTH && n->range) {
+      InvertedIndex_Free(n->range->entries);
+      array_free(n->range->values);
+      rm_free(n->range);
+      n->range = NULL;
+    }
+  }
+  return compacted;
+}
+
+int NumericRangeTree_CompactStep(NumericRangeTree *t, size_t maxEntries) {
+  if (!compactStep(t, &t->root, &maxEntries)) {
+    // another step would find nothing either, until the leaves change
+    t->compactStalled = 1;
+    return 0;
+  }
+  numericTreeChanged(t);
+  return 1;
+}
+
 void NumericRangeTree_Free(NumericRangeTree *t) {
   NumericRangeNode_Free(t->root);
   rm_free(t);
@@ -398,26 +713,25 @@ static NumericRangeTree *openNumericKeysDict(RedisSearchCtx *ctx, RedisModuleStr
   return kdv->p;
 }
 
-struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
-                                               ConcurrentSearchCtx *csx, FieldType forType) {
-  RedisModuleString *s =
-      IndexSpec_GetFormattedKeyByName(ctx->spec, flt->fieldName, forType);
+NumericRangeTree *OpenNumericIndexForRead(RedisSearchCtx *ctx, const char *fieldName,
+                                          FieldType forType) {
+  RedisModuleString *s = IndexSpec_GetFormattedKeyByName(ctx->spec, fieldName, forType);
   if (!s) {
     return NULL;
   }
-  RedisModuleKey *key = NULL;
-  NumericRangeTree *t = NULL;
   if (!ctx->spec->keysDict) {
-    key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
+    RedisModuleKey *key = RedisModule_OpenKey(ctx->redisCtx, s, REDISMODULE_READ);
     if (!key || RedisModule_ModuleTypeGetType(key) != NumericIndexType) {
       return NULL;
     }
-
-    t = RedisModule_ModuleTypeGetValue(key);
-  } else {
-    t = openNumericKeysDict(ctx, s, 0);
+    return RedisModule_ModuleTypeGetValue(key);
   }
+  return openNumericKeysDict(ctx, s, 0);
+}
 
+struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const NumericFilter *flt,
+                                               ConcurrentSearchCtx *csx, FieldType forType) {
+  NumericRangeTree *t = OpenNumericIndexForRead(ctx, flt->fieldName, forType);
   if (!t) {
     return NULL;
   }
@@ -507,13 +821,6 @@ int NumericIndexType_Register(RedisModuleCtx *ctx) {
   return REDISMODULE_OK;
 }
 
-/* A single entry in a numeric index's single range. Since entries are binned together, each needs
- * to have the exact value */
-typedef struct {
-  t_docId docId;
-  double value;
-} NumericRangeEntry;
-
 static int cmpdocId(const void *p1, const void *p2) {
   NumericRangeEntry *e1 = (NumericRangeEntry *)p1;
   NumericRangeEntry *e2 = (NumericRangeEntry *)p2;
@@ -73,8 +73,23 @@ typedef struct {
 
   uint32_t uniqueId;
 
+  // Set when a compaction step found nothing to compact, until the tree's leaves change again.
+  // NumericRangeTree_NeedsCompaction returns 0 meanwhile, so the fork GC stops retrying
+  int compactStalled;
 } NumericRangeTree;
 
+/* Structural statistics of a numeric range tree, used to decide when to compact it */
+typedef struct {
+  size_t numLeaves;
+  // leaves whose ranges hold no entries, e.g. after their documents were garbage collected
+  size_t emptyLeaves;
+  // the depths of the shallowest and the deepest leaves
+  size_t minDepth;
+  size_t maxDepth;
+  // the average number of entries per leaf, relative to the leaf size of a compacted tree
+  double fill;
+} NumericRangeTreeStats;
+
 #define NumericRangeNode_IsLeaf(n) (n->left == NULL && n->right == NULL)
 
 struct indexIterator *NewNumericRangeIterator(const IndexSpec *sp, NumericRange *nr,
@@ -88,6 +103,10 @@ struct indexIterator *NewNumericFilterIterator(RedisSearchCtx *ctx, const Numeri
  * No deduplication is done */
 size_t NumericRange_Add(NumericRange *r, t_docId docId, double value, int checkCard);
 
+/* Remove a document's entry from a range, updating the range's cardinality if checkCard is set.
+ * Returns 0 if the range does not hold the document */
+int NumericRange_Delete(NumericRange *r, t_docId docId, double value, int checkCard);
+
 /* Split n into two ranges, lp for left, and rp for right. We split by the median score */
 double NumericRange_Split(NumericRange *n, NumericRangeNode **lp, NumericRangeNode **rp);
 
@@ -98,6 +117,10 @@ NumericRangeNode *NewLeafNode(size_t cap, double min, double max, size_t splitCa
  * Returns 0 if no nodes were split, 1 if we splitted nodes */
 NRN_AddRv NumericRangeNode_Add(NumericRangeNode *n, t_docId docId, double value);
 
+/* Remove a document's entry from the ranges along the path of its value. Returns 0 if its leaf
+ * does not hold the document */
+int NumericRangeNode_Delete(NumericRangeNode *n, t_docId docId, double value);
+
 /* Recursively find all the leaves under a node that correspond to a given min-max range. Returns a
  * vector with range node pointers.  */
 Vector *NumericRangeNode_FindRange(NumericRangeNode *n, double min, double max);
@@ -111,18 +134,54 @@ NumericRangeTree *NewNumericRangeTree();
 /* Add a value to a tree. Returns 0 if no nodes were split, 1 if we splitted nodes */
 size_t NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value);
 
+/* Add a value of a document which may be older than the last document of the tree, as when a
+ * document is updated in place and keeps its id. Returns the size added, 0 if the tree already
+ * holds the document */
+size_t NumericRangeTree_Insert(NumericRangeTree *t, t_docId docId, double value);
+
+/* Remove a document's value from the tree. The value must be the one the document was indexed
+ * with. Returns 0 if the tree does not hold the document with this value */
+int NumericRangeTree_Delete(NumericRangeTree *t, t_docId docId, double value);
+
 /* Recursively find all the leaves under tree's root, that correspond to a given min-max range.
  * Returns a vector with range node pointers. */
 Vector *NumericRangeTree_Find(NumericRangeTree *t, double min, double max);
 
+/* The ranges of the tree's leaves, ordered by their values. The values of a leaf are all greater
+ * than those of the leaves before it. Returns an array to be freed with array_free */
+NumericRange **NumericRangeTree_GetLeaves(NumericRangeTree *t);
+
 /* Free the tree and all nodes */
 void NumericRangeTree_Free(NumericRangeTree *t);
 
+void NumericRangeTree_GetStats(NumericRangeTree *t, NumericRangeTreeStats *stats);
+
+/* Returns 1 if enough of the tree's leaves are empty or underfilled to make compacting it
+ * worthwhile, unless the last compaction step could not compact any of them */
+int NumericRangeTree_NeedsCompaction(NumericRangeTree *t);
+
+/* Rebuild the tree from its current entries into a balanced tree with evenly filled leaves,
+ * dropping empty ranges. This invalidates all the nodes and ranges of the tree */
+void NumericRangeTree_Compact(NumericRangeTree *t);
+
+// The number of entries compacted by the fork GC on each of its runs
+#define NR_COMPACT_STEP_ENTRIES 200000
+
+/* Compact the tree a part at a time: rebuild the largest subtrees whose entries would fit in half of
+ * their leaves, as long as they hold no more than maxEntries entries in total. Returns 1 if any
+ * subtree was rebuilt, in which case the nodes and ranges of the tree are invalidated like by
+ * NumericRangeTree_Compact. Otherwise the tree no longer needs compaction until its leaves change */
+int NumericRangeTree_CompactStep(NumericRangeTree *t, size_t maxEntries);
+
 extern RedisModuleType *NumericIndexType;
 
 NumericRangeTree *OpenNumericIndex(RedisSearchCtx *ctx, RedisModuleString *keyName,
                                    RedisModuleKey **idxKey);
 
+/* Open the tree of a numeric field for reading. Returns NULL if the field has no tree yet */
+NumericRangeTree *OpenNumericIndexForRead(RedisSearchCtx *ctx, const char *fieldName,
+                                          FieldType forType);
+
 int NumericIndexType_Register(RedisModuleCtx *ctx);
 void *NumericIndexType_RdbLoad(RedisModuleIO *rdb, int encver);
 void NumericIndexType_RdbSave(RedisModuleIO *rdb, void *value);
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "rmalloc.h"
+#include "term_cache.h"
 
 static void PhoneticManager_AddPrefix(char** phoneticTerm) {
   if (!phoneticTerm || !(*phoneticTerm)) {
@@ -14,14 +15,50 @@ static void PhoneticManager_AddPrefix(char** phoneticTerm) {
   *phoneticTerm[0] = PHONETIC_PREFIX;
 }
 
+static char *PhoneticManager_Dup(const char *code) {
+  return *code ? rm_strdup(code) : NULL;
+}
+
 void PhoneticManager_ExpandPhonetics(PhoneticManagerCtx* ctx, const char* term, size_t len,
                                      char** primary, char** secondary) {
+  // The cache holds both codes, each with its prefix and NUL terminated, an empty code standing for
+  // none. There is a single algorithm for all the languages, so the language is not part of the key
+  const char *cached;
+  size_t cachedLen;
+  if (TermCache_Get(TermCache_Phonetics, 0, term, len, &cached, &cachedLen)) {
+    if (primary) {
+      *primary = PhoneticManager_Dup(cached);
+    }
+    if (secondary) {
+      *secondary = PhoneticManager_Dup(cached + strlen(cached) + 1);
+    }
+    return;
+  }
+
   // currently ctx is irrelevant we support only one universal algorithm for all 4 languages
   // this phonetic manager was built for future thinking and easily add more algorithms
   char bufTmp[len + 1];
   bufTmp[len] = 0;
   memcpy(bufTmp, term, len);
-  DoubleMetaphone(bufTmp, primary, secondary);
-  PhoneticManager_AddPrefix(primary);
-  PhoneticManager_AddPrefix(secondary);
+  char *p = NULL, *s = NULL;
+  DoubleMetaphone(bufTmp, &p, &s);
+  PhoneticManager_AddPrefix(&p);
+  PhoneticManager_AddPrefix(&s);
+
+  size_t plen = p ? strlen(p) : 0, slen = s ? strlen(s) : 0;
+  char codes[plen + slen + 2];
+  memcpy(codes, p ? p : "", plen + 1);
+  memcpy(codes + plen + 1, s ? s : "", slen + 1);
+  TermCache_Put(TermCache_Phonetics, 0, term, len, codes, plen + slen + 2);
+
+  if (primary) {
+    *primary = p;
+  } else {
+    rm_free(p);
+  }
+  if (secondary) {
+    *secondary = s;
+  } else {
+    rm_free(s);
+  }
 }
@@ -4,6 +4,10 @@
 
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define PHONETIC_PREFIX '<'
 
 typedef struct {
@@ -14,4 +18,8 @@ typedef struct {
 void PhoneticManager_ExpandPhonetics(PhoneticManagerCtx* ctx, const char* term, size_t len,
                                      char** primary, char** secondary);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* SRC_PHONETIC_MANAGER_H_ */
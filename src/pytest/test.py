@@ -769,6 +769,32 @@ def testSortBy(env):
         env.assertListEqual([100L, 'doc99', '$hello099 world', 'doc98', '$hello098 world', 'doc97', '$hello097 world', 'doc96',
                               '$hello096 world', 'doc95', '$hello095 world'], res)
 
+def testSortByWithoutCount(env):
+    r = env
+    env.assertOk(r.execute_command(
+        'ft.create', 'idx', 'ON', 'HASH', 'schema', 'foo', 'text', 'sortable', 'bar', 'numeric', 'sortable',
+        'baz', 'numeric', 'sortable', 'noindex'))
+    N = 1000
+    for i in range(N):
+        fields = ['foo', 'hello%03d world' % i]
+        if i % 10:
+            fields += ['bar', (i * 37) % 101, 'baz', (i * 41) % 103]
+        env.assertOk(r.execute_command('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields', *fields))
+    for _ in r.retry_with_rdb_reload():
+        waitForIndex(r, 'idx')
+        # baz is not indexed, and is sorted as any other field
+        for field in ('bar', 'baz'):
+            for order in ('asc', 'desc'):
+                for query in ('world', '*', '-hello001'):
+                    for limit in (1, 10, 200):
+                        args = ['ft.search', 'idx', query, 'nocontent', 'sortby', field, order, 'limit', 0, limit]
+                        res = r.execute_command(*args)
+                        fast = r.execute_command(*(args + ['withoutcount']))
+                        # the same results, but only the documents read are counted
+                        env.assertEqual(res[1:], fast[1:])
+                        env.assertGreaterEqual(fast[0], len(fast) - 1)
+                        env.assertLessEqual(fast[0], res[0])
+
 def testNot(env):
     r = env
     env.assertOk(r.execute_command(
@@ -1032,6 +1058,79 @@ def testGeo(env):
             'heathrow', -0.44155, 51.45865, '5', 'km')
         env.assertListEqual(sorted(res), sorted(res2))
 
+def testGeoKnn(env):
+    r = env
+    env.assertOk(r.execute_command('ft.create', 'idx', 'ON', 'HASH',
+                                    'schema', 'name', 'text', 'location', 'geo'))
+
+    for i, hotel in enumerate(hotels):
+        env.assertOk(r.execute_command('ft.add', 'idx', 'hotel{}'.format(i), 1.0, 'fields', 'name',
+                                        hotel[0], 'location', '{},{}'.format(hotel[2], hotel[1])))
+
+    for _ in r.retry_with_rdb_reload():
+        waitForIndex(env, 'idx')
+        # the five heathrow hotels within 10km are its five nearest neighbours
+        res = r.execute_command('ft.search', 'idx', 'heathrow', 'geofilter', 'location',
+                                -0.44155, 51.45865, 10, 'km', 'NOCONTENT')
+        env.assertEqual(5, res[0])
+        knn = r.execute_command('ft.search', 'idx', 'heathrow', 'geoknn', 'location',
+                                -0.44155, 51.45865, 5, 'km', 'RETURN', 1, '__location_distance')
+        env.assertEqual(5, knn[0])
+        env.assertEqual('hotel94', knn[1])
+        env.assertEqual(sorted(res[1:]), sorted(knn[1::2]))
+        distances = [float(fields[1]) for fields in knn[2::2]]
+        env.assertEqual(sorted(distances), distances)
+        env.assertLess(distances[0], 0.01)
+        env.assertLess(distances[-1], 10)
+
+        # only the nearest neighbours matching the query are returned
+        knn = r.execute_command('ft.search', 'idx', 'hilton', 'geoknn', 'location',
+                                -0.1757, 51.5156, 3, 'm', 'NOCONTENT')
+        env.assertEqual([3L, 'hotel2', 'hotel21', 'hotel79'], [knn[0]] + sorted(knn[1:]))
+
+        # more neighbours than documents
+        knn = r.execute_command('ft.search', 'idx', '*', 'geoknn', 'location',
+                                -0.1757, 51.5156, 1000, 'km', 'NOCONTENT', 'LIMIT', 0, 0)
+        env.assertEqual([len(hotels)], knn)
+
+    env.expect('ft.search idx hilton geoknn location -0.1757 51.5156 0 km').error()   \
+            .contains('Bad arguments for <k>')
+    env.expect('ft.search idx hilton geoknn location -0.1757 51.5156 3').error()   \
+            .contains('GEOKNN requires 5 arguments')
+    env.expect('ft.search idx hilton geoknn name -0.1757 51.5156 3 km').error()   \
+            .contains('`name` is not a geo field')
+
+def testVectorKnn(env):
+    import struct
+    r = env
+    env.assertOk(r.execute_command('ft.create', 'idx', 'ON', 'HASH', 'schema', 'name', 'text',
+                                    'v', 'vector', 'hnsw', 'dim', 2, 'distance_metric', 'l2'))
+    vec = lambda x, y: struct.pack('<2f', x, y)
+    for i in range(100):
+        r.execute_command('hset', 'doc%d' % i, 'name', 'even' if i % 2 == 0 else 'odd',
+                          'v', vec(i, i))
+    env.expect('ft.add', 'idx', 'bad', 1.0, 'fields', 'v', struct.pack('<3f', 1, 2, 3)).error()
+
+    for _ in r.retry_with_rdb_reload():
+        waitForIndex(env, 'idx')
+        res = r.execute_command('ft.search', 'idx', '*', 'vectorknn', 'v', 3, vec(10.2, 10.2),
+                                'RETURN', 1, '__v_score')
+        env.assertEqual(3, res[0])
+        env.assertEqual(['doc10', 'doc11', 'doc9'], res[1::2])
+        env.assertAlmostEqual(0.08, float(res[2][1]), 1E-4)
+
+        # the nearest neighbours are searched among the query's matches
+        res = r.execute_command('ft.search', 'idx', 'odd', 'vectorknn', 'v', 2, vec(10.2, 10.2),
+                                'NOCONTENT')
+        env.assertEqual([2L, 'doc11', 'doc9'], res)
+
+    env.expect('ft.search', 'idx', '*', 'vectorknn', 'v', 3, struct.pack('<3f', 1, 2, 3)).error() \
+            .contains('Query vector must have 2 elements')
+    env.expect('ft.search', 'idx', '*', 'vectorknn', 'name', 3, vec(1, 1)).error() \
+            .contains('`name` is not a vector field')
+    env.expect('ft.create', 'idx2', 'schema', 'v', 'vector', 'flat', 'dim', 4, 'sortable').error() \
+            .contains('Vector fields cannot be SORTABLE')
+
 def testTagErrors(env):
     env.expect("ft.create", "test", 'ON', 'HASH',
                 "SCHEMA",  "tags", "TAG").equal('OK')
@@ -32,6 +32,7 @@ def testGetConfigOptions(env):
     assert env.expect('ft.config', 'get', 'FORK_GC_RUN_INTERVAL').res[0][0] =='FORK_GC_RUN_INTERVAL'
     assert env.expect('ft.config', 'get', 'FORK_GC_CLEAN_THRESHOLD').res[0][0] =='FORK_GC_CLEAN_THRESHOLD'
     assert env.expect('ft.config', 'get', 'FORK_GC_RETRY_INTERVAL').res[0][0] =='FORK_GC_RETRY_INTERVAL'
+    assert env.expect('ft.config', 'get', 'FORK_GC_THREADS').res[0][0] =='FORK_GC_THREADS'
     assert env.expect('ft.config', 'get', '_MAX_RESULTS_TO_UNSORTED_MODE').res[0][0] =='_MAX_RESULTS_TO_UNSORTED_MODE'
     assert env.expect('ft.config', 'get', 'PARTIAL_INDEXED_DOCS').res[0][0] =='PARTIAL_INDEXED_DOCS'
 
@@ -95,9 +96,11 @@ def testAllConfig(env):
     env.assertEqual(res_dict['FORK_GC_RUN_INTERVAL'][0], '30')
     env.assertEqual(res_dict['FORK_GC_CLEAN_THRESHOLD'][0], '100')
     env.assertEqual(res_dict['FORK_GC_RETRY_INTERVAL'][0], '5')
+    env.assertEqual(res_dict['FORK_GC_THREADS'][0], '1')
     env.assertEqual(res_dict['CURSOR_MAX_IDLE'][0], '300000')
     env.assertEqual(res_dict['NO_MEM_POOLS'][0], 'false')
     env.assertEqual(res_dict['PARTIAL_INDEXED_DOCS'][0], 'false')
+    env.assertEqual(res_dict['TERM_CACHE_SIZE'][0], '1024')
 
     # skip ctest configured tests
     #env.assertEqual(res_dict['GC_POLICY'][0], 'fork')
@@ -126,7 +129,9 @@ def testInitConfig(env):
     test_arg_num('FORK_GC_RUN_INTERVAL', 3)
     test_arg_num('FORK_GC_CLEAN_THRESHOLD', 3)
     test_arg_num('FORK_GC_RETRY_INTERVAL', 3)
+    test_arg_num('FORK_GC_THREADS', 4)
     test_arg_num('_MAX_RESULTS_TO_UNSORTED_MODE', 3)
+    test_arg_num('TERM_CACHE_SIZE', 0)
 
     # True/False arguments
     def test_arg_true(arg_name):
@@ -27,7 +27,7 @@ class TestDebugCommands(object):
         err_msg = "wrong number of arguments for 'FT.DEBUG' command"
         help_list = ['DUMP_INVIDX', 'DUMP_NUMIDX', 'DUMP_TAGIDX', 'INFO_TAGIDX', 'IDTODOCID', 'DOCIDTOID', 'DOCINFO',
                     'DUMP_PHONETIC_HASH', 'DUMP_TERMS', 'INVIDX_SUMMARY', 'NUMIDX_SUMMARY',
-                    'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GIT_SHA', 'TTL']
+                    'NUMIDX_REBUILD', 'GC_FORCEINVOKE', 'GC_FORCEBGINVOKE', 'GIT_SHA', 'TTL']
         self.env.expect('FT.DEBUG', 'help').equal(help_list)
 
         for cmd in help_list:
@@ -161,11 +161,34 @@ class TestDebugCommands(object):
         self.env.expect('FT.DEBUG', 'invidx_summary', 'idx1').raiseError()
 
     def testNumericIdxIndexSummary(self):
-        self.env.expect('FT.DEBUG', 'numidx_summary', 'idx', 'age').equal(['numRanges', 1L, 'numEntries', 1L,
-                                                                           'lastDocId', 1L, 'revisionId', 0L])
-
-        self.env.expect('FT.DEBUG', 'NUMIDX_SUMMARY', 'idx', 'age').equal(['numRanges', 1L, 'numEntries', 1L,
-                                                                           'lastDocId', 1L, 'revisionId', 0L])
+        summary = ['numRanges', 1L, 'numEntries', 1L, 'lastDocId', 1L, 'revisionId', 0L,
+                   'numLeaves', 1L, 'emptyLeaves', 0L, 'depth', 0L, 'skew', 0L, 'fill']
+        res = self.env.cmd('FT.DEBUG', 'numidx_summary', 'idx', 'age')
+        self.env.assertEqual(res[:-1], summary)
+        self.env.assertGreater(float(res[-1]), 0)
+
+        res = self.env.cmd('FT.DEBUG', 'NUMIDX_SUMMARY', 'idx', 'age')
+        self.env.assertEqual(res[:-1], summary)
+
+    def testNumericIdxRebuild(self):
+        self.env.expect('FT.CREATE', 'rebuild_idx', 'ON', 'HASH', 'SCHEMA', 'n', 'NUMERIC').ok()
+        waitForIndex(self.env, 'rebuild_idx')
+        for i in range(1000):
+            self.env.cmd('HSET', 'rdoc%d' % i, 'n', i)
+        for i in range(900):
+            self.env.cmd('DEL', 'rdoc%d' % i)
+        self.env.cmd('FT.DEBUG', 'GC_FORCEINVOKE', 'rebuild_idx')
+
+        self.env.expect('FT.DEBUG', 'NUMIDX_REBUILD', 'rebuild_idx', 'n').equal(1L)
+        res = self.env.cmd('FT.DEBUG', 'NUMIDX_SUMMARY', 'rebuild_idx', 'n')
+        summary = dict(zip(res[::2], res[1::2]))
+        self.env.assertEqual(summary['numEntries'], 100L)
+        self.env.assertEqual(summary['emptyLeaves'], 0L)
+        self.env.assertEqual(summary['depth'], 0L)
+        self.env.expect('FT.SEARCH', 'rebuild_idx', '@n:[950 +inf]', 'LIMIT', 0, 0).equal([50L])
+
+    def testNumericIdxRebuildWrongArity(self):
+        self.env.expect('FT.DEBUG', 'numidx_rebuild', 'idx').raiseError()
 
     def testUnexistsNumericIndexSummary(self):
         self.env.expect('FT.DEBUG', 'numidx_summary', 'idx', 'age1').raiseError()
@@ -444,6 +444,42 @@ def testHDel(env):
     env.expect('FT.DEBUG docidtoid idx doc1').equal(2)
     env.expect('FT.SEARCH idx bar').equal([1L, 'doc1', ['test2', 'bar']])
 
+def testPartialInPlace(env):
+    if env.env == 'existing-env':
+        env.skip()
+    env.skipOnCluster()
+    env = Env(moduleArgs='PARTIAL_INDEXED_DOCS 1')
+
+    env.expect('FT.CREATE idx SCHEMA title TEXT views NUMERIC SORTABLE tags TAG').equal('OK')
+    env.expect('HSET doc1 title hello views 1 tags foo').equal(3)
+    env.expect('HSET doc2 title world views 2 tags bar').equal(3)
+    env.expect('FT.DEBUG docidtoid idx doc1').equal(1)
+
+    # numeric, tag and sortable changes keep the document's id
+    env.expect('HINCRBY doc1 views 41').equal(42)
+    env.expect('HSET doc1 tags bar').equal(0)
+    env.expect('FT.DEBUG docidtoid idx doc1').equal(1)
+    env.expect('FT.SEARCH idx @views:[42 42] NOCONTENT').equal([1L, 'doc1'])
+    env.expect('FT.SEARCH idx @views:[1 1] NOCONTENT').equal([0L])
+    env.expect('FT.SEARCH idx @tags:{foo} NOCONTENT').equal([0L])
+    env.expect('FT.SEARCH idx @tags:{bar} NOCONTENT SORTBY views DESC').equal([2L, 'doc1', 'doc2'])
+    env.expect('FT.SEARCH idx hello NOCONTENT').equal([1L, 'doc1'])
+    info = env.cmd('FT.INFO idx')
+    info = {info[i]: info[i + 1] for i in range(0, len(info), 2)}
+    env.assertEqual(2, float(info['num_in_place_updates']))
+
+    # a deleted numeric field leaves the document out of its index
+    env.expect('HDEL doc1 views').equal(1)
+    env.expect('FT.DEBUG docidtoid idx doc1').equal(1)
+    env.expect('FT.SEARCH idx @views:[-inf +inf] NOCONTENT').equal([1L, 'doc2'])
+
+    # text changes reindex the whole document
+    env.expect('HSET doc1 title bye').equal(0)
+    env.expect('FT.DEBUG docidtoid idx doc1').equal(3)
+    env.expect('FT.SEARCH idx bye NOCONTENT').equal([1L, 'doc1'])
+    res = env.cmd('FT.SEARCH idx @tags:{bar} NOCONTENT')
+    env.assertEqual(sorted(res[1:]), ['doc1', 'doc2'])
+
 def testRestore(env):
     if env.env == 'existing-env':
         env.skip()
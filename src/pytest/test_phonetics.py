@@ -106,3 +106,29 @@ def testIssue1313(env):
 
     env.expect('FT.CREATE test1 ON HASH SCHEMA topic TEXT PHONETIC dm:en topic2 TEXT NOINDEX').ok()
     env.expect('FT.SEARCH', 'test1', '@topic:(tmp)=>{$phonetic: true}').equal([0])
+
+def testTermCache(env):
+    env.skipOnCluster()
+    def cacheStats():
+        res = env.cmd('ft.info', 'idx')
+        res = {res[i]: res[i + 1] for i in range(0, len(res), 2)}
+        stats = res['term_cache_stats']
+        return {stats[i]: float(stats[i + 1]) for i in range(0, len(stats), 2)}
+
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH',
+                         'schema', 'text', 'TEXT', 'PHONETIC', 'dm:en'))
+    before = cacheStats()
+    for i in range(10):
+        env.assertOk(env.cmd('ft.add', 'idx', 'doc%d' % i, 1.0, 'fields',
+                             'text', 'running morfix gardens'))
+    after = cacheStats()
+    env.assertGreater(after['stem_hits'], before['stem_hits'])
+    env.assertGreater(after['phonetic_hits'], before['phonetic_hits'])
+    env.assertGreater(after['stem_hit_rate'], 0)
+
+    # the cached stems and phonetic codes are those computed without the cache
+    res = env.cmd('ft.search', 'idx', 'morphix runs', 'NOCONTENT')
+    env.expect('ft.config', 'set', 'TERM_CACHE_SIZE', 0).ok()
+    env.expect('ft.search', 'idx', 'morphix runs', 'NOCONTENT').equal(res)
+    env.assertEqual(res[0], 10)
+    env.expect('ft.config', 'set', 'TERM_CACHE_SIZE', 1024).ok()
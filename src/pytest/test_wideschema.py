@@ -42,4 +42,43 @@ def testWideSchema(env):
     if not env.isCluster():
         # todo: make it less specific to pass on cluster
         res = env.cmd('ft.info', 'idx')
-        env.assertEqual(res[3][0], 'MAXTEXTFIELDS')
\ No newline at end of file
+        env.assertEqual(res[3][0], 'MAXTEXTFIELDS')
+
+def testFieldPostings(env):
+    schema = []
+    FIELDS = 40
+    for i in range(FIELDS):
+        schema.extend(('field_%d' % i, 'TEXT'))
+    env.assertOk(env.cmd('ft.create', 'idx', 'ON', 'HASH', 'PREFIX', 1, 'doc',
+                         'FIELDPOSTINGS', 'schema', *schema))
+    env.assertOk(env.cmd('ft.create', 'ref', 'ON', 'HASH', 'PREFIX', 1, 'doc', 'schema', *schema))
+    env.assertIn('FIELDPOSTINGS', env.cmd('ft.info', 'idx')[3])
+
+    N = 50
+    for n in range(N):
+        # every document has "hello" in a single field, and "world" in all the fields
+        fields = ['field_%d' % i for i in range(FIELDS)]
+        args = []
+        for i, f in enumerate(fields):
+            args.extend((f, 'hello world' if i == n % FIELDS else 'world'))
+        env.cmd('hset', 'doc%d' % n, *args)
+
+    for _ in env.reloading_iterator():
+        waitForIndex(env, 'idx')
+        waitForIndex(env, 'ref')
+        for i in range(FIELDS):
+            q = '@field_%d:hello' % i
+            res = env.cmd('ft.search', 'idx', q, 'NOCONTENT', 'WITHSCORES')
+            env.assertEqual(res, env.cmd('ft.search', 'ref', q, 'NOCONTENT', 'WITHSCORES'))
+            env.assertEqual(res[0], 2 if i < N % FIELDS else 1)
+
+        q = '@field_0|field_1:hello @field_3:world'
+        env.assertEqual(env.cmd('ft.search', 'idx', q, 'NOCONTENT', 'WITHSCORES'),
+                        env.cmd('ft.search', 'ref', q, 'NOCONTENT', 'WITHSCORES'))
+
+    # deleted documents are removed from the per-field postings by the gc
+    for n in range(0, N, 2):
+        env.cmd('del', 'doc%d' % n)
+    env.cmd('ft.debug', 'GC_FORCEINVOKE', 'idx')
+    res = env.cmd('ft.search', 'idx', '@field_1:hello', 'NOCONTENT')
+    env.assertEqual(sorted(res[1:]), ['doc1', 'doc41'])
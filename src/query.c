@@ -16,6 +16,8 @@
 #include "ext/default.h"
 #include "rmutil/sds.h"
 #include "tag_index.h"
+#include "vector_index.h"
+#include "suffix_index.h"
 #include "err.h"
 #include "concurrent_ctx.h"
 #include "numeric_index.h"
@@ -63,7 +65,7 @@ void QueryNode_Free(QueryNode *n) {
 
       break;  //
     case QN_PREFX:
-      QueryTokenNode_Free(&n->pfx);
+      QueryTokenNode_Free(&n->pfx.tok);
       break;
     case QN_GEO:
       if (n->gn.gf) {
@@ -89,6 +91,7 @@ void QueryNode_Free(QueryNode *n) {
     case QN_OPTIONAL:
     case QN_NULL:
     case QN_PHRASE:
+    case QN_VECTOR:  // the vector query is owned by the search options
       break;
   }
   rm_free(n);
@@ -132,11 +135,15 @@ QueryNode *NewTokenNode(QueryParseCtx *q, const char *s, size_t len) {
   return ret;
 }
 
-QueryNode *NewPrefixNode(QueryParseCtx *q, const char *s, size_t len) {
+QueryNode *NewPrefixNode(QueryParseCtx *q, const char *s, size_t len, bool prefix, bool suffix) {
   QueryNode *ret = NewQueryNode(QN_PREFX);
   q->numTokens++;
 
-  ret->pfx = (QueryPrefixNode){.str = (char *)s, .len = len, .expanded = 0, .flags = 0};
+  ret->pfx = (QueryPrefixNode){
+      .tok = {.str = (char *)s, .len = len, .expanded = 0, .flags = 0},
+      .prefix = prefix,
+      .suffix = suffix,
+  };
   return ret;
 }
 
@@ -218,6 +225,13 @@ void QAST_SetGlobalFilters(QueryAST *ast, const QAST_GlobalFilterOptions *option
     n->fn.len = options->nids;
     setFilterNode(ast, n);
   }
+  if (options->vector && ast->root) {
+    // the nearest neighbours are searched among the matches of the whole query
+    QueryNode *n = NewQueryNode(QN_VECTOR);
+    n->vn.vq = options->vector;
+    QueryNode_AddChild(n, ast->root);
+    ast->root = n;
+  }
 }
 
 static void QueryNode_Expand(RSQueryTokenExpander expander, RSQueryExpanderCtx *expCtx,
@@ -234,7 +248,7 @@ static void QueryNode_Expand(RSQueryTokenExpander expander, RSQueryExpanderCtx *
   if (qn->type == QN_TOKEN) {
     expCtx->currentNode = pqn;
     expander(expCtx, &qn->tn);
-  } else if (qn->type == QN_UNION ||
+  } else if (qn->type == QN_UNION || qn->type == QN_VECTOR ||
              (qn->type == QN_PHRASE && !qn->pn.exact)) {  // do not expand exact phrases
     expandChildren = 1;
   }
@@ -329,20 +343,59 @@ static IndexIterator *iterateExpandedTerms(QueryEvalCtx *q, Trie *terms, const c
   }
   return NewUnionIterator(its, itsSz, q->docTable, 1, opts->weight);
 }
+/* Whether the postings of a prefix answer a prefix query: every text field the query searches
+ * must keep postings for prefixes of that many letters */
+static int hasPrefixPostings(const IndexSpec *spec, const char *str, size_t len,
+                             t_fieldMask fieldMask) {
+  if (!spec->prefixes) {
+    return 0;
+  }
+  size_t letters = 0;
+  for (size_t i = 0; i < len; i++) {
+    letters += (str[i] & 0xC0) != 0x80;
+  }
+  int nfields = 0;
+  for (int i = 0; i < spec->numFields; i++) {
+    const FieldSpec *fs = spec->fields + i;
+    if (!FIELD_IS(fs, INDEXFLD_T_FULLTEXT) || !FieldSpec_IsIndexable(fs) ||
+        !(fieldMask & FIELD_BIT(fs))) {
+      continue;
+    }
+    if (fs->prefixIndexLen < letters) {
+      return 0;
+    }
+    nfields++;
+  }
+  return nfields > 0;
+}
+
 /* Ealuate a prefix node by expanding all its possible matches and creating one big UNION on all
  * of them */
 static IndexIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
   RS_LOG_ASSERT(qn->type == QN_PREFX, "query node type should be prefix");
 
   // we allow a minimum of 2 letters in the prefx by default (configurable)
-  if (qn->pfx.len < RSGlobalConfig.minTermPrefix) {
+  if (qn->pfx.tok.len < RSGlobalConfig.minTermPrefix) {
     return NULL;
   }
   Trie *terms = q->sctx->spec->terms;
 
   if (!terms) return NULL;
 
-  return iterateExpandedTerms(q, terms, qn->pfx.str, qn->pfx.len, 0, 1, &qn->opts);
+  // read the pre-merged postings of the prefix rather than expanding it, when there are any
+  t_fieldMask fieldMask = EFFECTIVE_FIELDMASK(q, qn);
+  if (hasPrefixPostings(q->sctx->spec, qn->pfx.tok.str, qn->pfx.tok.len, fieldMask)) {
+    RSToken tok = {.str = qn->pfx.tok.str, .len = qn->pfx.tok.len};
+    RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
+    IndexReader *ir = Redis_OpenPrefixReader(q->sctx, term, fieldMask, q->conc, qn->opts.weight);
+    if (!ir) {
+      Term_Free(term);
+      return NULL;
+    }
+    return NewReadIterator(ir);
+  }
+
+  return iterateExpandedTerms(q, terms, qn->pfx.tok.str, qn->pfx.tok.len, 0, 1, &qn->opts);
 }
 
 typedef struct {
@@ -378,7 +431,7 @@ static void rangeIterCbStrs(const char *r, size_t n, void *p, void *invidx) {
   rangeItersAddIterator(ctx, ir);
 }
 
-static void rangeIterCb(const rune *r, size_t n, void *p) {
+static int rangeIterCb(const rune *r, size_t n, void *p) {
   LexRangeCtx *ctx = p;
   QueryEvalCtx *q = ctx->q;
   RSToken tok = {0};
@@ -389,10 +442,11 @@ static void rangeIterCb(const rune *r, size_t n, void *p) {
   rm_free(tok.str);
   if (!ir) {
     Term_Free(term);
-    return;
+    return 1;
   }
 
   rangeItersAddIterator(ctx, ir);
+  return 1;
 }
 
 static IndexIterator *Query_EvalLexRangeNode(QueryEvalCtx *q, QueryNode *lx) {
@@ -416,8 +470,8 @@ static IndexIterator *Query_EvalLexRangeNode(QueryEvalCtx *q, QueryNode *lx) {
     end = strToFoldedRunes(lx->lxrng.end, &nend);
   }
 
-  TrieNode_IterateRange(t->root, begin, begin ? nbegin : -1, lx->lxrng.includeBegin, end,
-                        end ? nend : -1, lx->lxrng.includeEnd, rangeIterCb, &ctx);
+  Trie_IterateRange(t, begin, begin ? nbegin : -1, lx->lxrng.includeBegin, end, end ? nend : -1,
+                    lx->lxrng.includeEnd, rangeIterCb, &ctx);
   rm_free(begin);
   rm_free(end);
   if (!ctx.its || ctx.nits == 0) {
@@ -428,6 +482,116 @@ static IndexIterator *Query_EvalLexRangeNode(QueryEvalCtx *q, QueryNode *lx) {
   }
 }
 
+/* Whether the suffix index answers a suffix or contains query: every text field the query searches
+ * must be declared WITHSUFFIXTRIE */
+static int hasSuffixIndex(const IndexSpec *spec, t_fieldMask fieldMask) {
+  if (!spec->suffix) {
+    return 0;
+  }
+  int nfields = 0;
+  for (int i = 0; i < spec->numFields; i++) {
+    const FieldSpec *fs = spec->fields + i;
+    if (!FIELD_IS(fs, INDEXFLD_T_FULLTEXT) || !FieldSpec_IsIndexable(fs) ||
+        !(fieldMask & FIELD_BIT(fs))) {
+      continue;
+    }
+    if (!FieldSpec_HasSuffixTrie(fs)) {
+      return 0;
+    }
+    nfields++;
+  }
+  return nfields > 0;
+}
+
+typedef struct {
+  LexRangeCtx range;
+  const char *str;
+  size_t len;
+  int contains;
+} SuffixCtx;
+
+/* Open a reader for a term matching a suffix node. Returns 0 once the expansion limit is reached */
+static int suffixIterCbStrs(const char *s, size_t n, void *p) {
+  SuffixCtx *ctx = p;
+  QueryEvalCtx *q = ctx->range.q;
+  size_t maxExpansions = q->sctx->spec->maxPrefixExpansions;
+  if (ctx->range.nits >= maxExpansions && maxExpansions != -1) {
+    return 0;
+  }
+  RSToken tok = {.str = (char *)s, .len = n};
+  RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
+  IndexReader *ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, 0,
+                                     q->opts->fieldmask & ctx->range.opts->fieldMask, q->conc, 1);
+  if (!ir) {
+    Term_Free(term);
+    return 1;
+  }
+  rangeItersAddIterator(&ctx->range, ir);
+  return 1;
+}
+
+static int suffixMatches(const char *s, size_t n, const char *str, size_t len, int contains) {
+  if (n < len) {
+    return 0;
+  }
+  if (!contains) {
+    return !memcmp(s + n - len, str, len);
+  }
+  for (size_t i = 0; i + len <= n; i++) {
+    if (!memcmp(s + i, str, len)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Without a suffix index, every term of the dictionary is checked, until the expansion limit is
+ * reached */
+static int suffixIterCb(const rune *r, size_t n, void *p) {
+  SuffixCtx *ctx = p;
+  if (n && IndexSpec_IsInternalTermStart(r[0])) {
+    return 1;
+  }
+  size_t len;
+  char *s = runesToStr(r, n, &len);
+  int rc = 1;
+  if (suffixMatches(s, len, ctx->str, ctx->len, ctx->contains)) {
+    rc = suffixIterCbStrs(s, len, ctx);
+  }
+  rm_free(s);
+  return rc;
+}
+
+/* Evaluate a suffix or contains node by expanding it to the matching terms, found through the
+ * suffix index when there is one, and creating a UNION of them */
+static IndexIterator *Query_EvalSuffixNode(QueryEvalCtx *q, QueryNode *qn) {
+  RS_LOG_ASSERT(qn->type == QN_PREFX && qn->pfx.suffix, "query node type should be suffix");
+
+  if (qn->pfx.tok.len < RSGlobalConfig.minTermPrefix) {
+    return NULL;
+  }
+  IndexSpec *spec = q->sctx->spec;
+  if (!spec->terms) return NULL;
+
+  SuffixCtx ctx = {.range = {.q = q, .opts = &qn->opts, .cap = 8},
+                   .str = qn->pfx.tok.str,
+                   .len = qn->pfx.tok.len,
+                   .contains = qn->pfx.prefix};
+  ctx.range.its = rm_malloc(sizeof(*ctx.range.its) * ctx.range.cap);
+
+  if (hasSuffixIndex(spec, EFFECTIVE_FIELDMASK(q, qn))) {
+    SuffixIndex_Find(spec->suffix, ctx.str, ctx.len, ctx.contains, suffixIterCbStrs, &ctx);
+  } else {
+    Trie_IterateRange(spec->terms, NULL, -1, false, NULL, -1, false, suffixIterCb, &ctx);
+  }
+
+  if (ctx.range.nits == 0) {
+    rm_free(ctx.range.its);
+    return NULL;
+  }
+  return NewUnionIterator(ctx.range.its, ctx.range.nits, q->docTable, 1, qn->opts.weight);
+}
+
 static IndexIterator *Query_EvalFuzzyNode(QueryEvalCtx *q, QueryNode *qn) {
   RS_LOG_ASSERT(qn->type == QN_FUZZY, "query node type should be fuzzy");
 
@@ -435,7 +599,8 @@ static IndexIterator *Query_EvalFuzzyNode(QueryEvalCtx *q, QueryNode *qn) {
 
   if (!terms) return NULL;
 
-  return iterateExpandedTerms(q, terms, qn->pfx.str, qn->pfx.len, qn->fz.maxDist, 0, &qn->opts);
+  return iterateExpandedTerms(q, terms, qn->fz.tok.str, qn->fz.tok.len, qn->fz.maxDist, 0,
+                              &qn->opts);
 }
 
 static IndexIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -491,6 +656,25 @@ static IndexIterator *Query_EvalWildcardNode(QueryEvalCtx *q, QueryNode *qn) {
   return NewWildcardIterator(q->docTable->maxDocId);
 }
 
+static IndexIterator *Query_EvalVectorNode(QueryEvalCtx *q, QueryNode *qn) {
+  const VectorQuery *vq = qn->vn.vq;
+  const FieldSpec *fs = IndexSpec_GetField(q->sctx->spec, vq->property, strlen(vq->property));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    return NULL;
+  }
+
+  // A wildcard child matches everything, so there is nothing to filter by
+  IndexIterator *child = NULL;
+  QueryNode *cn = QueryNode_GetChild(qn, 0);
+  if (cn && cn->type != QN_WILDCARD) {
+    child = Query_EvalNode(q, cn);
+    if (!child) {
+      return NULL;
+    }
+  }
+  return NewVectorKnnIterator(q->sctx, fs, vq, child);
+}
+
 static IndexIterator *Query_EvalNotNode(QueryEvalCtx *q, QueryNode *qn) {
   if (qn->type != QN_NOT) {
     return NULL;
@@ -607,12 +791,12 @@ static IndexIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
   }
 
   // we allow a minimum of 2 letters in the prefx by default (configurable)
-  if (qn->pfx.len < q->sctx->spec->minPrefix) {
+  if (qn->pfx.tok.len < q->sctx->spec->minPrefix) {
     return NULL;
   }
   if (!idx || !idx->values) return NULL;
 
-  TrieMapIterator *it = TrieMap_Iterate(idx->values, qn->pfx.str, qn->pfx.len);
+  TrieMapIterator *it = TrieMap_Iterate(idx->values, qn->pfx.tok.str, qn->pfx.tok.len);
   if (!it) return NULL;
 
   size_t itsSz = 0, itsCap = 8;
@@ -770,6 +954,9 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
     case QN_NOT:
       return Query_EvalNotNode(q, n);
     case QN_PREFX:
+      if (n->pfx.suffix) {
+        return Query_EvalSuffixNode(q, n);
+      }
       return Query_EvalPrefixNode(q, n);
     case QN_LEXRANGE:
       return Query_EvalLexRangeNode(q, n);
@@ -785,6 +972,8 @@ IndexIterator *Query_EvalNode(QueryEvalCtx *q, QueryNode *n) {
       return Query_EvalIdFilterNode(q, &n->fn);
     case QN_WILDCARD:
       return Query_EvalWildcardNode(q, n);
+    case QN_VECTOR:
+      return Query_EvalVectorNode(q, n);
     case QN_NULL:
       return NewEmptyIterator();
   }
@@ -941,7 +1130,7 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
   }
 
   if (qs->opts.fieldMask && qs->opts.fieldMask != RS_FIELDMASK_ALL && qs->type != QN_NUMERIC &&
-      qs->type != QN_GEO && qs->type != QN_IDS) {
+      qs->type != QN_GEO && qs->type != QN_IDS && qs->type != QN_VECTOR) {
     if (!spec) {
       s = sdscatprintf(s, "@%" PRIu64, (uint64_t)qs->opts.fieldMask);
     } else {
@@ -980,7 +1169,13 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       return s;
 
     case QN_PREFX:
-      s = sdscatprintf(s, "PREFIX{%s*", (char *)qs->pfx.str);
+      if (!qs->pfx.suffix) {
+        s = sdscatprintf(s, "PREFIX{%s*", qs->pfx.tok.str);
+      } else if (!qs->pfx.prefix) {
+        s = sdscatprintf(s, "SUFFIX{*%s", qs->pfx.tok.str);
+      } else {
+        s = sdscatprintf(s, "INFIX{*%s*", qs->pfx.tok.str);
+      }
       break;
 
     case QN_LEXRANGE:
@@ -1036,6 +1231,12 @@ static sds QueryNode_DumpSds(sds s, const IndexSpec *spec, const QueryNode *qs,
       s = sdscatprintf(s, "FUZZY{%s}\n", qs->fz.tok.str);
       return s;
 
+    case QN_VECTOR:
+      s = sdscatprintf(s, "VECTOR @%s KNN %zu {\n", qs->vn.vq->property, qs->vn.vq->k);
+      s = QueryNode_DumpChildren(s, spec, qs, depth + 1);
+      s = doPad(s, depth);
+      break;
+
     case QN_NULL:
       s = sdscat(s, "<empty>");
   }
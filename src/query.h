@@ -68,6 +68,9 @@ typedef struct {
   /** List of IDs to limit to, and the length of that array */
   t_docId *ids;
   size_t nids;
+
+  /** Nearest neighbour search over the matches of the whole query, set by VECTORKNN */
+  const struct VectorQuery *vector;
 } QAST_GlobalFilterOptions;
 
 /** Set global filters on the AST */
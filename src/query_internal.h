@@ -58,7 +58,7 @@ QueryNode *NewPhraseNode(int exact);
 #define NewNotNode(child) NewQueryNodeChildren(QN_NOT, &child, 1)
 #define NewOptionalNode(child) NewQueryNodeChildren(QN_OPTIONAL, &child, 1)
 
-QueryNode *NewPrefixNode(QueryParseCtx *q, const char *s, size_t len);
+QueryNode *NewPrefixNode(QueryParseCtx *q, const char *s, size_t len, bool prefix, bool suffix);
 QueryNode *NewFuzzyNode(QueryParseCtx *q, const char *s, size_t len, int maxDist);
 QueryNode *NewNumericNode(const struct NumericFilter *flt);
 QueryNode *NewIdFilterNode(const t_docId *, size_t);
@@ -1,6 +1,7 @@
 #ifndef __QUERY_NODE_H__
 #define __QUERY_NODE_H__
 #include <stdlib.h>
+#include <stdbool.h>
 #include "redisearch.h"
 #include "query_error.h"
 //#include "numeric_index.h"
@@ -9,6 +10,7 @@ struct RSQueryNode;
 struct numericFilter;
 struct geoFilter;
 struct idFilter;
+struct VectorQuery;
 
 /* The types of query nodes */
 typedef enum {
@@ -49,7 +51,10 @@ typedef enum {
   QN_LEXRANGE,
 
   /* Null term - take no action */
-  QN_NULL
+  QN_NULL,
+
+  /* Vector nearest neighbours among the matches of the child node */
+  QN_VECTOR
 } QueryNodeType;
 
 /* A prhase node represents a list of nodes with intersection between them, or a phrase in the case
@@ -76,7 +81,13 @@ typedef struct {
  * tokenizers. Later this gets passed to scoring functions in a Term object. See RSIndexRecord */
 typedef RSToken QueryTokenNode;
 
-typedef RSToken QueryPrefixNode;
+/* A prefix node matches the terms starting with its string (`foo*`). With `suffix` set it matches
+ * the terms ending with it instead (`*foo`), or containing it if `prefix` is set too (`*foo*`) */
+typedef struct {
+  RSToken tok;
+  bool prefix;
+  bool suffix;
+} QueryPrefixNode;
 
 typedef struct {
   RSToken tok;
@@ -92,6 +103,10 @@ typedef struct {
   const struct GeoFilter *gf;
 } QueryGeofilterNode;
 
+typedef struct {
+  const struct VectorQuery *vq;
+} QueryVectorNode;
+
 typedef struct {
   t_docId *ids;
   size_t len;
@@ -150,6 +165,7 @@ typedef struct RSQueryNode {
     QueryTagNode tag;
     QueryFuzzyNode fz;
     QueryLexRangeNode lxrng;
+    QueryVectorNode vn;
   };
 
   /* The node type, for resolving the union access */
@@ -95,6 +95,18 @@ static int one_not_null(void *a, void *b, void *out) {
         return NODENN_ONE_NULL;
     }
 }
+
+// A suffix (or contains) node from a star and the term that follows it. They must be adjacent, as
+// a star apart from a term is only valid as a query of its own
+static QueryNode *newSuffixNode(QueryParseCtx *ctx, QueryToken star, QueryToken tok, bool contains) {
+    if (star.pos + 1 != tok.pos) {
+        QueryError_SetErrorFmt(ctx->status, QUERY_ESYNTAX,
+            "Syntax error at offset %d near %.*s", tok.pos, tok.len, tok.s);
+        return NULL;
+    }
+    char *s = strdupcase(tok.s, tok.len);
+    return NewPrefixNode(ctx, s, strlen(s), contains, true);
+}
    
 /**************** End of %include directives **********************************/
 /* These constants specify the various numeric values for terminal symbols
@@ -186,17 +198,17 @@ typedef union {
 #define RSQueryParser_CTX_PARAM
 #define RSQueryParser_CTX_FETCH
 #define RSQueryParser_CTX_STORE
-#define YYNSTATE             62
-#define YYNRULE              54
+#define YYNSTATE             63
+#define YYNRULE              57
 #define YYNTOKEN             27
-#define YY_MAX_SHIFT         61
-#define YY_MIN_SHIFTREDUCE   97
-#define YY_MAX_SHIFTREDUCE   150
-#define YY_ERROR_ACTION      151
-#define YY_ACCEPT_ACTION     152
-#define YY_NO_ACTION         153
-#define YY_MIN_REDUCE        154
-#define YY_MAX_REDUCE        207
+#define YY_MAX_SHIFT         62
+#define YY_MIN_SHIFTREDUCE   101
+#define YY_MAX_SHIFTREDUCE   157
+#define YY_ERROR_ACTION      158
+#define YY_ACCEPT_ACTION     159
+#define YY_NO_ACTION         160
+#define YY_MIN_REDUCE        161
+#define YY_MAX_REDUCE        217
 /************* End control #defines *******************************************/
 
 /* Define the yytestcase() macro to be a no-op if is not already defined
@@ -262,95 +274,97 @@ typedef union {
 **  yy_default[]       Default action for each state.
 **
 *********** Begin parsing tables **********************************************/
-#define YY_ACTTAB_COUNT (258)
+#define YY_ACTTAB_COUNT (263)
 static const YYACTIONTYPE yy_action[] = {
- /*     0 */    47,   58,    5,   24,   19,   59,    6,  150,  118,    8,
- /*    10 */   149,  124,   23,   32,    7,  106,  131,  154,    9,    5,
- /*    20 */    61,   19,   36,    6,  150,  118,   60,  149,  124,   23,
- /*    30 */    61,    7,  155,  131,    5,    9,   19,   61,    6,  150,
- /*    40 */   118,  149,  149,  124,   23,  205,    7,  177,  131,   25,
- /*    50 */   146,  150,  204,   45,  149,  124,    5,   26,   19,   21,
- /*    60 */     6,  150,  118,   27,  149,  124,   23,  166,    7,  143,
- /*    70 */   131,   56,  150,  150,   50,  149,  149,   17,   31,   28,
- /*    80 */   193,   29,   19,  156,    6,  150,  118,  176,  149,  124,
- /*    90 */    23,   34,    7,    9,  131,   61,    9,  189,   61,  190,
- /*   100 */   150,   48,  164,  149,   40,   22,  112,   13,   46,    1,
- /*   110 */   173,   39,  158,   18,   41,  201,   43,  145,  199,  141,
- /*   120 */    44,   37,   33,    5,  128,   19,  129,    6,  150,  118,
- /*   130 */    49,  149,  124,   23,  130,    7,   38,  131,   51,  150,
- /*   140 */   118,   52,  149,  124,   23,  153,    7,  127,  131,  153,
- /*   150 */     9,    3,   61,   54,  173,   39,  158,   55,  196,   30,
- /*   160 */    43,  165,   42,  152,   44,   37,  126,   14,   57,   35,
- /*   170 */   173,   39,  158,  125,    4,   20,   43,  173,   39,  158,
- /*   180 */    44,   37,  153,   43,  153,  153,  113,   44,   37,  150,
- /*   190 */   121,   11,  149,  153,  173,   39,  158,  153,    2,  153,
- /*   200 */    43,  173,   39,  158,   44,   37,  153,   43,   25,  146,
- /*   210 */   153,   44,   37,  153,  153,   12,   26,  153,  173,   39,
- /*   220 */   158,  153,   15,  153,   43,  173,   39,  158,   44,   37,
- /*   230 */   153,   43,  153,  153,  153,   44,   37,  150,  121,   16,
- /*   240 */   149,  153,  173,   39,  158,  153,  150,   53,   43,  149,
- /*   250 */   153,  114,   44,   37,  150,  153,  153,  149,
+ /*     0 */   172,   44,    5,   48,   19,   59,    6,  157,  122,   60,
+ /*    10 */   156,  128,   42,   23,  184,    7,  110,  138,  161,    9,
+ /*    20 */     5,   62,   19,   62,    6,  157,  122,  215,  156,  128,
+ /*    30 */    42,   23,    9,    7,   62,  138,    5,    9,   19,   62,
+ /*    40 */     6,  157,  122,   61,  156,  128,   42,   23,   40,    7,
+ /*    50 */   116,  138,   25,  153,   25,  153,  214,   17,  162,   28,
+ /*    60 */     5,   26,   19,   26,    6,  157,  122,   21,  156,  128,
+ /*    70 */    41,   23,  150,    7,   19,  138,    6,  157,  122,   18,
+ /*    80 */   156,  128,   42,   23,  148,    7,    8,  138,    5,    9,
+ /*    90 */    19,   62,    6,  157,  122,   57,  156,  128,   42,   23,
+ /*   100 */    36,    7,   13,  138,   24,  180,   39,  165,   27,   43,
+ /*   110 */   211,   45,    1,  209,   32,   46,   37,  157,  122,  183,
+ /*   120 */   156,  128,   42,   23,  199,    7,   33,  138,  200,    9,
+ /*   130 */     3,   62,  171,  180,   39,  165,  203,   29,  157,   45,
+ /*   140 */   173,  156,  159,   46,   37,   14,  156,   34,  180,   39,
+ /*   150 */   165,  152,  206,   30,   45,  135,   47,    4,   46,   37,
+ /*   160 */   180,   39,  165,   35,  136,  157,   45,   50,  156,  128,
+ /*   170 */    46,   37,   11,   38,  137,  180,   39,  165,   52,  157,
+ /*   180 */   125,   45,  156,   53,  134,   46,   37,    2,   55,   56,
+ /*   190 */   180,   39,  165,  133,   12,  160,   45,  180,   39,  165,
+ /*   200 */    46,   37,   58,   45,  132,  160,   20,   46,   37,   15,
+ /*   210 */   160,  160,  180,   39,  165,  160,  157,   54,   45,  156,
+ /*   220 */   160,  160,   46,   37,   16,  160,  160,  180,   39,  165,
+ /*   230 */   160,  160,  130,   45,  129,  131,  160,   46,   37,  160,
+ /*   240 */   160,  157,   51,  160,  156,  157,   49,   31,  156,  117,
+ /*   250 */   163,   22,  157,  125,  160,  156,  118,  160,  130,  157,
+ /*   260 */   129,  131,  156,
 };
 static const YYCODETYPE yy_lookahead[] = {
- /*     0 */    37,   41,    2,   31,    4,   41,    6,    7,    8,    5,
- /*    10 */    10,   11,   12,   41,   14,   15,   16,    0,   18,    2,
- /*    20 */    20,    4,   18,    6,    7,    8,   13,   10,   11,   12,
- /*    30 */    20,   14,    0,   16,    2,   18,    4,   20,    6,    7,
- /*    40 */     8,   10,   10,   11,   12,   37,   14,   41,   16,    6,
- /*    50 */     7,    7,   37,   21,   10,   11,    2,   14,    4,   37,
- /*    60 */     6,    7,    8,   37,   10,   11,   12,   28,   14,   26,
- /*    70 */    16,   41,    7,    7,    8,   10,   10,   23,   12,   25,
- /*    80 */    30,   31,    4,    0,    6,    7,    8,   41,   10,   11,
- /*    90 */    12,   41,   14,   18,   16,   20,   18,   41,   20,   41,
- /*   100 */     7,    8,   41,   10,   22,   12,   24,   27,   10,    5,
- /*   110 */    30,   31,   32,   18,   34,   35,   36,   26,   38,   24,
- /*   120 */    40,   41,   18,    2,   12,    4,   12,    6,    7,    8,
- /*   130 */    12,   10,   11,   12,   12,   14,    5,   16,   12,    7,
- /*   140 */     8,   12,   10,   11,   12,   42,   14,   12,   16,   42,
- /*   150 */    18,   27,   20,   12,   30,   31,   32,   12,   30,   31,
- /*   160 */    36,   28,   29,   39,   40,   41,   12,   27,   12,   41,
- /*   170 */    30,   31,   32,   12,   27,   23,   36,   30,   31,   32,
- /*   180 */    40,   41,   42,   36,   42,   42,    4,   40,   41,    7,
- /*   190 */     8,   27,   10,   42,   30,   31,   32,   42,   27,   42,
- /*   200 */    36,   30,   31,   32,   40,   41,   42,   36,    6,    7,
- /*   210 */    42,   40,   41,   42,   42,   27,   14,   42,   30,   31,
- /*   220 */    32,   42,   27,   42,   36,   30,   31,   32,   40,   41,
- /*   230 */    42,   36,   42,   42,   42,   40,   41,    7,    8,   27,
- /*   240 */    10,   42,   30,   31,   32,   42,    7,    8,   36,   10,
- /*   250 */    42,    4,   40,   41,    7,   42,   42,   10,   42,   42,
- /*   260 */    42,   42,   42,   42,   42,   42,   42,   42,   42,   42,
- /*   270 */    42,   42,   42,   42,   42,   42,   42,   42,   42,
+ /*     0 */    28,   29,    2,   37,    4,   41,    6,    7,    8,   41,
+ /*    10 */    10,   11,   12,   13,   41,   15,   16,   17,    0,   19,
+ /*    20 */     2,   21,    4,   21,    6,    7,    8,   37,   10,   11,
+ /*    30 */    12,   13,   19,   15,   21,   17,    2,   19,    4,   21,
+ /*    40 */     6,    7,    8,   14,   10,   11,   12,   13,   22,   15,
+ /*    50 */    24,   17,    6,    7,    6,    7,   37,   23,    0,   25,
+ /*    60 */     2,   15,    4,   15,    6,    7,    8,   37,   10,   11,
+ /*    70 */    12,   13,   26,   15,    4,   17,    6,    7,    8,   19,
+ /*    80 */    10,   11,   12,   13,   24,   15,    5,   17,    2,   19,
+ /*    90 */     4,   21,    6,    7,    8,   41,   10,   11,   12,   13,
+ /*   100 */    19,   15,   27,   17,   31,   30,   31,   32,   37,   34,
+ /*   110 */    35,   36,    5,   38,   41,   40,   41,    7,    8,   41,
+ /*   120 */    10,   11,   12,   13,   41,   15,   19,   17,   41,   19,
+ /*   130 */    27,   21,   41,   30,   31,   32,   30,   31,    7,   36,
+ /*   140 */    28,   10,   39,   40,   41,   27,   10,   41,   30,   31,
+ /*   150 */    32,   26,   30,   31,   36,   13,   10,   27,   40,   41,
+ /*   160 */    30,   31,   32,   41,   13,    7,   36,   13,   10,   11,
+ /*   170 */    40,   41,   27,    5,   13,   30,   31,   32,   13,    7,
+ /*   180 */     8,   36,   10,   13,   13,   40,   41,   27,   13,   13,
+ /*   190 */    30,   31,   32,   13,   27,   42,   36,   30,   31,   32,
+ /*   200 */    40,   41,   13,   36,   13,   42,   23,   40,   41,   27,
+ /*   210 */    42,   42,   30,   31,   32,   42,    7,    8,   36,   10,
+ /*   220 */    42,   42,   40,   41,   27,   42,   42,   30,   31,   32,
+ /*   230 */    42,   42,    8,   36,   10,   11,   42,   40,   41,   42,
+ /*   240 */    42,    7,    8,   42,   10,    7,    8,   13,   10,    4,
+ /*   250 */     0,   13,    7,    8,   42,   10,    4,   42,    8,    7,
+ /*   260 */    10,   11,   10,   42,   42,   42,   42,   42,   42,   42,
+ /*   270 */    42,   42,   42,   42,   42,   42,   42,   42,   42,   42,
+ /*   280 */    42,   42,   42,   42,
 };
-#define YY_SHIFT_COUNT    (61)
+#define YY_SHIFT_COUNT    (62)
 #define YY_SHIFT_MIN      (0)
-#define YY_SHIFT_MAX      (247)
+#define YY_SHIFT_MAX      (252)
 static const unsigned short int yy_shift_ofst[] = {
- /*     0 */    32,   54,    0,   17,   78,  121,  121,  121,  121,  121,
- /*    10 */   121,  132,   75,   75,   75,   10,   10,   44,   44,   65,
- /*    20 */    13,   43,   66,   93,  182,  202,  202,  202,  202,  230,
- /*    30 */   230,  239,  247,   65,   65,   65,   65,   65,   65,   31,
- /*    40 */    13,   95,   82,    4,  104,   83,   91,   98,  112,  114,
- /*    50 */   118,  122,  126,  129,  135,  141,  145,  154,  156,  161,
- /*    60 */   131,  152,
+ /*     0 */    58,   34,    0,   18,   70,   86,   86,   86,   86,   86,
+ /*    10 */    86,  110,   13,   13,   13,    2,    2,  158,  158,  131,
+ /*    20 */    29,   46,  234,  238,  245,   48,   48,   48,   48,  172,
+ /*    30 */   172,  209,  252,  131,  131,  131,  131,  131,  131,  136,
+ /*    40 */    29,  250,  224,   60,   26,   81,  107,  125,  146,  142,
+ /*    50 */   151,  154,  161,  165,  170,  171,  175,  176,  180,  189,
+ /*    60 */   191,  168,  183,
 };
 #define YY_REDUCE_COUNT (40)
-#define YY_REDUCE_MIN   (-40)
-#define YY_REDUCE_MAX   (212)
+#define YY_REDUCE_MIN   (-36)
+#define YY_REDUCE_MAX   (197)
 static const short yy_reduce_ofst[] = {
- /*     0 */   124,   80,  140,  140,  140,  147,  164,  171,  188,  195,
- /*    10 */   212,  140,  140,  140,  140,  140,  140,   50,  128,  -28,
- /*    20 */   133,  -37,  -40,  -36,    6,    8,   15,   22,   26,    6,
- /*    30 */     6,   30,   46,   56,   46,   46,   58,   46,   61,    6,
- /*    40 */    39,
+ /*     0 */   103,   75,  118,  118,  118,  130,  145,  160,  167,  182,
+ /*    10 */   197,  118,  118,  118,  118,  118,  118,  106,  122,   73,
+ /*    20 */   -28,  -34,  -36,  -32,  -27,  -10,   19,   30,   71,  -27,
+ /*    30 */   -27,   54,   78,   83,   78,   78,   87,   78,   91,  -27,
+ /*    40 */   112,
 };
 static const YYACTIONTYPE yy_default[] = {
- /*     0 */   151,  151,  151,  151,  180,  151,  151,  151,  151,  151,
- /*    10 */   151,  179,  162,  161,  157,  159,  160,  151,  151,  151,
- /*    20 */   168,  151,  151,  151,  151,  151,  151,  151,  151,  194,
- /*    30 */   197,  151,  151,  151,  192,  195,  151,  172,  151,  174,
- /*    40 */   167,  191,  151,  151,  151,  151,  151,  151,  151,  151,
- /*    50 */   151,  151,  151,  151,  151,  151,  151,  151,  151,  151,
- /*    60 */   151,  151,
+ /*     0 */   158,  158,  158,  158,  187,  158,  158,  158,  158,  158,
+ /*    10 */   158,  186,  169,  168,  164,  166,  167,  158,  158,  158,
+ /*    20 */   175,  158,  158,  158,  158,  158,  158,  158,  158,  204,
+ /*    30 */   207,  158,  158,  158,  202,  205,  158,  179,  158,  181,
+ /*    40 */   174,  158,  158,  201,  158,  158,  158,  158,  158,  158,
+ /*    50 */   158,  158,  158,  158,  158,  158,  158,  158,  158,  158,
+ /*    60 */   158,  158,  158,
 };
 /********** End of lemon-generated parsing tables *****************************/
 
@@ -469,16 +483,16 @@ static const char *const yyTokenName[] = {
   /*    9 */ "TERMLIST",
   /*   10 */ "TERM",
   /*   11 */ "PREFIX",
-  /*   12 */ "PERCENT",
-  /*   13 */ "ATTRIBUTE",
-  /*   14 */ "LP",
-  /*   15 */ "RP",
-  /*   16 */ "MODIFIER",
-  /*   17 */ "AND",
-  /*   18 */ "OR",
-  /*   19 */ "ORX",
-  /*   20 */ "ARROW",
-  /*   21 */ "STAR",
+  /*   12 */ "STAR",
+  /*   13 */ "PERCENT",
+  /*   14 */ "ATTRIBUTE",
+  /*   15 */ "LP",
+  /*   16 */ "RP",
+  /*   17 */ "MODIFIER",
+  /*   18 */ "AND",
+  /*   19 */ "OR",
+  /*   20 */ "ORX",
+  /*   21 */ "ARROW",
   /*   22 */ "SEMICOLON",
   /*   23 */ "LB",
   /*   24 */ "RB",
@@ -534,32 +548,35 @@ static const char *const yyRuleName[] = {
  /*  25 */ "expr ::= MINUS expr",
  /*  26 */ "expr ::= TILDE expr",
  /*  27 */ "prefix ::= PREFIX",
- /*  28 */ "expr ::= PERCENT term PERCENT",
- /*  29 */ "expr ::= PERCENT PERCENT term PERCENT PERCENT",
- /*  30 */ "expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT",
- /*  31 */ "expr ::= PERCENT STOPWORD PERCENT",
- /*  32 */ "expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT",
- /*  33 */ "expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT",
- /*  34 */ "modifier ::= MODIFIER",
- /*  35 */ "modifierlist ::= modifier OR term",
- /*  36 */ "modifierlist ::= modifierlist OR term",
- /*  37 */ "expr ::= modifier COLON tag_list",
- /*  38 */ "tag_list ::= LB term",
- /*  39 */ "tag_list ::= LB prefix",
- /*  40 */ "tag_list ::= LB termlist",
- /*  41 */ "tag_list ::= tag_list OR term",
- /*  42 */ "tag_list ::= tag_list OR prefix",
- /*  43 */ "tag_list ::= tag_list OR termlist",
- /*  44 */ "tag_list ::= tag_list RB",
- /*  45 */ "expr ::= modifier COLON numeric_range",
- /*  46 */ "numeric_range ::= LSQB num num RSQB",
- /*  47 */ "expr ::= modifier COLON geo_filter",
- /*  48 */ "geo_filter ::= LSQB num num num TERM RSQB",
- /*  49 */ "num ::= NUMBER",
- /*  50 */ "num ::= LP num",
- /*  51 */ "num ::= MINUS num",
- /*  52 */ "term ::= TERM",
- /*  53 */ "term ::= NUMBER",
+ /*  28 */ "expr ::= STAR TERM",
+ /*  29 */ "expr ::= STAR STOPWORD",
+ /*  30 */ "expr ::= STAR PREFIX",
+ /*  31 */ "expr ::= PERCENT term PERCENT",
+ /*  32 */ "expr ::= PERCENT PERCENT term PERCENT PERCENT",
+ /*  33 */ "expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT",
+ /*  34 */ "expr ::= PERCENT STOPWORD PERCENT",
+ /*  35 */ "expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT",
+ /*  36 */ "expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT",
+ /*  37 */ "modifier ::= MODIFIER",
+ /*  38 */ "modifierlist ::= modifier OR term",
+ /*  39 */ "modifierlist ::= modifierlist OR term",
+ /*  40 */ "expr ::= modifier COLON tag_list",
+ /*  41 */ "tag_list ::= LB term",
+ /*  42 */ "tag_list ::= LB prefix",
+ /*  43 */ "tag_list ::= LB termlist",
+ /*  44 */ "tag_list ::= tag_list OR term",
+ /*  45 */ "tag_list ::= tag_list OR prefix",
+ /*  46 */ "tag_list ::= tag_list OR termlist",
+ /*  47 */ "tag_list ::= tag_list RB",
+ /*  48 */ "expr ::= modifier COLON numeric_range",
+ /*  49 */ "numeric_range ::= LSQB num num RSQB",
+ /*  50 */ "expr ::= modifier COLON geo_filter",
+ /*  51 */ "geo_filter ::= LSQB num num num TERM RSQB",
+ /*  52 */ "num ::= NUMBER",
+ /*  53 */ "num ::= LP num",
+ /*  54 */ "num ::= MINUS num",
+ /*  55 */ "term ::= TERM",
+ /*  56 */ "term ::= NUMBER",
 };
 #endif /* NDEBUG */
 
@@ -1059,32 +1076,35 @@ static const struct {
   {   27,   -2 }, /* (25) expr ::= MINUS expr */
   {   27,   -2 }, /* (26) expr ::= TILDE expr */
   {   30,   -1 }, /* (27) prefix ::= PREFIX */
-  {   27,   -3 }, /* (28) expr ::= PERCENT term PERCENT */
-  {   27,   -5 }, /* (29) expr ::= PERCENT PERCENT term PERCENT PERCENT */
-  {   27,   -7 }, /* (30) expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT */
-  {   27,   -3 }, /* (31) expr ::= PERCENT STOPWORD PERCENT */
-  {   27,   -5 }, /* (32) expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT */
-  {   27,   -7 }, /* (33) expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT */
-  {   40,   -1 }, /* (34) modifier ::= MODIFIER */
-  {   36,   -3 }, /* (35) modifierlist ::= modifier OR term */
-  {   36,   -3 }, /* (36) modifierlist ::= modifierlist OR term */
-  {   27,   -3 }, /* (37) expr ::= modifier COLON tag_list */
-  {   34,   -2 }, /* (38) tag_list ::= LB term */
-  {   34,   -2 }, /* (39) tag_list ::= LB prefix */
-  {   34,   -2 }, /* (40) tag_list ::= LB termlist */
-  {   34,   -3 }, /* (41) tag_list ::= tag_list OR term */
-  {   34,   -3 }, /* (42) tag_list ::= tag_list OR prefix */
-  {   34,   -3 }, /* (43) tag_list ::= tag_list OR termlist */
-  {   34,   -2 }, /* (44) tag_list ::= tag_list RB */
-  {   27,   -3 }, /* (45) expr ::= modifier COLON numeric_range */
-  {   38,   -4 }, /* (46) numeric_range ::= LSQB num num RSQB */
-  {   27,   -3 }, /* (47) expr ::= modifier COLON geo_filter */
-  {   35,   -6 }, /* (48) geo_filter ::= LSQB num num num TERM RSQB */
-  {   37,   -1 }, /* (49) num ::= NUMBER */
-  {   37,   -2 }, /* (50) num ::= LP num */
-  {   37,   -2 }, /* (51) num ::= MINUS num */
-  {   41,   -1 }, /* (52) term ::= TERM */
-  {   41,   -1 }, /* (53) term ::= NUMBER */
+  {   27,   -2 }, /* (28) expr ::= STAR TERM */
+  {   27,   -2 }, /* (29) expr ::= STAR STOPWORD */
+  {   27,   -2 }, /* (30) expr ::= STAR PREFIX */
+  {   27,   -3 }, /* (31) expr ::= PERCENT term PERCENT */
+  {   27,   -5 }, /* (32) expr ::= PERCENT PERCENT term PERCENT PERCENT */
+  {   27,   -7 }, /* (33) expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT */
+  {   27,   -3 }, /* (34) expr ::= PERCENT STOPWORD PERCENT */
+  {   27,   -5 }, /* (35) expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT */
+  {   27,   -7 }, /* (36) expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT */
+  {   40,   -1 }, /* (37) modifier ::= MODIFIER */
+  {   36,   -3 }, /* (38) modifierlist ::= modifier OR term */
+  {   36,   -3 }, /* (39) modifierlist ::= modifierlist OR term */
+  {   27,   -3 }, /* (40) expr ::= modifier COLON tag_list */
+  {   34,   -2 }, /* (41) tag_list ::= LB term */
+  {   34,   -2 }, /* (42) tag_list ::= LB prefix */
+  {   34,   -2 }, /* (43) tag_list ::= LB termlist */
+  {   34,   -3 }, /* (44) tag_list ::= tag_list OR term */
+  {   34,   -3 }, /* (45) tag_list ::= tag_list OR prefix */
+  {   34,   -3 }, /* (46) tag_list ::= tag_list OR termlist */
+  {   34,   -2 }, /* (47) tag_list ::= tag_list RB */
+  {   27,   -3 }, /* (48) expr ::= modifier COLON numeric_range */
+  {   38,   -4 }, /* (49) numeric_range ::= LSQB num num RSQB */
+  {   27,   -3 }, /* (50) expr ::= modifier COLON geo_filter */
+  {   35,   -6 }, /* (51) geo_filter ::= LSQB num num num TERM RSQB */
+  {   37,   -1 }, /* (52) num ::= NUMBER */
+  {   37,   -2 }, /* (53) num ::= LP num */
+  {   37,   -2 }, /* (54) num ::= MINUS num */
+  {   41,   -1 }, /* (55) term ::= TERM */
+  {   41,   -1 }, /* (56) term ::= NUMBER */
 };
 
 static void yy_accept(yyParser*);  /* Forward Declaration */
@@ -1388,7 +1408,7 @@ static YYACTIONTYPE yy_reduce(
   yymsp[-1].minor.yy35 = yylhsminor.yy35;
         break;
       case 24: /* termlist ::= termlist STOPWORD */
-      case 44: /* tag_list ::= tag_list RB */ yytestcase(yyruleno==44);
+      case 47: /* tag_list ::= tag_list RB */ yytestcase(yyruleno==47);
 {
     yylhsminor.yy35 = yymsp[-1].minor.yy35;
 }
@@ -1415,39 +1435,52 @@ static YYACTIONTYPE yy_reduce(
       case 27: /* prefix ::= PREFIX */
 {
     yymsp[0].minor.yy0.s = strdupcase(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
-    yylhsminor.yy35 = NewPrefixNode(ctx, yymsp[0].minor.yy0.s, strlen(yymsp[0].minor.yy0.s));
+    yylhsminor.yy35 = NewPrefixNode(ctx, yymsp[0].minor.yy0.s, strlen(yymsp[0].minor.yy0.s), true, false);
 }
   yymsp[0].minor.yy35 = yylhsminor.yy35;
         break;
-      case 28: /* expr ::= PERCENT term PERCENT */
-      case 31: /* expr ::= PERCENT STOPWORD PERCENT */ yytestcase(yyruleno==31);
+      case 28: /* expr ::= STAR TERM */
+      case 29: /* expr ::= STAR STOPWORD */ yytestcase(yyruleno==29);
+{
+    yylhsminor.yy35 = newSuffixNode(ctx, yymsp[-1].minor.yy0, yymsp[0].minor.yy0, false);
+}
+  yymsp[-1].minor.yy35 = yylhsminor.yy35;
+        break;
+      case 30: /* expr ::= STAR PREFIX */
+{
+    yylhsminor.yy35 = newSuffixNode(ctx, yymsp[-1].minor.yy0, yymsp[0].minor.yy0, true);
+}
+  yymsp[-1].minor.yy35 = yylhsminor.yy35;
+        break;
+      case 31: /* expr ::= PERCENT term PERCENT */
+      case 34: /* expr ::= PERCENT STOPWORD PERCENT */ yytestcase(yyruleno==34);
 {
     yymsp[-1].minor.yy0.s = strdupcase(yymsp[-1].minor.yy0.s, yymsp[-1].minor.yy0.len);
     yymsp[-2].minor.yy35 = NewFuzzyNode(ctx, yymsp[-1].minor.yy0.s, strlen(yymsp[-1].minor.yy0.s), 1);
 }
         break;
-      case 29: /* expr ::= PERCENT PERCENT term PERCENT PERCENT */
-      case 32: /* expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT */ yytestcase(yyruleno==32);
+      case 32: /* expr ::= PERCENT PERCENT term PERCENT PERCENT */
+      case 35: /* expr ::= PERCENT PERCENT STOPWORD PERCENT PERCENT */ yytestcase(yyruleno==35);
 {
     yymsp[-2].minor.yy0.s = strdupcase(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
     yymsp[-4].minor.yy35 = NewFuzzyNode(ctx, yymsp[-2].minor.yy0.s, strlen(yymsp[-2].minor.yy0.s), 2);
 }
         break;
-      case 30: /* expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT */
-      case 33: /* expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT */ yytestcase(yyruleno==33);
+      case 33: /* expr ::= PERCENT PERCENT PERCENT term PERCENT PERCENT PERCENT */
+      case 36: /* expr ::= PERCENT PERCENT PERCENT STOPWORD PERCENT PERCENT PERCENT */ yytestcase(yyruleno==36);
 {
     yymsp[-3].minor.yy0.s = strdupcase(yymsp[-3].minor.yy0.s, yymsp[-3].minor.yy0.len);
     yymsp[-6].minor.yy35 = NewFuzzyNode(ctx, yymsp[-3].minor.yy0.s, strlen(yymsp[-3].minor.yy0.s), 3);
 }
         break;
-      case 34: /* modifier ::= MODIFIER */
+      case 37: /* modifier ::= MODIFIER */
 {
     yymsp[0].minor.yy0.len = unescapen((char*)yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
     yylhsminor.yy0 = yymsp[0].minor.yy0;
  }
   yymsp[0].minor.yy0 = yylhsminor.yy0;
         break;
-      case 35: /* modifierlist ::= modifier OR term */
+      case 38: /* modifierlist ::= modifier OR term */
 {
     yylhsminor.yy78 = NewVector(char *, 2);
     char *s = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
@@ -1457,7 +1490,7 @@ static YYACTIONTYPE yy_reduce(
 }
   yymsp[-2].minor.yy78 = yylhsminor.yy78;
         break;
-      case 36: /* modifierlist ::= modifierlist OR term */
+      case 39: /* modifierlist ::= modifierlist OR term */
 {
     char *s = rm_strndup(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len);
     Vector_Push(yymsp[-2].minor.yy78, s);
@@ -1465,7 +1498,7 @@ static YYACTIONTYPE yy_reduce(
 }
   yymsp[-2].minor.yy78 = yylhsminor.yy78;
         break;
-      case 37: /* expr ::= modifier COLON tag_list */
+      case 40: /* expr ::= modifier COLON tag_list */
 {
     if (!yymsp[0].minor.yy35) {
         yylhsminor.yy35= NULL;
@@ -1484,35 +1517,35 @@ static YYACTIONTYPE yy_reduce(
 }
   yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
-      case 38: /* tag_list ::= LB term */
+      case 41: /* tag_list ::= LB term */
 {
     yymsp[-1].minor.yy35 = NewPhraseNode(0);
     QueryNode_AddChild(yymsp[-1].minor.yy35, NewTokenNode(ctx, strdupcase(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len), -1));
 }
         break;
-      case 39: /* tag_list ::= LB prefix */
-      case 40: /* tag_list ::= LB termlist */ yytestcase(yyruleno==40);
+      case 42: /* tag_list ::= LB prefix */
+      case 43: /* tag_list ::= LB termlist */ yytestcase(yyruleno==43);
 {
     yymsp[-1].minor.yy35 = NewPhraseNode(0);
     QueryNode_AddChild(yymsp[-1].minor.yy35, yymsp[0].minor.yy35);
 }
         break;
-      case 41: /* tag_list ::= tag_list OR term */
+      case 44: /* tag_list ::= tag_list OR term */
 {
     QueryNode_AddChild(yymsp[-2].minor.yy35, NewTokenNode(ctx, strdupcase(yymsp[0].minor.yy0.s, yymsp[0].minor.yy0.len), -1));
     yylhsminor.yy35 = yymsp[-2].minor.yy35;
 }
   yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
-      case 42: /* tag_list ::= tag_list OR prefix */
-      case 43: /* tag_list ::= tag_list OR termlist */ yytestcase(yyruleno==43);
+      case 45: /* tag_list ::= tag_list OR prefix */
+      case 46: /* tag_list ::= tag_list OR termlist */ yytestcase(yyruleno==46);
 {
     QueryNode_AddChild(yymsp[-2].minor.yy35, yymsp[0].minor.yy35);
     yylhsminor.yy35 = yymsp[-2].minor.yy35;
 }
   yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
-      case 45: /* expr ::= modifier COLON numeric_range */
+      case 48: /* expr ::= modifier COLON numeric_range */
 {
     // we keep the capitalization as is
     yymsp[0].minor.yy36->fieldName = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
@@ -1520,12 +1553,12 @@ static YYACTIONTYPE yy_reduce(
 }
   yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
-      case 46: /* numeric_range ::= LSQB num num RSQB */
+      case 49: /* numeric_range ::= LSQB num num RSQB */
 {
     yymsp[-3].minor.yy36 = NewNumericFilter(yymsp[-2].minor.yy83.num, yymsp[-1].minor.yy83.num, yymsp[-2].minor.yy83.inclusive, yymsp[-1].minor.yy83.inclusive);
 }
         break;
-      case 47: /* expr ::= modifier COLON geo_filter */
+      case 50: /* expr ::= modifier COLON geo_filter */
 {
     // we keep the capitalization as is
     yymsp[0].minor.yy64->property = rm_strndup(yymsp[-2].minor.yy0.s, yymsp[-2].minor.yy0.len);
@@ -1533,7 +1566,7 @@ static YYACTIONTYPE yy_reduce(
 }
   yymsp[-2].minor.yy35 = yylhsminor.yy35;
         break;
-      case 48: /* geo_filter ::= LSQB num num num TERM RSQB */
+      case 51: /* geo_filter ::= LSQB num num num TERM RSQB */
 {
     char buf[16] = {0};
     if (yymsp[-1].minor.yy0.len < 16) {
@@ -1545,27 +1578,27 @@ static YYACTIONTYPE yy_reduce(
     GeoFilter_Validate(yymsp[-5].minor.yy64, ctx->status);
 }
         break;
-      case 49: /* num ::= NUMBER */
+      case 52: /* num ::= NUMBER */
 {
     yylhsminor.yy83.num = yymsp[0].minor.yy0.numval;
     yylhsminor.yy83.inclusive = 1;
 }
   yymsp[0].minor.yy83 = yylhsminor.yy83;
         break;
-      case 50: /* num ::= LP num */
+      case 53: /* num ::= LP num */
 {
     yymsp[-1].minor.yy83=yymsp[0].minor.yy83;
     yymsp[-1].minor.yy83.inclusive = 0;
 }
         break;
-      case 51: /* num ::= MINUS num */
+      case 54: /* num ::= MINUS num */
 {
     yymsp[0].minor.yy83.num = -yymsp[0].minor.yy83.num;
     yymsp[-1].minor.yy83 = yymsp[0].minor.yy83;
 }
         break;
-      case 52: /* term ::= TERM */
-      case 53: /* term ::= NUMBER */ yytestcase(yyruleno==53);
+      case 55: /* term ::= TERM */
+      case 56: /* term ::= NUMBER */ yytestcase(yyruleno==56);
 {
     yylhsminor.yy0 = yymsp[0].minor.yy0; 
 }
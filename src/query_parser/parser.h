@@ -9,16 +9,16 @@
 #define TERMLIST                         9
 #define TERM                            10
 #define PREFIX                          11
-#define PERCENT                         12
-#define ATTRIBUTE                       13
-#define LP                              14
-#define RP                              15
-#define MODIFIER                        16
-#define AND                             17
-#define OR                              18
-#define ORX                             19
-#define ARROW                           20
-#define STAR                            21
+#define STAR                            12
+#define PERCENT                         13
+#define ATTRIBUTE                       14
+#define LP                              15
+#define RP                              16
+#define MODIFIER                        17
+#define AND                             18
+#define OR                              19
+#define ORX                             20
+#define ARROW                           21
 #define SEMICOLON                       22
 #define LB                              23
 #define RB                              24
@@ -9,7 +9,7 @@
 
 %left TERMLIST.
 %left TERM. 
-%left PREFIX.
+%left PREFIX STAR.
 %left PERCENT.
 %left ATTRIBUTE.
 %right LP.
@@ -102,6 +102,18 @@ static int one_not_null(void *a, void *b, void *out) {
         return NODENN_ONE_NULL;
     }
 }
+
+// A suffix (or contains) node from a star and the term that follows it. They must be adjacent, as
+// a star apart from a term is only valid as a query of its own
+static QueryNode *newSuffixNode(QueryParseCtx *ctx, QueryToken star, QueryToken tok, bool contains) {
+    if (star.pos + 1 != tok.pos) {
+        QueryError_SetErrorFmt(ctx->status, QUERY_ESYNTAX,
+            "Syntax error at offset %d near %.*s", tok.pos, tok.len, tok.s);
+        return NULL;
+    }
+    char *s = strdupcase(tok.s, tok.len);
+    return NewPrefixNode(ctx, s, strlen(s), contains, true);
+}
    
 } // END %include  
 
@@ -385,7 +397,24 @@ expr(A) ::= TILDE expr(B) . {
 
 prefix(A) ::= PREFIX(B) . [PREFIX] {
     B.s = strdupcase(B.s, B.len);
-    A = NewPrefixNode(ctx, B.s, strlen(B.s));
+    A = NewPrefixNode(ctx, B.s, strlen(B.s), true, false);
+}
+
+/////////////////////////////////////////////////////////////////
+// Suffix and contains experessions
+/////////////////////////////////////////////////////////////////
+
+// `*foo` and `*foo*` are lexed as a star followed by a term or a prefix, which must be adjacent
+expr(A) ::= STAR(S) TERM(B) . [PREFIX] {
+    A = newSuffixNode(ctx, S, B, false);
+}
+
+expr(A) ::= STAR(S) STOPWORD(B) . [PREFIX] {
+    A = newSuffixNode(ctx, S, B, false);
+}
+
+expr(A) ::= STAR(S) PREFIX(B) . [PREFIX] {
+    A = newSuffixNode(ctx, S, B, true);
 }
 
 /////////////////////////////////////////////////////////////////
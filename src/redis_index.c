@@ -12,6 +12,29 @@
 
 RedisModuleType *InvertedIndexType;
 
+static void loadBlockBuffer(RedisModuleIO *rdb, Buffer *b) {
+  b->data = RedisModule_LoadStringBuffer(rdb, &b->offset);
+  b->cap = b->offset;
+  // if we read a buffer of 0 bytes we still read 1 byte from the RDB that needs to be freed
+  if (!b->cap && b->data) {
+    RedisModule_Free(b->data);
+    b->data = NULL;
+  } else {
+    char *buf = rm_malloc(b->offset);
+    memcpy(buf, b->data, b->offset);
+    RedisModule_Free(b->data);
+    b->data = buf;
+  }
+}
+
+static void saveBlockBuffer(RedisModuleIO *rdb, const Buffer *b) {
+  if (b->offset) {
+    RedisModule_SaveStringBuffer(rdb, b->data, b->offset);
+  } else {
+    RedisModule_SaveStringBuffer(rdb, "", 0);
+  }
+}
+
 void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
   if (encver > INVERTED_INDEX_ENCVER) {
     return NULL;
@@ -38,17 +61,9 @@ void *InvertedIndex_RdbLoad(RedisModuleIO *rdb, int encver) {
       ++actualSize;
     }
 
-    blk->buf.data = RedisModule_LoadStringBuffer(rdb, &blk->buf.offset);
-    blk->buf.cap = blk->buf.offset;
-    // if we read a buffer of 0 bytes we still read 1 byte from the RDB that needs to be freed
-    if (!blk->buf.cap && blk->buf.data) {
-      RedisModule_Free(blk->buf.data);
-      blk->buf.data = NULL;
-    } else {
-      char *buf = rm_malloc(blk->buf.offset);
-      memcpy(buf, blk->buf.data, blk->buf.offset);
-      RedisModule_Free(blk->buf.data);
-      blk->buf.data = buf;
+    loadBlockBuffer(rdb, &blk->buf);
+    if (encver >= INVERTED_INDEX_SPLITPOS_VER && (idx->flags & Index_SplitPositions)) {
+      loadBlockBuffer(rdb, &blk->posBuf);
     }
   }
   idx->size = actualSize;
@@ -83,10 +98,9 @@ void InvertedIndex_RdbSave(RedisModuleIO *rdb, void *value) {
     RedisModule_SaveUnsigned(rdb, blk->firstId);
     RedisModule_SaveUnsigned(rdb, blk->lastId);
     RedisModule_SaveUnsigned(rdb, blk->numDocs);
-    if (IndexBlock_DataLen(blk)) {
-      RedisModule_SaveStringBuffer(rdb, IndexBlock_DataBuf(blk), IndexBlock_DataLen(blk));
-    } else {
-      RedisModule_SaveStringBuffer(rdb, "", 0);
+    saveBlockBuffer(rdb, &blk->buf);
+    if (idx->flags & Index_SplitPositions) {
+      saveBlockBuffer(rdb, &blk->posBuf);
     }
   }
 }
@@ -99,6 +113,7 @@ unsigned long InvertedIndex_MemUsage(const void *value) {
   for (size_t i = 0; i < idx->size; i++) {
     ret += sizeof(IndexBlock);
     ret += IndexBlock_DataLen(&idx->blocks[i]);
+    ret += IndexBlock_PosLen(&idx->blocks[i]);
   }
   return ret;
 }
@@ -277,7 +292,7 @@ const char *Redis_SelectRandomTerm(RedisSearchCtx *ctx, size_t *tlen) {
 }
 
 static InvertedIndex *openIndexKeysDict(RedisSearchCtx *ctx, RedisModuleString *termKey,
-                                        int write) {
+                                        IndexFlags flags, int write) {
   KeysDictValue *kdv = dictFetchValue(ctx->spec->keysDict, termKey);
   if (kdv) {
     return kdv->p;
@@ -288,13 +303,14 @@ static InvertedIndex *openIndexKeysDict(RedisSearchCtx *ctx, RedisModuleString *
 
   kdv = rm_calloc(1, sizeof(*kdv));
   kdv->dtor = InvertedIndex_Free;
-  kdv->p = NewInvertedIndex(ctx->spec->flags, 1);
+  kdv->p = NewInvertedIndex(InvertedIndex_TermFlags(flags), 1);
   dictAdd(ctx->spec->keysDict, termKey, kdv);
   return kdv->p;
 }
 
-InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term, size_t len,
-                                         int write, RedisModuleKey **keyp) {
+static InvertedIndex *openInvertedIndexInternal(RedisSearchCtx *ctx, const char *term, size_t len,
+                                                IndexFlags flags, int write,
+                                                RedisModuleKey **keyp) {
   RedisModuleString *termKey = fmtRedisTermKey(ctx, term, len);
   InvertedIndex *idx = NULL;
 
@@ -311,7 +327,7 @@ InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term,
 
     if (kType == REDISMODULE_KEYTYPE_EMPTY) {
       if (write) {
-        idx = NewInvertedIndex(ctx->spec->flags, 1);
+        idx = NewInvertedIndex(InvertedIndex_TermFlags(flags), 1);
         RedisModule_ModuleTypeSetValue(k, InvertedIndexType, idx);
       }
     } else if (kType == REDISMODULE_KEYTYPE_MODULE &&
@@ -323,20 +339,149 @@ InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term,
     } else {
       if (keyp) {
         *keyp = k;
+      } else {
+        RedisModule_CloseKey(k);
       }
     }
   } else {
-    idx = openIndexKeysDict(ctx, termKey, write);
+    idx = openIndexKeysDict(ctx, termKey, flags, write);
   }
 end:
   RedisModule_FreeString(ctx->redisCtx, termKey);
   return idx;
 }
 
+InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term, size_t len,
+                                         int write, RedisModuleKey **keyp) {
+  return openInvertedIndexInternal(ctx, term, len, ctx->spec->flags, write, keyp);
+}
+
+size_t Redis_FormatFieldTerm(char *buf, const char *term, size_t len, t_fieldId ftId) {
+  memcpy(buf, term, len);
+  buf[len] = FIELD_TERM_SEPARATOR;
+  buf[len + 1] = (char)(ftId + 1);
+  return len + FIELD_TERM_SUFFIX_LEN;
+}
+
+int Redis_ParseFieldTerm(const char *name, size_t len, size_t *termLen, t_fieldId *ftId) {
+  if (len < FIELD_TERM_SUFFIX_LEN || name[len - FIELD_TERM_SUFFIX_LEN] != FIELD_TERM_SEPARATOR ||
+      name[len - 1] == 0) {
+    return 0;
+  }
+  *termLen = len - FIELD_TERM_SUFFIX_LEN;
+  *ftId = (unsigned char)name[len - 1] - 1;
+  return 1;
+}
+
+InvertedIndex *Redis_OpenFieldInvertedIndexEx(RedisSearchCtx *ctx, const char *term, size_t len,
+                                              t_fieldId ftId, int write, RedisModuleKey **keyp) {
+  char buf_s[1024];
+  char *buf = len + FIELD_TERM_SUFFIX_LEN > sizeof(buf_s) ? rm_malloc(len + FIELD_TERM_SUFFIX_LEN)
+                                                          : buf_s;
+  size_t n = Redis_FormatFieldTerm(buf, term, len, ftId);
+  InvertedIndex *idx =
+      openInvertedIndexInternal(ctx, buf, n, IndexSpec_FieldPostingsFlags(ctx->spec), write, keyp);
+  if (buf != buf_s) {
+    rm_free(buf);
+  }
+  return idx;
+}
+
+size_t Redis_FormatPrefixTerm(char *buf, const char *prefix, size_t len) {
+  memcpy(buf, prefix, len);
+  memcpy(buf + len, PREFIX_TERM_SUFFIX, PREFIX_TERM_SUFFIX_LEN);
+  return len + PREFIX_TERM_SUFFIX_LEN;
+}
+
+int Redis_ParsePrefixTerm(const char *name, size_t len, size_t *prefixLen) {
+  if (len <= PREFIX_TERM_SUFFIX_LEN ||
+      memcmp(name + len - PREFIX_TERM_SUFFIX_LEN, PREFIX_TERM_SUFFIX, PREFIX_TERM_SUFFIX_LEN)) {
+    return 0;
+  }
+  *prefixLen = len - PREFIX_TERM_SUFFIX_LEN;
+  return 1;
+}
+
+InvertedIndex *Redis_OpenPrefixInvertedIndexEx(RedisSearchCtx *ctx, const char *prefix, size_t len,
+                                               int write, RedisModuleKey **keyp) {
+  char buf_s[1024];
+  char *buf = len + PREFIX_TERM_SUFFIX_LEN > sizeof(buf_s) ? rm_malloc(len + PREFIX_TERM_SUFFIX_LEN)
+                                                           : buf_s;
+  size_t n = Redis_FormatPrefixTerm(buf, prefix, len);
+  InvertedIndex *idx = openInvertedIndexInternal(ctx, buf, n, ctx->spec->flags, write, keyp);
+  if (buf != buf_s) {
+    rm_free(buf);
+  }
+  return idx;
+}
+
+IndexReader *Redis_OpenPrefixReader(RedisSearchCtx *ctx, RSQueryTerm *term, t_fieldMask fieldMask,
+                                    ConcurrentSearchCtx *csx, double weight) {
+  InvertedIndex *idx = Redis_OpenPrefixInvertedIndexEx(ctx, term->str, term->len, 0, NULL);
+  if (!idx || !idx->numDocs) {
+    return NULL;
+  }
+  IndexReader *ret = NewTermIndexReader(idx, ctx->spec, fieldMask, term, weight);
+  if (ret && csx) {
+    ConcurrentSearch_AddKey(csx, IndexReader_OnReopen, ret, NULL);
+  }
+  return ret;
+}
+
+/* Returns the id of the single field in the mask, or -1 if the mask selects zero or several
+ * fields */
+static int fieldMaskSingleId(t_fieldMask mask) {
+  if (!mask || (mask & (mask - 1))) {
+    return -1;
+  }
+  int id = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    ++id;
+  }
+  return id;
+}
+
+/* Open a reader on the per-field postings of a term. The idf is computed from the term's global
+ * index, so that scores do not depend on which posting list served the query */
+static IndexReader *openFieldReader(RedisSearchCtx *ctx, RSQueryTerm *term, t_fieldId ftId,
+                                    t_fieldMask fieldMask, ConcurrentSearchCtx *csx,
+                                    double weight) {
+  InvertedIndex *global = openInvertedIndexInternal(ctx, term->str, term->len, ctx->spec->flags,
+                                                    0, NULL);
+  if (!global || !global->numDocs) {
+    return NULL;
+  }
+  InvertedIndex *idx = Redis_OpenFieldInvertedIndexEx(ctx, term->str, term->len, ftId, 0, NULL);
+  if (!idx || !idx->numDocs) {
+    return NULL;
+  }
+
+  IndexReader *ret = NewTermIndexReader(idx, ctx->spec, RS_FIELDMASK_ALL, term, weight);
+  if (!ret) {
+    return NULL;
+  }
+  term->idf = CalculateIDF(ctx->spec->docs.size, global->numDocs);
+  // records in this list carry no field mask; they all belong to the requested field
+  ret->record->fieldMask = fieldMask;
+  if (csx) {
+    ConcurrentSearch_AddKey(csx, IndexReader_OnReopen, ret, NULL);
+  }
+  return ret;
+}
+
 IndexReader *Redis_OpenReader(RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
                               int singleWordMode, t_fieldMask fieldMask, ConcurrentSearchCtx *csx,
                               double weight) {
 
+  if ((ctx->spec->flags & Index_FieldPostings) && term) {
+    // a query restricted to a single field reads that field's postings directly
+    int ftId = fieldMaskSingleId(fieldMask);
+    if (ftId >= 0) {
+      return openFieldReader(ctx, term, ftId, fieldMask, csx, weight);
+    }
+  }
+
   RedisModuleString *termKey = fmtRedisTermKey(ctx, term->str, term->len);
   InvertedIndex *idx = NULL;
   RedisModuleKey *k = NULL;
@@ -351,7 +496,7 @@ IndexReader *Redis_OpenReader(RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *
 
     idx = RedisModule_ModuleTypeGetValue(k);
   } else {
-    idx = openIndexKeysDict(ctx, termKey, 0);
+    idx = openIndexKeysDict(ctx, termKey, ctx->spec->flags, 0);
     if (!idx) {
       goto err;
     }
@@ -8,6 +8,10 @@
 #include "concurrent_ctx.h"
 #include "spec.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Open an inverted index reader on a redis DMA string, for a specific term.
  * If singleWordMode is set to 1, we do not load the skip index, only the score index
  */
@@ -21,6 +25,45 @@ InvertedIndex *Redis_OpenInvertedIndexEx(RedisSearchCtx *ctx, const char *term,
   Redis_OpenInvertedIndexEx(ctx, term, len, isWrite, NULL)
 void Redis_CloseReader(IndexReader *r);
 
+/* With Index_FieldPostings, the postings of a term in a single text field are kept in an
+ * additional inverted index, named after the term followed by a NUL byte and the field id + 1.
+ * Tokens never contain NUL bytes, so these names cannot clash with regular terms */
+#define FIELD_TERM_SEPARATOR '\0'
+#define FIELD_TERM_SUFFIX_LEN 2
+
+/* Write the per-field name of a term to buf, which must hold len + FIELD_TERM_SUFFIX_LEN bytes.
+ * Returns the length of the name */
+size_t Redis_FormatFieldTerm(char *buf, const char *term, size_t len, t_fieldId ftId);
+
+/* Returns 1 and sets termLen and ftId if name is a per-field term name, 0 otherwise */
+int Redis_ParseFieldTerm(const char *name, size_t len, size_t *termLen, t_fieldId *ftId);
+
+/* Open the per-field inverted index of a term. Records there carry no field mask */
+InvertedIndex *Redis_OpenFieldInvertedIndexEx(RedisSearchCtx *ctx, const char *term, size_t len,
+                                              t_fieldId ftId, int write, RedisModuleKey **keyp);
+
+/* The postings of a prefix, merged from all the terms starting with it in PREFIXINDEX text fields,
+ * are kept in an inverted index named after the prefix followed by two NUL bytes. Per-field term
+ * names never end with a zero field byte, so these names cannot clash with them either */
+#define PREFIX_TERM_SUFFIX "\0\0"
+#define PREFIX_TERM_SUFFIX_LEN 2
+
+/* Write the postings name of a prefix to buf, which must hold len + PREFIX_TERM_SUFFIX_LEN bytes.
+ * Returns the length of the name */
+size_t Redis_FormatPrefixTerm(char *buf, const char *prefix, size_t len);
+
+/* Returns 1 and sets prefixLen if name is a prefix postings name, 0 otherwise */
+int Redis_ParsePrefixTerm(const char *name, size_t len, size_t *prefixLen);
+
+/* Open the inverted index of a prefix's postings */
+InvertedIndex *Redis_OpenPrefixInvertedIndexEx(RedisSearchCtx *ctx, const char *prefix, size_t len,
+                                               int write, RedisModuleKey **keyp);
+
+/* Open a reader on the postings of a prefix, whose string is the term's. Returns NULL if no
+ * document has the prefix */
+IndexReader *Redis_OpenPrefixReader(RedisSearchCtx *ctx, RSQueryTerm *term, t_fieldMask fieldMask,
+                                    ConcurrentSearchCtx *csx, double weight);
+
 /*
  * Select a random term from the index that matches the index prefix and inveted key format.
  * It tries RANDOMKEY 10 times and returns NULL if it can't find anything.
@@ -32,8 +75,10 @@ const char *Redis_SelectRandomTerm(RedisSearchCtx *ctx, size_t *tlen);
 #define SKIPINDEX_KEY_FORMAT "si:%s/%.*s"
 #define SCOREINDEX_KEY_FORMAT "ss:%s/%.*s"
 
-#define INVERTED_INDEX_ENCVER 1
+#define INVERTED_INDEX_ENCVER 2
 #define INVERTED_INDEX_NOFREQFLAG_VER 0
+// Blocks of indexes with Index_SplitPositions are followed by their positional stream
+#define INVERTED_INDEX_SPLITPOS_VER 2
 
 typedef int (*ScanFunc)(RedisModuleCtx *ctx, RedisModuleString *keyName, void *opaque);
 
@@ -72,4 +117,7 @@ void InvertedIndex_Digest(RedisModuleDigest *digest, void *value);
 int InvertedIndex_RegisterType(RedisModuleCtx *ctx);
 unsigned long InvertedIndex_MemUsage(const void *value);
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+#endif
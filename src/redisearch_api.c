@@ -220,6 +220,7 @@ int RediSearch_IndexAddDocument(IndexSpec* sp, Document* d, int options, char**
       if (errs) {
         *errs = rm_strdup("Document already exists");
       }
+      Indexer_Decref(aCtx->indexer);
       AddDocumentCtx_Free(aCtx);
       RWLOCK_RELEASE();
       return REDISMODULE_ERR;
@@ -257,8 +258,11 @@ QueryNode* RediSearch_CreateNumericNode(IndexSpec* sp, const char* field, double
 
 QueryNode* RediSearch_CreatePrefixNode(IndexSpec* sp, const char* fieldName, const char* s) {
   QueryNode* ret = NewQueryNode(QN_PREFX);
-  ret->pfx =
-      (QueryPrefixNode){.str = (char*)rm_strdup(s), .len = strlen(s), .expanded = 0, .flags = 0};
+  ret->pfx = (QueryPrefixNode){
+      .tok = {.str = (char*)rm_strdup(s), .len = strlen(s), .expanded = 0, .flags = 0},
+      .prefix = true,
+      .suffix = false,
+  };
   if (fieldName) {
     ret->opts.fieldMask = IndexSpec_GetFieldBit(sp, fieldName, strlen(fieldName));
   }
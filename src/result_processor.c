@@ -2,7 +2,9 @@
 #include "query.h"
 #include "extension.h"
 #include <util/minmax_heap.h>
+#include <util/minmax.h>
 #include "ext/default.h"
+#include "sort_key.h"
 #include "rmutil/rm_assert.h"
 
 /*******************************************************************************************************************
@@ -61,6 +63,28 @@ typedef struct {
   IndexIterator *iiter;
 } RPIndexIterator;
 
+static inline RSDocumentMetadata *getLiveDocument(ResultProcessor *base, t_docId docId) {
+  RSDocumentMetadata *dmd = DocTable_Get(&RP_SPEC(base)->docs, docId);
+  if (!dmd || (dmd->flags & Document_Deleted)) {
+    return NULL;
+  }
+  return dmd;
+}
+
+static void setIndexResult(ResultProcessor *base, SearchResult *res, RSIndexResult *r,
+                           RSDocumentMetadata *dmd) {
+  // Increment the total results barring deleted results
+  base->parent->totalResults++;
+
+  // set the result data
+  res->docId = r->docId;
+  res->indexResult = r;
+  res->score = 0;
+  res->dmd = dmd;
+  res->rowdata.sv = dmd->sortVector;
+  DMD_Incref(dmd);
+}
+
 /* Next implementation */
 static int rpidxNext(ResultProcessor *base, SearchResult *res) {
   RPIndexIterator *self = (RPIndexIterator *)base;
@@ -85,23 +109,14 @@ static int rpidxNext(ResultProcessor *base, SearchResult *res) {
       continue;
     }
 
-    dmd = DocTable_Get(&RP_SPEC(base)->docs, r->docId);
-    if (!dmd || (dmd->flags & Document_Deleted)) {
+    dmd = getLiveDocument(base, r->docId);
+    if (!dmd) {
       continue;
     }
-
-    // Increment the total results barring deleted results
-    base->parent->totalResults++;
     break;
   }
 
-  // set the result data
-  res->docId = r->docId;
-  res->indexResult = r;
-  res->score = 0;
-  res->dmd = dmd;
-  res->rowdata.sv = dmd->sortVector;
-  DMD_Incref(dmd);
+  setIndexResult(base, res, r, dmd);
   return RS_RESULT_OK;
 }
 
@@ -118,6 +133,217 @@ ResultProcessor *RPIndexIterator_New(IndexIterator *root) {
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Numeric Order Processor
+ *
+ * Reads the results of the root iterator in the order of a numeric sort key, so that the sorter
+ * after it sees the top results first and the reading can stop early. The leaves of the field's
+ * range tree are visited in the order of the sort. The postings of each leaf are sorted by id, and
+ * are intersected with the root iterator by skipping each to the other, after rewinding the root
+ * iterator for the leaf. The values of a leaf are all on the same side of those of the next one, so
+ * once the leaves read hold as many results as the sorter keeps, the rest cannot make it.
+ *
+ * The documents without a value are not in the tree, and are found by reading the root iterator
+ * through, checking their sorting vectors. They are sorted before all the values when ascending,
+ * and after them when descending. The doc table counts the documents without a value, so that the
+ * root iterator is not read through when all of them have one
+ *******************************************************************************************************************/
+
+typedef enum {
+  NumericOrder_MissingFirst,
+  NumericOrder_Leaves,
+  NumericOrder_MissingLast,
+  NumericOrder_Done,
+} NumericOrderPhase;
+
+typedef struct {
+  // the root iterator is read as by the index processor, see QITR_GetRootFilter
+  RPIndexIterator base;
+  NumericRangeTree *tree;
+  const RLookupKey *sortKey;
+  int ascending;
+  size_t limit;
+  NumericOrderPhase phase;
+
+  // the leaves in the order of the sort, collected by the first read
+  NumericRange **leaves;
+  size_t nextLeaf;
+  IndexReader *leafReader;
+
+  // the position of the root iterator in the current leaf, and its result there if it matches
+  t_docId rootId;
+  RSIndexResult *rootHit;
+  t_docId lastId;
+
+  // the number of results read so far
+  size_t numRead;
+} RPNumericOrder;
+
+static void rpnumRewind(RPNumericOrder *self) {
+  IndexIterator *it = self->base.iiter;
+  it->Rewind(it->ctx);
+  self->rootId = 0;
+  self->rootHit = NULL;
+  self->lastId = 0;
+}
+
+/* Read the next result of the root iterator without a value for the sort key */
+static int rpnumReadMissing(RPNumericOrder *self, SearchResult *res) {
+  ResultProcessor *base = &self->base.base;
+  if (!DocTable_NumMissingSortable(&RP_SPEC(base)->docs, self->sortKey->svidx)) {
+    return 0;
+  }
+  IndexIterator *it = self->base.iiter;
+  RSIndexResult *r;
+  int rc;
+  while ((rc = it->Read(it->ctx, &r)) != INDEXREAD_EOF) {
+    if (!r || rc == INDEXREAD_NOTFOUND) {
+      continue;
+    }
+    RSDocumentMetadata *dmd = getLiveDocument(base, r->docId);
+    if (!dmd) {
+      continue;
+    }
+    RLookupRow row = {.sv = dmd->sortVector};
+    if (RLookup_GetItem(self->sortKey, &row)) {
+      continue;
+    }
+    setIndexResult(base, res, r, dmd);
+    return 1;
+  }
+  return 0;
+}
+
+/* Read the next result of the root iterator in the current leaf */
+static int rpnumReadLeaf(RPNumericOrder *self, SearchResult *res) {
+  ResultProcessor *base = &self->base.base;
+  IndexIterator *it = self->base.iiter;
+  RSIndexResult *lr;
+  int rc = IR_Read(self->leafReader, &lr);
+  while (rc != INDEXREAD_EOF) {
+    t_docId docId = lr->docId;
+    if (docId < self->rootId) {
+      // the root iterator has no result before its position
+      rc = IR_SkipTo(self->leafReader, self->rootId, &lr);
+      continue;
+    }
+    if (docId > self->rootId) {
+      RSIndexResult *hit = NULL;
+      int rrc = it->SkipTo(it->ctx, docId, &hit);
+      if (rrc == INDEXREAD_EOF) {
+        return 0;
+      }
+      t_docId landed = hit ? hit->docId : it->LastDocId(it->ctx);
+      if (rrc == INDEXREAD_OK || landed > docId) {
+        // when not found, the root iterator is left at its next result, as the intersection of
+        // iterators expects
+        self->rootId = rrc == INDEXREAD_OK ? docId : landed;
+        self->rootHit = hit ? hit : it->current;
+      } else {
+        self->rootId = docId;
+        self->rootHit = NULL;
+      }
+      continue;
+    }
+
+    RSDocumentMetadata *dmd;
+    if (self->rootHit && docId != self->lastId && (dmd = getLiveDocument(base, docId))) {
+      self->lastId = docId;
+      setIndexResult(base, res, self->rootHit, dmd);
+      return 1;
+    }
+    rc = IR_Read(self->leafReader, &lr);
+  }
+  return 0;
+}
+
+static int rpnumNext(ResultProcessor *base, SearchResult *res) {
+  RPNumericOrder *self = (RPNumericOrder *)base;
+  if (!self->base.iiter) {
+    return RS_RESULT_EOF;
+  }
+  if (!self->leaves) {
+    self->leaves = NumericRangeTree_GetLeaves(self->tree);
+    if (!self->ascending) {
+      for (size_t i = 0, n = array_len(self->leaves); i < n / 2; i++) {
+        NumericRange *tmp = self->leaves[i];
+        self->leaves[i] = self->leaves[n - 1 - i];
+        self->leaves[n - 1 - i] = tmp;
+      }
+    }
+  }
+
+  while (1) {
+    switch (self->phase) {
+      case NumericOrder_MissingFirst:
+        // the results without a value tie, and are sorted by their ids, as they are read
+        if (self->numRead < self->limit && rpnumReadMissing(self, res)) {
+          self->numRead++;
+          return RS_RESULT_OK;
+        }
+        self->phase = self->numRead < self->limit ? NumericOrder_Leaves : NumericOrder_Done;
+        break;
+
+      case NumericOrder_Leaves:
+        if (self->leafReader) {
+          if (rpnumReadLeaf(self, res)) {
+            self->numRead++;
+            return RS_RESULT_OK;
+          }
+          IR_Free(self->leafReader);
+          self->leafReader = NULL;
+        }
+        if (self->numRead >= self->limit) {
+          self->phase = NumericOrder_Done;
+        } else if (self->nextLeaf == array_len(self->leaves)) {
+          self->phase = self->ascending ? NumericOrder_Done : NumericOrder_MissingLast;
+          rpnumRewind(self);
+        } else {
+          NumericRange *leaf = self->leaves[self->nextLeaf++];
+          self->leafReader = NewNumericReader(RP_SPEC(base), leaf->entries, NULL);
+          rpnumRewind(self);
+        }
+        break;
+
+      case NumericOrder_MissingLast:
+        if (rpnumReadMissing(self, res)) {
+          self->numRead++;
+          return RS_RESULT_OK;
+        }
+        self->phase = NumericOrder_Done;
+        break;
+
+      case NumericOrder_Done:
+        return RS_RESULT_EOF;
+    }
+  }
+}
+
+static void rpnumFree(ResultProcessor *base) {
+  RPNumericOrder *self = (RPNumericOrder *)base;
+  if (self->leafReader) {
+    IR_Free(self->leafReader);
+  }
+  array_free(self->leaves);
+  rm_free(self);
+}
+
+ResultProcessor *RPIndexIterator_NewNumericOrder(IndexIterator *root, NumericRangeTree *tree,
+                                                 const RLookupKey *sortKey, int ascending,
+                                                 size_t limit) {
+  RPNumericOrder *ret = rm_calloc(1, sizeof(*ret));
+  ret->base.iiter = root;
+  ret->tree = tree;
+  ret->sortKey = sortKey;
+  ret->ascending = ascending;
+  ret->limit = limit;
+  ret->phase = ascending ? NumericOrder_MissingFirst : NumericOrder_Leaves;
+  ret->base.base.Next = rpnumNext;
+  ret->base.base.Free = rpnumFree;
+  ret->base.base.name = "Index";
+  return &ret->base.base;
+}
+
 IndexIterator *QITR_GetRootFilter(QueryIterator *it) {
   return ((RPIndexIterator *)it->rootProc)->iiter;
 }
@@ -140,6 +366,21 @@ void QITR_FreeChain(QueryIterator *qitr) {
     rp->Free(rp);
     rp = next;
   }
+  QITR_FreeArena(qitr);
+}
+
+#define QITR_ARENA_BLOCK_SIZE 16384
+#define QITR_ARENA_ALIGNMENT 16
+
+void *QITR_Alloc(QueryIterator *it, size_t sz) {
+  // the blocks are aligned, and so is every allocation as long as all the sizes are rounded up
+  sz = (sz + QITR_ARENA_ALIGNMENT - 1) & ~(size_t)(QITR_ARENA_ALIGNMENT - 1);
+  return BlkAlloc_Alloc(&it->arena, sz, MAX(sz, QITR_ARENA_BLOCK_SIZE));
+}
+
+void QITR_FreeArena(QueryIterator *it) {
+  BlkAlloc_FreeAll(&it->arena, NULL, NULL, 0);
+  BlkAlloc_Init(&it->arena);
 }
 
 /*******************************************************************************************************************
@@ -214,6 +455,43 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Geo Distance Processor
+ *
+ * The nearest neighbour iterator returns the distance of each document from the center as the
+ * numeric value of its index result. This processor writes it into the result's row, so it can be
+ * sorted by and returned without computing it again. It takes the place of the scorer, so the
+ * distance is also the result's score, which WITHSCORES returns.
+ ********************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  const RLookupKey *distanceKey;
+} RPKnnDistance;
+
+static int rpknndistNext(ResultProcessor *base, SearchResult *res) {
+  RPKnnDistance *self = (RPKnnDistance *)base;
+  int rc = base->upstream->Next(base->upstream, res);
+  if (rc == RS_RESULT_OK && res->indexResult && res->indexResult->type == RSResultType_Numeric) {
+    RLookup_WriteOwnKey(self->distanceKey, &res->rowdata, RS_NumVal(res->indexResult->num.value));
+    res->score = res->indexResult->num.value;
+  }
+  return rc;
+}
+
+static void rpknndistFree(ResultProcessor *rp) {
+  rm_free(rp);
+}
+
+ResultProcessor *RPKnnDistance_New(const RLookupKey *distanceKey) {
+  RPKnnDistance *ret = rm_calloc(1, sizeof(*ret));
+  ret->distanceKey = distanceKey;
+  ret->base.Next = rpknndistNext;
+  ret->base.Free = rpknndistFree;
+  ret->base.name = "KnnDistance";
+  return &ret->base;
+}
+
 /*******************************************************************************************************************
  *  Sorting Processor
  *
@@ -222,8 +500,10 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
  * The sorter takes scored results from the scorer (or in the case of SORTBY, the raw results), and
  * maintains a heap of the top N results.
  *
- * Since we need it to be thread safe, every result that's put on the heap is copied, including its
- * index result tree.
+ * Since we need it to be thread safe, the index result of every result put on the heap is dropped,
+ * and the results read from the index are only held by their id, score and sort keys until they
+ * are yielded, see RPSorterEntry. Highlighting looks up the index result of a yielded document
+ * again.
  *
  * This means that from here down-stream, everything is thread safe, but we also need to properly
  * free discarded results.
@@ -238,6 +518,21 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
 
 typedef int (*RPSorterCompareFunc)(const void *e1, const void *e2, const void *udata);
 
+/* An entry of the heap. A result read from the index is held only by what orders it: its id, its
+ * score, and when sorting by fields, its document, whose sorting vector holds the sort keys. The
+ * rest of the result is derived again from the document when it is yielded, so nothing more is
+ * kept for the candidates which do not make it to the top. Any other result is held whole */
+typedef struct {
+  t_docId docId;
+  double score;
+  // referenced when sorting by fields
+  RSDocumentMetadata *dmd;
+  // the whole result, if it carries more than its document
+  SearchResult *full;
+  // when sorting by fields, their normalized key, see sort_key.h
+  char sortKey[];
+} RPSorterEntry;
+
 typedef struct {
   ResultProcessor base;
 
@@ -257,8 +552,9 @@ typedef struct {
   // private data for the compare function
   void *cmpCtx;
 
-  // pooled result - we recycle it to avoid allocations
+  // pooled result and entry - we recycle them to avoid allocations
   SearchResult *pooledResult;
+  RPSorterEntry *pooledEntry;
 
   struct {
     const RLookupKey **keys;
@@ -272,23 +568,59 @@ typedef struct {
 static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
   // make sure we don't overshoot the heap size, unless the heap size is dynamic
-  if (self->pq->count > 0 && (!self->size || self->offset++ < self->size)) {
-    SearchResult *sr = mmh_pop_max(self->pq);
-    RLookupRow oldrow = r->rowdata;
-    *r = *sr;
+  while (self->pq->count > 0 && (!self->size || self->offset++ < self->size)) {
+    RPSorterEntry *e = mmh_pop_max(self->pq);
+    if (e->full) {
+      RLookupRow oldrow = r->rowdata;
+      *r = *e->full;
+
+      // the result itself is left in the arena of the request
+      RLookupRow_Cleanup(&oldrow);
+      return RS_RESULT_OK;
+    }
+
+    RSDocumentMetadata *dmd = e->dmd;
+    if (!dmd && (dmd = DocTable_Get(&RP_SPEC(rp)->docs, e->docId))) {
+      DMD_Incref(dmd);
+    }
+    if (!dmd || (dmd->flags & Document_Deleted)) {
+      // deleted since it was read
+      if (dmd) {
+        DMD_Decref(dmd);
+      }
+      self->offset--;
+      rp->parent->totalResults--;
+      continue;
+    }
 
-    rm_free(sr);
-    RLookupRow_Cleanup(&oldrow);
+    RLookupRow_Wipe(&r->rowdata);
+    r->docId = e->docId;
+    r->score = e->score;
+    r->scoreExplain = NULL;
+    r->indexResult = NULL;
+    r->dmd = dmd;
+    r->rowdata.sv = dmd->sortVector;
     return RS_RESULT_OK;
   }
   return RS_RESULT_EOF;
 }
 
+static void sortEntryDtor(void *p) {
+  RPSorterEntry *e = p;
+  if (!e) {
+    return;
+  }
+  if (e->full) {
+    SearchResult_Destroy(e->full);
+  } else if (e->dmd) {
+    DMD_Decref(e->dmd);
+  }
+}
+
 static void rpsortFree(ResultProcessor *rp) {
   RPSorter *self = (RPSorter *)rp;
   if (self->pooledResult) {
     SearchResult_Destroy(self->pooledResult);
-    rm_free(self->pooledResult);
   }
 
   // calling mmh_free will free all the remaining results in the heap, if any
@@ -296,16 +628,52 @@ static void rpsortFree(ResultProcessor *rp) {
   rm_free(rp);
 }
 
+/* The entry was pushed to the heap, taking what it needs from the result it was made of */
+static void rpsortKeep(RPSorter *self, RPSorterEntry *e, SearchResult *h) {
+  if (e->full) {
+    // the index result belongs to the iterator, which moves on
+    h->indexResult = NULL;
+    self->pooledResult = NULL;
+  } else {
+    if (e->dmd) {
+      h->dmd = NULL;
+    }
+    SearchResult_Clear(h);
+  }
+  self->pooledEntry = NULL;
+}
+
+/* The entry was evicted from the heap, recycle it */
+static void rpsortRecycle(RPSorter *self, RPSorterEntry *e) {
+  if (e->full) {
+    if (!self->pooledResult) {
+      SearchResult_Clear(e->full);
+      self->pooledResult = e->full;
+    } else {
+      SearchResult_Destroy(e->full);
+    }
+  } else if (e->dmd) {
+    DMD_Decref(e->dmd);
+  }
+  self->pooledEntry = e;
+}
+
 #define RESULT_QUEUED RS_RESULT_MAX + 1
 
 static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
 
   if (self->pooledResult == NULL) {
-    self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
+    // the results held by the heap are allocated from the request, and recycled once evicted
+    self->pooledResult = QITR_Alloc(rp->parent, sizeof(*self->pooledResult));
+    memset(self->pooledResult, 0, sizeof(*self->pooledResult));
   } else {
     RLookupRow_Wipe(&self->pooledResult->rowdata);
   }
+  if (self->pooledEntry == NULL) {
+    self->pooledEntry =
+        QITR_Alloc(rp->parent, sizeof(*self->pooledEntry) + SortKey_Size(self->fieldcmp.nkeys));
+  }
 
   SearchResult *h = self->pooledResult;
   int rc = rp->upstream->Next(rp->upstream, h);
@@ -320,37 +688,52 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
     return rc;
   }
 
+  // A result with nothing but its document, as read from the index, is held by its entry alone.
+  // Its document is borrowed from the result to compare it, and kept only if it is pushed
+  RPSorterEntry *e = self->pooledEntry;
+  e->docId = h->docId;
+  e->score = h->score;
+  if (h->dmd && !h->scoreExplain && !h->rowdata.ndyn && h->rowdata.sv == h->dmd->sortVector) {
+    e->dmd = self->fieldcmp.nkeys ? h->dmd : NULL;
+    e->full = NULL;
+  } else {
+    e->dmd = NULL;
+    e->full = h;
+  }
+  if (self->fieldcmp.nkeys) {
+    // either way, the row of the result holds the fields of the entry
+    SortKey_Encode(e->sortKey, self->fieldcmp.keys, self->fieldcmp.nkeys, self->fieldcmp.ascendMap,
+                   &h->rowdata);
+  }
+
   // If the queue is not full - we just push the result into it
   // If the pool size is 0 we always do that, letting the heap grow dynamically
   if (!self->size || self->pq->count + 1 < self->pq->size) {
 
-    // copy the index result to make it thread safe - but only if it is pushed to the heap
-    h->indexResult = NULL;
-    mmh_insert(self->pq, h);
-    self->pooledResult = NULL;
-    if (h->score < rp->parent->minScore) {
-      rp->parent->minScore = h->score;
+    mmh_insert(self->pq, e);
+    rpsortKeep(self, e, h);
+    if (e->score < rp->parent->minScore) {
+      rp->parent->minScore = e->score;
     }
 
   } else {
     // find the min result
-    SearchResult *minh = mmh_peek_min(self->pq);
+    RPSorterEntry *mine = mmh_peek_min(self->pq);
 
     // update the min score. Irrelevant to SORTBY mode but hardly costs anything...
-    if (minh->score > rp->parent->minScore) {
-      rp->parent->minScore = minh->score;
+    if (mine->score > rp->parent->minScore) {
+      rp->parent->minScore = mine->score;
     }
 
     // if needed - pop it and insert a new result
-    if (self->cmp(h, minh, self->cmpCtx) > 0) {
-      h->indexResult = NULL;
-      self->pooledResult = mmh_pop_min(self->pq);
-      mmh_insert(self->pq, h);
-      SearchResult_Clear(self->pooledResult);
+    if (self->cmp(e, mine, self->cmpCtx) > 0) {
+      mine = mmh_pop_min(self->pq);
+      mmh_insert(self->pq, e);
+      rpsortKeep(self, e, h);
+      rpsortRecycle(self, mine);
     } else {
       // The current should not enter the pool, so just leave it as is
-      self->pooledResult = h;
-      SearchResult_Clear(self->pooledResult);
+      SearchResult_Clear(h);
     }
   }
   return RESULT_QUEUED;
@@ -366,7 +749,7 @@ static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
 
 /* Compare results for the heap by score */
 static inline int cmpByScore(const void *e1, const void *e2, const void *udata) {
-  const SearchResult *h1 = e1, *h2 = e2;
+  const RPSorterEntry *h1 = e1, *h2 = e2;
 
   if (h1->score < h2->score) {
     return -1;
@@ -376,24 +759,37 @@ static inline int cmpByScore(const void *e1, const void *e2, const void *udata)
   return h1->docId < h2->docId ? -1 : 1;
 }
 
+static inline const RSValue *sortEntryGetItem(const RPSorterEntry *e, const RLookupKey *key) {
+  if (e->full) {
+    return RLookup_GetItem(key, &e->full->rowdata);
+  }
+  RLookupRow row = {.sv = e->dmd->sortVector};
+  return RLookup_GetItem(key, &row);
+}
+
 /* Compare results for the heap by sorting key */
 static int cmpByFields(const void *e1, const void *e2, const void *udata) {
   const RPSorter *self = udata;
-  const SearchResult *h1 = e1, *h2 = e2;
+  const RPSorterEntry *h1 = e1, *h2 = e2;
   int ascending = 0;
 
+  // most comparisons are decided by the first bytes of the fields
+  int rc = SortKey_Cmp(h1->sortKey, h2->sortKey, self->fieldcmp.nkeys);
+  if (rc) {
+    return rc;
+  }
+
   QueryError *qerr = NULL;
   if (self && self->base.parent && self->base.parent->err) {
     qerr = self->base.parent->err;
   }
 
   for (size_t i = 0; i < self->fieldcmp.nkeys && i < SORTASCMAP_MAXFIELDS; i++) {
-    const RSValue *v1 = RLookup_GetItem(self->fieldcmp.keys[i], &h1->rowdata);
-    const RSValue *v2 = RLookup_GetItem(self->fieldcmp.keys[i], &h2->rowdata);
+    const RSValue *v1 = sortEntryGetItem(h1, self->fieldcmp.keys[i]);
+    const RSValue *v2 = sortEntryGetItem(h2, self->fieldcmp.keys[i]);
     // take the ascending bit for this property from the ascending bitmap
     ascending = SORTASCMAP_GETASC(self->fieldcmp.ascendMap, i);
     if (!v1 || !v2) {
-      int rc;
       if (v1) {
         rc = 1;
       } else if (v2) {
@@ -404,27 +800,14 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
       return ascending ? -rc : rc;
     }
 
-    int rc = RSValue_Cmp(v1, v2, qerr);
-    // printf("asc? %d Compare: \n", ascending);
-    // RSValue_Print(v1);
-    // printf(" <=> ");
-    // RSValue_Print(v2);
-    // printf("\n");
-
+    rc = RSValue_Cmp(v1, v2, qerr);
     if (rc != 0) return ascending ? -rc : rc;
   }
 
-  int rc = h1->docId < h2->docId ? -1 : 1;
+  rc = h1->docId < h2->docId ? -1 : 1;
   return ascending ? -rc : rc;
 }
 
-static void srDtor(void *p) {
-  if (p) {
-    SearchResult_Destroy(p);
-    rm_free(p);
-  }
-}
-
 ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys, size_t nkeys,
                                       uint64_t ascmap) {
   RPSorter *ret = rm_calloc(1, sizeof(*ret));
@@ -434,10 +817,11 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
   ret->fieldcmp.keys = keys;
   ret->fieldcmp.nkeys = nkeys;
 
-  ret->pq = mmh_init_with_size(maxresults + 1, ret->cmp, ret->cmpCtx, srDtor);
+  ret->pq = mmh_init_with_size(maxresults + 1, ret->cmp, ret->cmpCtx, sortEntryDtor);
   ret->size = maxresults;
   ret->offset = 0;
   ret->pooledResult = NULL;
+  ret->pooledEntry = NULL;
   ret->base.Next = rpsortNext_Accum;
   ret->base.Free = rpsortFree;
   ret->base.name = "Sorter";
@@ -11,6 +11,8 @@
 #include "rlookup.h"
 #include "extension.h"
 #include "score_explain.h"
+#include "util/block_alloc.h"
+#include "numeric_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,7 +49,7 @@ typedef enum {
 struct ResultProcessor;
 struct RLookup;
 
-typedef struct {
+typedef struct QueryIterator {
   // First processor
   struct ResultProcessor *rootProc;
 
@@ -74,12 +76,26 @@ typedef struct {
   QITRState state;
 
   struct timespec startTime;
+
+  // memory allocated for the lifetime of the request, see QITR_Alloc
+  BlkAlloc arena;
 } QueryIterator, QueryProcessingCtx;
 
 IndexIterator *QITR_GetRootFilter(QueryIterator *it);
 void QITR_PushRP(QueryIterator *it, struct ResultProcessor *rp);
 void QITR_FreeChain(QueryIterator *qitr);
 
+/**
+ * Allocate memory for the lifetime of the request from the arena of the iterator, suitably
+ * aligned for any type. It is never freed on its own, but released at once with the whole arena
+ * by QITR_FreeArena, which the request calls when it is freed. The sorter keeps the result and
+ * entry it fills from upstream there.
+ */
+void *QITR_Alloc(QueryIterator *it, size_t sz);
+
+/** Release everything allocated from the arena of the iterator */
+void QITR_FreeArena(QueryIterator *it);
+
 /*
  * SearchResult - the object all the processing chain is working on.
  * It has the indexResult which is what the index scan brought - scores, vectors, flags, etc.
@@ -174,9 +190,23 @@ void SearchResult_Destroy(SearchResult *r);
 
 ResultProcessor *RPIndexIterator_New(IndexIterator *itr);
 
+/** Reads the results of the root iterator in the order of a sortable numeric field, for a sorter
+ * by this field keeping `limit` results. The leaves of the field's tree are visited in the order of
+ * the sort, each intersected with the root iterator, and the reading stops at the end of the first
+ * leaf reaching `limit` results, as the results of the next leaves can no longer make it to the
+ * top. The results without a value are read first when ascending, and last when descending. As
+ * not all the results are read, the total number of results is only a lower bound */
+ResultProcessor *RPIndexIterator_NewNumericOrder(IndexIterator *itr, NumericRangeTree *tree,
+                                                 const RLookupKey *sortKey, int ascending,
+                                                 size_t limit);
+
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs);
 
+/** Writes the distance returned by a GEOKNN or VECTORKNN iterator into `distanceKey`, and makes it
+ * the score of the result */
+ResultProcessor *RPKnnDistance_New(const RLookupKey *distanceKey);
+
 /** Functions abstracting the sortmap. Hides the bitwise logic */
 #define SORTASCMAP_INIT 0xFFFFFFFFFFFFFFFF
 #define SORTASCMAP_MAXFIELDS 8
@@ -1,9 +1,12 @@
 #include "rules.h"
 #include "aggregate/expr/expression.h"
 #include "spec.h"
+#include "rlookup.h"
+#include "value.h"
 
 arrayof(SchemaRule *) SchemaRules_g;
-TrieMap *ScemaPrefixes_g;
+
+static void SchemaRules_Changed();
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -81,11 +84,8 @@ SchemaRule *SchemaRule_Create(SchemaRuleArgs *args, IndexSpec *spec, QueryError
     }
   }
 
-  for (int i = 0; i < array_len(rule->prefixes); ++i) {
-    SchemaPrefixes_Add(rule->prefixes[i], spec);
-  }
-
   SchemaRules_g = array_append(SchemaRules_g, rule);
+  SchemaRules_Changed();
   return rule;
 
 error:
@@ -94,7 +94,6 @@ error:
 }
 
 void SchemaRule_Free(SchemaRule *rule) {
-  SchemaPrefixes_RemoveSpec(rule->spec);
   SchemaRules_RemoveSpecRules(rule->spec);
 
   rm_free((void *)rule->lang_field);
@@ -110,22 +109,6 @@ void SchemaRule_Free(SchemaRule *rule) {
 
 //---------------------------------------------------------------------------------------------
 
-static SchemaPrefixNode *SchemaPrefixNode_Create(const char *prefix, IndexSpec *index) {
-  SchemaPrefixNode *node = rm_calloc(1, sizeof(*node));
-  node->prefix = rm_strdup(prefix);
-  node->index_specs = array_new(IndexSpec *, 1);
-  node->index_specs = array_append(node->index_specs, index);
-  return node;
-}
-
-static void SchemaPrefixNode_Free(SchemaPrefixNode *node) {
-  array_free(node->index_specs);
-  rm_free(node->prefix);
-  rm_free(node);
-}
-
-//---------------------------------------------------------------------------------------------
-
 RSLanguage SchemaRule_HashLang(RedisModuleCtx *rctx, const SchemaRule *rule, RedisModuleKey *key,
                                const char *kname) {
   RSLanguage lang = rule->lang_default;
@@ -207,6 +190,7 @@ void SchemaRules_RemoveSpecRules(IndexSpec *spec) {
     SchemaRule *rule = SchemaRules_g[i];
     if (spec == rule->spec) {
       array_del_fast(SchemaRules_g, i);
+      SchemaRules_Changed();
       return;
     }
   }
@@ -308,50 +292,314 @@ void SchemaRule_RdbSave(SchemaRule *rule, RedisModuleIO *rdb) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-void SchemaPrefixes_Create() {
-  ScemaPrefixes_g = NewTrieMap();
+/* The compiled form of all the rules, matched against the key of every hash written.
+ *
+ * The prefixes are merged into one trie, flattened into arrays: the edges of state `s` are
+ * `edges[s]` to `edges[s + 1]`, sorted by label. Every state has the bitmap of the rules whose
+ * prefix leads to it or to one of its ancestors, so the rules matching a key are those of the last
+ * state a walk along the key reaches. The filters share one lookup, holding the hash fields they
+ * read, which is refilled for every key */
+typedef struct {
+  bool compiled;
+  size_t nwords;
+  arrayof(uint32_t) edges;
+  arrayof(unsigned char) labels;
+  arrayof(uint32_t) targets;
+  arrayof(SchemaRuleBits) bits;
+
+  RLookup lk;
+  RLookupRow row;
+  RLookupKey *keyField;
+  // the hash fields read by the filter of each rule, or NULL if it has none
+  arrayof(arrayof(RLookupKey *)) filterFields;
+  // the key for which each field of the lookup was last loaded, to load it once per key
+  arrayof(uint64_t) loadedFor;
+  uint64_t keyCount;
+  ExprEval ee;
+  QueryError status;
+  RSValue res;
+} SchemaMatcher;
+
+static SchemaMatcher matcher_g;
+
+static void SchemaRules_Changed() {
+  matcher_g.compiled = false;
 }
 
-static void freePrefixNode(void *ctx) {
-  SchemaPrefixNode_Free(ctx);
+// the trie of the prefixes, before it is flattened
+typedef struct {
+  arrayof(uint32_t) children;
+  uint32_t parent;
+  unsigned char label;
+} prefixNode;
+
+static uint32_t prefixTrie_Add(arrayof(prefixNode) *nodes, const char *prefix) {
+  uint32_t cur = 0;
+  for (const unsigned char *p = (const unsigned char *)prefix; *p; p++) {
+    arrayof(uint32_t) children = (*nodes)[cur].children;
+    uint32_t pos = 0;
+    while (pos < array_len(children) && (*nodes)[children[pos]].label < *p) {
+      pos++;
+    }
+    if (pos < array_len(children) && (*nodes)[children[pos]].label == *p) {
+      cur = children[pos];
+      continue;
+    }
+    prefixNode node = {.children = array_new(uint32_t, 1), .parent = cur, .label = *p};
+    uint32_t id = array_len(*nodes);
+    *nodes = array_append(*nodes, node);
+    // keep the children sorted by label, for the binary search of the match
+    children = array_ensure_len(children, array_len(children) + 1);
+    memmove(children + pos + 1, children + pos, (array_len(children) - pos - 1) * sizeof(*children));
+    children[pos] = id;
+    (*nodes)[cur].children = children;
+    cur = id;
+  }
+  return cur;
+}
+
+static void collectFilterFields(RSExpr *e, arrayof(RLookupKey *) *fields) {
+  if (!e) {
+    return;
+  }
+  switch (e->t) {
+    case RSExpr_Property: {
+      RLookupKey *k = RLookup_GetKey(&matcher_g.lk, e->property.key,
+                                     RLOOKUP_F_OCREAT | RLOOKUP_F_NAMEALLOC);
+      if (k == matcher_g.keyField) {
+        return;
+      }
+      for (uint32_t i = 0; i < array_len(*fields); i++) {
+        if ((*fields)[i] == k) {
+          return;
+        }
+      }
+      *fields = array_append(*fields, k);
+      break;
+    }
+    case RSExpr_Function:
+      for (size_t i = 0; i < e->func.args->len; i++) {
+        collectFilterFields(e->func.args->args[i], fields);
+      }
+      break;
+    case RSExpr_Op:
+      collectFilterFields(e->op.left, fields);
+      collectFilterFields(e->op.right, fields);
+      break;
+    case RSExpr_Predicate:
+      collectFilterFields(e->pred.left, fields);
+      collectFilterFields(e->pred.right, fields);
+      break;
+    case RSExpr_Inverted:
+      collectFilterFields(e->inverted.child, fields);
+      break;
+    default:
+      break;
+  }
 }
 
-void SchemaPrefixes_Free() {
-  TrieMap_Free(ScemaPrefixes_g, freePrefixNode);
+void SchemaRules_FreeMatcher() {
+  SchemaMatcher *m = &matcher_g;
+  array_free(m->edges);
+  array_free(m->labels);
+  array_free(m->targets);
+  array_free(m->bits);
+  if (m->filterFields) {
+    array_free_ex(m->filterFields, array_free(*(arrayof(RLookupKey *) *)ptr));
+  }
+  array_free(m->loadedFor);
+  RLookupRow_Cleanup(&m->row);
+  RLookup_Cleanup(&m->lk);
+  BlkAlloc_FreeAll(&m->ee.stralloc, NULL, NULL, 0);
+  memset(m, 0, sizeof(*m));
 }
 
-void SchemaPrefixes_Add(const char *prefix, IndexSpec *spec) {
-  size_t nprefix = strlen(prefix);
-  void *p = TrieMap_Find(ScemaPrefixes_g, (char *)prefix, nprefix);
-  if (p == TRIEMAP_NOTFOUND) {
-    SchemaPrefixNode *node = SchemaPrefixNode_Create(prefix, spec);
-    TrieMap_Add(ScemaPrefixes_g, (char *)prefix, nprefix, node, NULL);
-  } else {
-    SchemaPrefixNode *node = (SchemaPrefixNode *)p;
-    node->index_specs = array_append(node->index_specs, spec);
+static void SchemaRules_Compile() {
+  SchemaRules_FreeMatcher();
+  SchemaMatcher *m = &matcher_g;
+  size_t nrules = array_len(SchemaRules_g);
+  m->nwords = MAX(1, (nrules + SCHEMA_RULE_BITS - 1) / SCHEMA_RULE_BITS);
+
+  arrayof(prefixNode) nodes = array_new(prefixNode, 16);
+  prefixNode root = {.children = array_new(uint32_t, 1)};
+  nodes = array_append(nodes, root);
+  arrayof(uint32_t) ends = array_new(uint32_t, nrules);
+  arrayof(uint32_t) endRules = array_new(uint32_t, nrules);
+  for (size_t i = 0; i < nrules; i++) {
+    SchemaRule *rule = SchemaRules_g[i];
+    for (uint32_t j = 0; j < array_len(rule->prefixes); j++) {
+      uint32_t end = prefixTrie_Add(&nodes, rule->prefixes[j]);
+      ends = array_append(ends, end);
+      endRules = array_append(endRules, i);
+    }
+  }
+
+  size_t nstates = array_len(nodes);
+  m->edges = array_new(uint32_t, nstates + 1);
+  m->labels = array_new(unsigned char, nstates);
+  m->targets = array_new(uint32_t, nstates);
+  m->bits = array_ensure_len(array_new(SchemaRuleBits, nstates * m->nwords), nstates * m->nwords);
+  memset(m->bits, 0, nstates * m->nwords * sizeof(*m->bits));
+  for (uint32_t i = 0; i < array_len(ends); i++) {
+    SchemaRuleBits *bits = m->bits + ends[i] * m->nwords;
+    bits[endRules[i] / SCHEMA_RULE_BITS] |= 1ULL << (endRules[i] % SCHEMA_RULE_BITS);
+  }
+  for (uint32_t s = 0; s < nstates; s++) {
+    m->edges = array_append(m->edges, array_len(m->targets));
+    for (uint32_t i = 0; i < array_len(nodes[s].children); i++) {
+      uint32_t child = nodes[s].children[i];
+      m->labels = array_append(m->labels, nodes[child].label);
+      m->targets = array_append(m->targets, child);
+    }
+    // a node is always added after its parent
+    if (s > 0) {
+      SchemaRuleBits *bits = m->bits + s * m->nwords;
+      const SchemaRuleBits *parentBits = m->bits + nodes[s].parent * m->nwords;
+      for (size_t w = 0; w < m->nwords; w++) {
+        bits[w] |= parentBits[w];
+      }
+    }
+    array_free(nodes[s].children);
   }
+  m->edges = array_append(m->edges, array_len(m->targets));
+  array_free(nodes);
+  array_free(ends);
+  array_free(endRules);
+
+  RLookup_Init(&m->lk, NULL);
+  m->keyField = RLookup_GetKey(&m->lk, "__key", RLOOKUP_F_OCREAT);
+  m->filterFields = array_new(arrayof(RLookupKey *), nrules);
+  for (size_t i = 0; i < nrules; i++) {
+    SchemaRule *rule = SchemaRules_g[i];
+    arrayof(RLookupKey *) fields = NULL;
+    if (rule->filter_exp) {
+      fields = array_new(RLookupKey *, 1);
+      collectFilterFields(rule->filter_exp, &fields);
+      // every property now has a key, so this cannot fail
+      ExprAST_GetLookupKeys(rule->filter_exp, &m->lk, &m->status);
+    }
+    m->filterFields = array_append(m->filterFields, fields);
+  }
+  m->loadedFor = array_ensure_len(array_new(uint64_t, m->lk.rowlen), m->lk.rowlen);
+  memset(m->loadedFor, 0, m->lk.rowlen * sizeof(*m->loadedFor));
+  m->ee.lookup = &m->lk;
+  m->ee.srcrow = &m->row;
+  m->ee.err = &m->status;
+  BlkAlloc_Init(&m->ee.stralloc);
+  m->compiled = true;
 }
 
-void SchemaPrefixes_RemoveSpec(IndexSpec *spec) {
-  TrieMapIterator *it = TrieMap_Iterate(ScemaPrefixes_g, "", 0);
-  while (true) {
-    char *p;
-    tm_len_t len;
-    SchemaPrefixNode *node = NULL;
-    if (!TrieMapIterator_Next(it, &p, &len, (void **)&node)) {
-      break;
+size_t SchemaRules_MatchWords() {
+  if (!matcher_g.compiled) {
+    SchemaRules_Compile();
+  }
+  return matcher_g.nwords;
+}
+
+static uint32_t SchemaMatcher_Step(const SchemaMatcher *m, uint32_t s, unsigned char c) {
+  uint32_t lo = m->edges[s], hi = m->edges[s + 1];
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (m->labels[mid] < c) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
-    if (!node) {
-      return;
+  }
+  // the root is no state's child
+  return lo < m->edges[s + 1] && m->labels[lo] == c ? m->targets[lo] : 0;
+}
+
+/* Load the fields a filter reads, each once per key. Returns false if the hash lacks one of them,
+ * in which case the filter is not evaluated and the rule matches, as the filter fails to compile
+ * against the hash */
+static bool SchemaMatcher_LoadFields(SchemaMatcher *m, RedisModuleKey *k,
+                                     arrayof(RLookupKey *) fields) {
+  bool found = true;
+  for (uint32_t i = 0; i < array_len(fields); i++) {
+    RLookupKey *field = fields[i];
+    if (m->loadedFor[field->dstidx] != m->keyCount) {
+      m->loadedFor[field->dstidx] = m->keyCount;
+      RedisModuleString *val = NULL;
+      if (k) {
+        RedisModule_HashGet(k, REDISMODULE_HASH_CFIELDS, field->name, &val, NULL);
+      }
+      if (val) {
+        RLookup_WriteOwnKey(field, &m->row, RS_StealRedisStringVal(val));
+      }
     }
-    for (int i = 0; i < array_len(node->index_specs); ++i) {
-      if (node->index_specs[i] == spec) {
-        array_del_fast(node->index_specs, i);
-        break;
+    found = found && RLookup_GetItem(field, &m->row);
+  }
+  return found;
+}
+
+void SchemaRules_Match(RedisModuleCtx *ctx, RedisModuleString *key, SchemaRuleBits *matches) {
+  SchemaMatcher *m = &matcher_g;
+  if (!m->compiled) {
+    SchemaRules_Compile();
+  }
+
+  size_t len;
+  const unsigned char *p = (const unsigned char *)RedisModule_StringPtrLen(key, &len);
+  uint32_t s = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint32_t next = SchemaMatcher_Step(m, s, p[i]);
+    if (!next) {
+      break;
+    }
+    s = next;
+  }
+  memcpy(matches, m->bits + s * m->nwords, m->nwords * sizeof(*matches));
+
+  RedisModuleKey *k = NULL;
+  bool loaded = false;
+  for (size_t w = 0; w < m->nwords; w++) {
+    for (SchemaRuleBits word = matches[w]; word; word &= word - 1) {
+      size_t i = w * SCHEMA_RULE_BITS + __builtin_ctzll(word);
+      if (!m->filterFields[i]) {
+        continue;
+      }
+      if (!loaded) {
+        // load the hash only if required
+        loaded = true;
+        m->keyCount++;
+        k = RedisModule_OpenKey(ctx, key, REDISMODULE_READ);
+        if (k && RedisModule_KeyType(k) != REDISMODULE_KEYTYPE_HASH) {
+          RedisModule_CloseKey(k);
+          k = NULL;
+        }
+        RLookup_WriteOwnKey(m->keyField, &m->row, RS_RedisStringVal(key));
+      }
+      if (!SchemaMatcher_LoadFields(m, k, m->filterFields[i])) {
+        continue;
       }
+      m->ee.root = SchemaRules_g[i]->filter_exp;
+      if (ExprEval_Eval(&m->ee, &m->res) == EXPR_EVAL_OK && !RSValue_BoolTest(&m->res)) {
+        SchemaRuleBits_Clear(matches, i);
+      }
+      RSValue_Clear(&m->res);
+      QueryError_ClearError(&m->status);
+    }
+  }
+
+  if (loaded) {
+    if (k) {
+      RedisModule_CloseKey(k);
+    }
+    RLookupRow_Wipe(&m->row);
+    BlkAlloc_Clear(&m->ee.stralloc, NULL, NULL, 0);
+  }
+}
+
+int SchemaRules_NextMatch(SchemaRuleBits *matches, size_t nwords) {
+  for (size_t w = 0; w < nwords; w++) {
+    if (matches[w]) {
+      int i = __builtin_ctzll(matches[w]);
+      matches[w] &= matches[w] - 1;
+      return w * SCHEMA_RULE_BITS + i;
     }
   }
-  TrieMapIterator_Free(it);
+  return -1;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,8 @@
 #include "dep/triemap/triemap.h"
 #include "stemmer.h"
 #include "util/arr.h"
+#include <stdbool.h>
+#include <stdint.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -65,17 +67,35 @@ int SchemaRule_RdbLoad(struct IndexSpec *sp, RedisModuleIO *rdb, int encver);
 
 //---------------------------------------------------------------------------------------------
 
-extern TrieMap *ScemaPrefixes_g;
+/* The rules matching a key, one bit per rule of SchemaRules_g */
+typedef uint64_t SchemaRuleBits;
 
-void SchemaPrefixes_Create();
-void SchemaPrefixes_Free();
-void SchemaPrefixes_Add(const char *prefix, struct IndexSpec *index);
-void SchemaPrefixes_RemoveSpec(struct IndexSpec *spec);
+#define SCHEMA_RULE_BITS 64
 
-typedef struct {
-  char *prefix;
-  arrayof(struct IndexSpec *) index_specs;
-} SchemaPrefixNode;
+static inline bool SchemaRuleBits_Test(const SchemaRuleBits *bits, size_t i) {
+  return bits[i / SCHEMA_RULE_BITS] & (1ULL << (i % SCHEMA_RULE_BITS));
+}
+
+static inline void SchemaRuleBits_Clear(SchemaRuleBits *bits, size_t i) {
+  bits[i / SCHEMA_RULE_BITS] &= ~(1ULL << (i % SCHEMA_RULE_BITS));
+}
+
+/* The number of words of a match bitmap, which the caller allocates (usually on the stack) */
+size_t SchemaRules_MatchWords();
+
+/* Find the rules whose prefixes and filter match the key.
+ *
+ * The prefixes of all the rules are compiled into one trie, walked once along the key, and the
+ * filters into one lookup, so that only the hash fields they read are loaded. Only the filters of
+ * the rules whose prefix matched are evaluated. The compiled form is rebuilt on the first match
+ * after the rules change */
+void SchemaRules_Match(RedisModuleCtx *ctx, RedisModuleString *key, SchemaRuleBits *matches);
+
+/* Remove the first rule from the match bitmap, returning its index in SchemaRules_g, or -1 if the
+ * bitmap is empty */
+int SchemaRules_NextMatch(SchemaRuleBits *matches, size_t nwords);
+
+void SchemaRules_FreeMatcher();
 
 #ifdef __cplusplus
 }
@@ -91,6 +91,12 @@ typedef struct {
 
   const StopWordList *stopwords;
 
+  // Nearest neighbour filter set by GEOKNN, or NULL
+  GeoFilter *geoKnn;
+
+  // Vector nearest neighbour search set by VECTORKNN, or NULL
+  struct VectorQuery *vectorKnn;
+
   /** Legacy options */
   struct {
     NumericFilter **filters;
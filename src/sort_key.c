@@ -0,0 +1,100 @@
+#include "sort_key.h"
+#include "result_processor.h"
+
+#include <math.h>
+#include <string.h>
+
+// the tag of a field is the type of its value, with the low bit set if its bytes are only a prefix
+#define TAG_PREFIX 0x01
+// the tag of a field whose value cannot be ordered by its bytes
+#define TAG_INEXACT 0xFF
+
+#define FIELD_PAYLOAD_SIZE (SORTKEY_FIELD_SIZE - 1)
+
+size_t SortKey_Size(size_t nkeys) {
+  return MIN(nkeys, SORTASCMAP_MAXFIELDS) * SORTKEY_FIELD_SIZE;
+}
+
+static void encodeNumber(uint8_t *payload, double d) {
+  uint64_t bits;
+  if (d == 0) {
+    // -0 compares equal to 0
+    d = 0;
+  }
+  memcpy(&bits, &d, sizeof(bits));
+  // negative numbers order backwards by their magnitude, and before the positive ones
+  bits = (bits & (1ULL << 63)) ? ~bits : bits | (1ULL << 63);
+  for (int i = FIELD_PAYLOAD_SIZE - 1; i >= 0; i--) {
+    payload[i] = bits & 0xFF;
+    bits >>= 8;
+  }
+}
+
+static uint8_t encodeField(uint8_t *payload, const RSValue *v) {
+  memset(payload, 0, FIELD_PAYLOAD_SIZE);
+  if (!v) {
+    return TAG_INEXACT;
+  }
+  v = RSValue_Dereference(v);
+  switch (v->t) {
+    case RSValue_Number:
+      if (isnan(v->numval)) {
+        return TAG_INEXACT;
+      }
+      encodeNumber(payload, v->numval);
+      return v->t << 1;
+
+    case RSValue_String:
+    case RSValue_RedisString:
+    case RSValue_OwnRstring: {
+      size_t len;
+      const char *s = RSValue_StringPtrLen(v, &len);
+      size_t n = MIN(len, FIELD_PAYLOAD_SIZE);
+      // strings are compared up to their first NUL, which their bytes do not tell
+      if (memchr(s, '\0', n)) {
+        return TAG_INEXACT;
+      }
+      memcpy(payload, s, n);
+      return (v->t << 1) | (len > FIELD_PAYLOAD_SIZE ? TAG_PREFIX : 0);
+    }
+
+    default:
+      // compared as equal to any other value of their type
+      return v->t << 1;
+  }
+}
+
+void SortKey_Encode(char *buf, const RLookupKey **keys, size_t nkeys, uint64_t ascendMap,
+                    const RLookupRow *row) {
+  uint8_t *p = (uint8_t *)buf;
+  for (size_t i = 0; i < nkeys && i < SORTASCMAP_MAXFIELDS; i++, p += SORTKEY_FIELD_SIZE) {
+    p[0] = encodeField(p + 1, RLookup_GetItem(keys[i], row));
+    if (SORTASCMAP_GETASC(ascendMap, i)) {
+      for (size_t j = 1; j < SORTKEY_FIELD_SIZE; j++) {
+        p[j] = ~p[j];
+      }
+    }
+  }
+}
+
+int SortKey_Cmp(const char *k1, const char *k2, size_t nkeys) {
+  const uint8_t *p1 = (const uint8_t *)k1, *p2 = (const uint8_t *)k2;
+  for (size_t i = 0; i < nkeys && i < SORTASCMAP_MAXFIELDS;
+       i++, p1 += SORTKEY_FIELD_SIZE, p2 += SORTKEY_FIELD_SIZE) {
+    uint8_t t1 = p1[0], t2 = p2[0];
+    // values of different types are converted to be compared
+    if (t1 == TAG_INEXACT || t2 == TAG_INEXACT || (t1 | TAG_PREFIX) != (t2 | TAG_PREFIX)) {
+      return 0;
+    }
+    int rc = memcmp(p1 + 1, p2 + 1, FIELD_PAYLOAD_SIZE);
+    if (rc) {
+      return rc;
+    }
+    if ((t1 | t2) & TAG_PREFIX) {
+      // the same prefix, the rest of the strings decides
+      return 0;
+    }
+  }
+  // the fields are equal, and the order is up to the ids
+  return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef __SORT_KEY_H__
+#define __SORT_KEY_H__
+
+#include "rlookup.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Normalized sort keys, ordering rows by a memcmp of their bytes.
+ *
+ * Comparing rows by their sort fields looks up, dereferences and compares the values of each
+ * field, on each of the many comparisons made by a sorter. Instead, the fields of a row are encoded
+ * once into a key of SORTKEY_FIELD_SIZE bytes per field: a tag holding the type of the value,
+ * followed by 8 bytes ordered as the value is. Numbers are encoded as their bits, flipped so that
+ * they order as unsigned integers, and strings as their first 8 bytes. The bytes of the fields
+ * sorted in ascending order are inverted, so that the keys of two rows order them as the sorter
+ * does, one field after the other.
+ *
+ * A key only tells apart values which differ within their first bytes. The keys of values which
+ * cannot be ordered by their bytes (missing fields, NaNs, strings holding a NUL) and of strings
+ * sharing a prefix longer than 8 bytes tell nothing, and the values are compared as before */
+
+#define SORTKEY_FIELD_SIZE 9
+
+/* The size of the key of nkeys fields. Fields past SORTASCMAP_MAXFIELDS are not encoded */
+size_t SortKey_Size(size_t nkeys);
+
+/* Encode the sort fields of a row into buf, of SortKey_Size(nkeys) bytes */
+void SortKey_Encode(char *buf, const RLookupKey **keys, size_t nkeys, uint64_t ascendMap,
+                    const RLookupRow *row);
+
+/* Compare the keys of two rows. Returns a positive or negative number when the keys order the
+ * rows, as RSValue_Cmp on their fields flipped by their direction does, or 0 when they cannot
+ * tell, in which case the fields themselves must be compared */
+int SortKey_Cmp(const char *k1, const char *k2, size_t nkeys);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -13,6 +13,10 @@
 #include "config.h"
 #include "cursor.h"
 #include "tag_index.h"
+#include "vector_index.h"
+#include "spell_index.h"
+#include "suffix_index.h"
+#include "async_index.h"
 #include "redis_index.h"
 #include "indexer.h"
 #include "alias.h"
@@ -21,6 +25,7 @@
 #include "rules.h"
 #include "commands.h"
 #include "dictionary.h"
+#include "stemmer.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -301,6 +306,20 @@ static int parseTextField(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
       fs->options |= FieldSpec_Phonetics;
       continue;
 
+    } else if (AC_AdvanceIfMatch(ac, SPEC_PREFIXINDEX_STR)) {
+      unsigned len;
+      if (AC_GetUnsigned(ac, &len, AC_F_GE1) != AC_OK || len > PREFIX_INDEX_MAX_LEN) {
+        QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "%s must be between 1 and %u",
+                               SPEC_PREFIXINDEX_STR, PREFIX_INDEX_MAX_LEN);
+        return 0;
+      }
+      fs->prefixIndexLen = len;
+      continue;
+
+    } else if (AC_AdvanceIfMatch(ac, SPEC_WITHSUFFIXTRIE_STR)) {
+      fs->options |= FieldSpec_WithSuffixTrie;
+      continue;
+
     } else {
       break;
     }
@@ -314,6 +333,84 @@ void FieldSpec_Initialize(FieldSpec *fs, FieldType types) {
     fs->tagFlags = TAG_FIELD_DEFAULT_FLAGS;
     fs->tagSep = TAG_FIELD_DEFAULT_SEP;
   }
+  if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    fs->vectorOpts = (VectorFieldOptions){.metric = VectorMetric_L2,
+                                          .algo = VectorAlgo_Flat,
+                                          .hnswM = VECTOR_DEFAULT_HNSW_M,
+                                          .hnswEfConstruction = VECTOR_DEFAULT_HNSW_EF_CONSTRUCTION,
+                                          .hnswEfRuntime = VECTOR_DEFAULT_HNSW_EF_RUNTIME};
+  }
+}
+
+static int parseVectorUnsigned(ArgsCursor *ac, const char *name, unsigned max, unsigned *out,
+                               QueryError *status) {
+  if (AC_GetUnsigned(ac, out, AC_F_GE1) != AC_OK || *out > max) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "%s must be between 1 and %u", name, max);
+    return 0;
+  }
+  return 1;
+}
+
+/* Parse the options of a vector field:
+ *  VECTOR {FLAT|HNSW} DIM {dim} [TYPE FLOAT32] [DISTANCE_METRIC {L2|IP|COSINE}]
+ *    [M {m}] [EF_CONSTRUCTION {ef}] [EF_RUNTIME {ef}]
+ */
+static int parseVectorField(FieldSpec *fs, ArgsCursor *ac, QueryError *status) {
+  VectorFieldOptions *opts = &fs->vectorOpts;
+  const char *s;
+  VectorAlgo algo;
+  if (AC_GetString(ac, &s, NULL, 0) != AC_OK || VectorAlgo_Parse(s, &algo) != REDISMODULE_OK) {
+    QueryError_SetError(status, QUERY_EPARSEARGS, "Vector algorithm must be FLAT or HNSW");
+    return 0;
+  }
+  opts->algo = algo;
+
+  unsigned u;
+  while (!AC_IsAtEnd(ac)) {
+    if (AC_AdvanceIfMatch(ac, "DIM")) {
+      if (!parseVectorUnsigned(ac, "DIM", VECTOR_MAX_DIM, &u, status)) {
+        return 0;
+      }
+      opts->dim = u;
+    } else if (AC_AdvanceIfMatch(ac, "TYPE")) {
+      if (AC_GetString(ac, &s, NULL, 0) != AC_OK || strcasecmp(s, "FLOAT32")) {
+        QueryError_SetError(status, QUERY_EPARSEARGS, "Vector type must be FLOAT32");
+        return 0;
+      }
+    } else if (AC_AdvanceIfMatch(ac, "DISTANCE_METRIC")) {
+      VectorMetric metric;
+      if (AC_GetString(ac, &s, NULL, 0) != AC_OK ||
+          VectorMetric_Parse(s, &metric) != REDISMODULE_OK) {
+        QueryError_SetError(status, QUERY_EPARSEARGS,
+                            "Distance metric must be L2, IP or COSINE");
+        return 0;
+      }
+      opts->metric = metric;
+    } else if (algo == VectorAlgo_HNSW && AC_AdvanceIfMatch(ac, "M")) {
+      if (!parseVectorUnsigned(ac, "M", 512, &u, status)) {
+        return 0;
+      }
+      opts->hnswM = u;
+    } else if (algo == VectorAlgo_HNSW && AC_AdvanceIfMatch(ac, "EF_CONSTRUCTION")) {
+      if (!parseVectorUnsigned(ac, "EF_CONSTRUCTION", UINT16_MAX, &u, status)) {
+        return 0;
+      }
+      opts->hnswEfConstruction = u;
+    } else if (algo == VectorAlgo_HNSW && AC_AdvanceIfMatch(ac, "EF_RUNTIME")) {
+      if (!parseVectorUnsigned(ac, "EF_RUNTIME", UINT16_MAX, &u, status)) {
+        return 0;
+      }
+      opts->hnswEfRuntime = u;
+    } else {
+      break;
+    }
+  }
+
+  if (!opts->dim) {
+    QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Vector field `%s` requires DIM", fs->name);
+    return 0;
+  }
+  return 1;
 }
 
 /* Parse a field definition from argv, at *offset. We advance offset as we progress.
@@ -348,6 +445,11 @@ static int parseFieldSpec(ArgsCursor *ac, FieldSpec *fs, QueryError *status) {
       }
       fs->tagSep = *sep;
     }
+  } else if (AC_AdvanceIfMatch(ac, SPEC_VECTOR_STR)) {  // vector field
+    FieldSpec_Initialize(fs, INDEXFLD_T_VECTOR);
+    if (!parseVectorField(fs, ac, status)) {
+      goto error;
+    }
   } else {  // not numeric and not text - nothing more supported currently
     QueryError_SetErrorFmt(status, QUERY_EPARSEARGS, "Invalid field type for field `%s`", fs->name);
     goto error;
@@ -355,6 +457,10 @@ static int parseFieldSpec(ArgsCursor *ac, FieldSpec *fs, QueryError *status) {
 
   while (!AC_IsAtEnd(ac)) {
     if (AC_AdvanceIfMatch(ac, SPEC_SORTABLE_STR)) {
+      if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+        QueryError_SetError(status, QUERY_EPARSEARGS, "Vector fields cannot be SORTABLE");
+        goto error;
+      }
       FieldSpec_SetSortable(fs);
       continue;
     } else if (AC_AdvanceIfMatch(ac, SPEC_NOINDEX_STR)) {
@@ -457,6 +563,9 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, ArgsCursor *ac, QueryError
     if (FieldSpec_IsPhonetics(fs)) {
       sp->flags |= Index_HasPhonetic;
     }
+    if (FieldSpec_HasSuffixTrie(fs)) {
+      sp->flags |= Index_HasSuffixTrie;
+    }
     fs = NULL;
   }
   return 1;
@@ -513,6 +622,8 @@ IndexSpec *IndexSpec_Parse(const char *name, const char **argv, int argc, QueryE
       {AC_MKUNFLAG(SPEC_NOFREQS_STR, &spec->flags, Index_StoreFreqs)},
       {AC_MKBITFLAG(SPEC_SCHEMA_EXPANDABLE_STR, &spec->flags, Index_WideSchema)},
       {AC_MKBITFLAG(SPEC_ASYNC_STR, &spec->flags, Index_Async)},
+      {AC_MKBITFLAG(SPEC_FIELDPOSTINGS_STR, &spec->flags, Index_FieldPostings)},
+      {AC_MKBITFLAG(SPEC_SPELLINDEX_STR, &spec->flags, Index_SpellIndex)},
 
       // For compatibility
       {.name = "NOSCOREIDX", .target = &dummy, .type = AC_ARGTYPE_BOOLFLAG},
@@ -616,10 +727,46 @@ int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len) {
   if (isNew) {
     sp->stats.numTerms++;
     sp->stats.termsSize += len;
+    if (sp->flags & Index_SpellIndex) {
+      if (!sp->spellIndex) {
+        sp->spellIndex = NewSpellIndex();
+      }
+      SpellIndex_Add(sp->spellIndex, term, len);
+    }
   }
   return isNew;
 }
 
+int IndexSpec_AddPrefix(IndexSpec *sp, const char *prefix, size_t len) {
+  if (!sp->prefixes) {
+    sp->prefixes = NewTrieMap();
+  }
+  return TrieMap_Add(sp->prefixes, (char *)prefix, len, NULL, NULL);
+}
+
+t_fieldMask IndexSpec_SuffixTrieMask(const IndexSpec *sp) {
+  t_fieldMask mask = 0;
+  for (int i = 0; i < sp->numFields; i++) {
+    const FieldSpec *fs = sp->fields + i;
+    if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_IsIndexable(fs) &&
+        FieldSpec_HasSuffixTrie(fs)) {
+      mask |= FIELD_BIT(fs);
+    }
+  }
+  return mask;
+}
+
+int IndexSpec_AddSuffixTerm(IndexSpec *sp, const char *term, size_t len) {
+  if (!sp->suffix) {
+    sp->suffix = NewSuffixIndex();
+  }
+  return SuffixIndex_Add(sp->suffix, term, len);
+}
+
+int IndexSpec_IsInternalTermStart(int c) {
+  return c == STEM_PREFIX || c == SYNONYM_PREFIX_CHAR;
+}
+
 IndexSpecCache *IndexSpec_GetSpecCache(const IndexSpec *spec) {
   if (!spec->spcache) {
     ((IndexSpec *)spec)->spcache = IndexSpec_BuildSpecCache(spec);
@@ -713,7 +860,6 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
     dictDelete(specDict, spec->name);
   }
   SchemaRules_RemoveSpecRules(spec);
-  SchemaPrefixes_RemoveSpec(spec);
 
   if (spec->isTimerSet) {
     RedisModule_StopTimer(RSDummyContext, spec->timerId, NULL);
@@ -730,6 +876,15 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
   if (spec->terms) {
     TrieType_Free(spec->terms);
   }
+  if (spec->spellIndex) {
+    SpellIndex_Free(spec->spellIndex);
+  }
+  if (spec->suffix) {
+    SuffixIndex_Free(spec->suffix);
+  }
+  if (spec->prefixes) {
+    TrieMap_Free(spec->prefixes, NULL);
+  }
   DocTable_Free(&spec->docs);
 
   if (spec->uniqueId) {
@@ -789,6 +944,9 @@ void IndexSpec_FreeInternals(IndexSpec *spec) {
     spec->scanner->cancelled = true;
     spec->scanner->spec = NULL;
   }
+  if (spec->asyncQueue) {
+    AsyncIndexQueue_Free(spec->asyncQueue);
+  }
   rm_free(spec);
 }
 
@@ -917,6 +1075,9 @@ RedisModuleString *IndexSpec_GetFormattedKey(IndexSpec *sp, const FieldSpec *fs,
       case INDEXFLD_T_TAG:
         ret = TagIndex_FormatName(&sctx, fs->name);
         break;
+      case INDEXFLD_T_VECTOR:
+        ret = VectorIndex_FormatName(&sctx, fs->name);
+        break;
       case INDEXFLD_T_FULLTEXT:  // Text fields don't get a per-field index
       default:
         ret = NULL;
@@ -1111,11 +1272,21 @@ static void FieldSpec_RdbSave(RedisModuleIO *rdb, FieldSpec *f) {
   if (FIELD_IS(f, INDEXFLD_T_FULLTEXT) || (f->options & FieldSpec_Dynamic)) {
     RedisModule_SaveUnsigned(rdb, f->ftId);
     RedisModule_SaveDouble(rdb, f->ftWeight);
+    RedisModule_SaveUnsigned(rdb, f->prefixIndexLen);
   }
   if (FIELD_IS(f, INDEXFLD_T_TAG) || (f->options & FieldSpec_Dynamic)) {
     RedisModule_SaveUnsigned(rdb, f->tagFlags);
     RedisModule_SaveStringBuffer(rdb, &f->tagSep, 1);
   }
+  // Save vector specific options
+  if (FIELD_IS(f, INDEXFLD_T_VECTOR)) {
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.dim);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.metric);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.algo);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.hnswM);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.hnswEfConstruction);
+    RedisModule_SaveUnsigned(rdb, f->vectorOpts.hnswEfRuntime);
+  }
 }
 
 static const FieldType fieldTypeMap[] = {[IDXFLD_LEGACY_FULLTEXT] = INDEXFLD_T_FULLTEXT,
@@ -1148,6 +1319,9 @@ static void FieldSpec_RdbLoad(RedisModuleIO *rdb, FieldSpec *f, int encver) {
   if (FIELD_IS(f, INDEXFLD_T_FULLTEXT) || (f->options & FieldSpec_Dynamic)) {
     f->ftId = RedisModule_LoadUnsigned(rdb);
     f->ftWeight = RedisModule_LoadDouble(rdb);
+    if (encver >= INDEX_MIN_PREFIXINDEX_VERSION) {
+      f->prefixIndexLen = RedisModule_LoadUnsigned(rdb);
+    }
   }
   // Load tag specific options
   if (FIELD_IS(f, INDEXFLD_T_TAG) || (f->options & FieldSpec_Dynamic)) {
@@ -1159,6 +1333,15 @@ static void FieldSpec_RdbLoad(RedisModuleIO *rdb, FieldSpec *f, int encver) {
     f->tagSep = *s;
     RedisModule_Free(s);
   }
+  // Load vector specific options
+  if (encver >= INDEX_MIN_VECTOR_VERSION && FIELD_IS(f, INDEXFLD_T_VECTOR)) {
+    f->vectorOpts.dim = RedisModule_LoadUnsigned(rdb);
+    f->vectorOpts.metric = RedisModule_LoadUnsigned(rdb);
+    f->vectorOpts.algo = RedisModule_LoadUnsigned(rdb);
+    f->vectorOpts.hnswM = RedisModule_LoadUnsigned(rdb);
+    f->vectorOpts.hnswEfConstruction = RedisModule_LoadUnsigned(rdb);
+    f->vectorOpts.hnswEfRuntime = RedisModule_LoadUnsigned(rdb);
+  }
 }
 
 static void IndexStats_RdbLoad(RedisModuleIO *rdb, IndexStats *stats) {
@@ -1266,7 +1449,7 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
     return;
   }
   if (scanner->global) {
-    Indexes_UpdateMatchingWithSchemaRules(ctx, keyname, NULL);
+    Indexes_UpdateMatchingWithSchemaRules(ctx, keyname, NULL, NULL);
   } else {
     IndexSpec_UpdateMatchingWithSchemaRules(scanner->spec, ctx, keyname);
   }
@@ -1675,76 +1858,9 @@ static void onFlush(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent
 void Indexes_Init(RedisModuleCtx *ctx) {
   specDict = dictCreate(&dictTypeHeapStrings, NULL);
   RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_FlushDB, onFlush);
-  SchemaPrefixes_Create();
   SchemaRules_Create();
 }
 
-dict *Indexes_FindMatchingSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key) {
-  dict *specs = dictCreate(&dictTypeHeapStrings, NULL);
-  if (array_len(SchemaRules_g) == 0) {
-    return specs;
-  }
-
-#if defined(_DEBUG) && 0
-  RLookupKey *k = RLookup_GetKey(&r->lk, "__key", 0);
-  RSValue *v = RLookup_GetItem(k, &r->row);
-  const char *x = RSValue_StringPtrLen(v, NULL);
-  RedisModule_Log(NULL, "notice", "Indexes_FindMatchingSchemaRules: x=%s", x);
-  const char *f = "name";
-  k = RLookup_GetKey(&r->lk, f, 0);
-  if (k) {
-    v = RLookup_GetItem(k, &r->row);
-    x = RSValue_StringPtrLen(v, NULL);
-  }
-#endif  // _DEBUG
-
-  size_t n;
-  const char *key_p = RedisModule_StringPtrLen(key, &n);
-  arrayof(SchemaPrefixNode *) prefixes = array_new(SchemaPrefixNode *, 1);
-  // collect specs that their name is prefixed by the key name
-  // `prefixes` includes list of arrays of specs, one for each prefix of key name
-  int nprefixes = TrieMap_FindPrefixes(ScemaPrefixes_g, key_p, n, (arrayof(void *) *)&prefixes);
-  for (int i = 0; i < array_len(prefixes); ++i) {
-    SchemaPrefixNode *node = prefixes[i];
-    for (int j = 0; j < array_len(node->index_specs); ++j) {
-      IndexSpec *spec = node->index_specs[j];
-      if (!dictFind(specs, spec->name)) {
-        dictAdd(specs, spec->name, spec);
-      }
-    }
-  }
-  array_free(prefixes);
-
-  EvalCtx *r = NULL;
-  for (size_t i = 0; i < array_len(SchemaRules_g); i++) {
-    SchemaRule *rule = SchemaRules_g[i];
-    if (!rule->filter_exp) {
-      continue;
-    }
-
-    if (!r) {
-      // load hash only if required
-      r = EvalCtx_Create();
-      EvalCtx_AddHash(r, ctx, key);
-      RSValue *keyRSV = RS_RedisStringVal(key);
-      EvalCtx_Set(r, "__key", keyRSV);
-    }
-
-    if (EvalCtx_EvalExpr(r, rule->filter_exp) == EXPR_EVAL_OK) {
-      IndexSpec *spec = rule->spec;
-      if (!RSValue_BoolTest(&r->res) && dictFind(specs, spec->name)) {
-        dictDelete(specs, spec->name);
-      }
-    }
-  }
-
-  if (r) {
-    EvalCtx_Destroy(r);
-  }
-
-  return specs;
-}
-
 static bool hashFieldChanged(IndexSpec *spec, RedisModuleString **hashFields) {
   if(hashFields == NULL) {
     return true;
@@ -1768,96 +1884,108 @@ static bool hashFieldChanged(IndexSpec *spec, RedisModuleString **hashFields) {
   return false;
 }
 
-void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, RedisModuleString **hashFields) {
-  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key);
+// Index the hash now, or queue it for the background indexer of ASYNC indexes
+static void IndexSpec_UpdateOrQueueHash(IndexSpec *spec, RedisModuleCtx *ctx,
+                                        RedisModuleString *key) {
+  if (spec->flags & Index_Async) {
+    AsyncIndex_Update(spec, ctx, key);
+  } else {
+    IndexSpec_UpdateWithHash(spec, ctx, key);
+  }
+}
 
-  dictIterator *di = dictGetIterator(specs);
-  dictEntry *ent = dictNext(di);
-  while (ent) {
-    IndexSpec *spec = (IndexSpec *)ent->v.val;
-    if (!hashFields || hashFieldChanged(spec, hashFields)) {
-      IndexSpec_UpdateWithHash(spec, ctx, key);
-    }
-    ent = dictNext(di);
+// Apply the change of some fields of the hash to its document without reindexing it
+static bool IndexSpec_UpdateHashInPlace(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key,
+                                        RedisModuleString **hashFields,
+                                        RedisModuleString **oldValues) {
+  // a queued hash is to be indexed again anyway, and its document may not hold the old values
+  if (!hashFields || !oldValues ||
+      (spec->asyncQueue && AsyncIndexQueue_Contains(spec->asyncQueue, key))) {
+    return false;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  if (Document_UpdateFieldsInPlace(&sctx, key, hashFields, oldValues) != REDISMODULE_OK) {
+    return false;
   }
-  dictReleaseIterator(di);
+  spec->stats.numInPlaceUpdates++;
+  return true;
+}
+
+void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                           RedisModuleString **hashFields,
+                                           RedisModuleString **oldValues) {
+  size_t nwords = SchemaRules_MatchWords();
+  SchemaRuleBits matches[nwords];
+  SchemaRules_Match(ctx, key, matches);
 
-  dictRelease(specs);
+  int i;
+  while ((i = SchemaRules_NextMatch(matches, nwords)) >= 0) {
+    IndexSpec *spec = SchemaRules_g[i]->spec;
+    if (hashFieldChanged(spec, hashFields) &&
+        !IndexSpec_UpdateHashInPlace(spec, ctx, key, hashFields, oldValues)) {
+      IndexSpec_UpdateOrQueueHash(spec, ctx, key);
+    }
+  }
 }
 
 void IndexSpec_UpdateMatchingWithSchemaRules(IndexSpec *sp, RedisModuleCtx *ctx,
                                              RedisModuleString *key) {
-  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key);
-  if (!dictFind(specs, sp->name)) {
-    goto end;
-  }
-
-  dictIterator *di = dictGetIterator(specs);
-  dictEntry *ent = dictNext(di);
-  while (ent) {
-    IndexSpec *spec = (IndexSpec *)ent->v.val;
-    if (spec == sp) {
-      IndexSpec_UpdateWithHash(spec, ctx, key);
+  size_t nwords = SchemaRules_MatchWords();
+  SchemaRuleBits matches[nwords];
+  SchemaRules_Match(ctx, key, matches);
+
+  int i;
+  while ((i = SchemaRules_NextMatch(matches, nwords)) >= 0) {
+    if (SchemaRules_g[i]->spec == sp) {
+      IndexSpec_UpdateWithHash(sp, ctx, key);
+      return;
     }
-    ent = dictNext(di);
   }
-  dictReleaseIterator(di);
-end:
-  dictRelease(specs);
 }
 
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, RedisModuleString **hashFields) {
-  dict *specs = Indexes_FindMatchingSchemaRules(ctx, key);
+  size_t nwords = SchemaRules_MatchWords();
+  SchemaRuleBits matches[nwords];
+  SchemaRules_Match(ctx, key, matches);
 
-  dictIterator *di = dictGetIterator(specs);
-  dictEntry *ent = dictNext(di);
-  while (ent) {
-    IndexSpec *spec = (IndexSpec *)ent->v.val;
+  int i;
+  while ((i = SchemaRules_NextMatch(matches, nwords)) >= 0) {
+    IndexSpec *spec = SchemaRules_g[i]->spec;
     if (!hashFields || hashFieldChanged(spec, hashFields)) {
       IndexSpec_DeleteHash(spec, ctx, key);
     }
-    ent = dictNext(di);
   }
-  dictReleaseIterator(di);
-
-  dictRelease(specs);
 }
 
 void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *from_key, 
                                                                  RedisModuleString *to_key) {
-  dict *from_specs = Indexes_FindMatchingSchemaRules(ctx, from_key);
-  dict *to_specs = Indexes_FindMatchingSchemaRules(ctx, to_key);
+  size_t nwords = SchemaRules_MatchWords();
+  SchemaRuleBits from_matches[nwords], to_matches[nwords];
+  SchemaRules_Match(ctx, from_key, from_matches);
+  SchemaRules_Match(ctx, to_key, to_matches);
 
   size_t from_len, to_len;
   const char *from_str = RedisModule_StringPtrLen(from_key, &from_len);
   const char *to_str = RedisModule_StringPtrLen(to_key, &to_len);
 
-  dictIterator *di = dictGetIterator(from_specs);
-  dictEntry *ent = dictNext(di);
-  while (ent) {
-    IndexSpec *spec = (IndexSpec *)ent->v.val;
-    if (dictFind(to_specs, spec->name)) {
+  int i;
+  while ((i = SchemaRules_NextMatch(from_matches, nwords)) >= 0) {
+    IndexSpec *spec = SchemaRules_g[i]->spec;
+    if (SchemaRuleBits_Test(to_matches, i)) {
       DocTable_Replace(&spec->docs, from_str, from_len, to_str, to_len);
-      dictDelete(to_specs, spec->name);
+      // a change not indexed yet is now the new key's
+      if (spec->asyncQueue && AsyncIndexQueue_Contains(spec->asyncQueue, from_key)) {
+        AsyncIndex_Update(spec, ctx, to_key);
+      }
+      SchemaRuleBits_Clear(to_matches, i);
     } else {
       IndexSpec_DeleteHash(spec, ctx, from_key);
     }
-    ent = dictNext(di);
   }
-  dictReleaseIterator(di);
-  dictRelease(from_specs);
-  
+
   // add to a different index
-  if (dictSize(to_specs) > 0) {
-    di = dictGetIterator(to_specs);
-    dictEntry *ent = dictNext(di);
-    while (ent) {
-      IndexSpec *spec = (IndexSpec *)ent->v.val;
-      IndexSpec_UpdateWithHash(spec, ctx, to_key);
-      ent = dictNext(di);
-    }
-    dictReleaseIterator(di);
+  while ((i = SchemaRules_NextMatch(to_matches, nwords)) >= 0) {
+    IndexSpec_UpdateOrQueueHash(SchemaRules_g[i]->spec, ctx, to_key);
   }
-  dictRelease(to_specs);
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////
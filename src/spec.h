@@ -15,6 +15,7 @@
 #include "query_error.h"
 #include "field_spec.h"
 #include "util/dict.h"
+#include "dep/triemap/triemap.h"
 #include "redisearch_api.h"
 #include "rules.h"
 
@@ -42,12 +43,17 @@ struct DocumentIndexer;
 #define SPEC_NOSTEM_STR "NOSTEM"
 #define SPEC_PHONETIC_STR "PHONETIC"
 #define SPEC_TAG_STR "TAG"
+#define SPEC_VECTOR_STR "VECTOR"
 #define SPEC_SORTABLE_STR "SORTABLE"
 #define SPEC_STOPWORDS_STR "STOPWORDS"
 #define SPEC_NOINDEX_STR "NOINDEX"
 #define SPEC_SEPARATOR_STR "SEPARATOR"
 #define SPEC_MULTITYPE_STR "MULTITYPE"
 #define SPEC_ASYNC_STR "ASYNC"
+#define SPEC_FIELDPOSTINGS_STR "FIELDPOSTINGS"
+#define SPEC_SPELLINDEX_STR "SPELLINDEX"
+#define SPEC_PREFIXINDEX_STR "PREFIXINDEX"
+#define SPEC_WITHSUFFIXTRIE_STR "WITHSUFFIXTRIE"
 
 /**
  * If wishing to represent field types positionally, use this
@@ -58,7 +64,8 @@ struct DocumentIndexer;
 static const char *SpecTypeNames[] = {[IXFLDPOS_FULLTEXT] = SPEC_TEXT_STR,
                                       [IXFLDPOS_NUMERIC] = NUMERIC_STR,
                                       [IXFLDPOS_GEO] = GEO_STR,
-                                      [IXFLDPOS_TAG] = SPEC_TAG_STR};
+                                      [IXFLDPOS_TAG] = SPEC_TAG_STR,
+                                      [IXFLDPOS_VECTOR] = SPEC_VECTOR_STR};
 
 #define INDEX_SPEC_KEY_PREFIX "idx:"
 #define INDEX_SPEC_KEY_FMT INDEX_SPEC_KEY_PREFIX "%s"
@@ -85,6 +92,10 @@ typedef struct {
   size_t offsetVecsSize;
   size_t offsetVecRecords;
   size_t termsSize;
+  // the part of invertedSize taken by the postings of prefixes, with PREFIXINDEX text fields
+  size_t prefixIndexSize;
+  // the hash changes applied to their documents in place, without reindexing them
+  size_t numInPlaceUpdates;
 } IndexStats;
 
 typedef enum {
@@ -104,7 +115,20 @@ typedef enum {
 
   // If any of the fields has phonetics. This is just a cache for quick lookup
   Index_HasPhonetic = 0x400,
-  Index_Async = 0x800
+  Index_Async = 0x800,
+
+  // Keep a separate posting list for each (text field, term), used by field-restricted queries
+  Index_FieldPostings = 0x1000,
+
+  // Set on inverted indexes (not on specs) whose term offsets are kept in a positional stream of
+  // each block, separately from the doc ids, frequencies and field masks
+  Index_SplitPositions = 0x2000,
+
+  // Keep a deletion index of the terms, used by FT.SPELLCHECK
+  Index_SpellIndex = 0x4000,
+
+  // If any of the fields has a suffix index. This is just a cache for quick lookup
+  Index_HasSuffixTrie = 0x8000
 } IndexFlags;
 
 /**
@@ -119,11 +143,17 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 
 #define INDEX_STORAGE_MASK                                                                  \
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
-   Index_WideSchema)
+   Index_WideSchema | Index_SplitPositions)
 
-#define INDEX_CURRENT_VERSION 17
+#define INDEX_CURRENT_VERSION 19
 #define INDEX_MIN_COMPAT_VERSION 17
 
+// Versions below this didn't know vector fields
+#define INDEX_MIN_VECTOR_VERSION 18
+
+// Versions below this didn't save the prefix index length of text fields
+#define INDEX_MIN_PREFIXINDEX_VERSION 19
+
 #define INDEX_MIN_WITH_SYNONYMS_INT_GROUP_ID 16
 
 // Those versions contains doc table as array, we modified it to be array of linked lists
@@ -160,6 +190,11 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
 #define IDXFLD_LEGACY_TAG 3
 #define IDXFLD_LEGACY_MAX 3
 
+/* Flags of the per-field posting lists. Records there belong to a single field, so the field
+ * mask is not stored */
+#define IndexSpec_FieldPostingsFlags(spec) \
+  ((spec)->flags & ~(Index_StoreFieldFlags | Index_WideSchema))
+
 #define Index_SupportsHighlight(spec) \
   (((spec)->flags & Index_StoreTermOffsets) && ((spec)->flags & Index_StoreByteOffsets))
 
@@ -180,6 +215,12 @@ typedef struct IndexSpec {
   IndexFlags flags;
 
   Trie *terms;
+  // An index of the terms for spell checking, with Index_SpellIndex
+  struct SpellIndex *spellIndex;
+  // The prefixes that have postings, with PREFIXINDEX text fields. Values are unused
+  TrieMap *prefixes;
+  // An index of the suffixes of the terms of WITHSUFFIXTRIE text fields
+  struct SuffixIndex *suffix;
 
   RSSortingTable *sortables;
 
@@ -217,6 +258,9 @@ typedef struct IndexSpec {
   // in favor on a newer, pending scan
   bool scan_in_progress;
   bool cascadeDelete; // remove keys when removing spec
+
+  // The hashes waiting to be indexed in the background, with Index_Async
+  struct AsyncIndexQueue *asyncQueue;
 } IndexSpec;
 
 typedef struct {
@@ -390,6 +434,19 @@ extern void (*IndexSpec_OnCreate)(const IndexSpec *sp);
 
 int IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len);
 
+/* Register a prefix that has postings, so that the GC finds them. Returns 1 if it is new */
+int IndexSpec_AddPrefix(IndexSpec *sp, const char *prefix, size_t len);
+
+/* The mask of the text fields declared WITHSUFFIXTRIE */
+t_fieldMask IndexSpec_SuffixTrieMask(const IndexSpec *sp);
+
+/* Add a term of WITHSUFFIXTRIE text fields to the suffix index. Returns 1 if it is new */
+int IndexSpec_AddSuffixTerm(IndexSpec *sp, const char *term, size_t len);
+
+/* Whether a term starting with the character `c` is internal to the dictionary: a stem or a synonym
+ * group that the terms of documents are expanded to. Suffix and contains queries skip them */
+int IndexSpec_IsInternalTermStart(int c);
+
 /* Get a random term from the index spec using weighted random. Weighted random is done by sampling
  * N terms from the index and then doing weighted random on them. A sample size of 10-20 should be
  * enough */
@@ -447,7 +504,11 @@ typedef struct IndexesScanner {
 //---------------------------------------------------------------------------------------------
 
 void Indexes_Init(RedisModuleCtx *ctx);
-void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, RedisModuleString **hashFields);
+/* Index the hash in the indexes its key matches. When the changed fields and their old values are
+ * given, the documents are updated in place where possible */
+void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                           RedisModuleString **hashFields,
+                                           RedisModuleString **oldValues);
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, RedisModuleString **hashFields);
 void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *from_key, 
                                                                  RedisModuleString *to_key);
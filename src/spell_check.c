@@ -1,6 +1,8 @@
 #include "spell_check.h"
 #include "util/arr.h"
 #include "dictionary.h"
+#include "spell_index.h"
+#include "config.h"
 #include <stdbool.h>
 
 /** Forward declaration **/
@@ -129,6 +131,21 @@ static bool SpellCheck_IsTermExistsInTrie(Trie *t, const char *term, size_t len,
   return retVal;
 }
 
+typedef struct {
+  SpellCheckCtx *scCtx;
+  t_fieldMask fieldMask;
+  RS_Suggestions *s;
+  int incr;
+} SpellCheckFindCtx;
+
+static void SpellCheck_AddSuggestion(const char *suggestion, size_t len, void *p) {
+  SpellCheckFindCtx *ctx = p;
+  double score;
+  if ((score = SpellCheck_GetScore(ctx->scCtx, (char *)suggestion, len, ctx->fieldMask)) != -1) {
+    RS_SuggestionsAdd(ctx->s, (char *)suggestion, len, score, ctx->incr);
+  }
+}
+
 static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char *term, size_t len,
                                        t_fieldMask fieldMask, RS_Suggestions *s, int incr) {
   rune *rstr = NULL;
@@ -136,6 +153,16 @@ static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char
   float score = 0;
   int dist = 0;
   size_t suggestionLen;
+  SpellCheckFindCtx ctx = {.scCtx = scCtx, .fieldMask = fieldMask, .s = s, .incr = incr};
+
+  // the spell index of the index terms answers without traversing the trie, unless the
+  // distance or the term are too long for it
+  SpellIndex *si = scCtx->sctx->spec->spellIndex;
+  if (si && t == scCtx->sctx->spec->terms &&
+      SpellIndex_Find(si, term, len, (int)scCtx->distance, RSGlobalConfig.fuzzyTranspositions,
+                      SpellCheck_AddSuggestion, &ctx)) {
+    return;
+  }
 
   TrieIterator *it = Trie_Iterate(t, term, len, (int)scCtx->distance, 0);
   // TrieIterator can be NULL when rune length exceed TRIE_MAX_PREFIX
@@ -144,10 +171,7 @@ static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char
   }
   while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
     char *res = runesToStr(rstr, slen, &suggestionLen);
-    double score;
-    if ((score = SpellCheck_GetScore(scCtx, res, suggestionLen, fieldMask)) != -1) {
-      RS_SuggestionsAdd(s, res, suggestionLen, score, incr);
-    }
+    SpellCheck_AddSuggestion(res, suggestionLen, &ctx);
     rm_free(res);
   }
   DFAFilter_Free(it->ctx);
@@ -0,0 +1,281 @@
+#include "spell_index.h"
+#include "trie/rune_util.h"
+#include "util/arr.h"
+#include "util/fnv.h"
+#include "util/khash.h"
+#include "rmalloc.h"
+
+#include <string.h>
+#include <sys/param.h>
+
+// The longest byte length of a term that can still be short enough to index
+#define SPELL_INDEX_MAX_TERM_BYTES (4 * SPELL_INDEX_MAX_TERM_LEN)
+
+// deletion hash -> array (util/arr.h) of the ids of the terms indexed under it
+KHASH_MAP_INIT_INT64(spellDeletes, uint32_t *)
+
+typedef struct {
+  // NULL once the term is deleted, until its id is taken by another term
+  char *str;
+  size_t len;
+} spellIndexTerm;
+
+struct SpellIndex {
+  spellIndexTerm *terms;
+  // the ids of the deleted terms, for new terms to take
+  uint32_t *freeIds;
+  khash_t(spellDeletes) * deletes;
+  // the bytes of the term strings and of the id arrays of the deletions
+  size_t memsize;
+};
+
+SpellIndex *NewSpellIndex() {
+  SpellIndex *si = rm_malloc(sizeof(*si));
+  si->terms = array_new(spellIndexTerm, 16);
+  si->freeIds = array_new(uint32_t, 0);
+  si->deletes = kh_init(spellDeletes);
+  si->memsize = 0;
+  return si;
+}
+
+void SpellIndex_Free(SpellIndex *si) {
+  for (uint32_t i = 0; i < array_len(si->terms); i++) {
+    rm_free(si->terms[i].str);
+  }
+  array_free(si->terms);
+  array_free(si->freeIds);
+  for (khiter_t it = kh_begin(si->deletes); it != kh_end(si->deletes); ++it) {
+    if (kh_exist(si->deletes, it)) {
+      array_free(kh_val(si->deletes, it));
+    }
+  }
+  kh_destroy(spellDeletes, si->deletes);
+  rm_free(si);
+}
+
+size_t SpellIndex_NumTerms(const SpellIndex *si) {
+  return array_len(si->terms) - array_len(si->freeIds);
+}
+
+size_t SpellIndex_MemUsage(const SpellIndex *si) {
+  // khash keeps 2 flag bits per bucket
+  size_t buckets = kh_n_buckets(si->deletes);
+  return sizeof(*si) + sizeof(*si->deletes) +
+         buckets * (sizeof(uint64_t) + sizeof(uint32_t *)) + buckets / 4 +
+         array_sizeof(array_hdr(si->terms)) + array_sizeof(array_hdr(si->freeIds)) + si->memsize;
+}
+
+/* Convert a term to folded runes. Returns its length, or a length above SPELL_INDEX_MAX_TERM_LEN
+ * if it's too long for the index */
+static size_t spellIndex_Runes(const char *term, size_t len, rune *buf) {
+  if (len > SPELL_INDEX_MAX_TERM_BYTES) {
+    return SPELL_INDEX_MAX_TERM_LEN + 1;
+  }
+  size_t n = strToRunesN(term, len, buf);
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = runeFold(buf[i]);
+  }
+  return n;
+}
+
+typedef void (*deleteCallback)(uint64_t hash, void *ctx);
+
+/* Call `cb` with the hash of the string and of every string made by deleting up to `k` of its
+ * runes. Runes are only deleted from `start` onwards, so each set of deleted positions is visited
+ * once */
+static void spellIndex_Deletes(const rune *s, size_t n, size_t start, int k, deleteCallback cb,
+                               void *ctx) {
+  cb(fnv_64a_buf(s, n * sizeof(rune), 0), ctx);
+  if (k == 0 || n == 0) {
+    return;
+  }
+  rune buf[n];
+  for (size_t i = start; i < n; i++) {
+    memcpy(buf, s, i * sizeof(rune));
+    memcpy(buf + i, s + i + 1, (n - i - 1) * sizeof(rune));
+    spellIndex_Deletes(buf, n - 1, i, k - 1, cb, ctx);
+  }
+}
+
+typedef struct {
+  SpellIndex *si;
+  uint32_t id;
+} updateCtx;
+
+static void addDelete(uint64_t hash, void *p) {
+  updateCtx *ctx = p;
+  int added;
+  khiter_t it = kh_put(spellDeletes, ctx->si->deletes, hash, &added);
+  if (added) {
+    kh_val(ctx->si->deletes, it) = array_new(uint32_t, 1);
+    ctx->si->memsize += sizeof(array_hdr_t);
+  }
+  // repeated letters make the same deletion more than once, right after the term was added to it
+  uint32_t *ids = kh_val(ctx->si->deletes, it);
+  if (array_len(ids) == 0 || array_tail(ids) != ctx->id) {
+    kh_val(ctx->si->deletes, it) = array_append(ids, ctx->id);
+    ctx->si->memsize += sizeof(uint32_t);
+  }
+}
+
+static void removeDelete(uint64_t hash, void *p) {
+  updateCtx *ctx = p;
+  khiter_t it = kh_get(spellDeletes, ctx->si->deletes, hash);
+  if (it == kh_end(ctx->si->deletes)) {
+    return;
+  }
+  uint32_t *ids = kh_val(ctx->si->deletes, it);
+  for (uint32_t i = 0; i < array_len(ids); i++) {
+    if (ids[i] == ctx->id) {
+      array_del_fast(ids, i);
+      ctx->si->memsize -= sizeof(uint32_t);
+      break;
+    }
+  }
+  if (array_len(ids) == 0) {
+    array_free(ids);
+    kh_del(spellDeletes, ctx->si->deletes, it);
+    ctx->si->memsize -= sizeof(array_hdr_t);
+  }
+}
+
+/* The id of a term, looked up among the terms indexed under the term itself, or UINT32_MAX */
+static uint32_t spellIndex_FindTerm(const SpellIndex *si, const char *term, size_t len,
+                                    const rune *runes, size_t n) {
+  khiter_t it = kh_get(spellDeletes, si->deletes, fnv_64a_buf(runes, n * sizeof(rune), 0));
+  if (it == kh_end(si->deletes)) {
+    return UINT32_MAX;
+  }
+  uint32_t *ids = kh_val(si->deletes, it);
+  for (uint32_t i = 0; i < array_len(ids); i++) {
+    const spellIndexTerm *t = &si->terms[ids[i]];
+    if (t->len == len && !memcmp(t->str, term, len)) {
+      return ids[i];
+    }
+  }
+  return UINT32_MAX;
+}
+
+int SpellIndex_Add(SpellIndex *si, const char *term, size_t len) {
+  rune runes[SPELL_INDEX_MAX_TERM_BYTES];
+  size_t n = spellIndex_Runes(term, len, runes);
+  if (n > SPELL_INDEX_MAX_TERM_LEN || spellIndex_FindTerm(si, term, len, runes, n) != UINT32_MAX) {
+    return 0;
+  }
+  spellIndexTerm t = {.str = rm_strndup(term, len), .len = len};
+  updateCtx ctx = {.si = si};
+  if (array_len(si->freeIds)) {
+    ctx.id = array_pop(si->freeIds);
+    si->terms[ctx.id] = t;
+  } else {
+    ctx.id = array_len(si->terms);
+    si->terms = array_append(si->terms, t);
+  }
+  si->memsize += len + 1;
+  spellIndex_Deletes(runes, n, 0, SPELL_INDEX_MAX_DISTANCE, addDelete, &ctx);
+  return 1;
+}
+
+int SpellIndex_Delete(SpellIndex *si, const char *term, size_t len) {
+  rune runes[SPELL_INDEX_MAX_TERM_BYTES];
+  size_t n = spellIndex_Runes(term, len, runes);
+  if (n > SPELL_INDEX_MAX_TERM_LEN) {
+    return 0;
+  }
+  updateCtx ctx = {.si = si, .id = spellIndex_FindTerm(si, term, len, runes, n)};
+  if (ctx.id == UINT32_MAX) {
+    return 0;
+  }
+  spellIndex_Deletes(runes, n, 0, SPELL_INDEX_MAX_DISTANCE, removeDelete, &ctx);
+  spellIndexTerm *t = &si->terms[ctx.id];
+  rm_free(t->str);
+  si->memsize -= t->len + 1;
+  *t = (spellIndexTerm){0};
+  si->freeIds = array_append(si->freeIds, ctx.id);
+  return 1;
+}
+
+/* The edit distance of two strings, or max + 1 if it's above max */
+static int spellIndex_Distance(const rune *a, size_t alen, const rune *b, size_t blen, int max,
+                               int transpositions) {
+  if ((alen > blen ? alen - blen : blen - alen) > max) {
+    return max + 1;
+  }
+  // the last three rows of the table
+  int rows[3][blen + 1];
+  int *prev2 = rows[0], *prev = rows[1], *cur = rows[2];
+  for (size_t j = 0; j <= blen; j++) {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= alen; i++) {
+    cur[0] = i;
+    int rowMin = cur[0];
+    for (size_t j = 1; j <= blen; j++) {
+      int d = MIN(prev[j] + 1, cur[j - 1] + 1);
+      d = MIN(d, prev[j - 1] + (a[i - 1] != b[j - 1]));
+      if (transpositions && i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+        d = MIN(d, prev2[j - 2] + 1);
+      }
+      cur[j] = d;
+      rowMin = MIN(rowMin, d);
+    }
+    if (rowMin > max) {
+      return max + 1;
+    }
+    int *tmp = prev2;
+    prev2 = prev;
+    prev = cur;
+    cur = tmp;
+  }
+  return MIN(prev[blen], max + 1);
+}
+
+typedef struct {
+  const SpellIndex *si;
+  uint32_t *candidates;
+} findCtx;
+
+static void findDelete(uint64_t hash, void *p) {
+  findCtx *ctx = p;
+  khiter_t it = kh_get(spellDeletes, ctx->si->deletes, hash);
+  if (it == kh_end(ctx->si->deletes)) {
+    return;
+  }
+  uint32_t *ids = kh_val(ctx->si->deletes, it);
+  for (uint32_t i = 0; i < array_len(ids); i++) {
+    ctx->candidates = array_append(ctx->candidates, ids[i]);
+  }
+}
+
+static int cmpIds(const void *p1, const void *p2) {
+  uint32_t id1 = *(const uint32_t *)p1, id2 = *(const uint32_t *)p2;
+  return id1 < id2 ? -1 : id1 > id2 ? 1 : 0;
+}
+
+int SpellIndex_Find(const SpellIndex *si, const char *term, size_t len, int maxDist,
+                    int transpositions, SpellIndexCallback cb, void *ctx) {
+  rune runes[SPELL_INDEX_MAX_TERM_BYTES];
+  size_t n = spellIndex_Runes(term, len, runes);
+  if (maxDist > SPELL_INDEX_MAX_DISTANCE || n + maxDist > SPELL_INDEX_MAX_TERM_LEN) {
+    return 0;
+  }
+
+  findCtx fctx = {.si = si, .candidates = array_new(uint32_t, 16)};
+  spellIndex_Deletes(runes, n, 0, maxDist, findDelete, &fctx);
+  uint32_t *candidates = fctx.candidates;
+  qsort(candidates, array_len(candidates), sizeof(*candidates), cmpIds);
+
+  rune other[SPELL_INDEX_MAX_TERM_BYTES];
+  for (uint32_t i = 0; i < array_len(candidates); i++) {
+    if (i > 0 && candidates[i] == candidates[i - 1]) {
+      continue;
+    }
+    const spellIndexTerm *t = &si->terms[candidates[i]];
+    size_t on = spellIndex_Runes(t->str, t->len, other);
+    if (spellIndex_Distance(runes, n, other, on, maxDist, transpositions) <= maxDist) {
+      cb(t->str, t->len, ctx);
+    }
+  }
+  array_free(candidates);
+  return 1;
+}
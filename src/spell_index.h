@@ -0,0 +1,54 @@
+#ifndef __SPELL_INDEX_H__
+#define __SPELL_INDEX_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The maximal edit distance the spell index can answer
+#define SPELL_INDEX_MAX_DISTANCE 2
+
+// Terms longer than this, in letters, are not indexed
+#define SPELL_INDEX_MAX_TERM_LEN 32
+
+/* A SymSpell style index of the terms of a dictionary. It finds the terms within a small edit
+ * distance of a query term without traversing the whole dictionary.
+ *
+ * Each term is indexed under every string made by deleting up to SPELL_INDEX_MAX_DISTANCE of its
+ * letters. Two terms within d edits of each other share a string made by deleting at most d
+ * letters from each, so the candidates of a query are found by probing the deletions of the query
+ * itself. The candidates are then checked against the actual distance. The deletions are keyed by
+ * their hash alone, since a term found through a collision fails that check anyway */
+typedef struct SpellIndex SpellIndex;
+
+typedef void (*SpellIndexCallback)(const char *term, size_t len, void *ctx);
+
+SpellIndex *NewSpellIndex();
+void SpellIndex_Free(SpellIndex *si);
+
+/* Add a term. Returns 0 if it was already in the index, or is too long to be indexed */
+int SpellIndex_Add(SpellIndex *si, const char *term, size_t len);
+
+/* Remove a term. Returns 0 if it was not in the index. Its id is then taken by the next term added,
+ * so the index does not grow as terms come and go */
+int SpellIndex_Delete(SpellIndex *si, const char *term, size_t len);
+
+/* Call `cb` with each term within `maxDist` edits of `term`, in no particular order. If
+ * `transpositions` is set, swapping two adjacent letters is a single edit.
+ * Returns 0 without calling `cb` if the index can't answer: either the distance is above
+ * SPELL_INDEX_MAX_DISTANCE, or the term is long enough to match terms that aren't indexed */
+int SpellIndex_Find(const SpellIndex *si, const char *term, size_t len, int maxDist,
+                    int transpositions, SpellIndexCallback cb, void *ctx);
+
+/* The number of terms in the index */
+size_t SpellIndex_NumTerms(const SpellIndex *si);
+
+/* The number of bytes used by the index */
+size_t SpellIndex_MemUsage(const SpellIndex *si);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -4,6 +4,7 @@
 #include <sys/param.h>
 #include "dep/snowball/include/libstemmer.h"
 #include "rmalloc.h"
+#include "term_cache.h"
 
 typedef struct langPair_s
 {
@@ -78,32 +79,48 @@ struct sbStemmerCtx {
   struct sb_stemmer *sb;
   char *buf;
   size_t cap;
+  RSLanguage language;
 };
 
+/* Copy a stem, and the terminating NUL, after the + prefix of our buffer */
+static const char *sbstemmer_Copy(struct sbStemmerCtx *stctx, const char *stem, size_t len) {
+  if (len + 2 > stctx->cap) {
+    stctx->cap = len + 2;
+    stctx->buf = rm_realloc(stctx->buf, stctx->cap);
+  }
+  memcpy(stctx->buf + 1, stem, len);
+  stctx->buf[len + 1] = '\0';
+  return stctx->buf;
+}
+
 const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *outlen) {
   const sb_symbol *b = (const sb_symbol *)word;
   struct sbStemmerCtx *stctx = ctx;
   struct sb_stemmer *sb = stctx->sb;
 
+  // the cache holds the stems without their prefix
+  const char *cached;
+  if (TermCache_Get(TermCache_Stems, stctx->language, word, len, &cached, outlen)) {
+    if (!cached) {
+      return NULL;
+    }
+    *outlen += 1;
+    return sbstemmer_Copy(stctx, cached, *outlen - 1);
+  }
+
   const sb_symbol *stemmed = sb_stemmer_stem(sb, b, (int)len);
   if (stemmed) {
     *outlen = sb_stemmer_length(sb);
 
     // if the stem and its origin are the same - don't do anything
     if (*outlen == len && strncasecmp(word, (const char *)stemmed, len) == 0) {
+      TermCache_Put(TermCache_Stems, stctx->language, word, len, NULL, 0);
       return NULL;
     }
-    // reserver one character for the '+' prefix
+    TermCache_Put(TermCache_Stems, stctx->language, word, len, (const char *)stemmed, *outlen);
+    // reserve one character for the '+' prefix
     *outlen += 1;
-
-    // make sure the expansion plus the 1 char prefix fit in our static buffer
-    if (*outlen + 2 > stctx->cap) {
-      stctx->cap = *outlen + 2;
-      stctx->buf = rm_realloc(stctx->buf, stctx->cap);
-    }
-    // the first location is saved for the + prefix
-    memcpy(stctx->buf + 1, stemmed, *outlen + 1);
-    return (const char *)stctx->buf;
+    return sbstemmer_Copy(stctx, (const char *)stemmed, *outlen - 1);
   }
   return NULL;
 }
@@ -136,6 +153,7 @@ Stemmer *__newSnowballStemmer(RSLanguage language) {
   ctx->cap = 24;
   ctx->buf = rm_malloc(ctx->cap);
   ctx->buf[0] = STEM_PREFIX;
+  ctx->language = language;
 
   Stemmer *ret = rm_malloc(sizeof(Stemmer));
   ret->ctx = ctx;
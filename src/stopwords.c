@@ -9,6 +9,8 @@
 typedef struct StopWordList {
   TrieMap *m;
   size_t refcount;
+  // the length of the longest stopword, longer terms are not looked up
+  size_t maxLen;
 } StopWordList;
 
 static StopWordList *__default_stopwords = NULL;
@@ -31,7 +33,7 @@ StopWordList *EmptyStopWordList() {
 
 /* Check if a stopword list contains a term. The term must be already lowercased */
 int StopWordList_Contains(const StopWordList *sl, const char *term, size_t len) {
-  if (!sl || !term) {
+  if (!sl || !term || len > sl->maxLen) {
     return 0;
   }
 
@@ -59,6 +61,7 @@ StopWordList *NewStopWordListCStr(const char **strs, size_t len) {
   StopWordList *sl = rm_malloc(sizeof(*sl));
   sl->refcount = 1;
   sl->m = NewTrieMap();
+  sl->maxLen = 0;
 
   for (size_t i = 0; i < len; i++) {
 
@@ -76,6 +79,7 @@ StopWordList *NewStopWordListCStr(const char **strs, size_t len) {
     }
     // printf("Adding stopword %s\n", t);
     TrieMap_Add(sl->m, t, tlen, NULL, NULL);
+    if (tlen > sl->maxLen) sl->maxLen = tlen;
     rm_free(t);
   }
   return sl;
@@ -122,11 +126,13 @@ StopWordList *StopWordList_RdbLoad(RedisModuleIO *rdb, int encver) {
   StopWordList *sl = rm_malloc(sizeof(*sl));
   sl->m = NewTrieMap();
   sl->refcount = 1;
+  sl->maxLen = 0;
 
   while (elements--) {
     size_t len;
     char *str = RedisModule_LoadStringBuffer(rdb, &len);
     TrieMap_Add(sl->m, str, len, NULL, NULL);
+    if (len > sl->maxLen) sl->maxLen = len;
     RedisModule_Free(str);
   }
 
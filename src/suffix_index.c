@@ -0,0 +1,153 @@
+#include "suffix_index.h"
+#include "dep/triemap/triemap.h"
+#include "util/arr.h"
+#include "util/khash.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+// the terms already reported by a contains search, by the address of their shared string
+KHASH_SET_INIT_INT64(suffixSeen)
+
+typedef struct {
+  // the term that is this whole suffix, if any. It owns the string shared by all its suffixes
+  char *term;
+  // array (util/arr.h) of the terms ending with this suffix, `term` included
+  char **terms;
+} suffixNode;
+
+struct SuffixIndex {
+  TrieMap *suffixes;
+  size_t numTerms;
+  // the bytes used by the nodes, the term lists and the term strings, outside of the trie map
+  size_t memsize;
+};
+
+SuffixIndex *NewSuffixIndex() {
+  SuffixIndex *si = rm_calloc(1, sizeof(*si));
+  si->suffixes = NewTrieMap();
+  return si;
+}
+
+static void suffixNode_Free(void *p) {
+  suffixNode *n = p;
+  rm_free(n->term);
+  array_free(n->terms);
+  rm_free(n);
+}
+
+void SuffixIndex_Free(SuffixIndex *si) {
+  TrieMap_Free(si->suffixes, suffixNode_Free);
+  rm_free(si);
+}
+
+size_t SuffixIndex_NumTerms(const SuffixIndex *si) {
+  return si->numTerms;
+}
+
+size_t SuffixIndex_MemUsage(const SuffixIndex *si) {
+  return TrieMap_MemUsage(si->suffixes) + si->memsize;
+}
+
+static suffixNode *suffixIndex_Find(const SuffixIndex *si, const char *str, size_t len) {
+  void *n = TrieMap_Find(si->suffixes, (char *)str, len);
+  return n == TRIEMAP_NOTFOUND ? NULL : n;
+}
+
+/* Whether a suffix can start at this byte, i.e. it does not continue a UTF-8 sequence */
+#define SUFFIX_START(c) (((c)&0xC0) != 0x80)
+
+int SuffixIndex_Add(SuffixIndex *si, const char *term, size_t len) {
+  suffixNode *n = suffixIndex_Find(si, term, len);
+  if (n && n->term) {
+    return 0;
+  }
+  char *str = rm_strndup(term, len);
+  si->memsize += len + 1;
+  for (size_t i = 0; i < len; i++) {
+    if (!SUFFIX_START(term[i])) {
+      continue;
+    }
+    n = suffixIndex_Find(si, term + i, len - i);
+    if (!n) {
+      n = rm_calloc(1, sizeof(*n));
+      n->terms = array_new(char *, 1);
+      TrieMap_Add(si->suffixes, (char *)term + i, len - i, n, NULL);
+      si->memsize += sizeof(*n) + sizeof(array_hdr_t);
+    }
+    if (i == 0) {
+      n->term = str;
+    }
+    n->terms = array_append(n->terms, str);
+    si->memsize += sizeof(char *);
+  }
+  si->numTerms++;
+  return 1;
+}
+
+int SuffixIndex_Delete(SuffixIndex *si, const char *term, size_t len) {
+  suffixNode *n = suffixIndex_Find(si, term, len);
+  if (!n || !n->term) {
+    return 0;
+  }
+  char *str = n->term;
+  n->term = NULL;
+  for (size_t i = 0; i < len; i++) {
+    if (!SUFFIX_START(term[i])) {
+      continue;
+    }
+    n = suffixIndex_Find(si, term + i, len - i);
+    for (uint32_t j = 0; j < array_len(n->terms); j++) {
+      if (n->terms[j] == str) {
+        n->terms = array_del_fast(n->terms, j);
+        si->memsize -= sizeof(char *);
+        break;
+      }
+    }
+    if (array_len(n->terms) == 0) {
+      si->memsize -= sizeof(*n) + sizeof(array_hdr_t);
+      TrieMap_Delete(si->suffixes, (char *)term + i, len - i, suffixNode_Free);
+    }
+  }
+  rm_free(str);
+  si->memsize -= len + 1;
+  si->numTerms--;
+  return 1;
+}
+
+void SuffixIndex_Find(const SuffixIndex *si, const char *str, size_t len, int contains,
+                      SuffixIndexCallback cb, void *ctx) {
+  if (!contains) {
+    suffixNode *n = suffixIndex_Find(si, str, len);
+    if (!n) {
+      return;
+    }
+    for (uint32_t i = 0; i < array_len(n->terms); i++) {
+      if (!cb(n->terms[i], strlen(n->terms[i]), ctx)) {
+        return;
+      }
+    }
+    return;
+  }
+
+  // a term containing the string more than once is listed under each of the suffixes starting
+  // with it
+  TrieMapIterator *it = TrieMap_Iterate(si->suffixes, str, len);
+  khash_t(suffixSeen) *seen = kh_init(suffixSeen);
+  char *key;
+  tm_len_t keyLen;
+  void *p;
+  int more = 1;
+  while (more && TrieMapIterator_Next(it, &key, &keyLen, &p)) {
+    suffixNode *n = p;
+    for (uint32_t i = 0; more && i < array_len(n->terms); i++) {
+      int added;
+      kh_put(suffixSeen, seen, (uint64_t)(uintptr_t)n->terms[i], &added);
+      if (added) {
+        more = cb(n->terms[i], strlen(n->terms[i]), ctx);
+      }
+    }
+  }
+  TrieMapIterator_Free(it);
+  kh_destroy(suffixSeen, seen);
+}
@@ -0,0 +1,45 @@
+#ifndef __SUFFIX_INDEX_H__
+#define __SUFFIX_INDEX_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An index of the suffixes of the terms of a dictionary, used by suffix (`*foo`) and contains
+ * (`*foo*`) queries.
+ *
+ * Every suffix of a term, starting at each of its letters, is a key of a trie map, whose value
+ * lists the terms ending with that suffix. The terms ending with a string are then listed under
+ * that string itself, and the terms containing it under all the keys it is a prefix of. Each term
+ * string is allocated once and shared by all of its suffixes */
+typedef struct SuffixIndex SuffixIndex;
+
+/* Called with each matching term. Returns 0 to stop the search */
+typedef int (*SuffixIndexCallback)(const char *term, size_t len, void *ctx);
+
+SuffixIndex *NewSuffixIndex();
+void SuffixIndex_Free(SuffixIndex *si);
+
+/* Add a term. Returns 0 if it was already in the index */
+int SuffixIndex_Add(SuffixIndex *si, const char *term, size_t len);
+
+/* Remove a term. Returns 0 if it was not in the index */
+int SuffixIndex_Delete(SuffixIndex *si, const char *term, size_t len);
+
+/* Call `cb` once with each term ending with `str`, or containing it if `contains` is set, in no
+ * particular order */
+void SuffixIndex_Find(const SuffixIndex *si, const char *str, size_t len, int contains,
+                      SuffixIndexCallback cb, void *ctx);
+
+/* The number of terms in the index */
+size_t SuffixIndex_NumTerms(const SuffixIndex *si);
+
+/* The number of bytes used by the index */
+size_t SuffixIndex_MemUsage(const SuffixIndex *si);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -7,6 +7,9 @@
 #include "util/arr.h"
 #include <stdbool.h>
 
+// the first character of the terms of synonym groups, under which their terms are indexed
+#define SYNONYM_PREFIX_CHAR '~'
+
 /**
  * Holding a term data
  *  term - the term itself
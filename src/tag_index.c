@@ -100,7 +100,8 @@ static inline size_t tagIndex_Put(TagIndex *idx, const char *value, size_t len,
   IndexEncoder enc = InvertedIndex_GetEncoder(Index_DocIdsOnly);
   RSIndexResult rec = {.type = RSResultType_Virtual, .docId = docId, .offsetsSz = 0, .freq = 0};
   InvertedIndex *iv = TagIndex_OpenIndex(idx, value, len, 1);
-  return InvertedIndex_WriteEntryGeneric(iv, enc, docId, &rec);
+  // a document updated in place keeps its id, which may be older than the tag's last document
+  return InvertedIndex_InsertEntry(iv, enc, docId, &rec);
 }
 
 /* Index a vector of pre-processed tags for a docId */
@@ -116,6 +117,21 @@ size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docI
   return ret;
 }
 
+size_t TagIndex_Unindex(TagIndex *idx, const char **values, size_t n, t_docId docId) {
+  if (!values) return 0;
+  size_t ret = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    const char *tok = values[ii];
+    if (tok && *tok != '\0') {
+      InvertedIndex *iv = TagIndex_OpenIndex(idx, tok, strlen(tok), 0);
+      if (iv != TRIEMAP_NOTFOUND) {
+        ret += InvertedIndex_DeleteEntry(iv, docId);
+      }
+    }
+  }
+  return ret;
+}
+
 typedef struct {
   IndexIterator **its;
   uint32_t uid;
@@ -119,6 +119,10 @@ static inline void TagIndex_FreePreprocessedData(char **s) {
 /* Index a vector of pre-processed tags for a docId */
 size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docId);
 
+/* Remove a docId from the indexes of a vector of pre-processed tags, the tags it was indexed with.
+ * Returns the number of tags the document was removed from */
+size_t TagIndex_Unindex(TagIndex *idx, const char **values, size_t n, t_docId docId);
+
 /* Open an index reader to iterate a tag index for a specific tag. Used at query evaluation time.
  * Returns NULL if there is no such tag in the index */
 IndexIterator *TagIndex_OpenReader(TagIndex *idx, IndexSpec *sp, const char *value, size_t len,
@@ -0,0 +1,202 @@
+#include "term_cache.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "util/fnv.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t hash;
+  uint8_t lang;
+  // 0 for an unused entry, as empty terms are not cached
+  uint8_t termLen;
+  uint8_t resultLen;
+  uint8_t hasResult;
+  // the term followed by its result
+  char data[TERM_CACHE_DATA_SIZE];
+} TermCacheEntry;
+
+typedef struct ThreadTermCache {
+  TermCacheEntry *entries[TermCache_NumKinds];
+  // the number of entries of each table, a power of 2
+  size_t size;
+  // written by the owning thread and read by TermCache_GetStats, hence accessed atomically
+  uint64_t hits[TermCache_NumKinds];
+  uint64_t misses[TermCache_NumKinds];
+  struct ThreadTermCache *prev, *next;
+} ThreadTermCache;
+
+// the caches of the running threads, and the stats of those which exited
+static pthread_mutex_t cachesLock_g = PTHREAD_MUTEX_INITIALIZER;
+static ThreadTermCache *caches_g = NULL;
+static TermCacheStats exitedStats_g[TermCache_NumKinds];
+
+static pthread_key_t cacheKey_g;
+
+static void freeThreadCache(void *p) {
+  ThreadTermCache *tc = p;
+  pthread_mutex_lock(&cachesLock_g);
+  for (int i = 0; i < TermCache_NumKinds; i++) {
+    exitedStats_g[i].hits += tc->hits[i];
+    exitedStats_g[i].misses += tc->misses[i];
+  }
+  if (tc->prev) {
+    tc->prev->next = tc->next;
+  } else {
+    caches_g = tc->next;
+  }
+  if (tc->next) {
+    tc->next->prev = tc->prev;
+  }
+  pthread_mutex_unlock(&cachesLock_g);
+
+  for (int i = 0; i < TermCache_NumKinds; i++) {
+    rm_free(tc->entries[i]);
+  }
+  rm_free(tc);
+}
+
+static void __attribute__((constructor)) initKey() {
+  pthread_key_create(&cacheKey_g, freeThreadCache);
+}
+
+static size_t tableSize() {
+  size_t size = RSGlobalConfig.termCacheSize;
+  if (size == 0) {
+    return 0;
+  }
+  size_t pow2 = 1;
+  while (pow2 < size) {
+    pow2 <<= 1;
+  }
+  return pow2;
+}
+
+/* The cache of the calling thread, resized to follow TERM_CACHE_SIZE. NULL if it is 0 */
+static ThreadTermCache *getThreadCache() {
+  ThreadTermCache *tc = pthread_getspecific(cacheKey_g);
+  size_t size = tableSize();
+  if (tc && tc->size == size) {
+    return tc;
+  }
+  if (!size) {
+    return NULL;
+  }
+
+  if (!tc) {
+    tc = rm_calloc(1, sizeof(*tc));
+    pthread_mutex_lock(&cachesLock_g);
+    tc->next = caches_g;
+    if (caches_g) {
+      caches_g->prev = tc;
+    }
+    caches_g = tc;
+    pthread_mutex_unlock(&cachesLock_g);
+    pthread_setspecific(cacheKey_g, tc);
+  }
+  for (int i = 0; i < TermCache_NumKinds; i++) {
+    rm_free(tc->entries[i]);
+    tc->entries[i] = rm_calloc(size, sizeof(TermCacheEntry));
+  }
+  tc->size = size;
+  return tc;
+}
+
+static inline uint32_t hashTerm(int lang, const char *term, size_t len) {
+  return rs_fnv_32a_buf(term, len, 0x811c9dc5 ^ (uint32_t)lang);
+}
+
+static inline void incrStat(uint64_t *stat) {
+  __atomic_store_n(stat, *stat + 1, __ATOMIC_RELAXED);
+}
+
+int TermCache_Get(TermCacheKind kind, int lang, const char *term, size_t len, const char **result,
+                  size_t *resultLen) {
+  if (len == 0 || len >= TERM_CACHE_DATA_SIZE) {
+    return 0;
+  }
+  ThreadTermCache *tc = getThreadCache();
+  if (!tc) {
+    return 0;
+  }
+
+  uint32_t hash = hashTerm(lang, term, len);
+  TermCacheEntry *e = &tc->entries[kind][hash & (tc->size - 1)];
+  if (e->hash != hash || e->termLen != len || e->lang != (uint8_t)lang ||
+      memcmp(e->data, term, len)) {
+    incrStat(&tc->misses[kind]);
+    return 0;
+  }
+  incrStat(&tc->hits[kind]);
+  *result = e->hasResult ? e->data + len : NULL;
+  *resultLen = e->resultLen;
+  return 1;
+}
+
+void TermCache_Put(TermCacheKind kind, int lang, const char *term, size_t len, const char *result,
+                   size_t resultLen) {
+  if (!result) {
+    resultLen = 0;
+  }
+  if (len == 0 || len + resultLen > TERM_CACHE_DATA_SIZE) {
+    return;
+  }
+  ThreadTermCache *tc = getThreadCache();
+  if (!tc) {
+    return;
+  }
+
+  uint32_t hash = hashTerm(lang, term, len);
+  TermCacheEntry *e = &tc->entries[kind][hash & (tc->size - 1)];
+  e->hash = hash;
+  e->lang = lang;
+  e->termLen = len;
+  e->resultLen = resultLen;
+  e->hasResult = !!result;
+  memcpy(e->data, term, len);
+  if (result) {
+    memcpy(e->data + len, result, resultLen);
+  }
+}
+
+TermCacheStats TermCache_GetStats(TermCacheKind kind) {
+  pthread_mutex_lock(&cachesLock_g);
+  TermCacheStats stats = exitedStats_g[kind];
+  for (ThreadTermCache *tc = caches_g; tc; tc = tc->next) {
+    stats.hits += __atomic_load_n(&tc->hits[kind], __ATOMIC_RELAXED);
+    stats.misses += __atomic_load_n(&tc->misses[kind], __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&cachesLock_g);
+  return stats;
+}
+
+void TermCache_RenderStats(RedisModuleCtx *ctx) {
+#define REPLY_KVNUM(n, k, v)                   \
+  RedisModule_ReplyWithSimpleString(ctx, k);   \
+  RedisModule_ReplyWithDouble(ctx, (double)v); \
+  n += 2
+
+  static const char *names[TermCache_NumKinds][3] = {
+      {"stem_hits", "stem_misses", "stem_hit_rate"},
+      {"phonetic_hits", "phonetic_misses", "phonetic_hit_rate"},
+  };
+  int n = 0;
+  RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+  for (int i = 0; i < TermCache_NumKinds; i++) {
+    TermCacheStats stats = TermCache_GetStats(i);
+    uint64_t lookups = stats.hits + stats.misses;
+    REPLY_KVNUM(n, names[i][0], stats.hits);
+    REPLY_KVNUM(n, names[i][1], stats.misses);
+    REPLY_KVNUM(n, names[i][2], lookups ? (double)stats.hits / lookups : 0);
+  }
+  RedisModule_ReplySetArrayLength(ctx, n);
+}
+
+void TermCache_FreeThread() {
+  ThreadTermCache *tc = pthread_getspecific(cacheKey_g);
+  if (tc) {
+    pthread_setspecific(cacheKey_g, NULL);
+    freeThreadCache(tc);
+  }
+}
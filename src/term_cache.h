@@ -0,0 +1,58 @@
+#ifndef __TERM_CACHE_H__
+#define __TERM_CACHE_H__
+
+#include "redismodule.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-thread caches of the stems and phonetic codes of terms.
+ *
+ * Natural-language text repeats a small vocabulary, so the indexing threads and the query
+ * expanders stem and encode the same terms over and over. Each thread keeps, for each kind of
+ * result, a direct-mapped table of TERM_CACHE_SIZE entries keyed by the term and its language. A
+ * newer term evicts an older one hashed to the same entry, which bounds the memory of a thread to
+ * 64 bytes per entry. Terms whose key and result do not fit an entry are not cached.
+ *
+ * The tables are allocated by the first lookup of each thread, and freed when the thread exits. A
+ * TERM_CACHE_SIZE of 0 disables them */
+typedef enum {
+  TermCache_Stems = 0,
+  TermCache_Phonetics = 1,
+  TermCache_NumKinds = 2,
+} TermCacheKind;
+
+/* The bytes of an entry left for the term and its result */
+#define TERM_CACHE_DATA_SIZE 56
+
+/* Look up the result of a term. Returns 1 if it is cached, setting result to the cached bytes, or
+ * NULL if the term has no result, and resultLen to their length. The result is only valid until
+ * the next call on this thread */
+int TermCache_Get(TermCacheKind kind, int lang, const char *term, size_t len, const char **result,
+                  size_t *resultLen);
+
+/* Cache the result of a term, which may be NULL if it has none */
+void TermCache_Put(TermCacheKind kind, int lang, const char *term, size_t len, const char *result,
+                   size_t resultLen);
+
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+} TermCacheStats;
+
+/* The hits and misses of all the threads, including those which exited */
+TermCacheStats TermCache_GetStats(TermCacheKind kind);
+
+/* Reply with the hits, misses and hit rate of each cache, summed over all the threads */
+void TermCache_RenderStats(RedisModuleCtx *ctx);
+
+/* Free the caches of the calling thread now, instead of when it exits */
+void TermCache_FreeThread();
+
+#ifdef __cplusplus
+}
+#endif
+#endif
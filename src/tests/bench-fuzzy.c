@@ -0,0 +1,83 @@
+#include "trie/trie_type.h"
+#include "trie/levenshtein.h"
+#include "rmutil/alloc.h"
+#include "time_sample.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_TERMS 500000
+#define NUM_QUERIES 200
+
+/* A random lowercase word of 3 to 12 letters, mostly from the common ones so that terms share
+ * prefixes and have close neighbours, like a real dictionary */
+static void randWord(char *buf) {
+  static const char common[] = "etaoinshrdlu";
+  size_t n = 3 + rand() % 10;
+  for (size_t i = 0; i < n; ++i) {
+    buf[i] = rand() % 4 ? common[rand() % (sizeof(common) - 1)] : 'a' + rand() % 26;
+  }
+  buf[n] = 0;
+}
+
+/* Measure building the automata of the queries, and expanding them over the dictionary */
+static void bench(Trie *t, char queries[][16], int maxDist, int transpositions) {
+  TimeSample ts;
+  size_t matches = 0;
+  long long buildNS = 0;
+  TimeSampler_Start(&ts);
+  for (size_t i = 0; i < NUM_QUERIES; ++i) {
+    size_t rlen;
+    rune *runes = strToFoldedRunes(queries[i], &rlen);
+    struct timespec start, end;
+    clock_gettime(CLOCK_REALTIME, &start);
+    DFAFilter fc = NewDFAFilter(runes, rlen, maxDist, 0, transpositions);
+    clock_gettime(CLOCK_REALTIME, &end);
+    buildNS += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+
+    // the mutable nodes first, and then the frozen terms, as Trie_Iterate does
+    TrieIterator *it = TrieNode_Iterate(t->root, FilterFunc, StackPop, &fc);
+    if (t->frozen) {
+      TrieIterator_SetFrozen(it, t->frozen);
+    }
+    rune *rstr;
+    t_len slen;
+    float score;
+    int dist;
+    while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+      ++matches;
+    }
+    TrieIterator_Free(it);
+    DFAFilter_Free(&fc);
+    free(runes);
+    TimeSampler_Tick(&ts);
+  }
+  TimeSampler_End(&ts);
+  printf("distance %d%s: %d queries in %lldms, %fus/query (%fus building), %f matches/query\n",
+         maxDist, transpositions ? " with transpositions" : "", ts.num, TimeSampler_DurationMS(&ts),
+         TimeSampler_IterationMS(&ts) * 1000, (double)buildNS / NUM_QUERIES / 1000,
+         (double)matches / NUM_QUERIES);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  srand(1337);
+  Trie *t = NewTrie();
+  char word[16];
+  for (size_t i = 0; i < NUM_TERMS; ++i) {
+    randWord(word);
+    Trie_InsertStringBuffer(t, word, strlen(word), 1, 1, NULL);
+  }
+  printf("%zu distinct terms\n", t->size);
+
+  static char queries[NUM_QUERIES][16];
+  for (size_t i = 0; i < NUM_QUERIES; ++i) {
+    randWord(queries[i]);
+  }
+  for (int maxDist = 1; maxDist <= 3; ++maxDist) {
+    bench(t, queries, maxDist, 0);
+    bench(t, queries, maxDist, 1);
+  }
+  TrieType_Free(t);
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include "trie/trie_type.h"
+#include "trie/frozen_trie.h"
+#include "trie/rune_util.h"
+#include "rmutil/alloc.h"
+#include "rmalloc.h"
+#include "time_sample.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_TERMS 1000000
+
+/* A random lowercase word of 3 to 12 letters, mostly from the common ones so that terms share
+ * prefixes, like a real dictionary */
+static void randWord(char *buf) {
+  static const char common[] = "etaoinshrdlu";
+  size_t n = 3 + rand() % 10;
+  for (size_t i = 0; i < n; ++i) {
+    buf[i] = rand() % 4 ? common[rand() % (sizeof(common) - 1)] : 'a' + rand() % 26;
+  }
+  buf[n] = 0;
+}
+
+static int cmpWords(const void *p1, const void *p2) {
+  return strcmp(p1, p2);
+}
+
+static void report(const char *name, TimeSample *ts, size_t bytes) {
+  printf("%s: %d items (%zuMB) in %lldms, %.2fs/GB\n", name, ts->num, bytes >> 20,
+         TimeSampler_DurationMS(ts), TimeSampler_DurationSec(ts) * (1 << 30) / bytes);
+}
+
+/* Measure loading a trie saved in lexical order, by inserting each term and then freezing the
+ * trie, and by building it frozen in bulk */
+static void benchTrie() {
+  char(*words)[16] = malloc(NUM_TERMS * sizeof(*words));
+  size_t bytes = 0;
+  for (size_t ii = 0; ii < NUM_TERMS; ++ii) {
+    randWord(words[ii]);
+    bytes += strlen(words[ii]) + 1 + sizeof(double);
+  }
+  qsort(words, NUM_TERMS, sizeof(*words), cmpWords);
+
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  Trie *t = NewTrie();
+  for (size_t ii = 0; ii < NUM_TERMS; ++ii) {
+    Trie_InsertStringBuffer(t, words[ii], strlen(words[ii]), 1, 0, NULL);
+    TimeSampler_Tick(&ts);
+  }
+  Trie_Freeze(t);
+  TimeSampler_End(&ts);
+  report("trie insert", &ts, bytes);
+  TrieType_Free(t);
+
+  TimeSampler_Start(&ts);
+  FrozenTrieBuilder *b = NewFrozenTrieBuilder();
+  rune runes[16];
+  for (size_t ii = 0; ii < NUM_TERMS; ++ii) {
+    size_t len = strToRunesN(words[ii], strlen(words[ii]), runes);
+    FrozenTrieBuilder_Add(b, runes, len, 1, NULL, 0);
+    TimeSampler_Tick(&ts);
+  }
+  FrozenTrie *ft = FrozenTrieBuilder_Finish(b);
+  TimeSampler_End(&ts);
+  report("trie bulk build", &ts, bytes);
+  FrozenTrie_Free(ft);
+  free(words);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  srand(1337);
+  benchTrie();
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "tokenize.h"
+#include "stemmer.h"
+#include "stopwords.h"
+#include "rmutil/alloc.h"
+#include "time_sample.h"
+#include "config.h"
+#include "term_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_ROUNDS 200
+#define CATALOG_BYTES (1 << 20)
+
+/* Product titles and descriptions, mostly ASCII words with some codes and punctuation, like our
+ * catalog */
+static char *catalogText() {
+  static const char *words[] = {"Stainless", "steel",   "Water",    "bottle", "750ml", "insulated",
+                                "BPA_free",  "Leakproof", "lid",    "for",    "Outdoor", "sports",
+                                "and",       "travel",  "SKU",      "X200",   "black",  "matte"};
+  static const char *seps[] = {" ", " ", " ", ", ", " - ", ". ", " / ", " (", ") "};
+  char *text = malloc(CATALOG_BYTES + 32);
+  size_t len = 0;
+  while (len < CATALOG_BYTES) {
+    len += sprintf(text + len, "%s%s", words[rand() % (sizeof(words) / sizeof(*words))],
+                   seps[rand() % (sizeof(seps) / sizeof(*seps))]);
+  }
+  return text;
+}
+
+static char *readFile(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *text = malloc(len + 1);
+  text[fread(text, 1, len, f)] = 0;
+  fclose(f);
+  return text;
+}
+
+/* Tokenize the text repeatedly, on a fresh copy each time as tokens are normalized in place */
+static void bench(const char *name, const char *text, Stemmer *stemmer, uint32_t options) {
+  size_t len = strlen(text);
+  char *buf = malloc(len + 1);
+  RSTokenizer *tk = NewSimpleTokenizer(stemmer, DefaultStopWordList(), 0);
+  Token tok = {0};
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  for (size_t ii = 0; ii < NUM_ROUNDS; ++ii) {
+    memcpy(buf, text, len + 1);
+    tk->Start(tk, buf, len, options);
+    while (tk->Next(tk, &tok)) {
+      TimeSampler_Tick(&ts);
+    }
+  }
+  TimeSampler_End(&ts);
+  printf("%s: %d tokens in %lldms, %.1fMB/s\n", name, ts.num, TimeSampler_DurationMS(&ts),
+         (double)len * NUM_ROUNDS / (1 << 20) / TimeSampler_DurationSec(&ts));
+  tk->Free(tk);
+  free(buf);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  char *texts[] = {catalogText(), readFile(argc > 1 ? argv[1] : "genesis.txt")};
+  const char *names[] = {"catalog", "genesis"};
+  Stemmer *stemmer = NewStemmer(SnowballStemmer, RS_LANG_ENGLISH);
+
+  for (size_t ii = 0; ii < sizeof(texts) / sizeof(*texts); ++ii) {
+    if (!texts[ii]) {
+      continue;
+    }
+    char name[64];
+    sprintf(name, "%s, scalar", names[ii]);
+    bench(name, texts[ii], NULL, TOKENIZE_NOSTEM | TOKENIZE_SCALAR);
+    sprintf(name, "%s, vectorized", names[ii]);
+    bench(name, texts[ii], NULL, TOKENIZE_NOSTEM);
+    // stemming and phonetic encoding take most of the time left, unless their results are cached
+    RSGlobalConfig.termCacheSize = 0;
+    sprintf(name, "%s, stemmed", names[ii]);
+    bench(name, texts[ii], stemmer, TOKENIZE_DEFAULT_OPTIONS);
+    sprintf(name, "%s, phonetics", names[ii]);
+    bench(name, texts[ii], NULL, TOKENIZE_NOSTEM | TOKENIZE_PHONETICS);
+    RSGlobalConfig.termCacheSize = DEFAULT_TERM_CACHE_SIZE;
+    TermCacheStats before = TermCache_GetStats(TermCache_Stems);
+    sprintf(name, "%s, stemmed, cached", names[ii]);
+    bench(name, texts[ii], stemmer, TOKENIZE_DEFAULT_OPTIONS);
+    sprintf(name, "%s, phonetics, cached", names[ii]);
+    bench(name, texts[ii], NULL, TOKENIZE_NOSTEM | TOKENIZE_PHONETICS);
+    TermCacheStats after = TermCache_GetStats(TermCache_Stems);
+    uint64_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+    printf("%s, stem cache hit rate %.3f\n", names[ii], (double)hits / (hits + misses));
+    free(texts[ii]);
+  }
+  stemmer->Free(stemmer);
+  return 0;
+}
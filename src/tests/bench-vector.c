@@ -0,0 +1,105 @@
+#include "redisearch.h"
+#include "vector_index.h"
+#include "doc_table.h"
+#include "rmutil/alloc.h"
+#include "util/arr.h"
+#include "time_sample.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_VECTORS 20000
+#define NUM_QUERIES 200
+#define DIM 128
+#define K 10
+
+static float randf(void) {
+  return (float)rand() / RAND_MAX;
+}
+
+/* Measure the build time, query latency and recall of an index, against the flat index */
+static void bench(const char *name, const VectorFieldOptions *opts, const float *vecs,
+                  const float *queries, KnnHit **truth, DocTable *docs) {
+  VectorIndex *vi = NewVectorIndex(opts);
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  for (size_t ii = 0; ii < NUM_VECTORS; ++ii) {
+    VectorIndex_Add(vi, ii + 1, vecs + ii * DIM);
+    TimeSampler_Tick(&ts);
+  }
+  TimeSampler_End(&ts);
+  printf("%s: %d vectors added in %lldms, %fus/vector\n", name, ts.num, TimeSampler_DurationMS(&ts),
+         TimeSampler_IterationMS(&ts) * 1000);
+
+  size_t found = 0;
+  TimeSampler_Start(&ts);
+  for (size_t ii = 0; ii < NUM_QUERIES; ++ii) {
+    KnnHit *hits = VectorIndex_Search(vi, docs, queries + ii * DIM, K, NULL);
+    for (size_t jj = 0; jj < array_len(hits); ++jj) {
+      for (size_t kk = 0; kk < array_len(truth[ii]); ++kk) {
+        found += hits[jj].docId == truth[ii][kk].docId;
+      }
+    }
+    array_free(hits);
+    TimeSampler_Tick(&ts);
+  }
+  TimeSampler_End(&ts);
+  printf("%s: %d queries in %lldms, %fus/query, recall@%d %f\n", name, ts.num,
+         TimeSampler_DurationMS(&ts), TimeSampler_IterationMS(&ts) * 1000, K,
+         (double)found / (NUM_QUERIES * K));
+  VectorIndex_Free(vi);
+}
+
+int main(int argc, char **argv) {
+  RMUTil_InitAlloc();
+  srand(1337);
+  float *vecs = malloc(NUM_VECTORS * DIM * sizeof(float));
+  for (size_t ii = 0; ii < NUM_VECTORS * DIM; ++ii) {
+    vecs[ii] = randf();
+  }
+  float *queries = malloc(NUM_QUERIES * DIM * sizeof(float));
+  for (size_t ii = 0; ii < NUM_QUERIES * DIM; ++ii) {
+    queries[ii] = randf();
+  }
+
+  DocTable docs = NewDocTable(1000, NUM_VECTORS);
+  for (size_t ii = 0; ii < NUM_VECTORS; ++ii) {
+    char key[32];
+    sprintf(key, "doc%zu", ii);
+    DocTable_Put(&docs, key, strlen(key), 1.0, Document_DefaultFlags, NULL, 0);
+  }
+
+  // the exact nearest neighbours, to measure the recall of the graph
+  VectorFieldOptions opts = {.dim = DIM,
+                             .metric = VectorMetric_L2,
+                             .algo = VectorAlgo_Flat,
+                             .hnswM = VECTOR_DEFAULT_HNSW_M,
+                             .hnswEfConstruction = VECTOR_DEFAULT_HNSW_EF_CONSTRUCTION,
+                             .hnswEfRuntime = VECTOR_DEFAULT_HNSW_EF_RUNTIME};
+  VectorIndex *flat = NewVectorIndex(&opts);
+  for (size_t ii = 0; ii < NUM_VECTORS; ++ii) {
+    VectorIndex_Add(flat, ii + 1, vecs + ii * DIM);
+  }
+  KnnHit *truth[NUM_QUERIES];
+  for (size_t ii = 0; ii < NUM_QUERIES; ++ii) {
+    truth[ii] = VectorIndex_Search(flat, &docs, queries + ii * DIM, K, NULL);
+  }
+  VectorIndex_Free(flat);
+
+  bench("FLAT", &opts, vecs, queries, truth, &docs);
+  opts.algo = VectorAlgo_HNSW;
+  for (uint16_t ef = 10; ef <= 160; ef *= 2) {
+    char name[64];
+    sprintf(name, "HNSW(M=%u,EF_RUNTIME=%u)", opts.hnswM, ef);
+    opts.hnswEfRuntime = ef;
+    bench(name, &opts, vecs, queries, truth, &docs);
+  }
+
+  for (size_t ii = 0; ii < NUM_QUERIES; ++ii) {
+    array_free(truth[ii]);
+  }
+  DocTable_Free(&docs);
+  free(vecs);
+  free(queries);
+  return 0;
+}
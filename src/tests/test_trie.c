@@ -119,7 +119,7 @@ int testPayload() {
 
   size_t rlen;
   rune *runes = strToRunes("hel", &rlen);
-  DFAFilter fc = NewDFAFilter(runes, rlen, 1, 1);
+  DFAFilter fc = NewDFAFilter(runes, rlen, 1, 1, 0);
   TrieIterator *it = TrieNode_Iterate(root, FilterFunc, StackPop, &fc);
   rune *s;
   t_len len;
@@ -283,7 +283,7 @@ int testDFAFilter() {
 
   for (i = 0; terms[i] != NULL; i++) {
     runes = strToFoldedRunes(terms[i], &rlen);
-    DFAFilter fc = NewDFAFilter(runes, rlen, 2, 0);
+    DFAFilter fc = NewDFAFilter(runes, rlen, 2, 0, 0);
 
     TrieIterator *it = TrieNode_Iterate(root, FilterFunc, StackPop, &fc);
     rune *s;
@@ -315,7 +315,7 @@ int testDFAFilter() {
   for (i = 0; prefixes[i] != NULL; i++) {
     // printf("prefix %d: %s\n", i, prefixes[i]);
     runes = strToRunes(prefixes[i], &rlen);
-    DFAFilter fc = NewDFAFilter(runes, rlen, 1, 1);
+    DFAFilter fc = NewDFAFilter(runes, rlen, 1, 1, 0);
 
     TrieIterator *it = TrieNode_Iterate(root, FilterFunc, StackPop, &fc);
     rune *s;
@@ -8,10 +8,25 @@
 #include <strings.h>
 #include "phonetic_manager.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TOKENIZE_SIMD
+#endif
+
+// Shortest word which can/should actually be stemmed
+#define MIN_STEM_CANDIDATE_LEN 4
+
+// Normalization buffer
+#define MAX_NORMALIZE_SIZE 128
+
 typedef struct {
   RSTokenizer base;
   char **pos;
+  // the end of the text, which the vectorized scan does not read past
+  const char *end;
   Stemmer *stemmer;
+  // where tokens are normalized with TOKENIZE_NOMODIFY, which outlives the call to Next()
+  char normBuf[MAX_NORMALIZE_SIZE];
 } simpleTokenizer;
 
 static void simpleTokenizer_Start(RSTokenizer *base, char *text, size_t len, uint32_t options) {
@@ -21,14 +36,9 @@ static void simpleTokenizer_Start(RSTokenizer *base, char *text, size_t len, uin
   ctx->options = options;
   ctx->len = len;
   self->pos = &ctx->text;
+  self->end = text + len;
 }
 
-// Shortest word which can/should actually be stemmed
-#define MIN_STEM_CANDIDATE_LEN 4
-
-// Normalization buffer
-#define MAX_NORMALIZE_SIZE 128
-
 /**
  * Normalizes text.
  * - s contains the raw token
@@ -68,30 +78,120 @@ static char *DefaultNormalize(char *s, char *dst, size_t *len) {
   return dst;
 }
 
+#ifdef TOKENIZE_SIMD
+/* Whether a byte is an ASCII letter, digit or underscore, which tokens are mostly made of and which
+ * need no other normalization than lowercasing */
+static inline int isWordASCII(uint8_t c) {
+  return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// The mask of the ASCII letters, digits and underscores of 16 bytes
+static inline uint32_t wordMask16(__m128i v) {
+  // setting bit 5 lowercases ASCII letters, and maps no other byte to one
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+  __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), under));
+}
+
+static inline __m128i lowercase16(__m128i v) {
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+  return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+/* Find the first byte of `s` which is not an ASCII letter, digit or underscore, 32 bytes at a
+ * time. Returns NULL if there is none before `end` */
+static const char *scanWordASCII(const char *s, const char *end) {
+  for (; end - s >= 32; s += 32) {
+    uint32_t mask = wordMask16(_mm_loadu_si128((const __m128i *)s)) |
+                    (wordMask16(_mm_loadu_si128((const __m128i *)(s + 16))) << 16);
+    if (mask != 0xffffffff) {
+      return s + __builtin_ctz(~mask);
+    }
+  }
+  for (; s < end; ++s) {
+    if (!isWordASCII(*s)) {
+      return s;
+    }
+  }
+  return NULL;
+}
+
+/* Copy `len` bytes of ASCII letters, digits and underscores to `dst`, lowercased. `dst` may be
+ * `src` */
+static void lowercaseWordASCII(const char *src, char *dst, size_t len) {
+  size_t ii = 0;
+  for (; ii + 16 <= len; ii += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + ii));
+    _mm_storeu_si128((__m128i *)(dst + ii), lowercase16(v));
+  }
+  for (; ii < len; ++ii) {
+    dst[ii] = src[ii] | (src[ii] >= 'A' && src[ii] <= 'Z' ? 0x20 : 0);
+  }
+}
+
+/* The fast path of toksep() and DefaultNormalize() for tokens made of ASCII letters, digits and
+ * underscores and ended by a separator, which are normalized by lowercasing them. Returns the
+ * normalized token, or NULL if the token needs the full logic, as when it has escapes, blanks
+ * or non-ASCII bytes, or ends the text. The text is left as is in that case */
+static char *toksepNormalizeASCII(simpleTokenizer *self, char *dst, size_t *origLen,
+                                  size_t *normLen) {
+  char *tok = *self->pos;
+  const char *sep = scanWordASCII(tok, self->end);
+  // the byte before the separator is not a backslash escaping it
+  if (!sep || !istoksep(*sep)) {
+    return NULL;
+  }
+  *origLen = *normLen = sep - tok;
+  *self->pos = sep[1] ? (char *)sep + 1 : NULL;
+
+  if (self->base.ctx.options & TOKENIZE_NOMODIFY) {
+    if (*normLen > MAX_NORMALIZE_SIZE) {
+      *normLen = MAX_NORMALIZE_SIZE;
+    }
+  } else {
+    dst = tok;
+  }
+  lowercaseWordASCII(tok, dst, *normLen);
+  return dst;
+}
+#endif
+
 // tokenize the text in the context
 uint32_t simpleTokenizer_Next(RSTokenizer *base, Token *t) {
   TokenizerCtx *ctx = &base->ctx;
   simpleTokenizer *self = (simpleTokenizer *)base;
   while (*self->pos != NULL) {
-    // get the next token
-    size_t origLen;
-    char *tok = toksep(self->pos, &origLen);
-
-    // normalize the token
-    size_t normLen = origLen;
-
-    char normalized_s[MAX_NORMALIZE_SIZE];
-    char *normBuf;
-    if (ctx->options & TOKENIZE_NOMODIFY) {
-      normBuf = normalized_s;
-      if (normLen > MAX_NORMALIZE_SIZE) {
-        normLen = MAX_NORMALIZE_SIZE;
-      }
-    } else {
-      normBuf = tok;
+    size_t origLen, normLen;
+    char *normalized_s = self->normBuf;
+    char *tok = *self->pos, *normalized = NULL;
+
+#ifdef TOKENIZE_SIMD
+    if (!(ctx->options & TOKENIZE_SCALAR)) {
+      normalized = toksepNormalizeASCII(self, normalized_s, &origLen, &normLen);
     }
+#endif
+    if (!normalized) {
+      // get the next token
+      tok = toksep(self->pos, &origLen);
 
-    char *normalized = DefaultNormalize(tok, normBuf, &normLen);
+      // normalize the token
+      normLen = origLen;
+      char *normBuf;
+      if (ctx->options & TOKENIZE_NOMODIFY) {
+        normBuf = normalized_s;
+        if (normLen > MAX_NORMALIZE_SIZE) {
+          normLen = MAX_NORMALIZE_SIZE;
+        }
+      } else {
+        normBuf = tok;
+      }
+      normalized = DefaultNormalize(tok, normBuf, &normLen);
+    }
     // ignore tokens that turn into nothing
     if (normalized == NULL || normLen == 0) {
       continue;
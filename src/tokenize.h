@@ -80,6 +80,8 @@ RSTokenizer *NewChineseTokenizer(Stemmer *stemmer, StopWordList *stopwords, uint
 #define TOKENIZE_NOSTEM 0x02
 // perform phonetic matching
 #define TOKENIZE_PHONETICS 0x04
+// don't use the vectorized scan of ASCII tokens, for comparing with it
+#define TOKENIZE_SCALAR 0x08
 
 /**
  * Pooled tokenizer functions:
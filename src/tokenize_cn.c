@@ -44,6 +44,10 @@ static void maybeFrisoInit() {
   // Overrides:
   // Don't segment english text. We might use our actual tokenizer later if needed
   config_g->en_sseg = 0;
+
+  // The dictionary is read-only from now on, shared by all the tokenizers and threads, which
+  // segment the text by walking its compiled trie
+  friso_dic_compile(friso_g);
 }
 
 static void cnTokenizer_Start(RSTokenizer *base, char *text, size_t len, uint32_t options) {
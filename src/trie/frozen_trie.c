@@ -0,0 +1,409 @@
+#include "frozen_trie.h"
+#include "util/arr.h"
+#include "rmalloc.h"
+
+#include <sys/param.h>
+
+static TriePayload *frozenTrie_NewPayload(const char *data, size_t len) {
+  TriePayload *p = rm_malloc(sizeof(TriePayload) + len + 1);
+  p->len = len;
+  memcpy(p->data, data, len);
+  return p;
+}
+
+/* Set or clear the payload of a node */
+static void frozenTrie_SetPayload(FrozenTrie *ft, FrozenTrieNode *n, const char *data, size_t len) {
+  if (n->payload) {
+    rm_free(ft->payloads[n->payload - 1]);
+    ft->payloads[n->payload - 1] = NULL;
+  }
+  if (data == NULL || len == 0) {
+    return;
+  }
+  if (!n->payload) {
+    ft->payloads = array_append(ft->payloads, NULL);
+    n->payload = array_len(ft->payloads);
+  }
+  ft->payloads[n->payload - 1] = frozenTrie_NewPayload(data, len);
+}
+
+static int runecmp(const rune *sa, size_t na, const rune *sb, size_t nb) {
+  size_t minlen = MIN(na, nb);
+  for (size_t ii = 0; ii < minlen; ++ii) {
+    if (sa[ii] != sb[ii]) {
+      return (int)sa[ii] - (int)sb[ii];
+    }
+  }
+  return na < nb ? -1 : na > nb ? 1 : 0;
+}
+
+/***************************************************************
+ *
+ *                       Building
+ *
+ ***************************************************************/
+
+/* A node on the path of the last added string, whose children may still grow */
+typedef struct {
+  // the node's string is key[start:end]
+  t_len start;
+  t_len end;
+  float score;
+  uint32_t payload;
+  uint8_t flags;
+  // the finished children of the node
+  FrozenTrieNode *children;
+} frozenBuildNode;
+
+struct FrozenTrieBuilder {
+  FrozenTrie *ft;
+  // the last added string
+  rune key[TRIE_INITIAL_STRING_LEN + 1];
+  t_len keyLen;
+  // the path of the last added string, starting at the root
+  frozenBuildNode *path;
+};
+
+FrozenTrieBuilder *NewFrozenTrieBuilder() {
+  FrozenTrieBuilder *b = rm_calloc(1, sizeof(*b));
+  b->ft = rm_calloc(1, sizeof(*b->ft));
+  b->ft->nodes = array_new(FrozenTrieNode, 16);
+  b->ft->runes = array_new(rune, 16);
+  b->ft->payloads = array_new(TriePayload *, 1);
+  b->path = array_new(frozenBuildNode, 8);
+  frozenBuildNode root = {.children = array_new(FrozenTrieNode, 16)};
+  b->path = array_append(b->path, root);
+  return b;
+}
+
+/* Store the children and the string of a node whose subtree is complete, and return the node */
+static FrozenTrieNode frozenBuilder_Finish(FrozenTrieBuilder *b, frozenBuildNode *bn) {
+  FrozenTrie *ft = b->ft;
+  FrozenTrieNode n = {.str = array_len(ft->runes),
+                      .children = array_len(ft->nodes),
+                      .numChildren = array_len(bn->children),
+                      .payload = bn->payload,
+                      .score = bn->score,
+                      .maxChildScore = bn->score,
+                      .len = bn->end - bn->start,
+                      .first = bn->end > bn->start ? b->key[bn->start] : 0,
+                      .flags = bn->flags};
+  for (uint32_t i = 0; i < n.numChildren; i++) {
+    n.maxChildScore = MAX(n.maxChildScore, bn->children[i].maxChildScore);
+  }
+  ft->nodes = array_ensure_append(ft->nodes, bn->children, n.numChildren, FrozenTrieNode);
+  ft->runes = array_ensure_append(ft->runes, b->key + bn->start, n.len, rune);
+  array_free(bn->children);
+  bn->children = NULL;
+  return n;
+}
+
+/* Finish the last node of the path and add it to the children of its parent */
+static void frozenBuilder_Pop(FrozenTrieBuilder *b) {
+  frozenBuildNode bn = array_pop(b->path);
+  FrozenTrieNode n = frozenBuilder_Finish(b, &bn);
+  frozenBuildNode *parent = &array_tail(b->path);
+  parent->children = array_append(parent->children, n);
+}
+
+void FrozenTrieBuilder_Add(FrozenTrieBuilder *b, const rune *str, t_len len, float score,
+                           const char *payload, size_t plen) {
+  if (len == 0 || len > TRIE_INITIAL_STRING_LEN) {
+    return;
+  }
+  t_len lcp = 0;
+  while (lcp < len && lcp < b->keyLen && str[lcp] == b->key[lcp]) {
+    lcp++;
+  }
+
+  // the nodes past the common prefix are complete, since no later string can reach them
+  while (array_len(b->path) > 1 && array_tail(b->path).start >= lcp) {
+    frozenBuilder_Pop(b);
+  }
+  frozenBuildNode *top = &array_tail(b->path);
+  if (top->end > lcp) {
+    // the new string diverges inside the top node, so split off the part past the common prefix
+    frozenBuildNode split = *top;
+    split.start = lcp;
+    FrozenTrieNode n = frozenBuilder_Finish(b, &split);
+    *top = (frozenBuildNode){.start = top->start, .end = lcp,
+                             .children = array_new(FrozenTrieNode, 2)};
+    top->children = array_append(top->children, n);
+  }
+
+  uint32_t pl = 0;
+  if (payload != NULL && plen > 0) {
+    b->ft->payloads = array_append(b->ft->payloads, frozenTrie_NewPayload(payload, plen));
+    pl = array_len(b->ft->payloads);
+  }
+  if (lcp == len) {
+    // only reachable with a repeated string, which replaces the previous one
+    if (top->payload) {
+      rm_free(b->ft->payloads[top->payload - 1]);
+      b->ft->payloads[top->payload - 1] = NULL;
+    }
+    b->ft->size += !(top->flags & TRIENODE_TERMINAL);
+    top->flags = TRIENODE_TERMINAL;
+    top->score = score;
+    top->payload = pl;
+    return;
+  }
+
+  memcpy(b->key + lcp, str + lcp, (len - lcp) * sizeof(rune));
+  b->keyLen = len;
+  frozenBuildNode n = {.start = lcp,
+                       .end = len,
+                       .score = score,
+                       .payload = pl,
+                       .flags = TRIENODE_TERMINAL,
+                       .children = array_new(FrozenTrieNode, 1)};
+  b->path = array_append(b->path, n);
+  b->ft->size++;
+}
+
+FrozenTrie *FrozenTrieBuilder_Finish(FrozenTrieBuilder *b) {
+  while (array_len(b->path) > 1) {
+    frozenBuilder_Pop(b);
+  }
+  FrozenTrieNode root = frozenBuilder_Finish(b, &b->path[0]);
+  FrozenTrie *ft = b->ft;
+  ft->nodes = array_append(ft->nodes, root);
+  ft->root = array_len(ft->nodes) - 1;
+  ft->nodes = array_trimm_cap(ft->nodes, array_len(ft->nodes));
+  if (array_len(ft->runes)) {
+    ft->runes = array_trimm_cap(ft->runes, array_len(ft->runes));
+  }
+  array_free(b->path);
+  rm_free(b);
+  return ft;
+}
+
+void FrozenTrie_Free(FrozenTrie *ft) {
+  array_free(ft->nodes);
+  array_free(ft->runes);
+  array_free_ex(ft->payloads, rm_free(*(TriePayload **)ptr));
+  rm_free(ft);
+}
+
+size_t FrozenTrie_MemUsage(const FrozenTrie *ft) {
+  size_t sz = sizeof(*ft) + array_len(ft->nodes) * sizeof(FrozenTrieNode) +
+              array_len(ft->runes) * sizeof(rune) + array_len(ft->payloads) * sizeof(TriePayload *);
+  for (uint32_t i = 0; i < array_len(ft->payloads); i++) {
+    if (ft->payloads[i]) {
+      sz += sizeof(TriePayload) + ft->payloads[i]->len + 1;
+    }
+  }
+  return sz;
+}
+
+/***************************************************************
+ *
+ *                       Lookups and updates
+ *
+ ***************************************************************/
+
+uint32_t FrozenTrie_Child(const FrozenTrie *ft, const FrozenTrieNode *n, rune r) {
+  const FrozenTrieNode *children = ft->nodes + n->children;
+  uint32_t lo = 0, hi = n->numChildren;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (children[mid].first < r) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < n->numChildren && children[lo].first == r) {
+    return n->children + lo;
+  }
+  return FROZEN_TRIE_NONE;
+}
+
+/* Find the node whose string ends exactly at the end of `str`, recording the nodes on the way
+ * there in `path` if it's not NULL. Returns FROZEN_TRIE_NONE if there's no such node */
+static uint32_t frozenTrie_Walk(const FrozenTrie *ft, const rune *str, t_len len, uint32_t *path,
+                                size_t *depth) {
+  uint32_t idx = ft->root;
+  t_len offset = 0;
+  if (depth) *depth = 0;
+  while (1) {
+    const FrozenTrieNode *n = FrozenTrie_Node(ft, idx);
+    if (n->len > len - offset ||
+        memcmp(FrozenTrie_Str(ft, n), str + offset, n->len * sizeof(rune))) {
+      return FROZEN_TRIE_NONE;
+    }
+    offset += n->len;
+    if (offset == len) {
+      return idx;
+    }
+    if (path) path[(*depth)++] = idx;
+    if ((idx = FrozenTrie_Child(ft, n, str[offset])) == FROZEN_TRIE_NONE) {
+      return FROZEN_TRIE_NONE;
+    }
+  }
+}
+
+int FrozenTrie_Add(FrozenTrie *ft, const rune *str, t_len len, RSPayload *payload, float score,
+                   TrieAddOp op) {
+  if (score == 0 || len == 0 || len > TRIE_INITIAL_STRING_LEN) {
+    return 0;
+  }
+  uint32_t path[TRIE_INITIAL_STRING_LEN + 1];
+  size_t depth;
+  uint32_t idx = frozenTrie_Walk(ft, str, len, path, &depth);
+  if (idx == FROZEN_TRIE_NONE) {
+    return -1;
+  }
+
+  FrozenTrieNode *n = FrozenTrie_Node(ft, idx);
+  int live = FrozenTrie_IsLive(n);
+  n->score = op == ADD_INCR ? n->score + score : score;
+  frozenTrie_SetPayload(ft, n, payload ? payload->data : NULL, payload ? payload->len : 0);
+  n->flags |= TRIENODE_TERMINAL;
+  n->flags &= ~TRIENODE_DELETED;
+  n->maxChildScore = MAX(n->maxChildScore, n->score);
+  for (size_t i = 0; i < depth; i++) {
+    FrozenTrieNode *p = FrozenTrie_Node(ft, path[i]);
+    p->maxChildScore = MAX(p->maxChildScore, n->score);
+  }
+  ft->size += !live;
+  return !live;
+}
+
+int FrozenTrie_Delete(FrozenTrie *ft, const rune *str, t_len len) {
+  uint32_t idx = frozenTrie_Walk(ft, str, len, NULL, NULL);
+  if (idx == FROZEN_TRIE_NONE || !FrozenTrie_IsLive(FrozenTrie_Node(ft, idx))) {
+    return 0;
+  }
+  FrozenTrieNode *n = FrozenTrie_Node(ft, idx);
+  n->flags |= TRIENODE_DELETED;
+  n->flags &= ~TRIENODE_TERMINAL;
+  n->score = 0;
+  frozenTrie_SetPayload(ft, n, NULL, 0);
+  ft->size--;
+  return 1;
+}
+
+float FrozenTrie_Find(const FrozenTrie *ft, const rune *str, t_len len) {
+  uint32_t idx = frozenTrie_Walk(ft, str, len, NULL, NULL);
+  if (idx == FROZEN_TRIE_NONE || !FrozenTrie_IsLive(FrozenTrie_Node(ft, idx))) {
+    return 0;
+  }
+  return FrozenTrie_Node(ft, idx)->score;
+}
+
+uint32_t FrozenTrie_RandomWalk(const FrozenTrie *ft, int minSteps, rune **str, t_len *len) {
+  minSteps = MAX(minSteps, 4);
+  uint32_t *stack = array_new(uint32_t, minSteps);
+  stack = array_append(stack, ft->root);
+  int steps = 0;
+  size_t bufCap = 0;
+  while (steps < minSteps || !FrozenTrie_IsLive(FrozenTrie_Node(ft, array_tail(stack)))) {
+    const FrozenTrieNode *n = FrozenTrie_Node(ft, array_tail(stack));
+    // select the next step - -1 means walk back up one level
+    int rnd = (int)(rand() % (n->numChildren + 1)) - 1;
+    if (rnd == -1) {
+      // we can't walk up the top level
+      if (array_len(stack) > 1) {
+        steps++;
+        bufCap -= n->len;
+        (void)array_pop(stack);
+      }
+      continue;
+    }
+    uint32_t child = n->children + rnd;
+    stack = array_append(stack, child);
+    bufCap += FrozenTrie_Node(ft, child)->len;
+    steps++;
+  }
+
+  rune *buf = rm_calloc(bufCap + 1, sizeof(rune));
+  t_len bufSize = 0;
+  for (uint32_t i = 0; i < array_len(stack); i++) {
+    const FrozenTrieNode *n = FrozenTrie_Node(ft, stack[i]);
+    memcpy(buf + bufSize, FrozenTrie_Str(ft, n), n->len * sizeof(rune));
+    bufSize += n->len;
+  }
+  *str = buf;
+  *len = bufSize;
+  uint32_t ret = array_tail(stack);
+  array_free(stack);
+  return ret;
+}
+
+/***************************************************************
+ *
+ *                       Range iteration
+ *
+ ***************************************************************/
+
+typedef struct {
+  const FrozenTrie *ft;
+  rune *buf;
+  const rune *min;
+  int nmin;
+  bool includeMin;
+  const rune *max;
+  int nmax;
+  bool includeMax;
+  TrieRangeCallback *callback;
+  void *cbctx;
+  // set once the callback asked to stop the iteration
+  bool stop;
+} frozenRangeCtx;
+
+/* Iterate the terms within the range under a node. Returns 0 if the node's string is past the
+ * range, so the following siblings are past it as well, or if the iteration was stopped */
+static int frozenTrie_IterateRange(uint32_t idx, frozenRangeCtx *r) {
+  const FrozenTrieNode *n = FrozenTrie_Node(r->ft, idx);
+  r->buf = array_ensure_append(r->buf, FrozenTrie_Str(r->ft, n), n->len, rune);
+  size_t len = array_len(r->buf);
+  int rc = 1;
+
+  // compare the node's string to the bounds, up to its length, to skip whole subtrees
+  if (r->min && runecmp(r->buf, MIN(len, r->nmin), r->min, MIN(len, r->nmin)) < 0) {
+    goto end;
+  }
+  if (r->max && runecmp(r->buf, MIN(len, r->nmax), r->max, MIN(len, r->nmax)) > 0) {
+    rc = 0;
+    goto end;
+  }
+
+  if (FrozenTrie_IsLive(n)) {
+    int cmin = r->min ? runecmp(r->buf, len, r->min, r->nmin) : 1;
+    int cmax = r->max ? runecmp(r->buf, len, r->max, r->nmax) : -1;
+    if ((cmin > 0 || (cmin == 0 && r->includeMin)) && (cmax < 0 || (cmax == 0 && r->includeMax)) &&
+        !r->callback(r->buf, len, r->cbctx)) {
+      r->stop = true;
+      rc = 0;
+      goto end;
+    }
+  }
+  for (uint32_t i = 0; i < n->numChildren; i++) {
+    if (!frozenTrie_IterateRange(n->children + i, r)) {
+      break;
+    }
+  }
+
+end:
+  array_trimm_len(r->buf, len - n->len);
+  return rc;
+}
+
+int FrozenTrie_IterateRange(const FrozenTrie *ft, const rune *min, int nmin, bool includeMin,
+                             const rune *max, int nmax, bool includeMax,
+                             TrieRangeCallback callback, void *ctx) {
+  frozenRangeCtx r = {.ft = ft,
+                      .buf = array_new(rune, TRIE_INITIAL_STRING_LEN),
+                      .min = min,
+                      .nmin = nmin,
+                      .includeMin = includeMin,
+                      .max = max,
+                      .nmax = nmax,
+                      .includeMax = includeMax,
+                      .callback = callback,
+                      .cbctx = ctx};
+  frozenTrie_IterateRange(ft->root, &r);
+  array_free(r.buf);
+  return !r.stop;
+}
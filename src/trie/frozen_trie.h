@@ -0,0 +1,104 @@
+#ifndef __FROZEN_TRIE_H__
+#define __FROZEN_TRIE_H__
+
+#include "trie.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FROZEN_TRIE_NONE UINT32_MAX
+
+#pragma pack(1)
+/* A node of a frozen trie. Nodes refer to each other by their index in the node array rather than
+ * by pointer, and keep their strings in a rune pool shared by the whole trie */
+typedef struct {
+  // the offset of the node's string in the rune pool
+  uint32_t str;
+  // the index of the first child. The children of a node are stored next to each other, sorted by
+  // their first rune
+  uint32_t children;
+  uint32_t numChildren;
+  // 1 + the index of the node's payload in the payload array, or 0 if it has none
+  uint32_t payload;
+  float score;
+  // the maximal score of this node and any of its descendants. It is only ever raised in place,
+  // so after deletions or lowered scores it is an upper bound rather than the actual max
+  float maxChildScore;
+  // the string length of this node
+  t_len len;
+  // the first rune of the node's string, to find children without touching the pool
+  rune first;
+  uint8_t flags;
+} FrozenTrieNode;
+#pragma pack()
+
+/* A compact, read-mostly encoding of a trie. It is built once from sorted strings, and its
+ * structure never changes afterwards: terms that are not already nodes of it can't be added, and
+ * deleted terms are only marked as such. Scores and payloads can still be updated in place.
+ *
+ * All nodes live in a single array and all strings in a single rune pool, so a node takes a fixed
+ * 29 bytes plus its string, instead of an allocation holding a pointer per child. Children are
+ * found by binary search over their first rune */
+typedef struct FrozenTrie {
+  FrozenTrieNode *nodes;
+  rune *runes;
+  TriePayload **payloads;
+  uint32_t root;
+  // the number of live terms
+  size_t size;
+} FrozenTrie;
+
+#define FrozenTrie_Node(ft, i) (&(ft)->nodes[i])
+#define FrozenTrie_Str(ft, n) ((ft)->runes + (n)->str)
+#define FrozenTrie_Payload(ft, n) ((n)->payload ? (ft)->payloads[(n)->payload - 1] : NULL)
+#define FrozenTrie_IsLive(n) \
+  (((n)->flags & TRIENODE_TERMINAL) && !((n)->flags & TRIENODE_DELETED))
+
+/* Builds a frozen trie from strings added in strictly increasing rune order */
+typedef struct FrozenTrieBuilder FrozenTrieBuilder;
+
+FrozenTrieBuilder *NewFrozenTrieBuilder();
+
+/* Add a string, which must sort after all the strings added before it */
+void FrozenTrieBuilder_Add(FrozenTrieBuilder *b, const rune *str, t_len len, float score,
+                           const char *payload, size_t plen);
+
+/* Return the built trie, freeing the builder */
+FrozenTrie *FrozenTrieBuilder_Finish(FrozenTrieBuilder *b);
+
+void FrozenTrie_Free(FrozenTrie *ft);
+
+/* The number of bytes used by the trie */
+size_t FrozenTrie_MemUsage(const FrozenTrie *ft);
+
+/* Add a string whose node already exists in the trie, like TrieNode_Add. Returns 1 if the string
+ * was not a live term, 0 if its score was replaced or incremented, or -1 if the trie has no node
+ * ending exactly at the string, in which case it must be added elsewhere */
+int FrozenTrie_Add(FrozenTrie *ft, const rune *str, t_len len, RSPayload *payload, float score,
+                   TrieAddOp op);
+
+/* Mark a term as deleted. Returns 1 if it was a live term, 0 otherwise */
+int FrozenTrie_Delete(FrozenTrie *ft, const rune *str, t_len len);
+
+/* Return the score of a live term, or 0 if it is not in the trie */
+float FrozenTrie_Find(const FrozenTrie *ft, const rune *str, t_len len);
+
+/* Return the index of the child of a node whose string starts with `r`, or FROZEN_TRIE_NONE */
+uint32_t FrozenTrie_Child(const FrozenTrie *ft, const FrozenTrieNode *n, rune r);
+
+/* Walk randomly down and up the trie for at least `minSteps` steps until reaching a live term, and
+ * return its node. The term's string is allocated into `str` */
+uint32_t FrozenTrie_RandomWalk(const FrozenTrie *ft, int minSteps, rune **str, t_len *len);
+
+/* Call `callback` with every live term within a lexical range, in order, until it returns 0. The
+ * range arguments are like those of TrieNode_IterateRange. Returns 0 if the callback stopped the
+ * iteration */
+int FrozenTrie_IterateRange(const FrozenTrie *ft, const rune *min, int nmin, bool includeMin,
+                            const rune *max, int nmax, bool includeMax,
+                            TrieRangeCallback callback, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -8,8 +8,8 @@
 
 // NewSparseAutomaton creates a new automaton for the string s, with a given max
 // edit distance check
-SparseAutomaton NewSparseAutomaton(const rune *s, size_t len, int maxEdits) {
-  return (SparseAutomaton){s, len, maxEdits};
+SparseAutomaton NewSparseAutomaton(const rune *s, size_t len, int maxEdits, int transpositions) {
+  return (SparseAutomaton){s, len, maxEdits, transpositions};
 }
 
 // Start initializes the automaton's state vector and returns it for further
@@ -24,9 +24,15 @@ sparseVector *SparseAutomaton_Start(SparseAutomaton *a) {
 }
 
 // Step returns the next state of the automaton given a previous state and a
-// character to check
-sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune c) {
+// character to check.
+//
+// A transposition of the runes at i-1 and i costs one edit from the state two steps back, at
+// i-1. So when a step reads the rune at i, it records the cost of the transposition in nextTrans,
+// for the step after it to use if it reads the rune at i-1
+sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, sparseVector *trans,
+                                   rune c, sparseVector **nextTrans) {
   sparseVector *newVec = newSparseVectorCap(state->len);
+  size_t t = 0;
 
   if (state->len) {
     sparseVectorEntry e = state->entries[0];
@@ -54,10 +60,29 @@ sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune
       val = MIN(val, state->entries[j + 1].val + 1);
     }
 
+    // complete a transposition of the previous rune and this one
+    if (trans) {
+      while (t < trans->len && trans->entries[t].idx <= entry->idx) ++t;
+      if (t < trans->len && trans->entries[t].idx == entry->idx + 1 &&
+          a->string[entry->idx - 1] == c) {
+        val = MIN(val, trans->entries[t].val);
+      }
+    }
+
     if (val <= a->max) {
       sparseVector_append(&newVec, entry->idx + 1, val);
     }
   }
+
+  if (nextTrans) {
+    *nextTrans = newSparseVectorCap(state->len);
+    for (int j = 0; j < state->len; j++) {
+      sparseVectorEntry *entry = &state->entries[j];
+      if (entry->idx + 1 < a->len && a->string[entry->idx + 1] == c && entry->val < a->max) {
+        sparseVector_append(nextTrans, entry->idx + 2, entry->val + 1);
+      }
+    }
+  }
   return newVec;
 }
 
@@ -76,11 +101,12 @@ inline int SparseAutomaton_CanMatch(SparseAutomaton *a, sparseVector *v) {
   return v->len > 0;
 }
 
-dfaNode *__newDfaNode(int distance, sparseVector *state) {
+dfaNode *__newDfaNode(int distance, sparseVector *state, sparseVector *trans) {
   dfaNode *ret = rm_calloc(1, sizeof(dfaNode));
   ret->fallback = NULL;
   ret->distance = distance;
   ret->v = state;
+  ret->tv = trans;
   ret->edges = NULL;
   ret->numEdges = 0;
 
@@ -89,14 +115,17 @@ dfaNode *__newDfaNode(int distance, sparseVector *state) {
 
 void __dfaNode_free(dfaNode *d) {
   sparseVector_free(d->v);
+  if (d->tv) sparseVector_free(d->tv);
   if (d->edges) rm_free(d->edges);
   rm_free(d);
 }
 
 int __sv_equals(sparseVector *sv1, sparseVector *sv2) {
-  if (sv1->len != sv2->len) return 0;
+  // a NULL vector is an empty one
+  size_t len1 = sv1 ? sv1->len : 0, len2 = sv2 ? sv2->len : 0;
+  if (len1 != len2) return 0;
 
-  for (int i = 0; i < sv1->len; i++) {
+  for (int i = 0; i < len1; i++) {
     if (sv1->entries[i].idx != sv2->entries[i].idx || sv1->entries[i].val != sv2->entries[i].val) {
       return 0;
     }
@@ -105,13 +134,13 @@ int __sv_equals(sparseVector *sv1, sparseVector *sv2) {
   return 1;
 }
 
-dfaNode *__dfn_getCache(Vector *cache, sparseVector *v) {
+dfaNode *__dfn_getCache(Vector *cache, sparseVector *v, sparseVector *tv) {
   size_t n = Vector_Size(cache);
   for (int i = 0; i < n; i++) {
     dfaNode *dfn;
     Vector_Get(cache, i, &dfn);
 
-    if (__sv_equals(v, dfn->v)) {
+    if (__sv_equals(v, dfn->v) && __sv_equals(tv, dfn->tv)) {
       return dfn;
     }
   }
@@ -136,62 +165,114 @@ void __dfn_addEdge(dfaNode *n, rune r, dfaNode *child) {
   n->edges[n->numEdges++] = (dfaEdge){.r = r, .n = child};
 }
 
+/* Step a node of the DFA by a rune, building the next node if it's new. Returns NULL if no string
+ * continuing with the rune can match */
+static dfaNode *dfa_step(dfaNode *parent, SparseAutomaton *a, Vector *cache, rune c) {
+  sparseVector *nt = NULL;
+  sparseVector *nv = SparseAutomaton_Step(a, parent->v, parent->tv, c, a->transpositions ? &nt : NULL);
+  if (nv->len == 0) {
+    sparseVector_free(nv);
+    if (nt) sparseVector_free(nt);
+    return NULL;
+  }
+
+  dfaNode *dfn = __dfn_getCache(cache, nv, nt);
+  if (dfn) {
+    sparseVector_free(nv);
+    if (nt) sparseVector_free(nt);
+    return dfn;
+  }
+  int dist = nv->entries[nv->len - 1].val;
+  dfn = __newDfaNode(dist, nv, nt);
+  __dfn_putCache(cache, dfn);
+  dfa_build(dfn, a, cache);
+  return dfn;
+}
+
+/* Add an edge for a rune of the string, unless the node already has one */
+static void dfa_addRuneEdge(dfaNode *parent, SparseAutomaton *a, Vector *cache, rune c) {
+  if (__dfn_getEdge(parent, c)) {
+    return;
+  }
+  dfaNode *dfn = dfa_step(parent, a, cache, c);
+  if (dfn) {
+    __dfn_addEdge(parent, c, dfn);
+  }
+}
+
 void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
   parent->match = SparseAutomaton_IsMatch(a, parent->v);
 
+  // only the runes of the string around the current state's positions behave differently from
+  // any other rune
   for (int i = 0; i < parent->v->len; i++) {
-    if (parent->v->entries[i].idx < a->len) {
-      rune c = a->string[parent->v->entries[i].idx];
-      // printf("%c ---> ", c);
-      dfaNode *edge = __dfn_getEdge(parent, c);
-      if (edge == NULL) {
-        sparseVector *nv = SparseAutomaton_Step(a, parent->v, c);
-
-        if (nv->len > 0) {
-          dfaNode *dfn = __dfn_getCache(cache, nv);
-          if (dfn == NULL) {
-            int dist = nv->entries[nv->len - 1].val;
-            edge = __newDfaNode(dist, nv);
-            __dfn_addEdge(parent, c, edge);
-            __dfn_putCache(cache, edge);
-            dfa_build(edge, a, cache);
-            continue;
-          } else {
-            __dfn_addEdge(parent, c, dfn);
-          }
-        }
-        sparseVector_free(nv);
-      }
+    int idx = parent->v->entries[i].idx;
+    if (idx < a->len) {
+      dfa_addRuneEdge(parent, a, cache, a->string[idx]);
+    }
+    if (a->transpositions && idx + 1 < a->len) {
+      dfa_addRuneEdge(parent, a, cache, a->string[idx + 1]);
     }
   }
+  for (int i = 0; parent->tv && i < parent->tv->len; i++) {
+    dfa_addRuneEdge(parent, a, cache, a->string[parent->tv->entries[i].idx - 2]);
+  }
+
+  parent->fallback = dfa_step(parent, a, cache, 1);
+}
 
-  // if (parent->distance < a->max) {
-  sparseVector *nv = SparseAutomaton_Step(a, parent->v, 1);
-  if (nv->len > 0) {
-    dfaNode *dfn = __dfn_getCache(cache, nv);
-    if (dfn) {
-      parent->fallback = dfn;
-    } else {
-      int dist = nv->entries[nv->len - 1].val;
-      // printf("DEFAULT EDGE! edge %s - dist %d\n", a->string, dist);
-      parent->fallback = __newDfaNode(dist, nv);
-      __dfn_putCache(cache, parent->fallback);
-      dfa_build(parent->fallback, a, cache);
-      return;
+static int cmpRunes(const void *p1, const void *p2) {
+  return (int)*(const rune *)p1 - (int)*(const rune *)p2;
+}
+
+/* The class of a rune in the transition table: its position in the alphabet of the string, plus
+ * one, or 0 if it's not there */
+static inline size_t dfa_runeClass(const DFAFilter *fc, rune r) {
+  if (r < 128) {
+    return fc->asciiClasses[r];
+  }
+  const rune *found = bsearch(&r, fc->alphabet, fc->alphabetLen, sizeof(rune), cmpRunes);
+  return found ? found - fc->alphabet + 1 : 0;
+}
+
+/* Compile the edges of all the DFA nodes into a transition table by rune class */
+static void dfa_compile(DFAFilter *fc) {
+  SparseAutomaton *a = &fc->a;
+  fc->alphabet = rm_malloc(MAX(a->len, 1) * sizeof(rune));
+  memcpy(fc->alphabet, a->string, a->len * sizeof(rune));
+  qsort(fc->alphabet, a->len, sizeof(rune), cmpRunes);
+  fc->alphabetLen = 0;
+  for (size_t i = 0; i < a->len; i++) {
+    if (!fc->alphabetLen || fc->alphabet[fc->alphabetLen - 1] != fc->alphabet[i]) {
+      fc->alphabet[fc->alphabetLen++] = fc->alphabet[i];
     }
   }
-  sparseVector_free(nv);
+  memset(fc->asciiClasses, 0, sizeof(fc->asciiClasses));
+  for (size_t i = 0; i < fc->alphabetLen && fc->alphabet[i] < 128; i++) {
+    fc->asciiClasses[fc->alphabet[i]] = i + 1;
+  }
 
-  //}
+  size_t width = fc->alphabetLen + 1;
+  fc->transitions = rm_malloc(Vector_Size(fc->cache) * width * sizeof(dfaNode *));
+  for (size_t i = 0; i < Vector_Size(fc->cache); i++) {
+    dfaNode *dn;
+    Vector_Get(fc->cache, i, &dn);
+    dn->next = fc->transitions + i * width;
+    dn->next[0] = dn->fallback;
+    for (size_t j = 0; j < fc->alphabetLen; j++) {
+      dfaNode *edge = __dfn_getEdge(dn, fc->alphabet[j]);
+      dn->next[j + 1] = edge ? edge : dn->fallback;
+    }
+  }
 }
 
-DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
+DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode, int transpositions) {
   Vector *cache = NewVector(dfaNode *, 8);
 
-  SparseAutomaton a = NewSparseAutomaton(str, len, maxDist);
+  SparseAutomaton a = NewSparseAutomaton(str, len, maxDist, transpositions);
 
   sparseVector *v = SparseAutomaton_Start(&a);
-  dfaNode *dr = __newDfaNode(0, v);
+  dfaNode *dr = __newDfaNode(0, v, transpositions ? newSparseVectorCap(1) : NULL);
   __dfn_putCache(cache, dr);
   dfa_build(dr, &a, cache);
 
@@ -201,6 +282,7 @@ DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
   ret.distStack = NewVector(int, 8);
   ret.a = a;
   ret.prefixMode = prefixMode;
+  dfa_compile(&ret);
   Vector_Push(ret.stack, dr);
   Vector_Push(ret.distStack, (maxDist + 1));
 
@@ -218,63 +300,71 @@ void DFAFilter_Free(DFAFilter *fc) {
   Vector_Free(fc->cache);
   Vector_Free(fc->stack);
   Vector_Free(fc->distStack);
+  rm_free(fc->alphabet);
+  rm_free(fc->transitions);
 }
 
-FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
-  DFAFilter *fc = ctx;
-  dfaNode *dn;
-  int minDist;
+DFAState DFAFilter_Start(const DFAFilter *fc) {
+  DFAState st = {.node = NULL, .minDist = fc->a.max + 1, .dist = fc->a.max + 1};
+  Vector_Get(fc->stack, 0, &st.node);
+  return st;
+}
 
-  Vector_Get(fc->stack, Vector_Size(fc->stack) - 1, &dn);
-  Vector_Get(fc->distStack, Vector_Size(fc->distStack) - 1, &minDist);
+FilterCode DFAFilter_Step(const DFAFilter *fc, DFAState *st, rune b, int *matched) {
+  dfaNode *dn = st->node;
 
   // a null node means we're in prefix mode, and we're done matching our prefix
   if (dn == NULL) {
     *matched = 1;
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
     return F_CONTINUE;
   }
 
   *matched = dn->match;
 
   if (*matched) {
-    // printf("MATCH %c, dist %d\n", b, dn->distance);
-    int *pdist = matchCtx;
-    if (pdist) {
-      *pdist = MIN(dn->distance, minDist);
-    }
+    st->dist = MIN(dn->distance, st->minDist);
   }
 
-  rune foldedRune = runeFold(b);
-
   // get the next state change
-  dfaNode *next = __dfn_getEdge(dn, foldedRune);
-  if (!next) next = dn->fallback;
+  dfaNode *next = dn->next[dfa_runeClass(fc, runeFold(b))];
 
-  // we can continue - push the state on the stack
+  // we can continue - move to the next state
   if (next) {
     if (next->match) {
-      // printf("MATCH NEXT %c, dist %d\n", b, next->distance);
       *matched = 1;
-      int *pdist = matchCtx;
-      if (pdist) {
-        *pdist = MIN(next->distance, minDist);
-      }
-      //    if (fc->prefixMode) next = NULL;
+      st->dist = MIN(next->distance, st->minDist);
     }
-    Vector_Push(fc->stack, next);
-    Vector_Push(fc->distStack, MIN(next->distance, minDist));
+    st->node = next;
+    st->minDist = MIN(next->distance, st->minDist);
     return F_CONTINUE;
   } else if (fc->prefixMode && *matched) {
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
+    st->node = NULL;
     return F_CONTINUE;
   }
 
   return F_STOP;
 }
 
+FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
+  DFAFilter *fc = ctx;
+  int *pdist = matchCtx;
+  DFAState st = {.dist = pdist ? *pdist : 0};
+
+  Vector_Get(fc->stack, Vector_Size(fc->stack) - 1, &st.node);
+  Vector_Get(fc->distStack, Vector_Size(fc->distStack) - 1, &st.minDist);
+
+  FilterCode rc = DFAFilter_Step(fc, &st, b, matched);
+  if (*matched && pdist) {
+    *pdist = st.dist;
+  }
+  // we can continue - push the state on the stack
+  if (rc == F_CONTINUE) {
+    Vector_Push(fc->stack, st.node);
+    Vector_Push(fc->distStack, st.minDist);
+  }
+  return rc;
+}
+
 void StackPop(void *ctx, int numLevels) {
   DFAFilter *fc = ctx;
 
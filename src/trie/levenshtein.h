@@ -6,18 +6,27 @@
 #include "../rmutil/vector.h"
 #include "trie.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
 * SparseAutomaton is a C implementation of a levenshtein automaton using
 * sparse vectors, as described and implemented here:
 * http://julesjacobs.github.io/2015/06/17/disqus-levenshtein-simple-and-fast.html
 *
 * We then convert the automaton to a simple DFA that is faster to evaluate during the query stage.
-* This DFA is used while traversing a Trie to decide where to stop.
+* This DFA is used while traversing a Trie to decide where to stop. Once built, the DFA is compiled
+* into a transition table over the runes of the query, so each step is a single lookup.
+*
+* With transpositions, swapping two adjacent runes costs a single edit (the optimal string
+* alignment distance), rather than two.
 */
 typedef struct {
     const rune *string;
     size_t len;
     int max;
+    int transpositions;
 } SparseAutomaton;
 
 struct dfaEdge; 
@@ -28,9 +37,13 @@ typedef struct dfaNode {
 
     int match;
     sparseVector *v;
+    // the transpositions the next rune may complete, or NULL without transpositions
+    sparseVector *tv;
     struct dfaEdge *edges;
     size_t numEdges;
     struct dfaNode *fallback;
+    // the next node by the class of the next rune, see DFAFilter
+    struct dfaNode **next;
 } dfaNode;
 
 typedef struct dfaEdge {
@@ -43,20 +56,23 @@ dfaNode *__dfn_getEdge(dfaNode *n, rune r);
 
 
 /* Create a new DFA node */
-dfaNode *__newDfaNode(int distance, sparseVector *state);
+dfaNode *__newDfaNode(int distance, sparseVector *state, sparseVector *trans);
 
 /* Recusively build the DFA node and all its descendants */
 void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache);
 
 /* Create a new Sparse Levenshtein Automaton  for string s and length len, with a maximal edit
- * distance of maxEdits */
-SparseAutomaton NewSparseAutomaton(const rune *s, size_t len, int maxEdits);
+ * distance of maxEdits. If transpositions is set, swapping adjacent runes is a single edit */
+SparseAutomaton NewSparseAutomaton(const rune *s, size_t len, int maxEdits, int transpositions);
 
 /* Create the initial state vector of the root automaton node */
 sparseVector *SparseAutomaton_Start(SparseAutomaton *a);
 
-/* Step from a given state of the automaton to the next step given a specific character */
-sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune c);
+/* Step from a given state of the automaton to the next step given a specific character. `trans`
+ * holds the transpositions the state allows, if any. If nextTrans is not NULL, it is set to the
+ * transpositions the next state allows */
+sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, sparseVector *trans,
+                                   rune c, sparseVector **nextTrans);
 
 /* Is the current state of the automaton a match for the query? */
 int SparseAutomaton_IsMatch(SparseAutomaton *a, sparseVector *v);
@@ -75,13 +91,40 @@ typedef struct {
     // whether the filter works in prefix mode or not
     int prefixMode;
 
+    // The distinct runes of the string, sorted. Each one is a class of runes for the transition
+    // table, and all other runes are class 0
+    rune *alphabet;
+    size_t alphabetLen;
+    // the classes of ASCII runes, to skip searching the alphabet
+    uint16_t asciiClasses[128];
+    // the transition table of all the nodes, alphabetLen + 1 entries per node
+    dfaNode **transitions;
+
     SparseAutomaton a;
 } DFAFilter;
 
 /* Create a new DFA filter  using a Levenshtein automaton, for the given string  and maximum
  * distance. If prefixMode is 1, we match prefixes within the given distance, and then continue
- * onwards to all suffixes. */
-DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode);
+ * onwards to all suffixes. If transpositions is 1, swapping adjacent runes is a single edit */
+DFAFilter NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode, int transpositions);
+
+/* The state of a DFA filter at one point of a traversal. Unlike the filter's stacks, a state can
+ * be copied and stepped on its own, for traversals that are not depth first */
+typedef struct {
+    // the current DFA node, or NULL once a prefix was matched in prefix mode
+    dfaNode *node;
+    // the minimal distance of the states leading up to this one
+    int minDist;
+    // the distance of the last match on the way to this state
+    int dist;
+} DFAState;
+
+/* The initial state of a DFA filter */
+DFAState DFAFilter_Start(const DFAFilter *fc);
+
+/* Advance a state by the next rune. Returns F_STOP if no string continuing this way can match,
+ * in which case the state should be dropped. `matched` is set if the string so far matches */
+FilterCode DFAFilter_Step(const DFAFilter *fc, DFAState *st, rune b, int *matched);
 
 /* A callback function for the DFA Filter, passed to the Trie iterator */
 FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx);
@@ -94,4 +137,7 @@ void StackPop(void *ctx, int numLevels);
  * is not freed by itself. */
 void DFAFilter_Free(DFAFilter *fc);
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+#endif
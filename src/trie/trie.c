@@ -1,5 +1,6 @@
 #include <sys/param.h>
 #include "trie.h"
+#include "frozen_trie.h"
 #include "util/bsearch.h"
 #include "sparse_vector.h"
 #include "redisearch.h"
@@ -27,7 +28,7 @@ TrieNode *__newTrieNode(rune *str, t_len offset, t_len len, const char *payload,
   n->numChildren = numChildren;
   n->score = score;
   n->flags = 0 | (terminal ? TRIENODE_TERMINAL : 0);
-  n->maxChildScore = 0;
+  n->maxChildScore = score;
   n->sortmode = TRIENODE_SORTED_NONE;
   memcpy(n->str, str + offset, sizeof(rune) * (len - offset));
   if (payload != NULL && plen > 0) {
@@ -115,6 +116,16 @@ TrieNode *__trieNode_MergeWithSingleChild(TrieNode *n) {
   return merged;
 }
 
+/* Recompute the max score of a node's subtree, from its own score and its children's */
+static void __trieNode_updateMaxScore(TrieNode *n) {
+  float maxScore = n->score;
+  TrieNode **children = __trieNode_children(n);
+  for (t_len i = 0; i < n->numChildren; i++) {
+    maxScore = MAX(maxScore, children[i]->maxChildScore);
+  }
+  n->maxChildScore = maxScore;
+}
+
 void TrieNode_Print(TrieNode *n, int idx, int depth) {
   for (int i = 0; i < depth; i++) {
     printf("  ");
@@ -166,14 +177,12 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
     } else {
       // we add a child
       n = __trie_AddChild(n, str, offset, len, payload, score);
-      n->maxChildScore = MAX(n->maxChildScore, score);
     }
+    __trieNode_updateMaxScore(n);
     *np = n;
     return 1;
   }
 
-  n->maxChildScore = MAX(n->maxChildScore, score);
-
   // we're inserting in an existing node - just replace the value
   if (offset == len) {
     int term = __trieNode_isTerminal(n);
@@ -200,6 +209,8 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
     n->flags |= TRIENODE_TERMINAL;
     // if it was deleted, make sure it's not now
     n->flags &= ~TRIENODE_DELETED;
+    // a replaced score may be lower than the old one, so the max is recomputed rather than raised
+    __trieNode_updateMaxScore(n);
     *np = n;
     return (term && !deleted) ? 0 : 1;
   }
@@ -210,10 +221,13 @@ int TrieNode_Add(TrieNode **np, rune *str, t_len len, RSPayload *payload, float
     if (str[offset] == child->str[0]) {
       int rc = TrieNode_Add(&child, str + offset, len - offset, payload, score, op);
       __trieNode_children(n)[i] = child;
+      __trieNode_updateMaxScore(n);
       return rc;
     }
   }
-  *np = __trie_AddChild(n, str, offset, len, payload, score);
+  n = __trie_AddChild(n, str, offset, len, payload, score);
+  n->maxChildScore = MAX(n->maxChildScore, score);
+  *np = n;
   return 1;
 }
 
@@ -401,6 +415,20 @@ inline void __ti_Push(TrieIterator *it, TrieNode *node, int skipped) {
     sn->stringOffset = 0;
     sn->isSkipped = skipped;
     sn->n = node;
+    sn->fn = FROZEN_TRIE_NONE;
+    sn->state = ITERSTATE_SELF;
+  }
+}
+
+/* Push a node of the iterator's frozen trie on its stack */
+static void __ti_PushFrozen(TrieIterator *it, uint32_t fn) {
+  if (it->stackOffset < TRIE_INITIAL_STRING_LEN - 1) {
+    stackNode *sn = &it->stack[it->stackOffset++];
+    sn->childOffset = 0;
+    sn->stringOffset = 0;
+    sn->isSkipped = 0;
+    sn->n = NULL;
+    sn->fn = fn;
     sn->state = ITERSTATE_SELF;
   }
 }
@@ -417,20 +445,40 @@ inline void __ti_Pop(TrieIterator *it) {
   }
 }
 
+/* The string of the node of a stack node */
+static inline const rune *__ti_str(const TrieIterator *it, const stackNode *sn, t_len *len) {
+  if (sn->n) {
+    *len = sn->n->len;
+    return sn->n->str;
+  }
+  const FrozenTrieNode *fn = FrozenTrie_Node(it->frozen, sn->fn);
+  *len = fn->len;
+  return FrozenTrie_Str(it->frozen, fn);
+}
+
+/* Whether the node of a stack node is a live terminal node */
+static inline int __ti_isLive(const TrieIterator *it, const stackNode *sn) {
+  if (sn->n) {
+    return __trieNode_isTerminal(sn->n) && !__trieNode_isDeleted(sn->n);
+  }
+  return FrozenTrie_IsLive(FrozenTrie_Node(it->frozen, sn->fn));
+}
+
 inline int __ti_step(TrieIterator *it, void *matchCtx) {
   if (it->stackOffset == 0) {
-    return __STEP_STOP;
+    // done with the nodes, continue to the frozen trie
+    if (!it->frozen || it->frozenStarted) {
+      return __STEP_STOP;
+    }
+    it->frozenStarted = 1;
+    __ti_PushFrozen(it, it->frozen->root);
   }
 
   stackNode *current = __ti_current(it);
 
   int matched = 0;
-  // printf("[%.*s]current %p (%.*s %f), state %d, string offset %d/%d, child
-  // offset %d/%d\n",
-  //        it->bufOffset, it->buf, current, current->n->len, current->n->str,
-  //        current->n->score, current->state, current->stringOffset,
-  //        current->n->len,
-  //        current->childOffset, current->n->numChildren);
+  t_len nlen;
+  const rune *nstr = __ti_str(it, current, &nlen);
   switch (current->state) {
     case ITERSTATE_MATCH:
       __ti_Pop(it);
@@ -438,9 +486,9 @@ inline int __ti_step(TrieIterator *it, void *matchCtx) {
 
     case ITERSTATE_SELF:
 
-      if (current->stringOffset < current->n->len) {
+      if (current->stringOffset < nlen) {
         // get the current rune to feed the filter
-        rune b = current->n->str[current->stringOffset];
+        rune b = nstr[current->stringOffset];
 
         if (it->filter) {
           // run the next character in the filter
@@ -466,8 +514,7 @@ inline int __ti_step(TrieIterator *it, void *matchCtx) {
         // if we don't have a filter, a "match" is when we reach the end of the
         // node
         if (!it->filter) {
-          if (current->n->len > 0 && current->stringOffset == current->n->len &&
-              __trieNode_isTerminal(current->n) && !__trieNode_isDeleted(current->n)) {
+          if (nlen > 0 && current->stringOffset == nlen && __ti_isLive(it, current)) {
             matched = 1;
           }
         }
@@ -480,6 +527,23 @@ inline int __ti_step(TrieIterator *it, void *matchCtx) {
 
     case ITERSTATE_CHILDREN:
     default:
+      if (!current->n) {
+        // the children of frozen nodes are kept in lexical order
+        const FrozenTrieNode *fn = FrozenTrie_Node(it->frozen, current->fn);
+        if (current->childOffset < fn->numChildren) {
+          uint32_t chIdx = fn->children + current->childOffset++;
+          const FrozenTrieNode *ch = FrozenTrie_Node(it->frozen, chIdx);
+          if (ch->maxChildScore >= it->minScore || ch->score >= it->minScore) {
+            __ti_PushFrozen(it, chIdx);
+            it->nodesConsumed++;
+          } else {
+            it->nodesSkipped++;
+          }
+        } else {
+          __ti_Pop(it);
+        }
+        break;
+      }
       if (current->n->sortmode != TRIENODE_SORTED_SCORE) {
         __trieNode_sortChildren(current->n);
       }
@@ -509,11 +573,17 @@ TrieIterator *TrieNode_Iterate(TrieNode *n, StepFilter f, StackPopCallback pf, v
   it->popCallback = pf;
   it->minScore = 0;
   it->ctx = ctx;
-  __ti_Push(it, n, 0);
+  if (n) {
+    __ti_Push(it, n, 0);
+  }
 
   return it;
 }
 
+void TrieIterator_SetFrozen(TrieIterator *it, const FrozenTrie *ft) {
+  it->frozen = ft;
+}
+
 void TrieIterator_Free(TrieIterator *it) {
   rm_free(it);
 }
@@ -524,16 +594,25 @@ int TrieIterator_Next(TrieIterator *it, rune **ptr, t_len *len, RSPayload *paylo
   while ((rc = __ti_step(it, matchCtx)) != __STEP_STOP) {
     if (rc == __STEP_MATCH) {
       stackNode *sn = __ti_current(it);
+      t_len nlen;
+      __ti_str(it, sn, &nlen);
 
-      if (__trieNode_isTerminal(sn->n) && sn->n->len == sn->stringOffset &&
-          !__trieNode_isDeleted(sn->n)) {
+      if (nlen == sn->stringOffset && __ti_isLive(it, sn)) {
+        const TriePayload *p;
         *ptr = it->buf;
         *len = it->bufOffset;
-        *score = sn->n->score;
+        if (sn->n) {
+          *score = sn->n->score;
+          p = sn->n->payload;
+        } else {
+          const FrozenTrieNode *fn = FrozenTrie_Node(it->frozen, sn->fn);
+          *score = fn->score;
+          p = FrozenTrie_Payload(it->frozen, fn);
+        }
         if (payload != NULL) {
-          if (sn->n->payload != NULL) {
-            payload->data = sn->n->payload->data;
-            payload->len = sn->n->payload->len;
+          if (p != NULL) {
+            payload->data = (char *)p->data;
+            payload->len = p->len;
           } else {
             payload->data = NULL;
             payload->len = 0;
@@ -670,19 +749,27 @@ typedef struct {
   void *cbctx;
   bool includeMin;
   bool includeMax;
+  // set once the callback asked to stop the iteration
+  bool stop;
 } RangeCtx;
 
+static void rangeCallback(RangeCtx *r) {
+  if (!r->callback(r->buf, array_len(r->buf), r->cbctx)) {
+    r->stop = true;
+  }
+}
+
 static void rangeIterateSubTree(TrieNode *n, RangeCtx *r) {
   // Push string to stack
   r->buf = array_ensure_append(r->buf, n->str, n->len, rune);
 
   if (__trieNode_isTerminal(n)) {
-    r->callback(r->buf, array_len(r->buf), r->cbctx);
+    rangeCallback(r);
   }
 
   TrieNode **arr = __trieNode_children(n);
 
-  for (size_t ii = 0; ii < n->numChildren; ++ii) {
+  for (size_t ii = 0; ii < n->numChildren && !r->stop; ++ii) {
     // printf("Descending to index %lu\n", ii);
     rangeIterateSubTree(arr[ii], r);
   }
@@ -704,15 +791,15 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
     // if nmin or nmax is zero, it means that we find an exact match
     // we should fire the callback only if exact match requested
     if (r->includeMin && nmin == 0) {
-      r->callback(r->buf, array_len(r->buf), r->cbctx);
+      rangeCallback(r);
     } else if (r->includeMax && nmax == 0) {
-      r->callback(r->buf, array_len(r->buf), r->cbctx);
+      rangeCallback(r);
     }
   }
 
   TrieNode **arr = __trieNode_children(n);
   size_t arrlen = n->numChildren;
-  if (!arrlen) {
+  if (!arrlen || r->stop) {
     // no children, just return.
     goto clean_stack;
   }
@@ -799,11 +886,11 @@ static void rangeIterate(TrieNode *n, const rune *min, int nmin, const rune *max
   }
 
   // we need to iterate (without any checking) on all the subtree from beginIdx to endIdx
-  for (int ii = beginIdx; ii <= endIdx; ++ii) {
+  for (int ii = beginIdx; ii <= endIdx && !r->stop; ++ii) {
     rangeIterateSubTree(arr[ii], r);
   }
 
-  if (endEqIdx != -1) {
+  if (endEqIdx != -1 && !r->stop) {
     // we find a child that matches max prefix
     // we should continue the search on this child but at this point we should
     // not limit the min value
@@ -826,24 +913,24 @@ clean_stack:
 // LexRange iteration.
 // If min = NULL and nmin = -1 it tells us there is not limit on the min value
 // same rule goes for max value.
-void TrieNode_IterateRange(TrieNode *n, const rune *min, int nmin, bool includeMin, const rune *max,
+int TrieNode_IterateRange(TrieNode *n, const rune *min, int nmin, bool includeMin, const rune *max,
                            int nmax, bool includeMax, TrieRangeCallback callback, void *ctx) {
   if (min && max) {
     // min and max exists, lets compare them to make sure min < max
     int cmp = runecmp(min, nmin, max, nmax);
     if (cmp > 0) {
       // min > max, no reason to continue
-      return;
+      return 1;
     }
 
     if (cmp == 0) {
       // min = max, we should just search for min and check for its existence
       if (includeMin || includeMax) {
         if (TrieNode_Find(n, (rune *)min, nmin) != 0) {
-          callback(min, nmin, ctx);
+          return callback(min, nmin, ctx);
         }
       }
-      return;
+      return 1;
     }
   }
 
@@ -857,4 +944,5 @@ void TrieNode_IterateRange(TrieNode *n, const rune *min, int nmin, bool includeM
   r.buf = array_new(rune, TRIE_INITIAL_STRING_LEN);
   rangeIterate(n, min, nmin, max, nmax, &r);
   array_free(r.buf);
+  return !r.stop;
 }
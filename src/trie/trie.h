@@ -52,8 +52,8 @@ typedef struct {
   // the node's score. Non termn
   float score;
 
-  // the maximal score of any descendant of this node, used to optimize
-  // traversal
+  // the maximal score of this node and any of its descendants, used to prune
+  // traversals. It is kept up to date on insertion, increment and deletion
   float maxChildScore;
 
   // the payload of terminal node. could be NULL if it's not terminal
@@ -81,7 +81,7 @@ TrieNode *__newTrieNode(rune *str, t_len offset, t_len len, const char *payload,
  * of the node for
  * memory saving reasons */
 #define __trieNode_children(n) \
-  ((TrieNode **)((void *)n + sizeof(TrieNode) + (n->len + 1) * sizeof(rune)))
+  ((TrieNode **)((char *)(n) + sizeof(TrieNode) + ((n)->len + 1) * sizeof(rune)))
 
 #define __trieNode_isTerminal(n) (n->flags & TRIENODE_TERMINAL)
 
@@ -123,12 +123,16 @@ int TrieNode_Delete(TrieNode *n, rune *str, t_len len);
 /* Free the trie's root and all its children recursively */
 void TrieNode_Free(TrieNode *n);
 
+struct FrozenTrie;
+
 /* trie iterator stack node. for internal use only */
 typedef struct {
   int state;
   TrieNode *n;
+  // the node of the iterator's frozen trie, if n is NULL
+  uint32_t fn;
   t_len stringOffset;
-  t_len childOffset;
+  uint32_t childOffset;
   int isSkipped;
 } stackNode;
 
@@ -160,6 +164,9 @@ typedef struct TrieIterator {
   int nodesSkipped;
   StackPopCallback popCallback;
   void *ctx;
+  // a frozen trie to iterate once done with the nodes, and whether it was started
+  const struct FrozenTrie *frozen;
+  int frozenStarted;
 } TrieIterator;
 
 /* push a new trie iterator stack node  */
@@ -188,9 +195,14 @@ int __ti_step(TrieIterator *it, void *matchCtx);
  * continue down the trie
  * or not. This can be a levenshtein automaton, a regex automaton, etc. A NULL
  * filter means just
- * continue iterating the entire trie. ctx is the filter's context */
+ * continue iterating the entire trie. ctx is the filter's context. n may be NULL if only a
+ * frozen trie is to be iterated */
 TrieIterator *TrieNode_Iterate(TrieNode *n, StepFilter f, StackPopCallback pf, void *ctx);
 
+/* Iterate a frozen trie with the same filter once done with the nodes. The nodes come first in the
+ * order of their children's scores, and the frozen trie's terms follow in lexical order */
+void TrieIterator_SetFrozen(TrieIterator *it, const struct FrozenTrie *ft);
+
 /* Free a trie iterator */
 void TrieIterator_Free(TrieIterator *it);
 
@@ -202,7 +214,8 @@ int TrieIterator_Next(TrieIterator *it, rune **ptr, t_len *len, RSPayload *paylo
 
 TrieNode *TrieNode_RandomWalk(TrieNode *n, int minSteps, rune **str, t_len *len);
 
-typedef void(TrieRangeCallback)(const rune *, size_t, void *);
+/* Called with each term within a range. Returns 0 to stop the iteration */
+typedef int(TrieRangeCallback)(const rune *, size_t, void *);
 
 /**
  * Iterate all nodes within range.
@@ -213,9 +226,10 @@ typedef void(TrieRangeCallback)(const rune *, size_t, void *);
  * @param maxlen the maximum length of the max
  * @param callback the callback to invoke
  * @param ctx data to be passed to the callback
+ * @return 0 if the callback stopped the iteration, 1 otherwise
  */
 
-void TrieNode_IterateRange(TrieNode *n, const rune *min, int minlen, bool includeMin,
+int TrieNode_IterateRange(TrieNode *n, const rune *min, int minlen, bool includeMin,
                            const rune *max, int maxlen, bool includeMax, TrieRangeCallback callback,
                            void *ctx);
 
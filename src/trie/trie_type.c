@@ -2,11 +2,13 @@
 #include "../rmutil/strings.h"
 #include "../rmutil/util.h"
 #include "../util/heap.h"
+#include "../util/arr.h"
 #include "../util/misc.h"
 #include "rune_util.h"
 
 #include "trie_type.h"
 #include "../commands.h"
+#include "../config.h"
 #include <math.h>
 #include <sys/param.h>
 #include <time.h>
@@ -19,6 +21,8 @@ Trie *NewTrie() {
   rune *rs = strToRunes("", 0);
   tree->root = __newTrieNode(rs, 0, 0, NULL, 0, 0, 0, 0);
   tree->size = 0;
+  tree->frozen = NULL;
+  tree->freezing = NULL;
   rm_free(rs);
   return tree;
 }
@@ -64,6 +68,27 @@ static inline void runeBufFree(runeBuf *buf) {
   }
 }
 
+/* Add a term to the frozen trie if it has a node for it, and to the mutable nodes otherwise */
+static int trie_Add(TrieNode **root, FrozenTrie *frozen, rune *runes, t_len len,
+                    RSPayload *payload, float score, TrieAddOp op) {
+  int rc = frozen ? FrozenTrie_Add(frozen, runes, len, payload, score, op) : -1;
+  if (rc == -1) {
+    rc = TrieNode_Add(root, runes, len, payload, score, op);
+  }
+  return rc;
+}
+
+static int trie_Delete(TrieNode *root, FrozenTrie *frozen, rune *runes, t_len len) {
+  int rc = frozen ? FrozenTrie_Delete(frozen, runes, len) : 0;
+  if (!rc) {
+    rc = TrieNode_Delete(root, runes, len);
+  }
+  return rc;
+}
+
+static void trieFreeze_Update(Trie *t, const rune *str, t_len len, RSPayload *payload,
+                              float score, TrieAddOp op, int isDelete);
+
 int Trie_InsertStringBuffer(Trie *t, const char *s, size_t len, double score, int incr,
                             RSPayload *payload) {
   if (len > TRIE_INITIAL_STRING_LEN * sizeof(rune)) {
@@ -74,8 +99,10 @@ int Trie_InsertStringBuffer(Trie *t, const char *s, size_t len, double score, in
   int rc;
 
   if (runes && len && len < TRIE_INITIAL_STRING_LEN) {
-    rc = TrieNode_Add(&t->root, runes, len, payload, (float)score, incr ? ADD_INCR : ADD_REPLACE);
+    TrieAddOp op = incr ? ADD_INCR : ADD_REPLACE;
+    rc = trie_Add(&t->root, t->frozen, runes, len, payload, (float)score, op);
     t->size += rc;
+    trieFreeze_Update(t, runes, len, payload, (float)score, op, 0);
   } else {
     rc = 0;
   }
@@ -90,8 +117,11 @@ int Trie_Delete(Trie *t, const char *s, size_t len) {
   if (!runes || len > TRIE_INITIAL_STRING_LEN) {
     return 0;
   }
-  int rc = TrieNode_Delete(t->root, runes, len);
+  int rc = trie_Delete(t->root, t->frozen, runes, len);
   t->size -= rc;
+  if (rc) {
+    trieFreeze_Update(t, runes, len, NULL, 0, ADD_REPLACE, 1);
+  }
   rm_free(runes);
   return rc;
 }
@@ -127,113 +157,522 @@ TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist,
     return NULL;
   }
   DFAFilter *fc = rm_malloc(sizeof(*fc));
-  *fc = NewDFAFilter(runes, rlen, maxDist, prefixMode);
+  *fc = NewDFAFilter(runes, rlen, maxDist, prefixMode, RSGlobalConfig.fuzzyTranspositions);
 
   TrieIterator *it = TrieNode_Iterate(t->root, FilterFunc, StackPop, fc);
+  if (t->frozen) {
+    TrieIterator_SetFrozen(it, t->frozen);
+  }
   rm_free(runes);
   return it;
 }
 
-Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
-                    int trim, int optimize) {
+static int runecmp(const rune *sa, size_t na, const rune *sb, size_t nb) {
+  size_t minlen = MIN(na, nb);
+  for (size_t ii = 0; ii < minlen; ++ii) {
+    if (sa[ii] != sb[ii]) {
+      return (int)sa[ii] - (int)sb[ii];
+    }
+  }
+  return na < nb ? -1 : na > nb ? 1 : 0;
+}
 
-  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
-    return NULL;
+typedef void (*trieLexCallback)(const rune *str, t_len len, float score, const char *payload,
+                                size_t plen, void *ctx);
+
+typedef struct {
+  trieLexCallback cb;
+  void *cbCtx;
+  // iterates the terms of the frozen trie, in lexical order
+  TrieIterator *it;
+  // the next term of the frozen trie, which is yet to be passed to the callback
+  int hasNext;
+  rune next[TRIE_INITIAL_STRING_LEN + 1];
+  t_len nextLen;
+  float nextScore;
+  RSPayload nextPayload;
+} trieLexCtx;
+
+static void trieLex_Advance(trieLexCtx *ctx) {
+  rune *str;
+  ctx->hasNext = ctx->it && TrieIterator_Next(ctx->it, &str, &ctx->nextLen, &ctx->nextPayload,
+                                              &ctx->nextScore, NULL);
+  if (ctx->hasNext) {
+    memcpy(ctx->next, str, ctx->nextLen * sizeof(rune));
   }
-  size_t rlen;
-  rune *runes = strToFoldedRunes(s, &rlen);
-  // make sure query length does not overflow
-  if (!runes || rlen >= TRIE_MAX_PREFIX) {
-    rm_free(runes);
-    return NULL;
+}
+
+/* Pass on the frozen terms sorting before a string, or all of them if str is NULL */
+static void trieLex_AddFrozen(trieLexCtx *ctx, const rune *str, t_len len) {
+  while (ctx->hasNext && (!str || runecmp(ctx->next, ctx->nextLen, str, len) < 0)) {
+    ctx->cb(ctx->next, ctx->nextLen, ctx->nextScore, ctx->nextPayload.data, ctx->nextPayload.len,
+            ctx->cbCtx);
+    trieLex_Advance(ctx);
+  }
+}
+
+static int cmpFirstRune(const void *p1, const void *p2) {
+  const TrieNode *n1 = *(const TrieNode **)p1, *n2 = *(const TrieNode **)p2;
+  return (int)n1->str[0] - (int)n2->str[0];
+}
+
+/* Like range iteration, this leaves the children of a node in lexical order */
+static void trieNode_SortLex(TrieNode *n) {
+  if (n->sortmode != TRIENODE_SORTED_LEX) {
+    qsort(__trieNode_children(n), n->numChildren, sizeof(TrieNode *), cmpFirstRune);
+    n->sortmode = TRIENODE_SORTED_LEX;
   }
+}
 
-  heap_t *pq = rm_malloc(heap_sizeof(num));
-  heap_init(pq, cmpEntries, NULL, num);
+/* Pass on the terms under a node in lexical order, merged with the frozen terms */
+static void trieLex_AddNode(trieLexCtx *ctx, TrieNode *n, rune *buf, t_len len) {
+  memcpy(buf + len, n->str, n->len * sizeof(rune));
+  len += n->len;
+  if (n->len > 0 && __trieNode_isTerminal(n) && !__trieNode_isDeleted(n)) {
+    trieLex_AddFrozen(ctx, buf, len);
+    ctx->cb(buf, len, n->score, n->payload ? n->payload->data : NULL,
+            n->payload ? n->payload->len : 0, ctx->cbCtx);
+  }
+  trieNode_SortLex(n);
+  for (t_len i = 0; i < n->numChildren; i++) {
+    trieLex_AddNode(ctx, __trieNode_children(n)[i], buf, len);
+  }
+}
 
-  DFAFilter fc = NewDFAFilter(runes, rlen, maxDist, prefixMode);
+/* Call `cb` with every live term of the trie, mutable and frozen, in lexical order */
+static void trieLex_ForEach(Trie *t, trieLexCallback cb, void *cbCtx) {
+  trieLexCtx ctx = {.cb = cb, .cbCtx = cbCtx};
+  if (t->frozen) {
+    ctx.it = TrieNode_Iterate(NULL, NULL, NULL, NULL);
+    TrieIterator_SetFrozen(ctx.it, t->frozen);
+  }
+  trieLex_Advance(&ctx);
+  rune buf[TRIE_INITIAL_STRING_LEN + 1];
+  trieLex_AddNode(&ctx, t->root, buf, 0);
+  trieLex_AddFrozen(&ctx, NULL, 0);
+  if (ctx.it) {
+    TrieIterator_Free(ctx.it);
+  }
+}
 
-  TrieIterator *it = TrieNode_Iterate(tree->root, FilterFunc, StackPop, &fc);
-  // TrieIterator *it = TrieNode_Iterate(tree->root,NULL, NULL, NULL);
-  rune *rstr;
-  t_len slen;
+static void trieFreeze_Add(const rune *str, t_len len, float score, const char *payload,
+                           size_t plen, void *ctx) {
+  FrozenTrieBuilder_Add(ctx, str, len, score, payload, plen);
+}
+
+/***************************************************************
+ *
+ *                       Incremental freezing
+ *
+ ***************************************************************/
+
+/* An update of a term already moved into the frozen trie being built, replayed onto it once built */
+typedef struct {
+  rune *str;
+  t_len len;
+  int isDelete;
+  TrieAddOp op;
   float score;
-  RSPayload payload = {.data = NULL, .len = 0};
-
-  TrieSearchResult *pooledEntry = NULL;
-  int dist = maxDist + 1;
-  while (TrieIterator_Next(it, &rstr, &slen, &payload, &score, &dist)) {
-    if (pooledEntry == NULL) {
-      pooledEntry = rm_malloc(sizeof(TrieSearchResult));
-      pooledEntry->str = NULL;
-      pooledEntry->payload = NULL;
-      pooledEntry->plen = 0;
-    }
-    TrieSearchResult *ent = pooledEntry;
+  // a copy of the payload, if any
+  RSPayload payload;
+} trieFreezeUpdate;
+
+/* A live term collected by a step of the freeze */
+typedef struct {
+  // the offset of the term's string in the runes of its collector
+  size_t str;
+  t_len len;
+  float score;
+  const char *payload;
+  size_t plen;
+} trieFreezeTerm;
+
+/* The next terms of one part of the trie, in lexical order */
+typedef struct {
+  trieFreezeTerm *terms;
+  rune *runes;
+  // whether the part has no terms left past the collected ones
+  int done;
+} trieFreezeCollector;
+
+/* A frozen trie built a step at a time from the terms of both parts, in lexical order. The parts
+ * stay as they are until it is complete, so each step collects the next terms of both parts again,
+ * starting after the last term it moved */
+struct TrieFreeze {
+  FrozenTrieBuilder *b;
+  // the last term moved into the builder
+  rune last[TRIE_INITIAL_STRING_LEN + 1];
+  t_len lastLen;
+  // the updates of the terms sorting up to the last one, which the builder missed
+  trieFreezeUpdate *updates;
+  trieFreezeCollector frozen;
+  trieFreezeCollector nodes;
+};
+
+/* Whether a term was already moved into the builder */
+static int trieFreeze_IsMoved(const struct TrieFreeze *f, const rune *str, t_len len) {
+  return runecmp(str, len, f->last, f->lastLen) <= 0;
+}
 
-    ent->score = slen > 0 && slen == rlen && memcmp(runes, rstr, slen) == 0 ? INT_MAX : score;
+/* Whether a subtree whose strings start with `str` may hold terms that were not moved yet */
+static int trieFreeze_IsAhead(const struct TrieFreeze *f, const rune *str, t_len len) {
+  t_len n = MIN(len, f->lastLen);
+  return runecmp(str, n, f->last, n) >= 0;
+}
+
+/* Collect a term. Returns 0 once a step's worth of terms are collected */
+static int trieFreeze_Collect(trieFreezeCollector *c, const rune *str, t_len len, float score,
+                              const char *payload, size_t plen) {
+  trieFreezeTerm term = {
+      .str = array_len(c->runes), .len = len, .score = score, .payload = payload, .plen = plen};
+  c->runes = array_ensure_append(c->runes, str, len, rune);
+  c->terms = array_append(c->terms, term);
+  return array_len(c->terms) < TRIE_FREEZE_STEP;
+}
 
-    if (maxDist > 0) {
-      // factor the distance into the score
-      ent->score *= exp((double)-(2 * dist));
+/* Collect the terms under a mutable node that were not moved yet. Returns 0 once a step's worth of
+ * terms are collected */
+static int trieFreeze_CollectNode(struct TrieFreeze *f, TrieNode *n, rune *buf, t_len len) {
+  memcpy(buf + len, n->str, n->len * sizeof(rune));
+  len += n->len;
+  if (!trieFreeze_IsAhead(f, buf, len)) {
+    return 1;
+  }
+  if (n->len > 0 && __trieNode_isTerminal(n) && !__trieNode_isDeleted(n) &&
+      !trieFreeze_IsMoved(f, buf, len) &&
+      !trieFreeze_Collect(&f->nodes, buf, len, n->score, n->payload ? n->payload->data : NULL,
+                          n->payload ? n->payload->len : 0)) {
+    return 0;
+  }
+  trieNode_SortLex(n);
+  for (t_len i = 0; i < n->numChildren; i++) {
+    if (!trieFreeze_CollectNode(f, __trieNode_children(n)[i], buf, len)) {
+      return 0;
     }
-    // in prefix mode we also factor in the total length of the suffix
-    if (prefixMode) {
-      ent->score /= sqrt(1 + (slen >= len ? slen - len : len - slen));
+  }
+  return 1;
+}
+
+/* Like trieFreeze_CollectNode, for a node of the frozen trie */
+static int trieFreeze_CollectFrozen(struct TrieFreeze *f, const FrozenTrie *ft, uint32_t idx,
+                                    rune *buf, t_len len) {
+  const FrozenTrieNode *n = FrozenTrie_Node(ft, idx);
+  memcpy(buf + len, FrozenTrie_Str(ft, n), n->len * sizeof(rune));
+  len += n->len;
+  if (!trieFreeze_IsAhead(f, buf, len)) {
+    return 1;
+  }
+  const TriePayload *payload = FrozenTrie_Payload(ft, n);
+  if (FrozenTrie_IsLive(n) && !trieFreeze_IsMoved(f, buf, len) &&
+      !trieFreeze_Collect(&f->frozen, buf, len, n->score, payload ? payload->data : NULL,
+                          payload ? payload->len : 0)) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < n->numChildren; i++) {
+    if (!trieFreeze_CollectFrozen(f, ft, n->children + i, buf, len)) {
+      return 0;
     }
+  }
+  return 1;
+}
 
-    if (heap_count(pq) < heap_size(pq)) {
-      ent->str = runesToStr(rstr, slen, &ent->len);
-      ent->payload = payload.data;
-      ent->plen = payload.len;
-      heap_offerx(pq, ent);
-      pooledEntry = NULL;
-
-      if (heap_count(pq) == heap_size(pq)) {
-        TrieSearchResult *qe = heap_peek(pq);
-        it->minScore = qe->score;
+/* Move the next terms of the trie into the builder. Returns 1 once all of them are moved */
+static int trieFreeze_Step(Trie *t) {
+  struct TrieFreeze *f = t->freezing;
+  rune buf[TRIE_INITIAL_STRING_LEN + 1];
+  array_clear(f->frozen.terms);
+  array_clear(f->frozen.runes);
+  array_clear(f->nodes.terms);
+  array_clear(f->nodes.runes);
+  f->frozen.done = !t->frozen || trieFreeze_CollectFrozen(f, t->frozen, t->frozen->root, buf, 0);
+  f->nodes.done = trieFreeze_CollectNode(f, t->root, buf, 0);
+
+  // merge the terms of both parts, as long as the next term of a part that has more is known
+  uint32_t i = 0, j = 0, nf = array_len(f->frozen.terms), nn = array_len(f->nodes.terms);
+  while ((i < nf || f->frozen.done) && (j < nn || f->nodes.done) && (i < nf || j < nn)) {
+    trieFreezeCollector *c = &f->nodes;
+    const trieFreezeTerm *term = j < nn ? &f->nodes.terms[j] : NULL;
+    if (i < nf) {
+      const trieFreezeTerm *ft = &f->frozen.terms[i];
+      if (!term || runecmp(f->frozen.runes + ft->str, ft->len, c->runes + term->str, term->len) < 0) {
+        c = &f->frozen;
+        term = ft;
       }
+    }
+    c == &f->frozen ? i++ : j++;
+
+    const rune *str = c->runes + term->str;
+    FrozenTrieBuilder_Add(f->b, str, term->len, term->score, term->payload, term->plen);
+    memcpy(f->last, str, term->len * sizeof(rune));
+    f->lastLen = term->len;
+  }
+  return f->frozen.done && f->nodes.done && i == nf && j == nn;
+}
+
+static void trieFreeze_Free(Trie *t) {
+  struct TrieFreeze *f = t->freezing;
+  if (!f) {
+    return;
+  }
+  if (f->b) {
+    FrozenTrie_Free(FrozenTrieBuilder_Finish(f->b));
+  }
+  for (uint32_t i = 0; i < array_len(f->updates); i++) {
+    rm_free(f->updates[i].str);
+    if (f->updates[i].payload.data) {
+      rm_free(f->updates[i].payload.data);
+    }
+  }
+  array_free(f->updates);
+  array_free(f->frozen.terms);
+  array_free(f->frozen.runes);
+  array_free(f->nodes.terms);
+  array_free(f->nodes.runes);
+  rm_free(f);
+  t->freezing = NULL;
+}
 
+/* Replace both parts of the trie by the built frozen trie, once the updates it missed are replayed
+ * onto it. The terms added since they were moved end up in the new mutable nodes */
+static void trieFreeze_Finish(Trie *t) {
+  struct TrieFreeze *f = t->freezing;
+  FrozenTrie *ft = FrozenTrieBuilder_Finish(f->b);
+  f->b = NULL;
+  rune empty = 0;
+  TrieNode *root = __newTrieNode(&empty, 0, 0, NULL, 0, 0, 0, 0);
+  for (uint32_t i = 0; i < array_len(f->updates); i++) {
+    trieFreezeUpdate *u = &f->updates[i];
+    if (u->isDelete) {
+      trie_Delete(root, ft, u->str, u->len);
     } else {
-      if (ent->score >= it->minScore) {
-        pooledEntry = heap_poll(pq);
-        rm_free(pooledEntry->str);
-        pooledEntry->str = NULL;
-        ent->str = runesToStr(rstr, slen, &ent->len);
-        ent->payload = payload.data;
-        ent->plen = payload.len;
-        heap_offerx(pq, ent);
-
-        // get the new minimal score
-        TrieSearchResult *qe = heap_peek(pq);
-        if (qe->score > it->minScore) {
-          it->minScore = qe->score;
-        }
+      trie_Add(&root, ft, u->str, u->len, u->payload.data ? &u->payload : NULL, u->score, u->op);
+    }
+  }
 
-      } else {
-        pooledEntry = ent;
-      }
+  if (t->frozen) {
+    FrozenTrie_Free(t->frozen);
+  }
+  TrieNode_Free(t->root);
+  t->frozen = ft;
+  t->root = root;
+  trieFreeze_Free(t);
+}
+
+/* Called after each update of a term. While the trie is being frozen, the update is recorded if
+ * the builder missed it, and the next terms are moved. Otherwise the trie starts being frozen once
+ * its mutable nodes grow too large */
+static void trieFreeze_Update(Trie *t, const rune *str, t_len len, RSPayload *payload,
+                              float score, TrieAddOp op, int isDelete) {
+  struct TrieFreeze *f = t->freezing;
+  if (!f) {
+    size_t frozenSize = t->frozen ? t->frozen->size : 0;
+    if (t->size - frozenSize < TRIE_FREEZE_MIN_TERMS ||
+        t->size - frozenSize < frozenSize / TRIE_FREEZE_RATIO) {
+      return;
     }
+    f = t->freezing = rm_calloc(1, sizeof(*f));
+    f->b = NewFrozenTrieBuilder();
+    f->updates = array_new(trieFreezeUpdate, 16);
+  } else if (trieFreeze_IsMoved(f, str, len)) {
+    trieFreezeUpdate u = {.len = len, .isDelete = isDelete, .op = op, .score = score};
+    u.str = rm_malloc(len * sizeof(rune));
+    memcpy(u.str, str, len * sizeof(rune));
+    if (payload) {
+      u.payload.data = rm_malloc(payload->len + 1);
+      memcpy(u.payload.data, payload->data, payload->len);
+      u.payload.len = payload->len;
+    }
+    f->updates = array_append(f->updates, u);
+  }
+
+  if (trieFreeze_Step(t)) {
+    trieFreeze_Finish(t);
+  }
+}
 
-    // dist = maxDist + 3;
+void Trie_Freeze(Trie *t) {
+  // a freeze in progress is dropped, as all the terms are moved at once
+  trieFreeze_Free(t);
+  FrozenTrieBuilder *b = NewFrozenTrieBuilder();
+  trieLex_ForEach(t, trieFreeze_Add, b);
+  if (t->frozen) {
+    FrozenTrie_Free(t->frozen);
   }
+  t->frozen = FrozenTrieBuilder_Finish(b);
+  TrieNode_Free(t->root);
+  rune empty = 0;
+  t->root = __newTrieNode(&empty, 0, 0, NULL, 0, 0, 0, 0);
+}
 
-  if (pooledEntry) {
-    TrieSearchResult_Free(pooledEntry);
+void Trie_IterateRange(Trie *t, const rune *min, int nmin, bool includeMin, const rune *max,
+                       int nmax, bool includeMax, TrieRangeCallback callback, void *ctx) {
+  if (!TrieNode_IterateRange(t->root, min, nmin, includeMin, max, nmax, includeMax, callback,
+                             ctx)) {
+    return;
+  }
+  if (t->frozen) {
+    FrozenTrie_IterateRange(t->frozen, min, nmin, includeMin, max, nmax, includeMax, callback,
+                            ctx);
   }
+}
 
-  // printf("Nodes consumed: %d/%d (%.02f%%)\n", it->nodesConsumed,
-  //        it->nodesConsumed + it->nodesSkipped,
-  //        100.0 * (float)(it->nodesConsumed) / (float)(it->nodesConsumed +
-  //        it->nodesSkipped));
+/* A step of the best-first search of Trie_Search. It is either a node whose subtree is yet to be
+ * searched, or a completion ending at a node */
+typedef struct trieSearchStep {
+  // the node, or NULL for the node `fn` of the frozen trie
+  TrieNode *n;
+  uint32_t fn;
+  // the step of the node's parent, used to rebuild the string
+  struct trieSearchStep *parent;
+  // the state of the filter before the node's string
+  DFAState state;
+  // the length of the string leading up to the node
+  t_len offset;
+  // whether the string leading up to the node is a prefix of the query
+  int onQuery;
+  int isCompletion;
+  // the score of a completion, or an upper bound on the scores of the completions under a node
+  float score;
+} trieSearchStep;
 
-  // put the results from the heap on a vector to return
-  size_t n = MIN(heap_count(pq), num);
-  Vector *ret = NewVector(TrieSearchResult *, n);
-  for (int i = 0; i < n; ++i) {
-    TrieSearchResult *h = heap_poll(pq);
-    Vector_Put(ret, n - i - 1, h);
+/* Steps with the highest score come first, and completions before nodes of the same score */
+static int cmpSearchSteps(const void *p1, const void *p2, const void *udata) {
+  const trieSearchStep *s1 = p1, *s2 = p2;
+  if (s1->score != s2->score) {
+    return s1->score > s2->score ? 1 : -1;
   }
+  return s1->isCompletion - s2->isCompletion;
+}
+
+static trieSearchStep *newSearchStep(trieSearchStep ***steps, TrieNode *n, uint32_t fn,
+                                     trieSearchStep *parent, t_len offset) {
+  trieSearchStep *step = rm_malloc(sizeof(*step));
+  *step = (trieSearchStep){.n = n, .fn = fn, .parent = parent, .offset = offset};
+  *steps = array_append(*steps, step);
+  return step;
+}
+
+/* The string of the node of a step */
+static const rune *searchStep_Str(const Trie *t, const trieSearchStep *step, t_len *len) {
+  if (step->n) {
+    *len = step->n->len;
+    return step->n->str;
+  }
+  const FrozenTrieNode *fn = FrozenTrie_Node(t->frozen, step->fn);
+  *len = fn->len;
+  return FrozenTrie_Str(t->frozen, fn);
+}
+
+/* Write the string ending at the node of a step into buf, which must fit it */
+static t_len searchStep_String(const Trie *t, const trieSearchStep *step, rune *buf) {
+  t_len nlen;
+  searchStep_Str(t, step, &nlen);
+  t_len len = step->offset + nlen;
+  for (; step; step = step->parent) {
+    const rune *str = searchStep_Str(t, step, &nlen);
+    memcpy(buf + step->offset, str, nlen * sizeof(rune));
+  }
+  return len;
+}
+
+/* Return the top `num` completions of a string. This is a best-first search over the trie, where each
+ * subtree is bounded by the max score of its nodes. The completion scores are lowered by their
+ * distance from the query and, in prefix mode, by their length, and only an exact match can score
+ * higher than its node. So once `num` completions score at least as much as the bounds of all
+ * unsearched subtrees, the search stops */
+Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
+                    int trim, int optimize) {
+
+  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
+    return NULL;
+  }
+  size_t rlen;
+  rune *runes = strToFoldedRunes(s, &rlen);
+  // make sure query length does not overflow
+  if (!runes || rlen >= TRIE_MAX_PREFIX) {
+    rm_free(runes);
+    return NULL;
+  }
+
+  DFAFilter fc = NewDFAFilter(runes, rlen, maxDist, prefixMode, RSGlobalConfig.fuzzyTranspositions);
+
+  heap_t *pq = heap_new(cmpSearchSteps, NULL);
+  trieSearchStep **steps = array_new(trieSearchStep *, 16);
+  // the mutable nodes and the frozen trie are searched together, from both of their roots
+  for (int i = 0; i < (tree->frozen ? 2 : 1); i++) {
+    trieSearchStep *root = i == 0 ? newSearchStep(&steps, tree->root, FROZEN_TRIE_NONE, NULL, 0)
+                                  : newSearchStep(&steps, NULL, tree->frozen->root, NULL, 0);
+    root->state = DFAFilter_Start(&fc);
+    root->onQuery = 1;
+    root->score = INT_MAX;
+    heap_offer(&pq, root);
+  }
+
+  Vector *ret = NewVector(TrieSearchResult *, num);
+  rune rstr[TRIE_INITIAL_STRING_LEN + 1];
+  trieSearchStep *step;
+  while (Vector_Size(ret) < num && (step = heap_poll(pq))) {
+    TrieNode *n = step->n;
+    const FrozenTrieNode *fn = n ? NULL : FrozenTrie_Node(tree->frozen, step->fn);
+    if (step->isCompletion) {
+      t_len slen = searchStep_String(tree, step, rstr);
+      const TriePayload *payload = n ? n->payload : FrozenTrie_Payload(tree->frozen, fn);
+      TrieSearchResult *ent = rm_malloc(sizeof(TrieSearchResult));
+      ent->str = runesToStr(rstr, slen, &ent->len);
+      ent->score = step->score;
+      ent->payload = payload ? (char *)payload->data : NULL;
+      ent->plen = payload ? payload->len : 0;
+      Vector_Push(ret, ent);
+      continue;
+    }
+
+    // feed the node's string to the filter, dropping the subtree if it can't match
+    t_len nlen;
+    const rune *nstr = searchStep_Str(tree, step, &nlen);
+    DFAState state = step->state;
+    int matched = 0;
+    FilterCode rc = F_CONTINUE;
+    for (t_len i = 0; i < nlen && rc == F_CONTINUE; i++) {
+      rc = DFAFilter_Step(&fc, &state, nstr[i], &matched);
+    }
+    if (rc == F_STOP) {
+      continue;
+    }
+    t_len offset = step->offset + nlen;
+    int onQuery = step->onQuery && offset <= rlen &&
+                  !memcmp(nstr, runes + step->offset, nlen * sizeof(rune));
+
+    int live = n ? __trieNode_isTerminal(n) && !__trieNode_isDeleted(n) : FrozenTrie_IsLive(fn);
+    if (nlen > 0 && matched && live) {
+      trieSearchStep *comp = newSearchStep(&steps, n, step->fn, step->parent, step->offset);
+      comp->isCompletion = 1;
+      comp->score = onQuery && offset == rlen ? INT_MAX : n ? n->score : fn->score;
+      if (maxDist > 0) {
+        // factor the distance into the score
+        comp->score *= exp((double)-(2 * state.dist));
+      }
+      // in prefix mode we also factor in the total length of the suffix
+      if (prefixMode) {
+        comp->score /= sqrt(1 + (offset >= len ? offset - len : len - offset));
+      }
+      heap_offer(&pq, comp);
+    }
+
+    uint32_t numChildren = n ? n->numChildren : fn->numChildren;
+    for (uint32_t i = 0; i < numChildren; i++) {
+      TrieNode *child = n ? __trieNode_children(n)[i] : NULL;
+      uint32_t childFn = n ? FROZEN_TRIE_NONE : fn->children + i;
+      float maxScore =
+          n ? child->maxChildScore : FrozenTrie_Node(tree->frozen, childFn)->maxChildScore;
+      trieSearchStep *ch = newSearchStep(&steps, child, childFn, step, offset);
+      ch->state = state;
+      ch->onQuery = onQuery && offset < rlen;
+      // the factors above can only lower a score, but they may raise a negative one up to 0
+      ch->score = ch->onQuery ? INT_MAX : MAX(maxScore, 0);
+      heap_offer(&pq, ch);
+    }
+  }
+  size_t n = Vector_Size(ret);
 
   // trim the results to remove irrelevant results
   if (trim) {
@@ -259,7 +698,8 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
   }
 
   rm_free(runes);
-  TrieIterator_Free(it);
+  array_foreach(steps, st, rm_free(st));
+  array_free(steps);
   DFAFilter_Free(&fc);
   heap_free(pq);
 
@@ -275,17 +715,23 @@ int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score) {
   t_len rlen;
 
   // TODO: deduce steps from cardinality properly
-  TrieNode *n =
-      TrieNode_RandomWalk(t->root, 2 + rand() % 8 + (int)round(logb(1 + t->size)), &rstr, &rlen);
-  if (!n) {
-    return 0;
+  int minSteps = 2 + rand() % 8 + (int)round(logb(1 + t->size));
+  // pick the frozen or the mutable part of the trie by their number of terms
+  size_t frozenSize = t->frozen ? t->frozen->size : 0;
+  if (frozenSize && rand() % t->size < frozenSize) {
+    uint32_t fn = FrozenTrie_RandomWalk(t->frozen, minSteps, &rstr, &rlen);
+    *score = FrozenTrie_Node(t->frozen, fn)->score;
+  } else {
+    TrieNode *n = TrieNode_RandomWalk(t->root, minSteps, &rstr, &rlen);
+    if (!n) {
+      return 0;
+    }
+    *score = n->score;
   }
   size_t sz;
   *str = runesToStr(rstr, rlen, &sz);
   *len = sz;
   rm_free(rstr);
-
-  *score = n->score;
   return 1;
 }
 
@@ -309,6 +755,13 @@ void *TrieType_GenericLoad(RedisModuleIO *rdb, int loadPayloads) {
   uint64_t elements = RedisModule_LoadUnsigned(rdb);
   Trie *tree = NewTrie();
 
+  // tries are saved in lexical order, so a large one is built frozen straight away, without
+  // inserting its terms one by one. Should a term arrive out of order, as in RDBs saved before
+  // the order was kept, the rest of the terms are inserted as usual
+  FrozenTrieBuilder *b = elements >= TRIE_FREEZE_MIN_TERMS ? NewFrozenTrieBuilder() : NULL;
+  rune prev[TRIE_INITIAL_STRING_LEN + 1];
+  size_t prevLen = 0;
+
   while (elements--) {
     size_t len;
     RSPayload payload = {.data = NULL, .len = 0};
@@ -319,10 +772,45 @@ void *TrieType_GenericLoad(RedisModuleIO *rdb, int loadPayloads) {
       // load an extra space for the null terminator
       payload.len--;
     }
-    Trie_InsertStringBuffer(tree, str, len - 1, score, 0, payload.len ? &payload : NULL);
+    len--;
+    if (b) {
+      // terms that insertion would drop are skipped
+      int valid = 0, inOrder = 0;
+      if (len <= TRIE_INITIAL_STRING_LEN * sizeof(rune)) {
+        runeBuf buf;
+        size_t rlen;
+        rune *runes = runeBufFill(str, len, &buf, &rlen);
+        valid = rlen && rlen < TRIE_INITIAL_STRING_LEN;
+        inOrder = valid && runecmp(prev, prevLen, runes, rlen) < 0;
+        if (inOrder) {
+          FrozenTrieBuilder_Add(b, runes, rlen, score, payload.data, payload.len);
+          memcpy(prev, runes, rlen * sizeof(rune));
+          prevLen = rlen;
+        }
+        runeBufFree(&buf);
+      }
+      if (inOrder || !valid) {
+        goto next;
+      }
+    }
+    if (b) {
+      tree->frozen = FrozenTrieBuilder_Finish(b);
+      tree->size = tree->frozen->size;
+      b = NULL;
+    }
+    Trie_InsertStringBuffer(tree, str, len, score, 0, payload.len ? &payload : NULL);
+  next:
     RedisModule_Free(str);
     if (payload.data != NULL) RedisModule_Free(payload.data);
   }
+  if (b) {
+    tree->frozen = FrozenTrieBuilder_Finish(b);
+    tree->size = tree->frozen->size;
+  }
+  // a loaded trie is mostly read from, so it is frozen whole if it's large enough
+  if (tree->size >= TRIE_FREEZE_MIN_TERMS && tree->size > (tree->frozen ? tree->frozen->size : 0)) {
+    Trie_Freeze(tree);
+  }
   // TrieNode_Print(tree->root, 0, 0);
   return tree;
 }
@@ -331,42 +819,46 @@ void TrieType_RdbSave(RedisModuleIO *rdb, void *value) {
   TrieType_GenericSave(rdb, (Trie *)value, 1);
 }
 
+typedef struct {
+  RedisModuleIO *rdb;
+  int savePayloads;
+  size_t count;
+} trieSaveCtx;
+
+static void trieSave_Add(const rune *str, t_len len, float score, const char *payload,
+                         size_t plen, void *p) {
+  trieSaveCtx *ctx = p;
+  size_t slen = 0;
+  char *s = runesToStr(str, len, &slen);
+  RedisModule_SaveStringBuffer(ctx->rdb, s, slen + 1);
+  RedisModule_SaveDouble(ctx->rdb, (double)score);
+
+  if (ctx->savePayloads) {
+    // save an extra space for the null terminator to make the payload null terminated on load
+    if (payload != NULL && plen > 0) {
+      RedisModule_SaveStringBuffer(ctx->rdb, payload, plen + 1);
+    } else {
+      // If there's no payload - we save an empty string
+      RedisModule_SaveStringBuffer(ctx->rdb, "", 1);
+    }
+  }
+  // TODO: Save a marker for empty payload!
+  rm_free(s);
+  ctx->count++;
+}
+
 void TrieType_GenericSave(RedisModuleIO *rdb, Trie *tree, int savePayloads) {
   RedisModule_SaveUnsigned(rdb, tree->size);
   RedisModuleCtx *ctx = RedisModule_GetContextFromIO(rdb);
   //  RedisModule_Log(ctx, "notice", "Trie: saving %zd nodes.", tree->size);
-  int count = 0;
   if (tree->root) {
-    TrieIterator *it = TrieNode_Iterate(tree->root, NULL, NULL, NULL);
-    rune *rstr;
-    t_len len;
-    float score;
-    RSPayload payload = {.data = NULL, .len = 0};
-
-    while (TrieIterator_Next(it, &rstr, &len, &payload, &score, NULL)) {
-      size_t slen = 0;
-      char *s = runesToStr(rstr, len, &slen);
-      RedisModule_SaveStringBuffer(rdb, s, slen + 1);
-      RedisModule_SaveDouble(rdb, (double)score);
-
-      if (savePayloads) {
-        // save an extra space for the null terminator to make the payload null terminated on load
-        if (payload.data != NULL && payload.len > 0) {
-          RedisModule_SaveStringBuffer(rdb, payload.data, payload.len + 1);
-        } else {
-          // If there's no payload - we save an empty string
-          RedisModule_SaveStringBuffer(rdb, "", 1);
-        }
-      }
-      // TODO: Save a marker for empty payload!
-      rm_free(s);
-      count++;
+    // the terms are saved in lexical order, so that loading can build the trie in bulk
+    trieSaveCtx sctx = {.rdb = rdb, .savePayloads = savePayloads};
+    trieLex_ForEach(tree, trieSave_Add, &sctx);
+    if (sctx.count != tree->size) {
+      RedisModule_Log(ctx, "warning", "Trie: saving %zd nodes actually iterated only %zd nodes",
+                      tree->size, sctx.count);
     }
-    if (count != tree->size) {
-      RedisModule_Log(ctx, "warning", "Trie: saving %zd nodes actually iterated only %d nodes",
-                      tree->size, count);
-    }
-    TrieIterator_Free(it);
   }
 }
 
@@ -376,10 +868,14 @@ void TrieType_Digest(RedisModuleDigest *digest, void *value) {
 
 void TrieType_Free(void *value) {
   Trie *tree = value;
+  trieFreeze_Free(tree);
   if (tree->root) {
 
     TrieNode_Free(tree->root);
   }
+  if (tree->frozen) {
+    FrozenTrie_Free(tree->frozen);
+  }
 
   rm_free(tree);
 }
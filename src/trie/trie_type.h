@@ -4,6 +4,7 @@
 #include "../redismodule.h"
 
 #include "trie.h"
+#include "frozen_trie.h"
 #include "levenshtein.h"
 
 #ifdef __cplusplus
@@ -15,9 +16,25 @@ extern RedisModuleType *TrieType;
 #define TRIE_ENCVER_CURRENT 1
 #define TRIE_ENCVER_NOPAYLOADS 0
 
+// A trie is frozen once it has this many terms outside of its frozen part...
+#define TRIE_FREEZE_MIN_TERMS 50000
+// ...and they are at least this fraction of the frozen terms
+#define TRIE_FREEZE_RATIO 4
+// The number of terms moved into the next frozen trie by each update, while it is built
+#define TRIE_FREEZE_STEP 64
+
+struct TrieFreeze;
+
+/* A trie is made of a frozen trie holding most of its terms, and of mutable nodes holding the
+ * terms added since it was last frozen. Each term is in exactly one of them: a term is added to
+ * the frozen trie if it already has a node for it, and to the mutable nodes otherwise */
 typedef struct {
   TrieNode *root;
   size_t size;
+  // the frozen part of the trie, or NULL if it was never frozen
+  FrozenTrie *frozen;
+  // the next frozen part while it is being built, or NULL
+  struct TrieFreeze *freezing;
 } Trie;
 
 typedef struct {
@@ -46,6 +63,17 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
  * Otherwise we return an iterator to all strings within maxDist Levenshtein distance */
 TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist, int prefixMode);
 
+/* Move all the terms of the trie into a new frozen trie at once. As terms are added, this rather
+ * happens on its own whenever the mutable nodes grow too large: the new frozen trie is then built
+ * TRIE_FREEZE_STEP terms at a time by each following update, and replaces the current parts once
+ * complete */
+void Trie_Freeze(Trie *t);
+
+/* Iterate the terms within a lexical range, like TrieNode_IterateRange, until the callback returns
+ * 0 */
+void Trie_IterateRange(Trie *t, const rune *min, int nmin, bool includeMin, const rune *max,
+                       int nmax, bool includeMax, TrieRangeCallback callback, void *ctx);
+
 /* Get a random key from the trie, and put the node's score in the score pointer. Returns 0 if the
  * trie is empty and we cannot do that */
 int Trie_RandomKey(Trie *t, char **str, t_len *len, double *score);
@@ -90,7 +90,7 @@ void *BlkAlloc_Alloc(BlkAlloc *blocks, size_t elemSize, size_t blockSize) {
   if (!blocks->root) {
     blocks->root = blocks->last = getNewBlock(blocks, blockSize);
 
-  } else if (blocks->last->numUsed + elemSize > blockSize) {
+  } else if (blocks->last->numUsed + elemSize > blocks->last->capacity) {
     // Allocate a new element
     BlkAllocBlock *newBlock = getNewBlock(blocks, blockSize);
     blocks->last->next = newBlock;
@@ -0,0 +1,837 @@
+#include "vector_index.h"
+#include "knn_iterator.h"
+#include "spec.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VECTOR_INITIAL_CAPACITY 64
+
+/*****************************************************************************
+ * Distance functions
+ *
+ * The loops keep four independent accumulators, so the compiler can vectorize them with whatever
+ * SIMD width the target has, without a dependency chain through a single sum.
+ *****************************************************************************/
+
+static float distL2(const float *a, const float *b, size_t dim) {
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    float d0 = a[i] - b[i], d1 = a[i + 1] - b[i + 1];
+    float d2 = a[i + 2] - b[i + 2], d3 = a[i + 3] - b[i + 3];
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+    s2 += d2 * d2;
+    s3 += d3 * d3;
+  }
+  for (; i < dim; ++i) {
+    float d = a[i] - b[i];
+    s0 += d * d;
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+static float dotProduct(const float *a, const float *b, size_t dim) {
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < dim; ++i) {
+    s0 += a[i] * b[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+static void normalize(float *v, size_t dim) {
+  float norm = sqrtf(dotProduct(v, v, dim));
+  if (norm > 0) {
+    for (size_t i = 0; i < dim; ++i) {
+      v[i] /= norm;
+    }
+  }
+}
+
+/*****************************************************************************
+ * Index storage
+ *****************************************************************************/
+
+typedef struct {
+  uint32_t level;
+  // Set by the sweep once the node's document was found deleted. No new links are made to the node
+  int dead;
+  // For each level: the number of neighbours followed by their ids. Level 0 has room for 2*M
+  // neighbours, and the levels above it for M
+  uint32_t *links;
+} HNSWNode;
+
+// Marks the nodes visited by a graph search. Bumping the epoch clears the set
+typedef struct {
+  uint32_t *tags;
+  uint32_t epoch;
+} VisitedSet;
+
+struct VectorIndex {
+  VectorFieldOptions opts;
+  float *vectors;
+  // 0 for the slots freed by the sweep
+  t_docId *docIds;
+  size_t size;
+  size_t cap;
+  // The slots freed by the sweep, which new vectors take before the index grows
+  uint32_t *freeIds;
+
+  // The slot the sweep visits next, and whether it is unlinking the dead nodes it marked
+  size_t sweepPos;
+  int sweepUnlinking;
+  // The graph nodes the sweep marked dead
+  uint32_t *deadIds;
+  // The live node of the highest level the unlink pass saw, which replaces a dead entry point
+  uint32_t sweepEntry;
+  int sweepEntryLevel;
+
+  // HNSW graph. maxLevel is -1 while the graph is empty
+  HNSWNode *nodes;
+  uint32_t entry;
+  int maxLevel;
+  double levelMult;
+  uint64_t rng;
+  // Inserts, sweeps and queries all run under the GIL, so they share a single visited set
+  VisitedSet visited;
+};
+
+#define VEC(vi, id) ((vi)->vectors + (size_t)(id) * (vi)->opts.dim)
+
+float VectorIndex_Distance(const VectorIndex *vi, const float *a, const float *b) {
+  if (vi->opts.metric == VectorMetric_L2) {
+    return distL2(a, b, vi->opts.dim);
+  }
+  // cosine vectors are normalized when added and queried
+  return 1 - dotProduct(a, b, vi->opts.dim);
+}
+
+VectorIndex *NewVectorIndex(const VectorFieldOptions *opts) {
+  VectorIndex *vi = rm_calloc(1, sizeof(*vi));
+  vi->opts = *opts;
+  vi->maxLevel = -1;
+  vi->levelMult = 1 / log(opts->hnswM > 1 ? opts->hnswM : 2);
+  vi->rng = 0x9E3779B97F4A7C15ULL;
+  vi->freeIds = array_new(uint32_t, 0);
+  vi->deadIds = array_new(uint32_t, 0);
+  return vi;
+}
+
+static void hnswClear(VectorIndex *vi) {
+  if (vi->nodes) {
+    for (size_t i = 0; i < vi->size; ++i) {
+      rm_free(vi->nodes[i].links);
+      vi->nodes[i].links = NULL;
+    }
+  }
+  vi->maxLevel = -1;
+  vi->entry = 0;
+}
+
+void VectorIndex_Free(void *p) {
+  VectorIndex *vi = p;
+  hnswClear(vi);
+  rm_free(vi->nodes);
+  rm_free(vi->visited.tags);
+  array_free(vi->freeIds);
+  array_free(vi->deadIds);
+  rm_free(vi->vectors);
+  rm_free(vi->docIds);
+  rm_free(vi);
+}
+
+size_t VectorIndex_Size(const VectorIndex *vi) {
+  return vi->size - array_len(vi->freeIds);
+}
+
+static inline int isLive(const DocTable *docs, t_docId docId) {
+  const RSDocumentMetadata *dmd = DocTable_Get(docs, docId);
+  return dmd && !(dmd->flags & Document_Deleted);
+}
+
+/*****************************************************************************
+ * Candidate heaps
+ *****************************************************************************/
+
+typedef struct {
+  float dist;
+  uint32_t id;
+} VecCandidate;
+
+// A binary heap of candidates. A max heap has the farthest candidate on top, a min heap the nearest
+typedef struct {
+  VecCandidate *items;
+  int max;
+} VecHeap;
+
+static inline int heapAbove(const VecHeap *h, const VecCandidate *a, const VecCandidate *b) {
+  return h->max ? a->dist > b->dist : a->dist < b->dist;
+}
+
+static void heapPush(VecHeap *h, VecCandidate c) {
+  h->items = array_append(h->items, c);
+  size_t i = array_len(h->items) - 1;
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!heapAbove(h, &h->items[i], &h->items[parent])) {
+      break;
+    }
+    VecCandidate tmp = h->items[i];
+    h->items[i] = h->items[parent];
+    h->items[parent] = tmp;
+    i = parent;
+  }
+}
+
+static VecCandidate heapPop(VecHeap *h) {
+  VecCandidate top = h->items[0];
+  size_t n = array_len(h->items) - 1;
+  h->items[0] = h->items[n];
+  h->items = array_trimm_len(h->items, n);
+  size_t i = 0;
+  while (1) {
+    size_t l = 2 * i + 1, r = l + 1, best = i;
+    if (l < n && heapAbove(h, &h->items[l], &h->items[best])) best = l;
+    if (r < n && heapAbove(h, &h->items[r], &h->items[best])) best = r;
+    if (best == i) {
+      break;
+    }
+    VecCandidate tmp = h->items[i];
+    h->items[i] = h->items[best];
+    h->items[best] = tmp;
+    i = best;
+  }
+  return top;
+}
+
+static int cmpCandidates(const void *p1, const void *p2) {
+  const VecCandidate *c1 = p1, *c2 = p2;
+  return c1->dist < c2->dist ? -1 : (c1->dist > c2->dist ? 1 : 0);
+}
+
+/*****************************************************************************
+ * HNSW graph
+ *
+ * See "Efficient and robust approximate nearest neighbor search using Hierarchical Navigable Small
+ * World graphs" (Malkov & Yashunin). Nodes of deleted documents stay in the graph to keep it
+ * connected; they are only left out of query results, until the sweep unlinks them.
+ *****************************************************************************/
+
+static inline uint32_t hnswMaxLinks(const VectorIndex *vi, int level) {
+  return level ? vi->opts.hnswM : 2 * vi->opts.hnswM;
+}
+
+static inline uint32_t *hnswLinks(const VectorIndex *vi, uint32_t id, int level) {
+  uint32_t *links = vi->nodes[id].links;
+  if (level == 0) {
+    return links;
+  }
+  return links + 1 + 2 * vi->opts.hnswM + (level - 1) * (1 + vi->opts.hnswM);
+}
+
+static inline size_t hnswLinksSize(const VectorIndex *vi, uint32_t level) {
+  return (1 + 2 * vi->opts.hnswM + level * (1 + vi->opts.hnswM)) * sizeof(uint32_t);
+}
+
+static int hnswRandomLevel(VectorIndex *vi) {
+  // xorshift64*
+  vi->rng ^= vi->rng >> 12;
+  vi->rng ^= vi->rng << 25;
+  vi->rng ^= vi->rng >> 27;
+  uint64_t r = vi->rng * 0x2545F4914F6CDD1DULL;
+  double u = ((r >> 11) + 1) * (1.0 / 9007199254740993.0);
+  int level = (int)(-log(u) * vi->levelMult);
+  return level > 16 ? 16 : level;
+}
+
+static inline int visitedTestAndSet(VisitedSet *vs, uint32_t id) {
+  if (vs->tags[id] == vs->epoch) {
+    return 1;
+  }
+  vs->tags[id] = vs->epoch;
+  return 0;
+}
+
+static void visitedReset(VisitedSet *vs, size_t size) {
+  if (++vs->epoch == 0) {
+    memset(vs->tags, 0, size * sizeof(*vs->tags));
+    vs->epoch = 1;
+  }
+}
+
+/* Descend to the node nearest to `q` on a level, one hop at a time */
+static VecCandidate hnswGreedy(const VectorIndex *vi, const float *q, VecCandidate ep, int level) {
+  int changed = 1;
+  while (changed) {
+    changed = 0;
+    const uint32_t *links = hnswLinks(vi, ep.id, level);
+    for (uint32_t i = 1; i <= links[0]; ++i) {
+      float d = VectorIndex_Distance(vi, q, VEC(vi, links[i]));
+      if (d < ep.dist) {
+        ep = (VecCandidate){.dist = d, .id = links[i]};
+        changed = 1;
+      }
+    }
+  }
+  return ep;
+}
+
+/* Find the `ef` nodes nearest to `q` on a level, starting from the entry points. Returns an array
+ * of candidates in no particular order */
+static VecCandidate *hnswSearchLayer(const VectorIndex *vi, const float *q, const VecCandidate *eps,
+                                     size_t neps, size_t ef, int level, VisitedSet *vs) {
+  VecHeap cands = {.items = array_new(VecCandidate, ef), .max = 0};
+  VecHeap res = {.items = array_new(VecCandidate, ef + 1), .max = 1};
+  visitedReset(vs, vi->size);
+  for (size_t i = 0; i < neps; ++i) {
+    if (!visitedTestAndSet(vs, eps[i].id)) {
+      heapPush(&cands, eps[i]);
+      heapPush(&res, eps[i]);
+    }
+  }
+  while (array_len(res.items) > ef) {
+    heapPop(&res);
+  }
+
+  while (array_len(cands.items)) {
+    VecCandidate c = heapPop(&cands);
+    if (array_len(res.items) >= ef && c.dist > res.items[0].dist) {
+      break;
+    }
+    const uint32_t *links = hnswLinks(vi, c.id, level);
+    for (uint32_t i = 1; i <= links[0]; ++i) {
+      uint32_t n = links[i];
+      if (visitedTestAndSet(vs, n)) {
+        continue;
+      }
+      float d = VectorIndex_Distance(vi, q, VEC(vi, n));
+      if (array_len(res.items) < ef || d < res.items[0].dist) {
+        VecCandidate nc = {.dist = d, .id = n};
+        heapPush(&cands, nc);
+        heapPush(&res, nc);
+        if (array_len(res.items) > ef) {
+          heapPop(&res);
+        }
+      }
+    }
+  }
+  array_free(cands.items);
+  return res.items;
+}
+
+/* Pick up to `m` neighbours out of candidates sorted by distance, preferring ones which are not
+ * closer to an already picked neighbour than to the node itself. This keeps links spread in all
+ * directions instead of clustering. Dead nodes are never picked. Returns the number picked */
+static size_t hnswSelectNeighbors(const VectorIndex *vi, const VecCandidate *cands, size_t n,
+                                  size_t m, uint32_t *out) {
+  size_t nout = 0;
+  for (size_t i = 0; i < n && nout < m; ++i) {
+    int keep = !vi->nodes[cands[i].id].dead;
+    for (size_t j = 0; j < nout && keep; ++j) {
+      keep = VectorIndex_Distance(vi, VEC(vi, cands[i].id), VEC(vi, out[j])) >= cands[i].dist;
+    }
+    if (keep) {
+      out[nout++] = cands[i].id;
+    }
+  }
+  return nout;
+}
+
+/* Add a link from `from` to `to`, pruning the links of `from` if it has too many */
+static void hnswConnect(VectorIndex *vi, uint32_t from, uint32_t to, int level) {
+  uint32_t *links = hnswLinks(vi, from, level);
+  uint32_t maxLinks = hnswMaxLinks(vi, level);
+  if (links[0] < maxLinks) {
+    links[++links[0]] = to;
+    return;
+  }
+
+  VecCandidate cands[maxLinks + 1];
+  const float *v = VEC(vi, from);
+  for (uint32_t i = 0; i < links[0]; ++i) {
+    cands[i] = (VecCandidate){.dist = VectorIndex_Distance(vi, v, VEC(vi, links[i + 1])),
+                              .id = links[i + 1]};
+  }
+  cands[maxLinks] = (VecCandidate){.dist = VectorIndex_Distance(vi, v, VEC(vi, to)), .id = to};
+  qsort(cands, maxLinks + 1, sizeof(*cands), cmpCandidates);
+  links[0] = hnswSelectNeighbors(vi, cands, maxLinks + 1, maxLinks, links + 1);
+}
+
+static size_t hnswInsert(VectorIndex *vi, uint32_t id) {
+  const float *q = VEC(vi, id);
+  int level = hnswRandomLevel(vi);
+  size_t sz = hnswLinksSize(vi, level);
+  vi->nodes[id] = (HNSWNode){.level = level, .links = rm_calloc(1, sz)};
+  if (vi->maxLevel < 0) {
+    vi->entry = id;
+    vi->maxLevel = level;
+    return sz;
+  }
+
+  VecCandidate ep = {.dist = VectorIndex_Distance(vi, q, VEC(vi, vi->entry)), .id = vi->entry};
+  for (int l = vi->maxLevel; l > level; --l) {
+    ep = hnswGreedy(vi, q, ep, l);
+  }
+
+  VecCandidate *eps = array_new(VecCandidate, 1);
+  eps = array_append(eps, ep);
+  uint32_t selected[2 * vi->opts.hnswM];
+  for (int l = level < vi->maxLevel ? level : vi->maxLevel; l >= 0; --l) {
+    VecCandidate *w =
+        hnswSearchLayer(vi, q, eps, array_len(eps), vi->opts.hnswEfConstruction, l, &vi->visited);
+    qsort(w, array_len(w), sizeof(*w), cmpCandidates);
+    size_t nsel = hnswSelectNeighbors(vi, w, array_len(w), vi->opts.hnswM, selected);
+    uint32_t *links = hnswLinks(vi, id, l);
+    links[0] = nsel;
+    memcpy(links + 1, selected, nsel * sizeof(*selected));
+    for (size_t i = 0; i < nsel; ++i) {
+      hnswConnect(vi, selected[i], id, l);
+    }
+    array_free(eps);
+    eps = w;
+  }
+  array_free(eps);
+
+  if (level > vi->maxLevel) {
+    vi->entry = id;
+    vi->maxLevel = level;
+  }
+  return sz;
+}
+
+/* Find about `ef` nodes nearest to `q`, sorted by distance */
+static VecCandidate *hnswSearch(const VectorIndex *vi, const float *q, size_t ef, VisitedSet *vs) {
+  if (vi->maxLevel < 0) {
+    return array_new(VecCandidate, 1);
+  }
+  VecCandidate ep = {.dist = VectorIndex_Distance(vi, q, VEC(vi, vi->entry)), .id = vi->entry};
+  for (int l = vi->maxLevel; l > 0; --l) {
+    ep = hnswGreedy(vi, q, ep, l);
+  }
+  VecCandidate *w = hnswSearchLayer(vi, q, &ep, 1, ef, 0, vs);
+  qsort(w, array_len(w), sizeof(*w), cmpCandidates);
+  return w;
+}
+
+/*****************************************************************************
+ * Adding vectors
+ *****************************************************************************/
+
+static size_t vectorIndexGrow(VectorIndex *vi) {
+  size_t oldCap = vi->cap;
+  vi->cap = vi->cap ? vi->cap * 2 : VECTOR_INITIAL_CAPACITY;
+  size_t added = vi->cap - oldCap;
+  vi->vectors = rm_realloc(vi->vectors, vi->cap * vi->opts.dim * sizeof(float));
+  vi->docIds = rm_realloc(vi->docIds, vi->cap * sizeof(t_docId));
+  size_t sz = added * (vi->opts.dim * sizeof(float) + sizeof(t_docId));
+  if (vi->opts.algo == VectorAlgo_HNSW) {
+    vi->nodes = rm_realloc(vi->nodes, vi->cap * sizeof(*vi->nodes));
+    vi->visited.tags = rm_realloc(vi->visited.tags, vi->cap * sizeof(*vi->visited.tags));
+    memset(vi->visited.tags + oldCap, 0, added * sizeof(*vi->visited.tags));
+    sz += added * (sizeof(*vi->nodes) + sizeof(*vi->visited.tags));
+  }
+  return sz;
+}
+
+size_t VectorIndex_Add(VectorIndex *vi, t_docId docId, const float *vec) {
+  size_t sz = 0;
+  uint32_t id;
+  if (array_len(vi->freeIds)) {
+    id = array_pop(vi->freeIds);
+  } else {
+    if (vi->size == vi->cap) {
+      sz += vectorIndexGrow(vi);
+    }
+    id = vi->size++;
+  }
+
+  memcpy(VEC(vi, id), vec, vi->opts.dim * sizeof(float));
+  if (vi->opts.metric == VectorMetric_Cosine) {
+    normalize(VEC(vi, id), vi->opts.dim);
+  }
+  vi->docIds[id] = docId;
+  if (vi->opts.algo == VectorAlgo_HNSW) {
+    sz += hnswInsert(vi, id);
+  }
+  return sz;
+}
+
+/*****************************************************************************
+ * Sweeping deleted vectors
+ *
+ * The flat index frees the slots of deleted documents as soon as it finds them. The graph has to
+ * stay connected, so a first pass only marks the nodes of deleted documents dead, a second one
+ * relinks their live neighbours around them, and their slots are freed once nothing links to them.
+ *****************************************************************************/
+
+static size_t vectorIndexFreeSlot(VectorIndex *vi, uint32_t id) {
+  size_t sz = 0;
+  if (vi->opts.algo == VectorAlgo_HNSW) {
+    sz = hnswLinksSize(vi, vi->nodes[id].level);
+    rm_free(vi->nodes[id].links);
+    vi->nodes[id] = (HNSWNode){0};
+  }
+  vi->docIds[id] = 0;
+  vi->freeIds = array_append(vi->freeIds, id);
+  return sz;
+}
+
+static VecCandidate *hnswAddCandidate(VectorIndex *vi, VecCandidate *cands, const float *v,
+                                      uint32_t id) {
+  if (!vi->nodes[id].dead && !visitedTestAndSet(&vi->visited, id)) {
+    VecCandidate c = {.dist = VectorIndex_Distance(vi, v, VEC(vi, id)), .id = id};
+    cands = array_append(cands, c);
+  }
+  return cands;
+}
+
+/* Replace the links of a node to dead nodes on a level, picking among its live neighbours and the
+ * live neighbours of its dead ones */
+static void hnswRelink(VectorIndex *vi, uint32_t id, int level) {
+  uint32_t *links = hnswLinks(vi, id, level);
+  uint32_t i = 1;
+  while (i <= links[0] && !vi->nodes[links[i]].dead) {
+    i++;
+  }
+  if (i > links[0]) {
+    return;
+  }
+
+  const float *v = VEC(vi, id);
+  VecCandidate *cands = array_new(VecCandidate, hnswMaxLinks(vi, level));
+  visitedReset(&vi->visited, vi->size);
+  visitedTestAndSet(&vi->visited, id);
+  for (i = 1; i <= links[0]; ++i) {
+    if (!vi->nodes[links[i]].dead) {
+      cands = hnswAddCandidate(vi, cands, v, links[i]);
+      continue;
+    }
+    const uint32_t *deadLinks = hnswLinks(vi, links[i], level);
+    for (uint32_t j = 1; j <= deadLinks[0]; ++j) {
+      cands = hnswAddCandidate(vi, cands, v, deadLinks[j]);
+    }
+  }
+  qsort(cands, array_len(cands), sizeof(*cands), cmpCandidates);
+  links[0] = hnswSelectNeighbors(vi, cands, array_len(cands), hnswMaxLinks(vi, level), links + 1);
+  array_free(cands);
+}
+
+/* End the unlink pass: nothing links to the dead nodes anymore, so their slots can be reused */
+static size_t hnswFreeDead(VectorIndex *vi, size_t *bytesFreed) {
+  if (vi->maxLevel >= 0 && vi->nodes[vi->entry].dead) {
+    vi->entry = vi->sweepEntryLevel >= 0 ? vi->sweepEntry : 0;
+    vi->maxLevel = vi->sweepEntryLevel;
+  }
+  size_t n = array_len(vi->deadIds);
+  for (size_t i = 0; i < n; ++i) {
+    *bytesFreed += vectorIndexFreeSlot(vi, vi->deadIds[i]);
+  }
+  array_clear(vi->deadIds);
+  return n;
+}
+
+size_t VectorIndex_Sweep(VectorIndex *vi, const DocTable *docs, size_t maxSlots,
+                         size_t *bytesFreed) {
+  int graph = vi->opts.algo == VectorAlgo_HNSW;
+  size_t dropped = 0;
+  for (; maxSlots; --maxSlots) {
+    if (vi->sweepPos >= vi->size) {
+      vi->sweepPos = 0;
+      if (graph && vi->sweepUnlinking) {
+        vi->sweepUnlinking = 0;
+        dropped += hnswFreeDead(vi, bytesFreed);
+      } else if (graph && array_len(vi->deadIds)) {
+        vi->sweepUnlinking = 1;
+        vi->sweepEntryLevel = -1;
+        continue;
+      }
+      break;
+    }
+
+    uint32_t id = vi->sweepPos++;
+    if (!vi->docIds[id]) {
+      // a free slot
+      continue;
+    }
+    if (!graph) {
+      if (!isLive(docs, vi->docIds[id])) {
+        vectorIndexFreeSlot(vi, id);
+        dropped++;
+      }
+    } else if (!vi->sweepUnlinking) {
+      if (!isLive(docs, vi->docIds[id])) {
+        vi->nodes[id].dead = 1;
+        vi->deadIds = array_append(vi->deadIds, id);
+      }
+    } else if (!vi->nodes[id].dead) {
+      int level = vi->nodes[id].level;
+      for (int l = 0; l <= level; ++l) {
+        hnswRelink(vi, id, l);
+      }
+      if (level > vi->sweepEntryLevel) {
+        vi->sweepEntry = id;
+        vi->sweepEntryLevel = level;
+      }
+    }
+  }
+  return dropped;
+}
+
+/*****************************************************************************
+ * Opening indexes
+ *****************************************************************************/
+
+RedisModuleString *VectorIndex_FormatName(RedisSearchCtx *sctx, const char *field) {
+  return RedisModule_CreateStringPrintf(sctx->redisCtx, VECTOR_INDEX_KEY_FMT, sctx->spec->name,
+                                        field);
+}
+
+VectorIndex *VectorIndex_Open(RedisSearchCtx *sctx, const FieldSpec *fs, int openWrite) {
+  // vector indexes only live in the index's keys dictionary, never in the keyspace
+  if (!sctx->spec->keysDict) {
+    return NULL;
+  }
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sctx->spec, fs, INDEXFLD_T_VECTOR);
+  KeysDictValue *kdv = dictFetchValue(sctx->spec->keysDict, key);
+  if (kdv) {
+    return kdv->p;
+  }
+  if (!openWrite) {
+    return NULL;
+  }
+  kdv = rm_calloc(1, sizeof(*kdv));
+  kdv->p = NewVectorIndex(&fs->vectorOpts);
+  kdv->dtor = VectorIndex_Free;
+  dictAdd(sctx->spec->keysDict, key, kdv);
+  return kdv->p;
+}
+
+/*****************************************************************************
+ * Queries
+ *****************************************************************************/
+
+int VectorQuery_Parse(VectorQuery *vq, ArgsCursor *ac, QueryError *status) {
+  if (AC_NumRemaining(ac) < 3) {
+    QERR_MKBADARGS_FMT(status, "VECTORKNN requires 3 arguments");
+    return REDISMODULE_ERR;
+  }
+
+  int rv;
+  const char *property;
+  if ((rv = AC_GetString(ac, &property, NULL, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<vector property>", rv);
+    return REDISMODULE_ERR;
+  }
+  vq->property = rm_strdup(property);
+
+  uint64_t k;
+  if ((rv = AC_GetU64(ac, &k, AC_F_GE1)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<k>", rv);
+    return REDISMODULE_ERR;
+  }
+  vq->k = k;
+
+  const char *blob;
+  size_t len;
+  if ((rv = AC_GetString(ac, &blob, &len, 0)) != AC_OK) {
+    QERR_MKBADARGS_AC(status, "<vector>", rv);
+    return REDISMODULE_ERR;
+  }
+  if (len == 0 || len % sizeof(float)) {
+    QERR_MKBADARGS_FMT(status, "Query vector must be a FLOAT32 blob");
+    return REDISMODULE_ERR;
+  }
+  vq->dim = len / sizeof(float);
+  vq->vector = rm_malloc(len);
+  memcpy(vq->vector, blob, len);
+  return REDISMODULE_OK;
+}
+
+void VectorQuery_Free(VectorQuery *vq) {
+  rm_free((char *)vq->property);
+  rm_free(vq->vector);
+  rm_free(vq);
+}
+
+typedef struct {
+  RedisSearchCtx *sctx;
+  const FieldSpec *fs;
+  const VectorQuery *vq;
+  IndexIterator *child;
+} VectorKnnCtx;
+
+/* Scan every vector. Without a child only the k nearest are kept while scanning */
+static KnnHit *flatSearch(const VectorIndex *vi, const DocTable *docs, const float *q,
+                          IndexIterator *child, size_t k) {
+  if (child) {
+    KnnHit *hits = array_new(KnnHit, vi->size);
+    for (size_t i = 0; i < vi->size; ++i) {
+      if (isLive(docs, vi->docIds[i])) {
+        float d = VectorIndex_Distance(vi, q, VEC(vi, i));
+        hits = array_append(hits, ((KnnHit){.docId = vi->docIds[i], .distance = d}));
+      }
+    }
+    KnnHits_SortByDocId(hits);
+    return KnnHits_Match(hits, child);
+  }
+
+  VecHeap nearest = {.items = array_new(VecCandidate, k + 1), .max = 1};
+  for (size_t i = 0; i < vi->size; ++i) {
+    float d = VectorIndex_Distance(vi, q, VEC(vi, i));
+    if (array_len(nearest.items) < k || d < nearest.items[0].dist) {
+      if (!isLive(docs, vi->docIds[i])) {
+        continue;
+      }
+      heapPush(&nearest, (VecCandidate){.dist = d, .id = i});
+      if (array_len(nearest.items) > k) {
+        heapPop(&nearest);
+      }
+    }
+  }
+  KnnHit *hits = array_new(KnnHit, array_len(nearest.items));
+  for (size_t i = 0; i < array_len(nearest.items); ++i) {
+    const VecCandidate *c = nearest.items + i;
+    hits = array_append(hits, ((KnnHit){.docId = vi->docIds[c->id], .distance = c->dist}));
+  }
+  array_free(nearest.items);
+  KnnHits_SortByDocId(hits);
+  return hits;
+}
+
+/* Search the graph for `ef` candidates, widening the search while too few of them match the child.
+ * Returns NULL if the search would cover most of the graph anyway, so a scan is cheaper */
+static KnnHit *graphSearch(VectorIndex *vi, const DocTable *docs, const float *q,
+                           IndexIterator *child, size_t k) {
+  size_t ef = vi->opts.hnswEfRuntime > k ? vi->opts.hnswEfRuntime : k;
+  KnnHit *hits = NULL;
+
+  while (ef < VectorIndex_Size(vi) / 2) {
+    VecCandidate *w = hnswSearch(vi, q, ef, &vi->visited);
+    hits = array_new(KnnHit, array_len(w));
+    for (size_t i = 0; i < array_len(w); ++i) {
+      t_docId docId = vi->docIds[w[i].id];
+      if (isLive(docs, docId)) {
+        hits = array_append(hits, ((KnnHit){.docId = docId, .distance = w[i].dist}));
+      }
+    }
+    array_free(w);
+    KnnHits_SortByDocId(hits);
+    hits = KnnHits_Match(hits, child);
+    if (array_len(hits) >= k) {
+      break;
+    }
+    array_free(hits);
+    hits = NULL;
+    ef *= 4;
+  }
+  return hits;
+}
+
+KnnHit *VectorIndex_Search(VectorIndex *vi, const DocTable *docs, const float *vec, size_t k,
+                           IndexIterator *child) {
+  if (!VectorIndex_Size(vi)) {
+    return array_new(KnnHit, 1);
+  }
+
+  size_t dim = vi->opts.dim;
+  float *q = rm_malloc(dim * sizeof(float));
+  memcpy(q, vec, dim * sizeof(float));
+  if (vi->opts.metric == VectorMetric_Cosine) {
+    normalize(q, dim);
+  }
+
+  KnnHit *hits = NULL;
+  if (vi->opts.algo == VectorAlgo_HNSW) {
+    hits = graphSearch(vi, docs, q, child, k);
+  }
+  if (!hits) {
+    hits = flatSearch(vi, docs, q, child, k);
+  }
+  rm_free(q);
+  return KnnHits_Nearest(hits, k);
+}
+
+static KnnHit *vectorKnnLoad(void *ctx) {
+  VectorKnnCtx *kc = ctx;
+  VectorIndex *vi = VectorIndex_Open(kc->sctx, kc->fs, 0);
+  if (!vi) {
+    return array_new(KnnHit, 1);
+  }
+  return VectorIndex_Search(vi, &kc->sctx->spec->docs, kc->vq->vector, kc->vq->k, kc->child);
+}
+
+static void vectorKnnFree(void *ctx) {
+  VectorKnnCtx *kc = ctx;
+  if (kc->child) {
+    kc->child->Free(kc->child);
+  }
+  rm_free(kc);
+}
+
+IndexIterator *NewVectorKnnIterator(RedisSearchCtx *sctx, const FieldSpec *fs,
+                                    const VectorQuery *vq, IndexIterator *child) {
+  VectorKnnCtx *kc = rm_malloc(sizeof(*kc));
+  *kc = (VectorKnnCtx){.sctx = sctx, .fs = fs, .vq = vq, .child = child};
+  return NewKnnIterator(kc, vectorKnnLoad, vectorKnnFree, vq->k);
+}
+
+/*****************************************************************************
+ * Options
+ *****************************************************************************/
+
+const char *VectorMetric_ToString(VectorMetric metric) {
+  switch (metric) {
+    case VectorMetric_L2:
+      return "L2";
+    case VectorMetric_IP:
+      return "IP";
+    case VectorMetric_Cosine:
+      return "COSINE";
+  }
+  return "<badmetric>";
+}
+
+int VectorMetric_Parse(const char *s, VectorMetric *metric) {
+  if (!strcasecmp(s, "L2")) {
+    *metric = VectorMetric_L2;
+  } else if (!strcasecmp(s, "IP")) {
+    *metric = VectorMetric_IP;
+  } else if (!strcasecmp(s, "COSINE")) {
+    *metric = VectorMetric_Cosine;
+  } else {
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+const char *VectorAlgo_ToString(VectorAlgo algo) {
+  switch (algo) {
+    case VectorAlgo_Flat:
+      return "FLAT";
+    case VectorAlgo_HNSW:
+      return "HNSW";
+  }
+  return "<badalgo>";
+}
+
+int VectorAlgo_Parse(const char *s, VectorAlgo *algo) {
+  if (!strcasecmp(s, "FLAT")) {
+    *algo = VectorAlgo_Flat;
+  } else if (!strcasecmp(s, "HNSW")) {
+    *algo = VectorAlgo_HNSW;
+  } else {
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
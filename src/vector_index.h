@@ -0,0 +1,88 @@
+#ifndef __VECTOR_INDEX_H__
+#define __VECTOR_INDEX_H__
+
+#include "redisearch.h"
+#include "field_spec.h"
+#include "index_iterator.h"
+#include "search_ctx.h"
+#include "query_error.h"
+#include "doc_table.h"
+#include "knn_iterator.h"
+#include "rmutil/args.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VECTOR_INDEX_KEY_FMT "vec:%s/%s"
+
+// Name of the result field holding the distance of each vector KNN result, given the field
+#define VECTOR_DISTANCE_FIELD_FMT "__%s_score"
+
+/* An index of the FLOAT32 vectors of one field, searched either by a brute force scan or through
+ * an HNSW graph, depending on the field options.
+ *
+ * Vectors of deleted documents are skipped when searching, until VectorIndex_Sweep drops them. New
+ * vectors take the slots of dropped ones before the index grows */
+typedef struct VectorIndex VectorIndex;
+
+VectorIndex *NewVectorIndex(const VectorFieldOptions *opts);
+void VectorIndex_Free(void *vi);
+
+/* Add the vector of a document, given as `opts->dim` floats. Returns the number of bytes the index
+ * grew by */
+size_t VectorIndex_Add(VectorIndex *vi, t_docId docId, const float *vec);
+
+/* The number of vectors in the index, including the ones of deleted documents not swept yet */
+size_t VectorIndex_Size(const VectorIndex *vi);
+
+/* Drop the vectors of deleted documents, visiting at most `maxSlots` slots of the index. Each call
+ * picks up where the last one stopped, and stops once a whole pass over the index is done. The
+ * graph of an HNSW index takes two passes, the first marking the deleted nodes and the second
+ * unlinking them. Returns the number of vectors dropped, and adds the bytes freed to `bytesFreed` */
+size_t VectorIndex_Sweep(VectorIndex *vi, const DocTable *docs, size_t maxSlots,
+                         size_t *bytesFreed);
+
+// The number of slots of each vector index swept by the fork GC on each of its runs
+#define VECTOR_SWEEP_STEP_SLOTS 50000
+
+/* The distance between two vectors, by the metric of the index */
+float VectorIndex_Distance(const VectorIndex *vi, const float *a, const float *b);
+
+/* Find the `k` vectors nearest to `vec` among the live documents matching `child`, or all live
+ * documents if `child` is NULL. Returns an array (util/arr.h) of hits sorted by docId */
+KnnHit *VectorIndex_Search(VectorIndex *vi, const DocTable *docs, const float *vec, size_t k,
+                           IndexIterator *child);
+
+/* Format the key name of a vector index */
+RedisModuleString *VectorIndex_FormatName(RedisSearchCtx *sctx, const char *field);
+
+/* Open the vector index of a field. Returns NULL if it doesn't exist and `openWrite` is not set */
+VectorIndex *VectorIndex_Open(RedisSearchCtx *sctx, const FieldSpec *fs, int openWrite);
+
+/* A nearest neighbour query, parsed from VECTORKNN {field} {k} {blob} */
+typedef struct VectorQuery {
+  const char *property;
+  size_t k;
+  float *vector;
+  size_t dim;
+} VectorQuery;
+
+int VectorQuery_Parse(VectorQuery *vq, ArgsCursor *ac, QueryError *status);
+void VectorQuery_Free(VectorQuery *vq);
+
+/* Create an iterator over the `vq->k` documents matching `child` whose vectors are nearest to the
+ * query vector, in docId order. A NULL child matches all documents. Each result is numeric, holding
+ * the distance from the query vector. The child is owned by the returned iterator */
+IndexIterator *NewVectorKnnIterator(RedisSearchCtx *sctx, const FieldSpec *fs,
+                                    const VectorQuery *vq, IndexIterator *child);
+
+const char *VectorMetric_ToString(VectorMetric metric);
+int VectorMetric_Parse(const char *s, VectorMetric *metric);
+const char *VectorAlgo_ToString(VectorAlgo algo);
+int VectorAlgo_Parse(const char *s, VectorAlgo *algo);
+
+#ifdef __cplusplus
+}
+#endif
+#endif